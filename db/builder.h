@@ -0,0 +1,31 @@
+#ifndef STORAGE_LEVELDB_DB_BUILDER_H_
+#define STORAGE_LEVELDB_DB_BUILDER_H_
+
+#include <cstdint>
+#include <string>
+
+#include "status.h"
+
+namespace leveldb {
+
+struct Options;
+
+class Env;
+class Iterator;
+class TableCache;
+struct FileMetaData;
+
+// Build a Table file from the contents of *iter.  The generated file
+// will be named according to meta->number.  On success, the rest of
+// *meta will be filled with metadata about the generated table.
+// If no data is present in *iter, meta->file_size will be set to
+// zero, and no Table file will be produced.
+//
+// options.comparator 必须是 InternalKeyComparator，iter 按 internal key 有序。
+// 文件在返回之前已经 Sync 并关闭，并通过 table_cache 打开一次以确认可用。
+Status BuildTable(const std::string& dbname, Env* env, const Options& options,
+                  TableCache* table_cache, Iterator* iter, FileMetaData* meta);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_BUILDER_H_
@@ -0,0 +1,90 @@
+#include "compaction_iterator.h"
+
+#include "version_set.h"
+
+namespace leveldb {
+
+CompactionIterator::CompactionIterator(Iterator* input,
+                                       const Comparator* user_comparator,
+                                       SequenceNumber smallest_snapshot,
+                                       Compaction* compaction,
+                                       CompactionProgress* progress)
+    : input_(input),
+      user_comparator_(user_comparator),
+      smallest_snapshot_(smallest_snapshot),
+      compaction_(compaction),
+      progress_(progress),
+      has_current_user_key_(false),
+      last_sequence_for_key_(kMaxSequenceNumber),
+      num_dropped_(0) {}
+
+CompactionIterator::~CompactionIterator() { delete input_; }
+
+void CompactionIterator::SeekToFirst() {
+  input_->SeekToFirst();
+  has_current_user_key_ = false;
+  FindNextKept();
+}
+
+void CompactionIterator::Seek(const Slice& target) {
+  input_->Seek(target);
+  has_current_user_key_ = false;
+  FindNextKept();
+}
+
+void CompactionIterator::Next() {
+  input_->Next();
+  FindNextKept();
+}
+
+void CompactionIterator::FindNextKept() {
+  while (input_->Valid() && ShouldDrop()) {
+    num_dropped_++;
+    input_->Next();
+  }
+}
+
+bool CompactionIterator::ShouldDrop() {
+  Slice key = input_->key();
+  ParsedInternalKey ikey;
+  if (!ParseInternalKey(key, &ikey)) {
+    // Do not hide error keys
+    current_user_key_.clear();
+    has_current_user_key_ = false;
+    last_sequence_for_key_ = kMaxSequenceNumber;
+    return false;
+  }
+
+  if (!has_current_user_key_ ||
+      user_comparator_->Compare(ikey.user_key, Slice(current_user_key_)) !=
+          0) {
+    // First occurrence of this user key
+    current_user_key_.assign(ikey.user_key.data(), ikey.user_key.size());
+    has_current_user_key_ = true;
+    last_sequence_for_key_ = kMaxSequenceNumber;
+  }
+
+  bool drop = false;
+  if (last_sequence_for_key_ <= smallest_snapshot_) {
+    // Hidden by an newer entry for same user key
+    drop = true;
+  } else if (ikey.type == kTypeDeletion &&
+             ikey.sequence <= smallest_snapshot_ &&
+             (progress_ != nullptr
+                  ? compaction_->IsBaseLevelForKey(ikey.user_key, progress_)
+                  : compaction_->IsBaseLevelForKey(ikey.user_key))) {
+    // For this user key:
+    // (1) there is no data in higher levels
+    // (2) data in lower levels will have larger sequence numbers
+    // (3) data in layers that are being compacted here and have
+    //     smaller sequence numbers will be dropped in the next
+    //     few iterations of this loop (by the hidden-entry rule above).
+    // Therefore this deletion marker is obsolete and can be dropped.
+    drop = true;
+  }
+
+  last_sequence_for_key_ = ikey.sequence;
+  return drop;
+}
+
+}  // namespace leveldb
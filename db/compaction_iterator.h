@@ -0,0 +1,72 @@
+#ifndef STORAGE_LEVELDB_DB_COMPACTION_ITERATOR_H_
+#define STORAGE_LEVELDB_DB_COMPACTION_ITERATOR_H_
+
+#include <string>
+
+#include "dbformat.h"
+#include "iterator.h"
+
+namespace leveldb {
+
+class Compaction;
+struct CompactionProgress;
+
+// compaction 的输入迭代器：包装所有输入文件的归并迭代器，只输出需要写入
+// 新文件的 entry，跳过以下两类：
+//  - 被遮挡的旧版本：同一个 user key 已经输出过一个序列号 <= smallest_snapshot
+//    的版本，更老的版本不会再被任何读操作看到；
+//  - 多余的删除标记：序列号 <= smallest_snapshot 的 kTypeDeletion，并且更高的
+//    层(level+2 及以上)中没有这个 key，删除标记不再需要遮挡任何数据。
+// 只支持正向遍历。
+class CompactionIterator {
+ public:
+  // 接管 input 的所有权。compaction 用于判断 key 是否在更高的层中出现，
+  // IsBaseLevelForKey 要求 key 递增，它的位置保存在 *progress 中。
+  // progress 为 nullptr 时使用 compaction 自己的状态，此时一个 Compaction
+  // 同一时间只能被一个 CompactionIterator 使用；子 compaction 各自传入自己的
+  // progress。
+  CompactionIterator(Iterator* input, const Comparator* user_comparator,
+                     SequenceNumber smallest_snapshot, Compaction* compaction,
+                     CompactionProgress* progress = nullptr);
+
+  CompactionIterator(const CompactionIterator&) = delete;
+  CompactionIterator& operator=(const CompactionIterator&) = delete;
+
+  ~CompactionIterator();
+
+  void SeekToFirst();
+  // 定位到第一个 >= target 的需要保留的 entry
+  void Seek(const Slice& target);
+  void Next();
+
+  bool Valid() const { return input_->Valid(); }
+  Slice key() const { return input_->key(); }
+  Slice value() const { return input_->value(); }
+  Status status() const { return input_->status(); }
+
+  // 目前为止跳过的 entry 数(被遮挡的旧版本 + 删除标记)
+  uint64_t num_dropped() const { return num_dropped_; }
+
+ private:
+  // 从 input_ 当前的位置开始跳过不需要保留的 entry
+  void FindNextKept();
+
+  // 判断 input_ 当前的 entry 是否可以丢弃，同时更新 current_user_key_ 等状态
+  bool ShouldDrop();
+
+  Iterator* const input_;
+  const Comparator* const user_comparator_;
+  const SequenceNumber smallest_snapshot_;
+  Compaction* const compaction_;
+  CompactionProgress* const progress_;
+
+  std::string current_user_key_;
+  bool has_current_user_key_;
+  // 当前 user key 上一个输出(或跳过)的 entry 的序列号
+  SequenceNumber last_sequence_for_key_;
+  uint64_t num_dropped_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_COMPACTION_ITERATOR_H_
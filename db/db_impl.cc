@@ -0,0 +1,1476 @@
+#include "db_impl.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "builder.h"
+#include "compaction_iterator.h"
+#include "env.h"
+#include "filename.h"
+#include "log_parallel_reader.h"
+#include "log_reader.h"
+#include "logging.h"
+#include "log_writer.h"
+#include "memtable.h"
+#include "table.h"
+#include "table_builder.h"
+#include "table_cache.h"
+#include "version_set.h"
+#include "write_batch.h"
+#include "write_batch_internal.h"
+#include "write_queue.h"
+
+namespace leveldb {
+
+const int kNumNonTableCacheFiles = 10;
+
+// Files produced by compaction
+struct DBImpl::CompactionOutput {
+  uint64_t number;
+  uint64_t file_size;
+  InternalKey smallest, largest;
+};
+
+// compaction 按 user key 范围 [start, end) 拆分出的一部分，各自独立地归并输入、
+// 写出自己的输出文件。不拆分时只有一个范围不受限的子 compaction。
+struct DBImpl::SubcompactionState {
+  SubcompactionState(CompactionState* c, const std::string* start,
+                     const std::string* end)
+      : compact(c),
+        has_start(start != nullptr),
+        has_end(end != nullptr),
+        outfile(nullptr),
+        builder(nullptr),
+        total_bytes(0),
+        num_dropped(0) {
+    if (has_start) this->start = *start;
+    if (has_end) this->end = *end;
+  }
+
+  CompactionOutput* current_output() { return &outputs[outputs.size() - 1]; }
+
+  CompactionState* const compact;
+  std::string start;  // 包含
+  std::string end;    // 不包含
+  const bool has_start;
+  const bool has_end;
+
+  // grandparent 重叠和 IsBaseLevelForKey 的位置，从本范围的起点开始推进
+  CompactionProgress progress;
+
+  std::vector<CompactionOutput> outputs;
+
+  // State kept for output being generated
+  WritableFile* outfile;
+  TableBuilder* builder;
+
+  uint64_t total_bytes;
+  uint64_t num_dropped;
+  Status status;
+};
+
+struct DBImpl::CompactionState {
+  explicit CompactionState(Compaction* c) : compaction(c), smallest_snapshot(0) {}
+
+  ~CompactionState() {
+    for (SubcompactionState* sub : subcompactions) {
+      delete sub;
+    }
+  }
+
+  Compaction* const compaction;
+
+  // Sequence numbers < smallest_snapshot are not significant since we
+  // will never have to service a snapshot below smallest_snapshot.
+  // Therefore if we have seen a sequence number S <= smallest_snapshot,
+  // we can drop all entries for the same key with sequence numbers < S.
+  SequenceNumber smallest_snapshot;
+
+  // 按 key 的顺序排列，范围首尾相接、互不重叠
+  std::vector<SubcompactionState*> subcompactions;
+};
+
+// 通过 Env::Schedule 提交的一个子 compaction。LOW 线程池可能只有一个线程，
+// 正是执行 compaction 的这个线程，所以它在完成自己的部分之后会把还没有被
+// 后台线程领取的子 compaction 收回来自己执行；之后任务才运行时什么也不做。
+// 任务对象由 compaction 线程和任务各持有一个引用，最后释放的一方删除它。
+struct DBImpl::SubcompactionTask {
+  SubcompactionTask(DBImpl* d, SubcompactionState* s)
+      : db(d), sub(s), claimed(false), refs(2), done(false) {}
+
+  void Unref() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  DBImpl* const db;
+  SubcompactionState* const sub;
+  std::atomic<bool> claimed;  // 已经有线程开始执行
+  std::atomic<int> refs;
+  bool done;  // 由 db->mutex_ 保护
+};
+
+// Fix user-supplied options to be reasonable
+template <class T, class V>
+static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
+  if (static_cast<V>(*ptr) > maxvalue) *ptr = maxvalue;
+  if (static_cast<V>(*ptr) < minvalue) *ptr = minvalue;
+}
+
+Options SanitizeOptions(const std::string& dbname,
+                        const InternalKeyComparator* icmp,
+                        const InternalFilterPolicy* ipolicy,
+                        const Options& src) {
+  Options result = src;
+  result.comparator = icmp;
+  result.filter_policy = (src.filter_policy != nullptr) ? ipolicy : nullptr;
+  ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000);
+  ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
+  ClipToRange(&result.max_write_buffer_number, 2, 64);
+  ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
+  ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  if (result.arena_block_size == 0) {
+    result.arena_block_size = result.write_buffer_size / 8;
+  }
+  ClipToRange(&result.arena_block_size,
+              4 * ConcurrentArena::kDefaultShardBlockSize, size_t{1} << 30);
+  return result;
+}
+
+static int TableCacheSize(const Options& sanitized_options) {
+  // Reserve ten files or so for other uses and give the rest to TableCache.
+  return sanitized_options.max_open_files - kNumNonTableCacheFiles;
+}
+
+DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
+    : env_(raw_options.env),
+      internal_comparator_(raw_options.comparator),
+      internal_filter_policy_(raw_options.filter_policy),
+      options_(SanitizeOptions(dbname, &internal_comparator_,
+                               &internal_filter_policy_, raw_options)),
+      dbname_(dbname),
+      table_cache_(new TableCache(dbname_, options_, TableCacheSize(options_))),
+      db_lock_(nullptr),
+      shutting_down_(false),
+      background_work_finished_signal_(&mutex_),
+      mem_(nullptr),
+      logfile_(nullptr),
+      logfile_number_(0),
+      log_(nullptr),
+      queue_(nullptr),
+      min_recyclable_log_(0),
+      background_flush_scheduled_(false),
+      background_compaction_scheduled_(false),
+      manifest_writing_(false),
+      manual_compaction_(nullptr),
+      versions_(new VersionSet(dbname_, &options_, table_cache_,
+                               &internal_comparator_)),
+      num_flushes_(0),
+      stall_micros_(0),
+      compaction_dropped_entries_(0),
+      num_subcompactions_(0) {}
+
+DBImpl::~DBImpl() {
+  // Wait for background work to finish.
+  mutex_.Lock();
+  shutting_down_.store(true, std::memory_order_release);
+  while (background_flush_scheduled_ || background_compaction_scheduled_) {
+    background_work_finished_signal_.Wait();
+  }
+  mutex_.Unlock();
+
+  if (db_lock_ != nullptr) {
+    env_->UnlockFile(db_lock_);
+  }
+
+  // 尚未 flush 的 memtable 的内容仍然保存在各自的日志文件中，下次打开时恢复
+  delete versions_;
+  delete queue_;
+  delete log_;
+  if (logfile_ != nullptr) {
+    logfile_->Close();
+  }
+  delete logfile_;
+  if (mem_ != nullptr) mem_->Unref();
+  for (const ImmutableMemTable& imm : imm_) {
+    imm.mem->Unref();
+  }
+  delete table_cache_;
+}
+
+Status DBImpl::NewDB() {
+  VersionEdit new_db;
+  new_db.SetComparatorName(internal_comparator_.user_comparator()->Name());
+  new_db.SetLogNumber(0);
+  new_db.SetNextFile(2);
+  new_db.SetLastSequence(0);
+
+  const std::string manifest = DescriptorFileName(dbname_, 1);
+  WritableFile* file;
+  Status s = env_->NewWritableFile(manifest, &file);
+  if (!s.ok()) {
+    return s;
+  }
+  {
+    log::Writer log(file);
+    std::string record;
+    new_db.EncodeTo(&record);
+    s = log.AddRecord(record);
+    if (s.ok()) {
+      s = file->Sync();
+    }
+    if (s.ok()) {
+      s = file->Close();
+    }
+  }
+  delete file;
+  if (s.ok()) {
+    // Make "CURRENT" file that points to the new manifest file.
+    s = SetCurrentFile(env_, dbname_, 1);
+  } else {
+    env_->RemoveFile(manifest);
+  }
+  return s;
+}
+
+void DBImpl::RemoveObsoleteFiles() {
+  if (!bg_error_.ok()) {
+    // After a background error, we don't know whether a new version may
+    // or may not have been committed, so we cannot safely garbage collect.
+    return;
+  }
+
+  // Make a set of all of the live files
+  std::set<uint64_t> live = pending_outputs_;
+  versions_->AddLiveFiles(&live);
+
+  // 等待 flush 的 memtable 的日志文件号都不小于 versions_->LogNumber()
+  std::vector<std::string> filenames;
+  env_->GetChildren(dbname_, &filenames);  // Ignoring errors on purpose
+  uint64_t number;
+  FileType type;
+  std::vector<std::string> files_to_delete;
+  for (std::string& filename : filenames) {
+    if (ParseFileName(filename, &number, &type)) {
+      bool keep = true;
+      switch (type) {
+        case kLogFile:
+          keep = ((number >= versions_->LogNumber()) ||
+                  (number == versions_->PrevLogNumber()));
+          if (!keep && options_.recycle_log_file_num > 0 &&
+              number >= min_recyclable_log_) {
+            if (std::find(recycle_logs_.begin(), recycle_logs_.end(),
+                          number) != recycle_logs_.end()) {
+              keep = true;
+            } else if (recycle_logs_.size() < options_.recycle_log_file_num) {
+              recycle_logs_.push_back(number);
+              keep = true;
+            }
+          }
+          break;
+        case kDescriptorFile:
+          // Keep my manifest file, and any newer incarnations'
+          // (in case there is a race that allows other incarnations)
+          keep = (number >= versions_->ManifestFileNumber());
+          break;
+        case kTableFile:
+          keep = (live.find(number) != live.end());
+          break;
+        case kTempFile:
+          // Any temp files that are currently being written to must
+          // be recorded in pending_outputs_, which is inserted into "live"
+          keep = (live.find(number) != live.end());
+          break;
+        case kCurrentFile:
+        case kDBLockFile:
+        case kInfoLogFile:
+          keep = true;
+          break;
+      }
+
+      if (!keep) {
+        files_to_delete.push_back(std::move(filename));
+        if (type == kTableFile) {
+          table_cache_->Evict(number);
+        }
+      }
+    }
+  }
+
+  // While deleting all files unblock other threads. All files being deleted
+  // have unique names which will not collide with newly created files and
+  // are therefore safe to delete while allowing other threads to proceed.
+  mutex_.Unlock();
+  for (const std::string& filename : files_to_delete) {
+    env_->RemoveFile(dbname_ + "/" + filename);
+  }
+  mutex_.Lock();
+}
+
+Status DBImpl::Recover(VersionEdit* edit, bool* save_manifest) {
+  // Ignore error from CreateDir since the creation of the DB is
+  // committed only when the descriptor is created, and this directory
+  // may already exist from a previous failed creation attempt.
+  env_->CreateDir(dbname_);
+  assert(db_lock_ == nullptr);
+  Status s = env_->LockFile(LockFileName(dbname_), &db_lock_);
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (!env_->FileExists(CurrentFileName(dbname_))) {
+    if (options_.create_if_missing) {
+      s = NewDB();
+      if (!s.ok()) {
+        return s;
+      }
+    } else {
+      return Status::InvalidArgument(
+          dbname_, "does not exist (create_if_missing is false)");
+    }
+  } else {
+    if (options_.error_if_exists) {
+      return Status::InvalidArgument(dbname_,
+                                     "exists (error_if_exists is true)");
+    }
+  }
+
+  s = versions_->Recover(save_manifest);
+  if (!s.ok()) {
+    return s;
+  }
+  SequenceNumber max_sequence(0);
+
+  // Recover from all newer log files than the ones named in the
+  // descriptor (new log files may have been added by the previous
+  // incarnation without registering them in the descriptor).
+  //
+  // Note that PrevLogNumber() is no longer used, but we pay
+  // attention to it in case we are recovering a database
+  // produced by an older version of leveldb.
+  const uint64_t min_log = versions_->LogNumber();
+  const uint64_t prev_log = versions_->PrevLogNumber();
+  std::vector<std::string> filenames;
+  s = env_->GetChildren(dbname_, &filenames);
+  if (!s.ok()) {
+    return s;
+  }
+  std::set<uint64_t> expected;
+  versions_->AddLiveFiles(&expected);
+  uint64_t number;
+  FileType type;
+  std::vector<uint64_t> logs;
+  for (size_t i = 0; i < filenames.size(); i++) {
+    if (ParseFileName(filenames[i], &number, &type)) {
+      expected.erase(number);
+      if (type == kLogFile && ((number >= min_log) || (number == prev_log)))
+        logs.push_back(number);
+    }
+  }
+  if (!expected.empty()) {
+    char buf[50];
+    std::snprintf(buf, sizeof(buf), "%d missing files; e.g.",
+                  static_cast<int>(expected.size()));
+    return Status::Corruption(buf, TableFileName(dbname_, *(expected.begin())));
+  }
+
+  // Recover in the order in which the logs were generated
+  std::sort(logs.begin(), logs.end());
+  for (size_t i = 0; i < logs.size(); i++) {
+    s = RecoverLogFile(logs[i], save_manifest, edit, &max_sequence);
+    if (!s.ok()) {
+      return s;
+    }
+
+    // The previous incarnation may not have written any MANIFEST
+    // records after allocating this log number.  So we manually
+    // update the file number allocation counter in VersionSet.
+    versions_->MarkFileNumberUsed(logs[i]);
+  }
+
+  if (versions_->LastSequence() < max_sequence) {
+    versions_->SetLastSequence(max_sequence);
+  }
+
+  return Status::OK();
+}
+
+Status DBImpl::RecoverLogFile(uint64_t log_number, bool* save_manifest,
+                              VersionEdit* edit,
+                              SequenceNumber* max_sequence) {
+  struct LogReporter : public log::Reader::Reporter {
+    Status* status;  // null if options_.paranoid_checks==false
+    void Corruption(size_t bytes, const Status& s) override {
+      if (this->status != nullptr && this->status->ok()) *this->status = s;
+    }
+  };
+
+  // Open the log file
+  // 顺序恢复时通过 mmap 读取，单个 block 内的记录直接从映射中写入 memtable；
+  // 并行恢复的 chunk 在下一次 Read 之后仍然要使用，只能拷贝到自己的 buffer 中
+  std::string fname = LogFileName(dbname_, log_number);
+  SequentialFile* file;
+  Status status = options_.recovery_threads > 1
+                      ? env_->NewSequentialFile(fname, &file)
+                      : env_->NewMmapSequentialFile(fname, &file);
+  if (!status.ok()) {
+    return status;
+  }
+
+  // Create the log reader.
+  LogReporter reporter;
+  reporter.status = (options_.paranoid_checks ? &status : nullptr);
+  // We intentionally make log::Reader do checksumming even if
+  // paranoid_checks==false so that corruptions cause entire commits
+  // to be skipped instead of propagating bad information (like overly
+  // large sequence numbers).
+  // recovery_threads > 1 时预读和校验在后台线程中进行，当前线程只负责写入 memtable
+  std::unique_ptr<log::Reader> reader;
+  std::unique_ptr<log::ParallelReader> parallel_reader;
+  if (options_.recovery_threads > 1) {
+    parallel_reader.reset(new log::ParallelReader(
+        file, &reporter, true /*checksum*/, options_.recovery_threads,
+        log::ParallelReader::kDefaultChunkSize, log_number));
+  } else {
+    reader.reset(new log::Reader(file, &reporter, true /*checksum*/,
+                                 0 /*initial_offset*/, log_number));
+  }
+
+  // Read all the records and add to a memtable
+  std::string scratch;
+  Slice record;
+  WriteBatch batch;
+  int compactions = 0;
+  MemTable* mem = nullptr;
+  while ((parallel_reader != nullptr
+              ? parallel_reader->ReadRecord(&record, &scratch)
+              : reader->ReadRecord(&record, &scratch)) &&
+         status.ok()) {
+    if (record.size() < 12) {
+      reporter.Corruption(record.size(),
+                          Status::Corruption("log record too small"));
+      continue;
+    }
+    WriteBatchInternal::SetContents(&batch, record);
+
+    if (mem == nullptr) {
+      mem = new MemTable(internal_comparator_, options_.arena_block_size,
+                         options_.arena_use_mmap, options_.memtable_factory);
+      mem->Ref();
+    }
+    status = WriteBatchInternal::InsertInto(&batch, mem);
+    if (!status.ok()) {
+      break;
+    }
+    const SequenceNumber last_seq = WriteBatchInternal::Sequence(&batch) +
+                                    WriteBatchInternal::Count(&batch) - 1;
+    if (last_seq > *max_sequence) {
+      *max_sequence = last_seq;
+    }
+
+    if (mem->ApproximateMemoryUsage() > options_.write_buffer_size) {
+      compactions++;
+      *save_manifest = true;
+      uint64_t file_number;
+      status = WriteLevel0Table(mem, edit, false, &file_number);
+      // 恢复期间没有后台任务，RemoveObsoleteFiles 在新的 MANIFEST 写入后才运行
+      pending_outputs_.erase(file_number);
+      mem->Unref();
+      mem = nullptr;
+      if (!status.ok()) {
+        // Reflect errors immediately so that conditions like full
+        // file-systems cause the DB::Open() to fail.
+        break;
+      }
+    }
+  }
+
+  // 先停止可能仍在读取 file 的后台线程
+  parallel_reader.reset();
+  reader.reset();
+  delete file;
+
+  // 恢复出的数据全部写成 L0 文件，日志文件在新的 MANIFEST 写入后删除
+  if (mem != nullptr) {
+    if (status.ok()) {
+      *save_manifest = true;
+      uint64_t file_number;
+      status = WriteLevel0Table(mem, edit, false, &file_number);
+      pending_outputs_.erase(file_number);
+    }
+    mem->Unref();
+  }
+
+  return status;
+}
+
+Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
+                                bool push_down, uint64_t* file_number) {
+  const uint64_t start_micros = env_->NowMicros();
+  FileMetaData meta;
+  meta.number = versions_->NewFileNumber();
+  pending_outputs_.insert(meta.number);
+  *file_number = meta.number;
+  Iterator* iter = mem->NewIterator();
+
+  // immutable memtable 不会再被修改，可以不加锁地遍历
+  Status s;
+  {
+    mutex_.Unlock();
+    s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta);
+    mutex_.Lock();
+  }
+
+  delete iter;
+
+  // Note that if file_size is zero, the file has been deleted and
+  // should not be added to the manifest.
+  int level = 0;
+  if (s.ok() && meta.file_size > 0) {
+    const Slice min_user_key = meta.smallest.user_key();
+    const Slice max_user_key = meta.largest.user_key();
+    // compaction 在进行时不把新文件放到 L0 以外的层，否则可能与 compaction 的
+    // 输出重叠。在这里(而不是构建文件之前)选择层，保证基于最新的 Version。
+    if (push_down && !background_compaction_scheduled_) {
+      level = versions_->current()->PickLevelForMemTableOutput(min_user_key,
+                                                               max_user_key);
+    }
+    edit->AddFile(level, meta.number, meta.file_size, meta.smallest,
+                  meta.largest);
+  }
+
+  CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros;
+  stats.bytes_written = meta.file_size;
+  stats_[level].Add(stats);
+  return s;
+}
+
+Status DBImpl::LogAndApply(VersionEdit* edit) {
+  while (manifest_writing_) {
+    background_work_finished_signal_.Wait();
+  }
+  // 写入 MANIFEST 之前的序列号都已经在日志中，恢复时以两者中较大的为准
+  versions_->SetLastSequence(
+      std::max(versions_->LastSequence(), queue_->LastSequence()));
+  manifest_writing_ = true;
+  Status s = versions_->LogAndApply(edit, &mutex_);
+  manifest_writing_ = false;
+  background_work_finished_signal_.SignalAll();
+  return s;
+}
+
+void DBImpl::RecordBackgroundError(const Status& s) {
+  if (bg_error_.ok()) {
+    bg_error_ = s;
+    background_work_finished_signal_.SignalAll();
+  }
+}
+
+void DBImpl::MaybeScheduleFlush() {
+  if (background_flush_scheduled_) {
+    // Already scheduled
+  } else if (shutting_down_.load(std::memory_order_acquire)) {
+    // DB is being deleted; no more background work
+  } else if (!bg_error_.ok()) {
+    // Already got an error; no more changes
+  } else if (imm_.empty()) {
+    // No work to be done
+  } else {
+    background_flush_scheduled_ = true;
+    // flush 决定了写入是否阻塞，放在高优先级线程池，不会排在 compaction 之后
+    env_->Schedule(&DBImpl::BGFlushWork, this, Env::HIGH);
+  }
+}
+
+void DBImpl::BGFlushWork(void* db) {
+  reinterpret_cast<DBImpl*>(db)->BackgroundFlushCall();
+}
+
+void DBImpl::BackgroundFlushCall() {
+  MutexLock l(&mutex_);
+  assert(background_flush_scheduled_);
+  if (shutting_down_.load(std::memory_order_acquire)) {
+    // No more background work when shutting down.
+  } else if (!bg_error_.ok()) {
+    // No more background work after a background error.
+  } else {
+    BackgroundFlush();
+  }
+
+  background_flush_scheduled_ = false;
+
+  // 一次只 flush 一个 memtable，还有剩余的就重新调度
+  MaybeScheduleFlush();
+  MaybeScheduleCompaction();
+  background_work_finished_signal_.SignalAll();
+}
+
+void DBImpl::BackgroundFlush() {
+  assert(!imm_.empty());
+  const ImmutableMemTable imm = imm_.front();
+
+  // Save the contents of the memtable as a new Table
+  VersionEdit edit;
+  uint64_t file_number;
+  Status s = WriteLevel0Table(imm.mem, &edit, true, &file_number);
+
+  if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
+    s = Status::IOError("Deleting DB during memtable flush");
+  }
+
+  // Replace immutable memtable with the generated Table
+  if (s.ok()) {
+    // 更早的日志都已经不再需要：第二老的 immutable memtable 或者当前 memtable
+    // 的日志是恢复时需要重放的第一个日志
+    edit.SetPrevLogNumber(0);
+    edit.SetLogNumber(imm_.size() > 1 ? imm_[1].log_number : logfile_number_);
+    s = LogAndApply(&edit);
+  }
+  pending_outputs_.erase(file_number);
+
+  if (s.ok()) {
+    // sstable 和 memtable 在同一次加锁中交换，读操作总能在其中一个里看到数据
+    imm_.pop_front();
+    imm.mem->Unref();
+    num_flushes_++;
+    RemoveObsoleteFiles();
+  } else {
+    RecordBackgroundError(s);
+  }
+}
+
+void DBImpl::TEST_CompactRange(int level, const Slice* begin,
+                               const Slice* end) {
+  assert(level >= 0);
+  assert(level + 1 < config::kNumLevels);
+
+  InternalKey begin_storage, end_storage;
+
+  ManualCompaction manual;
+  manual.level = level;
+  manual.done = false;
+  if (begin == nullptr) {
+    manual.begin = nullptr;
+  } else {
+    begin_storage = InternalKey(*begin, kMaxSequenceNumber, kValueTypeForSeek);
+    manual.begin = &begin_storage;
+  }
+  if (end == nullptr) {
+    manual.end = nullptr;
+  } else {
+    end_storage = InternalKey(*end, 0, static_cast<ValueType>(0));
+    manual.end = &end_storage;
+  }
+
+  MutexLock l(&mutex_);
+  while (!manual.done && !shutting_down_.load(std::memory_order_acquire) &&
+         bg_error_.ok()) {
+    if (manual_compaction_ == nullptr) {  // Idle
+      manual_compaction_ = &manual;
+      MaybeScheduleCompaction();
+    } else {  // Running either my compaction or another compaction.
+      background_work_finished_signal_.Wait();
+    }
+  }
+  // Finish current background compaction in the case where
+  // `background_work_finished_signal_` was signalled due to an error.
+  while (background_compaction_scheduled_) {
+    background_work_finished_signal_.Wait();
+  }
+  if (manual_compaction_ == &manual) {
+    // Cancel my manual compaction since we aborted early for some reason.
+    manual_compaction_ = nullptr;
+  }
+}
+
+Status DBImpl::TEST_FlushMemTable() {
+  {
+    MutexLock l(&mutex_);
+    while (bg_error_.ok() &&
+           imm_.size() >=
+               static_cast<size_t>(options_.max_write_buffer_number - 1)) {
+      background_work_finished_signal_.Wait();
+    }
+    if (!bg_error_.ok()) {
+      return bg_error_;
+    }
+    Status s = SwitchMemTable();
+    if (!s.ok()) {
+      return s;
+    }
+    MaybeScheduleFlush();
+  }
+  return TEST_WaitForFlush();
+}
+
+Status DBImpl::TEST_WaitForFlush() {
+  MutexLock l(&mutex_);
+  while (bg_error_.ok() && (!imm_.empty() || background_flush_scheduled_)) {
+    background_work_finished_signal_.Wait();
+  }
+  return bg_error_;
+}
+
+Status DBImpl::TEST_WaitForCompaction() {
+  MutexLock l(&mutex_);
+  while (bg_error_.ok() &&
+         (!imm_.empty() || background_flush_scheduled_ ||
+          background_compaction_scheduled_ || versions_->NeedsCompaction())) {
+    background_work_finished_signal_.Wait();
+  }
+  return bg_error_;
+}
+
+void DBImpl::MaybeScheduleCompaction() {
+  if (background_compaction_scheduled_) {
+    // Already scheduled
+  } else if (shutting_down_.load(std::memory_order_acquire)) {
+    // DB is being deleted; no more background work
+  } else if (!bg_error_.ok()) {
+    // Already got an error; no more changes
+  } else if (manual_compaction_ == nullptr && !versions_->NeedsCompaction()) {
+    // No work to be done
+  } else {
+    background_compaction_scheduled_ = true;
+    env_->Schedule(&DBImpl::BGCompactionWork, this, Env::LOW);
+  }
+}
+
+void DBImpl::BGCompactionWork(void* db) {
+  reinterpret_cast<DBImpl*>(db)->BackgroundCompactionCall();
+}
+
+void DBImpl::BackgroundCompactionCall() {
+  MutexLock l(&mutex_);
+  assert(background_compaction_scheduled_);
+  if (shutting_down_.load(std::memory_order_acquire)) {
+    // No more background work when shutting down.
+  } else if (!bg_error_.ok()) {
+    // No more background work after a background error.
+  } else {
+    BackgroundCompaction();
+  }
+
+  background_compaction_scheduled_ = false;
+
+  // Previous compaction may have produced too many files in a level,
+  // so reschedule another compaction if needed.
+  MaybeScheduleCompaction();
+  background_work_finished_signal_.SignalAll();
+}
+
+void DBImpl::BackgroundCompaction() {
+  // 正在提交的 flush 可能把文件放到 L0 以外的层，等它完成后再基于新的
+  // Version 选择 compaction 的输入
+  while (manifest_writing_) {
+    background_work_finished_signal_.Wait();
+  }
+
+  Compaction* c;
+  bool is_manual = (manual_compaction_ != nullptr);
+  InternalKey manual_end;
+  if (is_manual) {
+    ManualCompaction* m = manual_compaction_;
+    c = versions_->CompactRange(m->level, m->begin, m->end);
+    m->done = (c == nullptr);
+    if (c != nullptr) {
+      manual_end = c->input(0, c->num_input_files(0) - 1)->largest;
+    }
+  } else {
+    c = versions_->PickCompaction();
+  }
+
+  Status status;
+  if (c == nullptr) {
+    // Nothing to do
+  } else if (!is_manual && c->IsTrivialMove()) {
+    // Move file to next level
+    assert(c->num_input_files(0) == 1);
+    FileMetaData* f = c->input(0, 0);
+    c->edit()->RemoveFile(c->level(), f->number);
+    c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest,
+                       f->largest);
+    status = LogAndApply(c->edit());
+    if (!status.ok()) {
+      RecordBackgroundError(status);
+    }
+  } else {
+    CompactionState* compact = new CompactionState(c);
+    status = DoCompactionWork(compact);
+    if (!status.ok()) {
+      RecordBackgroundError(status);
+    }
+    CleanupCompaction(compact);
+    c->ReleaseInputs();
+    RemoveObsoleteFiles();
+  }
+  delete c;
+
+  if (is_manual) {
+    ManualCompaction* m = manual_compaction_;
+    if (!status.ok()) {
+      m->done = true;
+    }
+    if (!m->done) {
+      // We only compacted part of the requested range.  Update *m
+      // to the range that is left to be compacted.
+      m->tmp_storage = manual_end;
+      m->begin = &m->tmp_storage;
+    }
+    manual_compaction_ = nullptr;
+  }
+}
+
+void DBImpl::CleanupCompaction(CompactionState* compact) {
+  for (SubcompactionState* sub : compact->subcompactions) {
+    if (sub->builder != nullptr) {
+      // May happen if we get a shutdown call in the middle of compaction
+      sub->builder->Abandon();
+      delete sub->builder;
+    } else {
+      assert(sub->outfile == nullptr);
+    }
+    delete sub->outfile;
+    for (size_t i = 0; i < sub->outputs.size(); i++) {
+      const CompactionOutput& out = sub->outputs[i];
+      pending_outputs_.erase(out.number);
+    }
+  }
+  delete compact;
+}
+
+Status DBImpl::OpenCompactionOutputFile(SubcompactionState* sub) {
+  assert(sub != nullptr);
+  assert(sub->builder == nullptr);
+  uint64_t file_number;
+  {
+    mutex_.Lock();
+    file_number = versions_->NewFileNumber();
+    pending_outputs_.insert(file_number);
+    CompactionOutput out;
+    out.number = file_number;
+    out.smallest.Clear();
+    out.largest.Clear();
+    sub->outputs.push_back(out);
+    mutex_.Unlock();
+  }
+
+  // Make the output file
+  std::string fname = TableFileName(dbname_, file_number);
+  Status s = options_.use_direct_io_for_flush_and_compaction
+                 ? env_->NewDirectWritableFile(fname, &sub->outfile)
+                 : env_->NewWritableFile(fname, &sub->outfile);
+  if (s.ok()) {
+    sub->builder = new TableBuilder(options_, sub->outfile);
+  }
+  return s;
+}
+
+Status DBImpl::FinishCompactionOutputFile(SubcompactionState* sub,
+                                          Iterator* input) {
+  assert(sub != nullptr);
+  assert(sub->outfile != nullptr);
+  assert(sub->builder != nullptr);
+
+  const uint64_t output_number = sub->current_output()->number;
+  assert(output_number != 0);
+
+  // Check for iterator errors
+  Status s = input != nullptr ? input->status() : Status::OK();
+  const uint64_t current_entries = sub->builder->NumEntries();
+  if (s.ok()) {
+    s = sub->builder->Finish();
+  } else {
+    sub->builder->Abandon();
+  }
+  const uint64_t current_bytes = sub->builder->FileSize();
+  sub->current_output()->file_size = current_bytes;
+  sub->total_bytes += current_bytes;
+  delete sub->builder;
+  sub->builder = nullptr;
+
+  // Finish and check for file errors
+  if (s.ok()) {
+    s = sub->outfile->Sync();
+  }
+  if (s.ok()) {
+    s = sub->outfile->Close();
+  }
+  delete sub->outfile;
+  sub->outfile = nullptr;
+
+  if (s.ok() && current_entries > 0) {
+    // Verify that the table is usable
+    Iterator* iter =
+        table_cache_->NewIterator(ReadOptions(), output_number, current_bytes);
+    s = iter->status();
+    delete iter;
+  }
+  return s;
+}
+
+Status DBImpl::InstallCompactionResults(CompactionState* compact) {
+  // Add compaction outputs
+  compact->compaction->AddInputDeletions(compact->compaction->edit());
+  const int level = compact->compaction->level();
+  // 所有子 compaction 的输出在同一个 VersionEdit 中提交，读操作要么看到全部
+  // 输入，要么看到全部输出
+  for (SubcompactionState* sub : compact->subcompactions) {
+    for (size_t i = 0; i < sub->outputs.size(); i++) {
+      const CompactionOutput& out = sub->outputs[i];
+      compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size,
+                                           out.smallest, out.largest);
+    }
+  }
+  return LogAndApply(compact->compaction->edit());
+}
+
+void DBImpl::BGSubcompactionWork(void* arg) {
+  SubcompactionTask* task = reinterpret_cast<SubcompactionTask*>(arg);
+  if (!task->claimed.exchange(true, std::memory_order_acq_rel)) {
+    // compaction 线程在所有被领取的任务完成之前一直等待，db 和 sub 都有效
+    DBImpl* db = task->db;
+    db->DoSubcompactionWork(task->sub);
+    MutexLock l(&db->mutex_);
+    task->done = true;
+    db->background_work_finished_signal_.SignalAll();
+  }
+  task->Unref();
+}
+
+void DBImpl::DoSubcompactionWork(SubcompactionState* sub) {
+  CompactionState* compact = sub->compact;
+  const Comparator* ucmp = internal_comparator_.user_comparator();
+  CompactionIterator* input = new CompactionIterator(
+      versions_->MakeInputIterator(compact->compaction), ucmp,
+      compact->smallest_snapshot, compact->compaction, &sub->progress);
+
+  if (sub->has_start) {
+    InternalKey start(sub->start, kMaxSequenceNumber, kValueTypeForSeek);
+    input->Seek(start.Encode());
+  } else {
+    input->SeekToFirst();
+  }
+  Status status;
+  while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
+    Slice key = input->key();
+    if (sub->has_end && ucmp->Compare(ExtractUserKey(key), sub->end) >= 0) {
+      break;
+    }
+    if (compact->compaction->ShouldStopBefore(key, &sub->progress) &&
+        sub->builder != nullptr) {
+      status = FinishCompactionOutputFile(sub, nullptr);
+      if (!status.ok()) {
+        break;
+      }
+    }
+
+    // Open output file if necessary
+    if (sub->builder == nullptr) {
+      status = OpenCompactionOutputFile(sub);
+      if (!status.ok()) {
+        break;
+      }
+    }
+    if (sub->builder->NumEntries() == 0) {
+      sub->current_output()->smallest.DecodeFrom(key);
+    }
+    sub->current_output()->largest.DecodeFrom(key);
+    sub->builder->Add(key, input->value());
+
+    // Close output file if it is big enough
+    if (sub->builder->FileSize() >= compact->compaction->MaxOutputFileSize()) {
+      status = FinishCompactionOutputFile(sub, nullptr);
+      if (!status.ok()) {
+        break;
+      }
+    }
+
+    input->Next();
+  }
+
+  if (status.ok() && shutting_down_.load(std::memory_order_acquire)) {
+    status = Status::IOError("Deleting DB during compaction");
+  }
+  if (status.ok() && sub->builder != nullptr) {
+    status = FinishCompactionOutputFile(sub, nullptr);
+  }
+  if (status.ok()) {
+    status = input->status();
+  }
+  sub->num_dropped = input->num_dropped();
+  sub->status = status;
+  delete input;
+}
+
+Status DBImpl::DoCompactionWork(CompactionState* compact) {
+  const uint64_t start_micros = env_->NowMicros();
+  Compaction* const c = compact->compaction;
+
+  assert(versions_->NumLevelFiles(c->level()) > 0);
+  // 还没有快照，比当前序列号更老的版本都不会再被读到
+  compact->smallest_snapshot = versions_->LastSequence();
+  if (queue_ != nullptr) {
+    compact->smallest_snapshot =
+        std::max(compact->smallest_snapshot, queue_->LastSequence());
+  }
+
+  // Release mutex while we're actually doing the compaction work
+  mutex_.Unlock();
+
+  // L0 -> L1 的 compaction 涉及所有重叠的 L0 文件，是写入量大时的瓶颈，
+  // 按输入文件的数据块边界拆分为多个子 compaction 并行执行
+  std::vector<std::string> boundaries;
+  if (c->level() == 0) {
+    versions_->GetSubcompactionBoundaries(c, options_.max_subcompactions,
+                                          &boundaries);
+  }
+  for (size_t i = 0; i <= boundaries.size(); i++) {
+    compact->subcompactions.push_back(new SubcompactionState(
+        compact, i == 0 ? nullptr : &boundaries[i - 1],
+        i == boundaries.size() ? nullptr : &boundaries[i]));
+  }
+
+  std::vector<SubcompactionTask*> tasks;
+  for (size_t i = 1; i < compact->subcompactions.size(); i++) {
+    SubcompactionTask* task =
+        new SubcompactionTask(this, compact->subcompactions[i]);
+    tasks.push_back(task);
+    env_->Schedule(&DBImpl::BGSubcompactionWork, task, Env::LOW);
+  }
+  DoSubcompactionWork(compact->subcompactions[0]);
+  // 收回还没有开始的子 compaction
+  for (SubcompactionTask* task : tasks) {
+    if (!task->claimed.exchange(true, std::memory_order_acq_rel)) {
+      DoSubcompactionWork(task->sub);
+      MutexLock l(&mutex_);
+      task->done = true;
+    }
+  }
+
+  mutex_.Lock();
+  for (SubcompactionTask* task : tasks) {
+    while (!task->done) {
+      background_work_finished_signal_.Wait();
+    }
+    task->Unref();
+  }
+
+  Status status;
+  CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros;
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < c->num_input_files(which); i++) {
+      stats.bytes_read += c->input(which, i)->file_size;
+    }
+  }
+  for (SubcompactionState* sub : compact->subcompactions) {
+    stats.bytes_written += sub->total_bytes;
+    compaction_dropped_entries_ += sub->num_dropped;
+    if (status.ok()) {
+      status = sub->status;
+    }
+  }
+  stats_[c->level() + 1].Add(stats);
+  if (compact->subcompactions.size() > 1) {
+    num_subcompactions_ += compact->subcompactions.size();
+  }
+
+  if (status.ok()) {
+    status = InstallCompactionResults(compact);
+  }
+  return status;
+}
+
+Status DBImpl::Get(const ReadOptions& options, const Slice& key,
+                   std::string* value) {
+  // 没有命中 memtable 时数据直接写入 *value；命中时再拷贝一次
+  PinnableSlice pinnable(value);
+  Status s = Get(options, key, &pinnable);
+  if (s.ok() && pinnable.IsPinned()) {
+    value->assign(pinnable.data(), pinnable.size());
+  }
+  return s;
+}
+
+Status DBImpl::Get(const ReadOptions& options, const Slice& key,
+                   PinnableSlice* value) {
+  value->Reset();
+  Status s;
+  MutexLock l(&mutex_);
+  const SequenceNumber snapshot = queue_->LastSequence();
+
+  // 持有引用，避免在查找过程中 memtable 被 flush 或者 Version 被替换之后释放
+  MemTable* mem = mem_;
+  std::vector<MemTable*> imms;
+  Version* current = versions_->current();
+  mem->Ref();
+  for (const ImmutableMemTable& imm : imm_) {
+    imms.push_back(imm.mem);
+    imm.mem->Ref();
+  }
+  current->Ref();
+
+  bool have_stat_update = false;
+  Version::GetStats stats;
+
+  // Unlock while reading from files and memtables
+  {
+    mutex_.Unlock();
+    // First look in the memtable, then in the immutable memtables (newest
+    // first), then in the tables.
+    LookupKey lkey(key, snapshot);
+    bool done = mem->Get(lkey, value, &s);
+    for (auto iter = imms.rbegin(); !done && iter != imms.rend(); ++iter) {
+      done = (*iter)->Get(lkey, value, &s);
+    }
+    if (!done) {
+      s = current->Get(options, lkey, value->GetSelf(), &stats);
+      if (s.ok()) {
+        value->PinSelf();
+      }
+      have_stat_update = true;
+    }
+    mutex_.Lock();
+  }
+
+  // 查找经过但没有命中的文件消耗一次 seek 预算，用完时触发对它的 compaction
+  if (have_stat_update && current->UpdateStats(stats)) {
+    MaybeScheduleCompaction();
+  }
+  mem->Unref();
+  for (MemTable* imm : imms) {
+    imm->Unref();
+  }
+  current->Unref();
+  return s;
+}
+
+Status DBImpl::Put(const WriteOptions& o, const Slice& key, const Slice& val) {
+  return DB::Put(o, key, val);
+}
+
+Status DBImpl::Delete(const WriteOptions& options, const Slice& key) {
+  return DB::Delete(options, key);
+}
+
+Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
+  // 只有在 memtable 或 L0 文件过多时才会在这里等待后台任务。切换 memtable 之后
+  // 到写入之间 mem_ 可能被其他写入继续填充，write_buffer_size 因此是一个软上限。
+  Status s = MakeRoomForWrite();
+  if (s.ok()) {
+    s = queue_->Write(options, updates);
+  }
+  return s;
+}
+
+Status DBImpl::MakeRoomForWrite() {
+  MutexLock l(&mutex_);
+  bool allow_delay = true;
+  uint64_t stall_start = 0;
+  Status s;
+  while (true) {
+    if (!bg_error_.ok()) {
+      // Yield previous error
+      s = bg_error_;
+      break;
+    } else if (allow_delay && versions_->NumLevelFiles(0) >=
+                                  config::kL0_SlowdownWritesTrigger) {
+      // We are getting close to hitting a hard limit on the number of
+      // L0 files.  Rather than delaying a single write by several
+      // seconds when we hit the hard limit, start delaying each
+      // individual write by 1ms to reduce latency variance.  Also,
+      // this delay hands over some CPU to the compaction thread in
+      // case it is sharing the same core as the writer.
+      const uint64_t start = env_->NowMicros();
+      mutex_.Unlock();
+      env_->SleepForMicroseconds(1000);
+      allow_delay = false;  // Do not delay a single write more than once
+      mutex_.Lock();
+      stall_micros_ += env_->NowMicros() - start;
+    } else if (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size) {
+      // There is room in current memtable
+      break;
+    } else if (imm_.size() >=
+               static_cast<size_t>(options_.max_write_buffer_number - 1)) {
+      // 已经有足够多的 memtable 在等待 flush，只能等待
+      if (stall_start == 0) {
+        stall_start = env_->NowMicros();
+      }
+      background_work_finished_signal_.Wait();
+    } else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
+      // There are too many level-0 files.
+      if (stall_start == 0) {
+        stall_start = env_->NowMicros();
+      }
+      background_work_finished_signal_.Wait();
+    } else {
+      // Attempt to switch to a new memtable and trigger flush of old
+      s = SwitchMemTable();
+      if (!s.ok()) {
+        break;
+      }
+      MaybeScheduleFlush();
+    }
+  }
+  if (stall_start != 0) {
+    stall_micros_ += env_->NowMicros() - stall_start;
+  }
+  return s;
+}
+
+Status DBImpl::SwitchMemTable() {
+  uint64_t new_log_number = versions_->NewFileNumber();
+  WritableFile* lfile = nullptr;
+  log::Writer* new_log = nullptr;
+  Status s = NewLogFile(new_log_number, &lfile, &new_log);
+  if (!s.ok()) {
+    // Avoid chewing through file number space in a tight loop.
+    versions_->ReuseFileNumber(new_log_number);
+    return s;
+  }
+  MemTable* new_mem =
+      new MemTable(internal_comparator_, options_.arena_block_size,
+                   options_.arena_use_mmap, options_.memtable_factory);
+  new_mem->Ref();
+
+  // 等待正在写入旧 memtable 的写入组完成。写入组不会获取 mutex_，不会死锁。
+  queue_->SwitchMemTable(new_log, lfile, new_mem);
+
+  delete log_;
+  s = logfile_->Close();
+  delete logfile_;
+  imm_.push_back(ImmutableMemTable{mem_, logfile_number_});
+  mem_ = new_mem;
+  log_ = new_log;
+  logfile_ = lfile;
+  logfile_number_ = new_log_number;
+  return s;
+}
+
+Status DBImpl::NewLogFile(uint64_t log_number, WritableFile** file,
+                          log::Writer** writer) {
+  const std::string fname = LogFileName(dbname_, log_number);
+  Status s;
+  if (!recycle_logs_.empty()) {
+    const uint64_t old_number = recycle_logs_.front();
+    recycle_logs_.pop_front();
+    s = env_->ReuseWritableFile(fname, LogFileName(dbname_, old_number), file);
+    if (s.ok()) {
+      // 回收的日志同步写入时 fdatasync 不会更新元数据，重命名必须在写入任何
+      // 记录之前持久化。否则掉电后目录中仍是旧的文件名，恢复时它被当作过期的
+      // 日志删除，已经确认同步的写入随之丢失。
+      s = env_->SyncDir(dbname_);
+      if (!s.ok()) {
+        delete *file;
+        *file = nullptr;
+        return s;
+      }
+    } else {
+      // 例如旧文件已经被另一个 RemoveObsoleteFiles 删除，改为新建
+      s = env_->NewWritableFile(fname, file);
+    }
+  } else {
+    s = env_->NewWritableFile(fname, file);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (options_.preallocate_log_files) {
+    // 预分配只是优化，失败时照常写入
+    (*file)->Preallocate(options_.write_buffer_size +
+                         options_.write_buffer_size / 10);
+  }
+  *writer = new log::Writer(*file, log_number,
+                            options_.recycle_log_file_num > 0);
+  return s;
+}
+
+bool DBImpl::GetProperty(const Slice& property, std::string* value) {
+  value->clear();
+
+  MutexLock l(&mutex_);
+  Slice in = property;
+  Slice prefix("leveldb.");
+  if (!in.starts_with(prefix)) return false;
+  in.remove_prefix(prefix.size());
+
+  if (in.starts_with("num-files-at-level")) {
+    in.remove_prefix(strlen("num-files-at-level"));
+    uint64_t level;
+    bool ok = ConsumeDecimalNumber(&in, &level) && in.empty();
+    if (!ok || level >= config::kNumLevels) {
+      return false;
+    } else {
+      *value = NumberToString(versions_->NumLevelFiles(static_cast<int>(level)));
+      return true;
+    }
+  } else if (in == "stats") {
+    char buf[200];
+    std::snprintf(buf, sizeof(buf),
+                  "                               Compactions\n"
+                  "Level  Files Size(MB) Time(sec) Read(MB) Write(MB)\n"
+                  "--------------------------------------------------\n");
+    value->append(buf);
+    for (int level = 0; level < config::kNumLevels; level++) {
+      int files = versions_->NumLevelFiles(level);
+      if (stats_[level].micros > 0 || files > 0) {
+        std::snprintf(buf, sizeof(buf), "%3d %8d %8.0f %9.0f %8.0f %9.0f\n",
+                      level, files, versions_->NumLevelBytes(level) / 1048576.0,
+                      stats_[level].micros / 1e6,
+                      stats_[level].bytes_read / 1048576.0,
+                      stats_[level].bytes_written / 1048576.0);
+        value->append(buf);
+      }
+    }
+    return true;
+  } else if (in == "sstables") {
+    *value = versions_->current()->DebugString();
+    return true;
+  } else if (in == "num-immutable-mem-table") {
+    *value = NumberToString(imm_.size());
+    return true;
+  } else if (in == "num-files") {
+    uint64_t files = 0;
+    for (int level = 0; level < config::kNumLevels; level++) {
+      files += versions_->NumLevelFiles(level);
+    }
+    *value = NumberToString(files);
+    return true;
+  } else if (in == "num-flushes") {
+    *value = NumberToString(num_flushes_);
+    return true;
+  } else if (in == "compaction-dropped-entries") {
+    *value = NumberToString(compaction_dropped_entries_);
+    return true;
+  } else if (in == "num-subcompactions") {
+    *value = NumberToString(num_subcompactions_);
+    return true;
+  } else if (in == "write-stall-micros") {
+    *value = NumberToString(stall_micros_);
+    return true;
+  } else if (in == "approximate-memory-usage") {
+    size_t total_usage = mem_->ApproximateMemoryUsage();
+    for (const ImmutableMemTable& imm : imm_) {
+      total_usage += imm.mem->ApproximateMemoryUsage();
+    }
+    *value = NumberToString(total_usage);
+    return true;
+  }
+
+  return false;
+}
+
+// Default implementations of convenience methods that subclasses of DB
+// can call if they wish
+Status DB::Get(const ReadOptions& options, const Slice& key,
+               PinnableSlice* value) {
+  value->Reset();
+  Status s = Get(options, key, value->GetSelf());
+  if (s.ok()) {
+    value->PinSelf();
+  }
+  return s;
+}
+
+Status DB::Put(const WriteOptions& opt, const Slice& key, const Slice& value) {
+  WriteBatch batch;
+  batch.Put(key, value);
+  return Write(opt, &batch);
+}
+
+Status DB::Delete(const WriteOptions& opt, const Slice& key) {
+  WriteBatch batch;
+  batch.Delete(key);
+  return Write(opt, &batch);
+}
+
+DB::~DB() = default;
+
+Status DB::Open(const Options& options, const std::string& dbname,
+                DB** dbptr) {
+  *dbptr = nullptr;
+
+  DBImpl* impl = new DBImpl(options, dbname);
+  impl->mutex_.Lock();
+  VersionEdit edit;
+  // Recover handles create_if_missing, error_if_exists
+  bool save_manifest = false;
+  Status s = impl->Recover(&edit, &save_manifest);
+  if (s.ok()) {
+    // Create new log and a corresponding memtable.
+    uint64_t new_log_number = impl->versions_->NewFileNumber();
+    impl->min_recyclable_log_ = new_log_number;
+    WritableFile* lfile;
+    log::Writer* writer;
+    s = impl->NewLogFile(new_log_number, &lfile, &writer);
+    if (s.ok()) {
+      edit.SetLogNumber(new_log_number);
+      impl->logfile_ = lfile;
+      impl->logfile_number_ = new_log_number;
+      impl->log_ = writer;
+      impl->mem_ = new MemTable(impl->internal_comparator_,
+                                impl->options_.arena_block_size,
+                                impl->options_.arena_use_mmap,
+                                impl->options_.memtable_factory);
+      impl->mem_->Ref();
+      impl->queue_ = new WriteQueue(impl->log_, impl->logfile_, impl->mem_,
+                                    impl->versions_->LastSequence());
+    }
+  }
+  if (s.ok() && save_manifest) {
+    edit.SetPrevLogNumber(0);  // No older logs needed after recovery.
+    edit.SetLogNumber(impl->logfile_number_);
+    s = impl->LogAndApply(&edit);
+  }
+  if (s.ok()) {
+    impl->RemoveObsoleteFiles();
+    impl->MaybeScheduleCompaction();
+  }
+  impl->mutex_.Unlock();
+  if (s.ok()) {
+    assert(impl->mem_ != nullptr);
+    *dbptr = impl;
+  } else {
+    delete impl;
+  }
+  return s;
+}
+
+Status DestroyDB(const std::string& dbname, const Options& options) {
+  Env* env = options.env;
+  std::vector<std::string> filenames;
+  Status result = env->GetChildren(dbname, &filenames);
+  if (!result.ok()) {
+    // Ignore error in case directory does not exist
+    return Status::OK();
+  }
+
+  FileLock* lock;
+  const std::string lockname = LockFileName(dbname);
+  result = env->LockFile(lockname, &lock);
+  if (result.ok()) {
+    uint64_t number;
+    FileType type;
+    for (size_t i = 0; i < filenames.size(); i++) {
+      if (ParseFileName(filenames[i], &number, &type) &&
+          type != kDBLockFile) {  // Lock file will be deleted at end
+        Status del = env->RemoveFile(dbname + "/" + filenames[i]);
+        if (result.ok() && !del.ok()) {
+          result = del;
+        }
+      }
+    }
+    env->UnlockFile(lock);  // Ignore error since state is already gone
+    env->RemoveFile(lockname);
+    env->RemoveDir(dbname);  // Ignore error in case dir contains other files
+  }
+  return result;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,239 @@
+#ifndef STORAGE_LEVELDB_DB_DB_IMPL_H_
+#define STORAGE_LEVELDB_DB_DB_IMPL_H_
+
+#include <atomic>
+#include <deque>
+#include <set>
+#include <string>
+
+#include "db.h"
+#include "dbformat.h"
+#include "mutex.h"
+
+namespace leveldb {
+
+class FileLock;
+class Iterator;
+class MemTable;
+class TableCache;
+class Version;
+class VersionEdit;
+class VersionSet;
+class WritableFile;
+class WriteQueue;
+
+namespace log {
+class Writer;
+}
+
+// 写入经过 WriteQueue 组提交进入活跃 memtable(mem_)。mem_ 的内存用量超过
+// write_buffer_size 时，它连同对应的日志文件一起变为只读，放入 imm_，并通过
+// Env::Schedule 在 HIGH 线程池中调度一个 flush 任务把它写成 sstable；
+// 新的写入进入新的 memtable 和新的日志文件。只有 imm_ 中已经有
+// max_write_buffer_number - 1 个 memtable 在等待 flush 时写入才会阻塞。
+//
+// sstable 按层组织(config::kNumLevels 层)，由 VersionSet 记录在 MANIFEST 中。
+// 某一层的大小超过上限，或者某个文件被无效查找的次数过多时，在 LOW 线程池
+// 中调度 compaction，把它与下一层中重叠的文件合并。
+class DBImpl : public DB {
+ public:
+  DBImpl(const Options& options, const std::string& dbname);
+
+  DBImpl(const DBImpl&) = delete;
+  DBImpl& operator=(const DBImpl&) = delete;
+
+  ~DBImpl() override;
+
+  // Implementations of the DB interface
+  Status Put(const WriteOptions&, const Slice& key,
+             const Slice& value) override;
+  Status Delete(const WriteOptions&, const Slice& key) override;
+  Status Write(const WriteOptions& options, WriteBatch* updates) override;
+  Status Get(const ReadOptions& options, const Slice& key,
+             std::string* value) override;
+  Status Get(const ReadOptions& options, const Slice& key,
+             PinnableSlice* value) override;
+  bool GetProperty(const Slice& property, std::string* value) override;
+
+  // Extra methods (for testing) that are not in the public DB interface
+
+  // Compact any files in the named level that overlap [*begin,*end]
+  void TEST_CompactRange(int level, const Slice* begin, const Slice* end);
+
+  // 把当前的 memtable 切换为 immutable(即使它没有写满)，并等待所有
+  // immutable memtable flush 完成。
+  Status TEST_FlushMemTable();
+
+  // 等待所有已经切换出去的 immutable memtable flush 完成
+  Status TEST_WaitForFlush();
+
+  // 等待后台 compaction 全部完成(不再需要 compaction)
+  Status TEST_WaitForCompaction();
+
+ private:
+  friend class DB;
+  struct CompactionOutput;
+  struct CompactionState;
+  struct SubcompactionState;
+  struct SubcompactionTask;
+
+  // 一个等待 flush 的 memtable，以及保存其内容的日志文件
+  struct ImmutableMemTable {
+    MemTable* mem;
+    uint64_t log_number;
+  };
+
+  // Information for a manual compaction
+  struct ManualCompaction {
+    int level;
+    bool done;
+    const InternalKey* begin;  // null means beginning of key range
+    const InternalKey* end;    // null means end of key range
+    InternalKey tmp_storage;   // Used to keep track of compaction progress
+  };
+
+  // Per level compaction stats.  stats_[level] stores the stats for
+  // compactions that produced data for the specified "level".
+  struct CompactionStats {
+    CompactionStats() : micros(0), bytes_read(0), bytes_written(0) {}
+
+    void Add(const CompactionStats& c) {
+      this->micros += c.micros;
+      this->bytes_read += c.bytes_read;
+      this->bytes_written += c.bytes_written;
+    }
+
+    int64_t micros;
+    int64_t bytes_read;
+    int64_t bytes_written;
+  };
+
+  Status NewDB();
+
+  // Recover the descriptor from persistent storage.  May do a significant
+  // amount of work to recover recently logged updates.  Any changes to
+  // be made to the descriptor are added to *edit.
+  Status Recover(VersionEdit* edit, bool* save_manifest);
+
+  Status RecoverLogFile(uint64_t log_number, bool* save_manifest,
+                        VersionEdit* edit, SequenceNumber* max_sequence);
+
+  // 把 mem 写成一个 sstable 并记录到 *edit 中。push_down 为 true 且没有
+  // compaction 在进行时，如果不与其他文件重叠，可以直接放到更高的层。
+  // 新文件的编号存入 *file_number 并留在 pending_outputs_ 中，调用者在 edit
+  // 提交之后再移除，否则另一个线程的 RemoveObsoleteFiles 会把它当作垃圾删除。
+  // REQUIRES: mutex_ 已加锁，构建文件期间释放锁
+  Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, bool push_down,
+                          uint64_t* file_number);
+
+  // flush 和 compaction 在不同的线程中提交 VersionEdit，这里保证同一时间只有
+  // 一个 LogAndApply 在进行。REQUIRES: mutex_ 已加锁
+  Status LogAndApply(VersionEdit* edit);
+
+  // Delete any unneeded files and stale in-memory entries.
+  void RemoveObsoleteFiles();
+
+  // 确保 mem_ 还有空间：写满时切换 memtable，immutable memtable 或 L0 文件
+  // 过多时等待后台任务。
+  Status MakeRoomForWrite();
+
+  // 把 mem_ 和当前的日志文件变为 immutable，之后的写入进入新的 memtable 和日志。
+  // REQUIRES: mutex_ 已加锁
+  Status SwitchMemTable();
+
+  // 创建编号为 log_number 的日志文件和它的 writer：有保留的旧日志时回收它，
+  // 否则新建。按选项预分配空间。REQUIRES: mutex_ 已加锁
+  Status NewLogFile(uint64_t log_number, WritableFile** file,
+                    log::Writer** writer);
+
+  void RecordBackgroundError(const Status& s);
+
+  // REQUIRES: mutex_ 已加锁
+  void MaybeScheduleFlush();
+  static void BGFlushWork(void* db);
+  void BackgroundFlushCall();
+
+  // 把最老的 immutable memtable 写成 sstable。
+  // REQUIRES: mutex_ 已加锁，imm_ 不为空
+  void BackgroundFlush();
+
+  // REQUIRES: mutex_ 已加锁
+  void MaybeScheduleCompaction();
+  static void BGCompactionWork(void* db);
+  void BackgroundCompactionCall();
+  void BackgroundCompaction();
+  void CleanupCompaction(CompactionState* compact);
+  Status DoCompactionWork(CompactionState* compact);
+
+  // 归并 sub 负责的 key 范围并写出输出文件，结果存入 sub->status。
+  // 不持有 mutex_，多个子 compaction 可以并行执行。
+  void DoSubcompactionWork(SubcompactionState* sub);
+  static void BGSubcompactionWork(void* task);
+
+  Status OpenCompactionOutputFile(SubcompactionState* sub);
+  Status FinishCompactionOutputFile(SubcompactionState* sub, Iterator* input);
+  Status InstallCompactionResults(CompactionState* compact);
+
+  // Constant after construction
+  Env* const env_;
+  const InternalKeyComparator internal_comparator_;
+  const InternalFilterPolicy internal_filter_policy_;
+  const Options options_;  // options_.comparator == &internal_comparator_
+  const std::string dbname_;
+
+  // table_cache_ provides its own synchronization
+  TableCache* const table_cache_;
+
+  // Lock over the persistent DB state.  Non-null iff successfully acquired.
+  FileLock* db_lock_;
+
+  // State below is protected by mutex_
+  Mutex mutex_;
+  std::atomic<bool> shutting_down_;
+  CondVar background_work_finished_signal_;
+  MemTable* mem_;
+  std::deque<ImmutableMemTable> imm_;  // 等待 flush 的 memtable，最老的在前
+  WritableFile* logfile_;
+  uint64_t logfile_number_;
+  log::Writer* log_;
+  WriteQueue* queue_;
+  // 保留用于回收的旧日志文件号，最老的在前(options_.recycle_log_file_num)
+  std::deque<uint64_t> recycle_logs_;
+  // 本次打开之后创建的第一个日志文件号。只有不小于它的日志一定是 recyclable
+  // 格式，可以回收
+  uint64_t min_recyclable_log_;
+
+  // Set of table files to protect from deletion because they are
+  // part of ongoing compactions.
+  std::set<uint64_t> pending_outputs_;
+
+  // Has a background flush / compaction been scheduled or is running?
+  bool background_flush_scheduled_;
+  bool background_compaction_scheduled_;
+
+  // 有一个 LogAndApply 正在写 MANIFEST(此时 mutex_ 被释放)
+  bool manifest_writing_;
+
+  ManualCompaction* manual_compaction_;
+
+  VersionSet* const versions_;
+
+  // Have we encountered a background error in paranoid mode?
+  Status bg_error_;
+
+  CompactionStats stats_[config::kNumLevels];
+  uint64_t num_flushes_;
+  uint64_t stall_micros_;
+  uint64_t compaction_dropped_entries_;
+  uint64_t num_subcompactions_;  // 被拆分的 compaction 中执行的子 compaction 数
+};
+
+// Sanitize db options：换成 internal key 的比较器和过滤器，并把参数限制在合理范围内。
+Options SanitizeOptions(const std::string& db,
+                        const InternalKeyComparator* icmp,
+                        const InternalFilterPolicy* ipolicy,
+                        const Options& src);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_DB_IMPL_H_
@@ -0,0 +1,540 @@
+#ifndef INLINE_SKIPLIST_H_
+#define INLINE_SKIPLIST_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <thread>
+
+#include "allocator.h"
+#include "random.h"
+
+namespace leveldb
+{
+
+/*
+* key 内联在节点中的跳表，key 为变长的字节串(const char*)。
+* SkipList<const char*> 的节点只保存指向 key 的指针，每次比较都要跳到另一块内存读取 key；
+* 这里一个节点只占一次分配，内存布局为：
+*
+*     next_[height-1] ... next_[1] | next_[0] | prefix | key bytes
+*                                  ^ Node*
+*
+* 高层的后继指针放在 Node 之前(负偏移)，第 0 层指针、key 前缀与 key 本身紧挨在一起，
+* 在第 0 层比较时通常只访问一条 cache line。
+*
+* prefix 为 Comparator::KeyPrefix 计算出的 64 位前缀，要求满足：
+* KeyPrefix(a) < KeyPrefix(b) 时 a < b。前缀不同时直接比较前缀，相同时才调用完整比较，
+* 大多数比较不需要解析 key。不能提供有序前缀的比较器让 KeyPrefix 恒返回 0 即可。
+*
+* 插入分两步：AllocateKey 分配节点并返回 key 的存储位置，调用者写入 key 之后再调用
+* Insert/InsertConcurrently。线程安全要求与 SkipList 相同。
+*/
+
+template <class Comparator>
+class InlineSkipList
+{
+private:
+    struct Node;
+    enum { kMaxHeight = 12 };   // 可以增长到的最大高度
+
+public:
+    // 节点内存从 allocator 分配；使用 InsertConcurrently 时 allocator 必须是线程安全的
+    explicit InlineSkipList(Comparator cmp, Allocator* allocator);
+
+    InlineSkipList(const InlineSkipList&) = delete;
+    InlineSkipList& operator=(const InlineSkipList&) = delete;
+
+    // 分配一个能容纳 key_size 字节 key 的节点，返回 key 的存储位置。
+    // 节点的高度在这里随机决定，可以被多个线程同时调用。
+    char* AllocateKey(size_t key_size);
+
+    // 插入 AllocateKey 返回的 key，插入前确保 list 中没有与之相等的 key
+    void Insert(const char* key);
+    // 与 Insert 相同，但允许多个线程同时调用，每一层通过 CAS 链接新节点
+    void InsertConcurrently(const char* key);
+    // Returns true iff an entry that compares equal to key is in the list.
+    bool Contains(const char* key) const;
+
+    // 跳表迭代器，用于遍历
+    class Iterator
+    {
+    public:
+        explicit Iterator(const InlineSkipList* list);
+        bool Valid() const;
+        const char* key() const;
+        void Next();
+        void Prev();
+        void Seek(const char* target);
+        void SeekToFirst();
+        void SeekToLast();
+    private:
+        const InlineSkipList* list_;
+        Node* node_;
+    };
+
+    // 按升序依次定位一批 key 的迭代器(finger search)，见 SkipList::FingerIterator
+    class FingerIterator
+    {
+    public:
+        explicit FingerIterator(const InlineSkipList* list);
+        bool Valid() const;
+        const char* key() const;
+        void Seek(const char* target);  // target 必须不小于上一次的 target
+    private:
+        const InlineSkipList* list_;
+        Node* node_;
+        int height_;
+        Node* finger_[kMaxHeight];
+    };
+
+private:
+    inline int GetMaxHeight() const
+    {
+        return max_height_.load(std::memory_order_relaxed);
+    }
+
+    Node* AllocateNode(size_t key_size, int height);
+    int RandomHeight();
+    bool Equal(const char* a, const char* b) const { return (compare_(a, b) == 0); }
+    // key(前缀为 key_prefix)是否大于 n 中的 key，n 为 nullptr 时返回 false
+    bool KeyIsAfterNode(const char* key, uint64_t key_prefix, Node* n) const;
+    // 找到第0层大于等于key的节点，没有返回nullptr；prev 不为 nullptr 时记录每一层的前驱
+    Node* FindGreaterOrEqual(const char* key, Node** prev) const;
+    // 返回跳表第0层最后一个小于key的节点
+    Node* FindLessThan(const char* key) const;
+    // 返回跳表第0层的尾部节点
+    Node* FindLast() const;
+    // 从 before 开始在第 level 层向后查找 key 的插入位置
+    void FindSpliceForLevel(const char* key, uint64_t key_prefix, Node* before,
+                            int level, Node** out_prev, Node** out_next) const;
+
+private:
+    Comparator const compare_;
+    Allocator* const allocator_;
+    Node* const head_;
+    std::atomic<int> max_height_;
+};
+
+template <class Comparator>
+struct InlineSkipList<Comparator>::Node
+{
+    // key 紧跟在 Node 之后
+    const char* Key() const { return reinterpret_cast<const char*>(this + 1); }
+
+    // 第 n 层的后继位于 next_[0] 之前第 n 个位置
+    Node* Next(int n)
+    {
+        assert(n >= 0);
+        return (&next_[0] - n)->load(std::memory_order_acquire);
+    }
+    void SetNext(int n, Node* x)
+    {
+        assert(n >= 0);
+        (&next_[0] - n)->store(x, std::memory_order_release);
+    }
+    Node* NoBarrier_Next(int n)
+    {
+        assert(n >= 0);
+        return (&next_[0] - n)->load(std::memory_order_relaxed);
+    }
+    void NoBarrier_SetNext(int n, Node* x)
+    {
+        assert(n >= 0);
+        (&next_[0] - n)->store(x, std::memory_order_relaxed);
+    }
+    bool CASNext(int n, Node* expected, Node* x)
+    {
+        assert(n >= 0);
+        return (&next_[0] - n)->compare_exchange_strong(expected, x,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed);
+    }
+
+    // AllocateKey 到 Insert 之间节点还没有链接，高度暂存在 next_[0] 中
+    void StashHeight(int height)
+    {
+        next_[0].store(reinterpret_cast<Node*>(static_cast<intptr_t>(height)),
+                       std::memory_order_relaxed);
+    }
+    int UnstashHeight() const
+    {
+        return static_cast<int>(reinterpret_cast<intptr_t>(
+            next_[0].load(std::memory_order_relaxed)));
+    }
+
+    std::atomic<Node*> next_[1];    // 第 0 层的后继，高层的后继在它之前
+    uint64_t prefix;                // key 的有序前缀，Insert 时计算
+};
+
+template <class Comparator>
+typename InlineSkipList<Comparator>::Node*
+    InlineSkipList<Comparator>::AllocateNode(size_t key_size, int height)
+{
+    const size_t prefix_bytes = sizeof(std::atomic<Node*>) * (height - 1);
+    char* raw = allocator_->AllocateAligned(prefix_bytes + sizeof(Node) + key_size);
+    Node* x = reinterpret_cast<Node*>(raw + prefix_bytes);
+    new (&x->next_[0]) std::atomic<Node*>(nullptr);
+    for (int i = 1; i < height; i++)
+    {
+        new (&x->next_[0] - i) std::atomic<Node*>(nullptr);
+    }
+    x->prefix = 0;
+    return x;
+}
+
+template <class Comparator>
+char* InlineSkipList<Comparator>::AllocateKey(size_t key_size)
+{
+    const int height = RandomHeight();
+    Node* x = AllocateNode(key_size, height);
+    x->StashHeight(height);
+    return const_cast<char*>(x->Key());
+}
+
+template <class Comparator>
+int InlineSkipList<Comparator>::RandomHeight()
+{
+    // AllocateKey 可能被多个线程同时调用，每个线程使用自己的随机数生成器
+    static thread_local Random rnd(static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id())));
+    static const unsigned int kBranching = 4;
+    int height = 1;
+    while (height < kMaxHeight && rnd.OneIn(kBranching))
+    {
+        height++;
+    }
+    return height;
+}
+
+template <class Comparator>
+inline bool InlineSkipList<Comparator>::KeyIsAfterNode(const char* key, uint64_t key_prefix,
+                                                       Node* n) const
+{
+    if (n == nullptr)
+    {
+        return false;
+    }
+    // 前缀不同时可以直接得出结果，不需要访问完整的 key
+    if (n->prefix != key_prefix)
+    {
+        return n->prefix < key_prefix;
+    }
+    return compare_(n->Key(), key) < 0;
+}
+
+template <class Comparator>
+typename InlineSkipList<Comparator>::Node*
+    InlineSkipList<Comparator>::FindGreaterOrEqual(const char* key, Node** prev) const
+{
+    const uint64_t key_prefix = compare_.KeyPrefix(key);
+    Node* x = head_;
+    int level = GetMaxHeight() - 1;
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (KeyIsAfterNode(key, key_prefix, next))
+        {
+            x = next;
+        }
+        else
+        {
+            if (prev != nullptr) prev[level] = x;
+            if (level == 0)
+            {
+                return next;
+            }
+            level--;
+        }
+    }
+}
+
+template <class Comparator>
+typename InlineSkipList<Comparator>::Node*
+    InlineSkipList<Comparator>::FindLessThan(const char* key) const
+{
+    const uint64_t key_prefix = compare_.KeyPrefix(key);
+    Node* x = head_;
+    int level = GetMaxHeight() - 1;
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (KeyIsAfterNode(key, key_prefix, next))
+        {
+            x = next;
+        }
+        else
+        {
+            if (level == 0)
+            {
+                return x;
+            }
+            level--;
+        }
+    }
+}
+
+template <class Comparator>
+typename InlineSkipList<Comparator>::Node* InlineSkipList<Comparator>::FindLast() const
+{
+    Node* x = head_;
+    int level = GetMaxHeight() - 1;
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (next == nullptr)
+        {
+            if (level == 0)
+            {
+                return x;
+            }
+            level--;
+        }
+        else
+        {
+            x = next;
+        }
+    }
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::FindSpliceForLevel(const char* key, uint64_t key_prefix,
+                                                    Node* before, int level,
+                                                    Node** out_prev, Node** out_next) const
+{
+    Node* x = before;
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (KeyIsAfterNode(key, key_prefix, next))
+        {
+            x = next;
+        }
+        else
+        {
+            *out_prev = x;
+            *out_next = next;
+            return;
+        }
+    }
+}
+
+template <class Comparator>
+InlineSkipList<Comparator>::InlineSkipList(Comparator cmp, Allocator* allocator)
+    : compare_(cmp),
+    allocator_(allocator),
+    head_(AllocateNode(0, kMaxHeight)),
+    max_height_(1)
+{
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::Insert(const char* key)
+{
+    Node* x = reinterpret_cast<Node*>(const_cast<char*>(key)) - 1;
+    const int height = x->UnstashHeight();
+    x->prefix = compare_.KeyPrefix(key);
+
+    Node* prev[kMaxHeight];
+    Node* next = FindGreaterOrEqual(key, prev);
+    assert(next == nullptr || !Equal(key, next->Key()));
+    (void)next;
+
+    if (height > GetMaxHeight())
+    {
+        for (int i = GetMaxHeight(); i < height; i++)
+        {
+            prev[i] = head_;
+        }
+        // 并发读看到新高度但节点尚未链接时读到 nullptr，会继续往下一层查找，见 SkipList::Insert
+        max_height_.store(height, std::memory_order_relaxed);
+    }
+
+    // 先设置本节点的后继，再把它链接到前驱之后，保证并发读的正确性
+    for (int i = 0; i < height; i++)
+    {
+        x->NoBarrier_SetNext(i, prev[i]->NoBarrier_Next(i));
+        prev[i]->SetNext(i, x);
+    }
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::InsertConcurrently(const char* key)
+{
+    Node* x = reinterpret_cast<Node*>(const_cast<char*>(key)) - 1;
+    const int height = x->UnstashHeight();
+    const uint64_t key_prefix = compare_.KeyPrefix(key);
+    x->prefix = key_prefix;
+
+    // 流程与 SkipList::InsertConcurrently 相同：先查找各层前驱，抬高 max_height_，
+    // 再从第 0 层往上逐层 CAS 链接，失败时从 prev[i] 向后修正
+    int max_height = GetMaxHeight();
+    Node* prev[kMaxHeight];
+    FindGreaterOrEqual(key, prev);
+    for (int i = max_height; i < height; i++)
+    {
+        prev[i] = head_;
+    }
+    while (height > max_height)
+    {
+        if (max_height_.compare_exchange_weak(max_height, height,
+                                              std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < height; i++)
+    {
+        while (true)
+        {
+            Node* next;
+            FindSpliceForLevel(key, key_prefix, prev[i], i, &prev[i], &next);
+            assert(next == nullptr || !Equal(key, next->Key()));
+            x->NoBarrier_SetNext(i, next);
+            if (prev[i]->CASNext(i, next, x))
+            {
+                break;
+            }
+        }
+    }
+}
+
+template <class Comparator>
+bool InlineSkipList<Comparator>::Contains(const char* key) const
+{
+    Node* x = FindGreaterOrEqual(key, nullptr);
+    return x != nullptr && Equal(key, x->Key());
+}
+
+template <class Comparator>
+inline InlineSkipList<Comparator>::Iterator::Iterator(const InlineSkipList* list)
+    : list_(list), node_(nullptr)
+{
+}
+
+template <class Comparator>
+inline bool InlineSkipList<Comparator>::Iterator::Valid() const
+{
+    return node_ != nullptr;
+}
+
+template <class Comparator>
+inline const char* InlineSkipList<Comparator>::Iterator::key() const
+{
+    assert(Valid());
+    return node_->Key();
+}
+
+template <class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Next()
+{
+    assert(Valid());
+    node_ = node_->Next(0);
+}
+
+template <class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Prev()
+{
+    assert(Valid());
+    node_ = list_->FindLessThan(node_->Key());
+    if (node_ == list_->head_)
+    {
+        node_ = nullptr;
+    }
+}
+
+template <class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::Seek(const char* target)
+{
+    node_ = list_->FindGreaterOrEqual(target, nullptr);
+}
+
+template <class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::SeekToFirst()
+{
+    node_ = list_->head_->Next(0);
+}
+
+template <class Comparator>
+inline void InlineSkipList<Comparator>::Iterator::SeekToLast()
+{
+    node_ = list_->FindLast();
+    if (node_ == list_->head_)
+    {
+        node_ = nullptr;
+    }
+}
+
+template <class Comparator>
+inline InlineSkipList<Comparator>::FingerIterator::FingerIterator(const InlineSkipList* list)
+    : list_(list), node_(nullptr), height_(0)
+{
+}
+
+template <class Comparator>
+inline bool InlineSkipList<Comparator>::FingerIterator::Valid() const
+{
+    return node_ != nullptr;
+}
+
+template <class Comparator>
+inline const char* InlineSkipList<Comparator>::FingerIterator::key() const
+{
+    assert(Valid());
+    return node_->Key();
+}
+
+template <class Comparator>
+void InlineSkipList<Comparator>::FingerIterator::Seek(const char* target)
+{
+    const int max_height = list_->GetMaxHeight();
+    for (int i = height_; i < max_height; i++)
+    {
+        finger_[i] = list_->head_;
+    }
+    height_ = max_height;
+
+    const uint64_t target_prefix = list_->compare_.KeyPrefix(target);
+    int level = 0;
+    while (level + 1 < max_height &&
+           list_->KeyIsAfterNode(target, target_prefix, finger_[level + 1]->Next(level + 1)))
+    {
+        level++;
+    }
+
+    Node* x = finger_[level];
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (next != nullptr)
+        {
+            __builtin_prefetch(next->NoBarrier_Next(level));
+        }
+        if (level > 0)
+        {
+            __builtin_prefetch(x->NoBarrier_Next(level - 1));
+        }
+        if (list_->KeyIsAfterNode(target, target_prefix, next))
+        {
+            x = next;
+        }
+        else
+        {
+            finger_[level] = x;
+            if (level == 0)
+            {
+                node_ = next;
+                return;
+            }
+            level--;
+        }
+    }
+}
+
+}  // namespace leveldb
+
+#endif  // INLINE_SKIPLIST_H_
@@ -13,15 +13,27 @@ enum RecordType {
   // For fragments
   kFirstType = 2,   // 说明是user record的第一条log record
   kMiddleType = 3,  // 说明是user record中间的log record
-  kLastType = 4     // 说明是user record最后的一条log record
+  kLastType = 4,    // 说明是user record最后的一条log record
+
+  // 与上面四种相同，但 header 中多了日志文件号，用于回收的日志文件
+  kRecyclableFullType = 5,
+  kRecyclableFirstType = 6,
+  kRecyclableMiddleType = 7,
+  kRecyclableLastType = 8
 };
-static const int kMaxRecordType = kLastType;
+static const int kMaxRecordType = kRecyclableLastType;
 
 static const int kBlockSize = 32768;
 
 // Header is checksum (4 bytes), length (2 bytes), type (1 byte).
 static const int kHeaderSize = 4 + 2 + 1;
 
+// Recyclable 格式的 header 在 type 之后还有日志文件号的低 32 位(4 bytes)。
+// 回收的日志文件中，新写入的 record 之后是文件上一次使用时留下的旧 record，
+// 它们的日志文件号不同，读取时据此判断日志在哪里结束。CRC 覆盖 type、
+// 日志文件号和数据。
+static const int kRecyclableHeaderSize = 4 + 2 + 1 + 4;
+
 }  // namespace log
 }  // namespace leveldb
 
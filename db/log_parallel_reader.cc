@@ -0,0 +1,373 @@
+#include "log_parallel_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+
+#include "coding.h"
+#include "crc32c.h"
+#include "env.h"
+
+namespace leveldb {
+namespace log {
+
+const size_t ParallelReader::kDefaultChunkSize;
+
+struct ParallelReader::Chunk {
+  explicit Chunk(size_t capacity)
+      : buf(new char[capacity]), offset(0), eof(false), parsed(false) {}
+
+  std::unique_ptr<char[]> buf;
+  Slice data;       // 读到的内容，指向 buf
+  uint64_t offset;  // data 在文件中的起始位置
+  Status status;    // 读取出错时的状态
+  bool eof;         // 这是最后一个 chunk(读到文件尾或者出错)
+  bool parsed;
+  std::vector<Fragment> fragments;
+};
+
+ParallelReader::ParallelReader(SequentialFile* file, Reader::Reporter* reporter,
+                               bool checksum, int num_workers,
+                               size_t chunk_size, uint64_t log_number)
+    : file_(file),
+      reporter_(reporter),
+      checksum_(checksum),
+      num_workers_(num_workers < 1 ? 1 : num_workers),
+      chunk_size_(chunk_size),
+      max_chunks_(2 * num_workers_ + 2),
+      log_number_(log_number),
+      cv_(&mutex_),
+      read_done_(false),
+      shutdown_(false),
+      started_(false),
+      current_(nullptr),
+      fragment_index_(0),
+      last_record_offset_(0),
+      recycled_(false),
+      stale_(false) {
+  assert(chunk_size_ > 0 && chunk_size_ % kBlockSize == 0);
+}
+
+ParallelReader::~ParallelReader() {
+  mutex_.Lock();
+  shutdown_ = true;
+  cv_.SignalAll();
+  mutex_.Unlock();
+  for (std::thread& t : threads_) {
+    t.join();
+  }
+  delete current_;
+  for (Chunk* chunk : chunks_) {
+    delete chunk;
+  }
+}
+
+void ParallelReader::ReadLoop() {
+  uint64_t offset = 0;
+  while (true) {
+    mutex_.Lock();
+    while (!shutdown_ && chunks_.size() >= max_chunks_) {
+      cv_.Wait();
+    }
+    const bool stop = shutdown_;
+    mutex_.Unlock();
+    if (stop) {
+      break;
+    }
+
+    // 读文件时不持有锁，校验线程和 ReadRecord 可以同时处理之前的 chunk
+    Chunk* chunk = new Chunk(chunk_size_);
+    chunk->offset = offset;
+    chunk->status = file_->Read(chunk_size_, &chunk->data, chunk->buf.get());
+    if (!chunk->status.ok()) {
+      chunk->data.clear();
+      chunk->eof = true;
+    } else if (chunk->data.size() < chunk_size_) {
+      // 同 Reader：读到的数据少于请求的长度说明到了文件尾
+      chunk->eof = true;
+    }
+    offset += chunk->data.size();
+
+    mutex_.Lock();
+    chunks_.push_back(chunk);
+    unparsed_.push_back(chunk);
+    read_done_ = chunk->eof;
+    cv_.SignalAll();
+    mutex_.Unlock();
+    if (chunk->eof) {
+      break;
+    }
+  }
+}
+
+void ParallelReader::WorkerLoop() {
+  mutex_.Lock();
+  while (true) {
+    while (!shutdown_ && unparsed_.empty() && !read_done_) {
+      cv_.Wait();
+    }
+    if (shutdown_ || unparsed_.empty()) {
+      break;
+    }
+    Chunk* chunk = unparsed_.front();
+    unparsed_.pop_front();
+    mutex_.Unlock();
+
+    ParseChunk(chunk);
+
+    mutex_.Lock();
+    chunk->parsed = true;
+    cv_.SignalAll();
+  }
+  mutex_.Unlock();
+}
+
+void ParallelReader::ParseChunk(Chunk* chunk) const {
+  std::vector<Fragment>* fragments = &chunk->fragments;
+  if (!chunk->status.ok()) {
+    // 同 Reader：读取出错时丢弃一次读取的长度并结束
+    fragments->push_back(
+        Fragment{kEof, Slice(), chunk->offset, chunk_size_, chunk->status});
+    return;
+  }
+
+  const char* data = chunk->data.data();
+  const size_t size = chunk->data.size();
+  for (size_t pos = 0; pos < size; pos += kBlockSize) {
+    const size_t block_size = std::min<size_t>(kBlockSize, size - pos);
+    // 不足一个 block 说明文件在这个 block 中结束
+    const bool last = chunk->eof && block_size < static_cast<size_t>(kBlockSize);
+    if (!ParseBlock(data + pos, block_size, chunk->offset + pos, last,
+                    fragments)) {
+      return;
+    }
+  }
+  if (chunk->eof) {
+    fragments->push_back(Fragment{kEof, Slice(), chunk->offset + size, 0,
+                                  Status::OK()});
+  }
+}
+
+bool ParallelReader::ParseBlock(const char* block, size_t size,
+                                uint64_t block_offset, bool last,
+                                std::vector<Fragment>* fragments) const {
+  Slice buffer(block, size);
+  while (true) {
+    const uint64_t offset = block_offset + (size - buffer.size());
+    if (buffer.size() < kHeaderSize) {
+      if (last) {
+        // 文件末尾截断的头部，同 Reader 只报告 EOF
+        fragments->push_back(Fragment{kEof, Slice(), offset, 0, Status::OK()});
+        return false;
+      }
+      // block 末尾的填充
+      return true;
+    }
+
+    const char* header = buffer.data();
+    const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
+    const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
+    const unsigned int type = header[6];
+    const uint32_t length = a | (b << 8);
+    const bool recyclable =
+        type >= kRecyclableFullType && type <= kRecyclableLastType;
+    const int header_size = recyclable ? kRecyclableHeaderSize : kHeaderSize;
+    if (header_size + length > buffer.size()) {
+      if (!last) {
+        fragments->push_back(Fragment{kBadRecord, Slice(), offset,
+                                      buffer.size(),
+                                      Status::Corruption("bad record length")});
+        return true;
+      }
+      // 写入端在写记录的过程中退出，不报告
+      fragments->push_back(Fragment{kEof, Slice(), offset, 0, Status::OK()});
+      return false;
+    }
+
+    if (type == kZeroType && length == 0) {
+      fragments->push_back(
+          Fragment{kBadRecord, Slice(), offset, 0, Status::OK()});
+      return true;
+    }
+
+    if (checksum_) {
+      uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(header));
+      uint32_t actual_crc =
+          crc32c::Value(header + 6, header_size - 6 + length);
+      if (actual_crc != expected_crc) {
+        fragments->push_back(Fragment{kBadRecord, Slice(), offset,
+                                      buffer.size(),
+                                      Status::Corruption("checksum mismatch")});
+        return true;
+      }
+    }
+
+    if (recyclable &&
+        DecodeFixed32(header + 7) != static_cast<uint32_t>(log_number_)) {
+      // 回收的文件上一次使用时留下的 record
+      fragments->push_back(Fragment{kEof, Slice(), offset, 0, Status::OK()});
+      return false;
+    }
+
+    buffer.remove_prefix(header_size + length);
+    fragments->push_back(Fragment{type, Slice(header + header_size, length),
+                                  offset, 0, Status::OK()});
+  }
+}
+
+ParallelReader::Fragment* ParallelReader::NextFragment() {
+  while (current_ == nullptr ||
+         fragment_index_ == current_->fragments.size()) {
+    MutexLock l(&mutex_);
+    if (current_ != nullptr) {
+      delete current_;
+      current_ = nullptr;
+    }
+    while (chunks_.empty() || !chunks_.front()->parsed) {
+      cv_.Wait();
+    }
+    current_ = chunks_.front();
+    chunks_.pop_front();
+    fragment_index_ = 0;
+    // 腾出了位置，读线程可以继续预读
+    cv_.SignalAll();
+  }
+
+  Fragment* fragment = &current_->fragments[fragment_index_];
+  // 停在 kEof 上，之后的调用一直返回它
+  if (fragment->type != kEof) {
+    fragment_index_++;
+  }
+  return fragment;
+}
+
+bool ParallelReader::ReadRecord(Slice* record, std::string* scratch) {
+  if (stale_) {
+    scratch->clear();
+    record->clear();
+    return false;
+  }
+  if (!started_) {
+    started_ = true;
+    threads_.emplace_back(&ParallelReader::ReadLoop, this);
+    for (int i = 0; i < num_workers_; i++) {
+      threads_.emplace_back(&ParallelReader::WorkerLoop, this);
+    }
+  }
+
+  scratch->clear();
+  record->clear();
+  bool in_fragmented_record = false;
+  uint64_t prospective_record_offset = 0;
+
+  while (true) {
+    Fragment& fragment = *NextFragment();
+    unsigned int type = fragment.type;
+    const bool recyclable =
+        type >= kRecyclableFullType && type <= kRecyclableLastType;
+    // 文件尾、读取错误，以及 zero type 和 trailer
+    const bool marker = type == kEof ||
+                        (type == kBadRecord && fragment.drop_status.ok());
+    if (recycled_ && !recyclable && !marker) {
+      // 同 Reader：回收的文件中新写入的内容到此为止，之后是旧内容
+      stale_ = true;
+      scratch->clear();
+      return false;
+    }
+    if (!fragment.drop_status.ok()) {
+      ReportDrop(fragment.drop_bytes, fragment.drop_status);
+      // 停在 kEof 上时不重复报告
+      fragment.drop_status = Status::OK();
+    }
+    if (recyclable) {
+      recycled_ = true;
+      type -= kRecyclableFullType - kFullType;
+    }
+
+    // 以下与 Reader::ReadRecord 相同
+    switch (type) {
+      case kFullType:
+        if (in_fragmented_record) {
+          if (!scratch->empty()) {
+            ReportCorruption(scratch->size(), "partial record without end(1)");
+          }
+        }
+        scratch->clear();
+        *record = fragment.data;
+        last_record_offset_ = fragment.offset;
+        return true;
+
+      case kFirstType:
+        if (in_fragmented_record) {
+          if (!scratch->empty()) {
+            ReportCorruption(scratch->size(), "partial record without end(2)");
+          }
+        }
+        prospective_record_offset = fragment.offset;
+        scratch->assign(fragment.data.data(), fragment.data.size());
+        in_fragmented_record = true;
+        break;
+
+      case kMiddleType:
+        if (!in_fragmented_record) {
+          ReportCorruption(fragment.data.size(),
+                           "missing start of fragmented record(1)");
+        } else {
+          scratch->append(fragment.data.data(), fragment.data.size());
+        }
+        break;
+
+      case kLastType:
+        if (!in_fragmented_record) {
+          ReportCorruption(fragment.data.size(),
+                           "missing start of fragmented record(2)");
+        } else {
+          scratch->append(fragment.data.data(), fragment.data.size());
+          *record = Slice(*scratch);
+          last_record_offset_ = prospective_record_offset;
+          return true;
+        }
+        break;
+
+      case kEof:
+        if (in_fragmented_record) {
+          // 写入端在写完一条逻辑 record 之前退出，忽略整条 record
+          scratch->clear();
+        }
+        return false;
+
+      case kBadRecord:
+        if (in_fragmented_record) {
+          ReportCorruption(scratch->size(), "error in middle of record");
+          in_fragmented_record = false;
+          scratch->clear();
+        }
+        break;
+
+      default: {
+        char buf[40];
+        std::snprintf(buf, sizeof(buf), "unknown record type %u", type);
+        ReportCorruption(
+            (fragment.data.size() + (in_fragmented_record ? scratch->size() : 0)),
+            buf);
+        in_fragmented_record = false;
+        scratch->clear();
+        break;
+      }
+    }
+  }
+  return false;
+}
+
+void ParallelReader::ReportCorruption(uint64_t bytes, const char* reason) {
+  ReportDrop(bytes, Status::Corruption(reason));
+}
+
+void ParallelReader::ReportDrop(uint64_t bytes, const Status& reason) {
+  if (reporter_ != nullptr) {
+    reporter_->Corruption(static_cast<size_t>(bytes), reason);
+  }
+}
+
+}  // namespace log
+}  // namespace leveldb
@@ -0,0 +1,122 @@
+#ifndef STORAGE_LEVELDB_DB_LOG_PARALLEL_READER_H_
+#define STORAGE_LEVELDB_DB_LOG_PARALLEL_READER_H_
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_format.h"
+#include "log_reader.h"
+#include "mutex.h"
+#include "slice.h"
+#include "status.h"
+
+namespace leveldb {
+
+class SequentialFile;
+
+namespace log {
+
+// 流水线化的日志读取，用于恢复较大的日志文件：
+//   1. 一个读线程按 chunk(若干个 block)顺序预读文件；
+//   2. num_workers 个线程并行地对各个 chunk 校验 CRC，并解析出其中的物理 record；
+//   3. 调用 ReadRecord 的线程按文件顺序拼装逻辑 record(同 Reader::ReadRecord)。
+// 物理 record 不会跨 block，所以各个 chunk 可以独立解析。损坏的报告与 Reader
+// 完全一致，并且都在调用 ReadRecord 的线程中按文件顺序调用 reporter。
+// 内存中最多同时有 2 * num_workers + 2 个 chunk。
+//
+// 与 Reader 不同，总是从文件开头读取；file 只会被读线程访问。
+// 读线程在第一次调用 ReadRecord 时才启动。析构时停止并 join 所有线程，
+// 所以 file 和 reporter 的生命期不能短于 ParallelReader 对象。
+class ParallelReader {
+ public:
+  // chunk_size 必须是 kBlockSize 的整数倍。log_number 同 Reader。
+  ParallelReader(SequentialFile* file, Reader::Reporter* reporter,
+                 bool checksum, int num_workers,
+                 size_t chunk_size = kDefaultChunkSize,
+                 uint64_t log_number = 0);
+
+  ParallelReader(const ParallelReader&) = delete;
+  ParallelReader& operator=(const ParallelReader&) = delete;
+
+  ~ParallelReader();
+
+  static const size_t kDefaultChunkSize = 32 * kBlockSize;  // 1MB
+
+  // 同 Reader::ReadRecord。*record 指向的内存在下一次调用 ReadRecord 之前有效。
+  bool ReadRecord(Slice* record, std::string* scratch);
+
+  // 返回 ReadRecord 返回的最后一条记录的物理偏移量。
+  uint64_t LastRecordOffset() const { return last_record_offset_; }
+
+ private:
+  enum {
+    kEof = kMaxRecordType + 1,
+    kBadRecord = kMaxRecordType + 2
+  };
+
+  // 解析出的物理 record，或者一个 kEof/kBadRecord 标记
+  struct Fragment {
+    unsigned int type;  // recyclable 格式的 type 由 ReadRecord 转换
+    Slice data;
+    uint64_t offset;  // 物理 record 在文件中的起始位置
+    // 解析时发现的损坏，在 ReadRecord 处理该 fragment 之前报告
+    uint64_t drop_bytes;
+    Status drop_status;
+  };
+
+  struct Chunk;
+
+  // 读线程和校验线程的主循环
+  void ReadLoop();
+  void WorkerLoop();
+
+  // 校验 chunk 中的每个 block 并填充 chunk->fragments
+  void ParseChunk(Chunk* chunk) const;
+
+  // 按 Reader::ReadPhysicalRecord 的规则解析一个 block。last 表示 block 之后
+  // 没有数据了(文件在 block 中间结束)。遇到文件尾时追加 kEof 并返回 false。
+  bool ParseBlock(const char* block, size_t size, uint64_t block_offset,
+                  bool last, std::vector<Fragment>* fragments) const;
+
+  // 按文件顺序返回下一个 fragment，必要时等待校验线程
+  Fragment* NextFragment();
+
+  void ReportCorruption(uint64_t bytes, const char* reason);
+  void ReportDrop(uint64_t bytes, const Status& reason);
+
+  SequentialFile* const file_;
+  Reader::Reporter* const reporter_;
+  bool const checksum_;
+  const int num_workers_;
+  const size_t chunk_size_;
+  const size_t max_chunks_;
+  const uint64_t log_number_;
+
+  Mutex mutex_;
+  CondVar cv_;  // chunk 被读入、解析完或者被消费，以及关闭
+  // 已经读入、尚未被消费的 chunk，按文件顺序
+  std::deque<Chunk*> chunks_;
+  // 等待校验的 chunk
+  std::deque<Chunk*> unparsed_;
+  bool read_done_;  // 读线程已经读到文件尾或者出错
+  bool shutdown_;
+
+  std::vector<std::thread> threads_;
+
+  // 以下只由调用 ReadRecord 的线程访问
+  bool started_;
+  Chunk* current_;        // 正在消费的 chunk，已经从 chunks_ 中移除
+  size_t fragment_index_;
+  uint64_t last_record_offset_;
+  bool recycled_;  // 同 Reader::recycled_
+  bool stale_;     // 读到了回收的文件中的旧内容，日志已经结束
+};
+
+}  // namespace log
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_LOG_PARALLEL_READER_H_
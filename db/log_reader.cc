@@ -12,7 +12,7 @@ namespace log {
 Reader::Reporter::~Reporter() = default;
 
 Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum,
-               uint64_t initial_offset)
+               uint64_t initial_offset, uint64_t log_number)
     : file_(file),
       reporter_(reporter),
       checksum_(checksum),
@@ -22,7 +22,9 @@ Reader::Reader(SequentialFile* file, Reporter* reporter, bool checksum,
       last_record_offset_(0),
       end_of_buffer_offset_(0),
       initial_offset_(initial_offset),
-      resyncing_(initial_offset > 0) {}
+      resyncing_(initial_offset > 0),
+      log_number_(log_number),
+      recycled_(false) {}
 
 Reader::~Reader() { delete[] backing_store_; }
 
@@ -78,8 +80,10 @@ bool Reader::ReadRecord(Slice* record, std::string* scratch) {
     // end_of_buffer_offset_ 表示 log file 待读取字节位置
     // buffer_ 表示是对一整个 block 数据的封装, 底层存储为 backing_store_, 
     //    每次执行 ReadPhysicalRecord 时会移动 buffer_ 指针.
+    // 读到过 recyclable record 之后返回的 record 都是 recyclable 格式
+    const int header_size = recycled_ ? kRecyclableHeaderSize : kHeaderSize;
     uint64_t physical_record_offset =
-        end_of_buffer_offset_ - buffer_.size() - kHeaderSize - fragment.size();
+        end_of_buffer_offset_ - buffer_.size() - header_size - fragment.size();
 
     if (resyncing_) {
       if (record_type == kMiddleType) {
@@ -219,13 +223,21 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
     const char* header = buffer_.data();
     const uint32_t a = static_cast<uint32_t>(header[4]) & 0xff;
     const uint32_t b = static_cast<uint32_t>(header[5]) & 0xff;
-    const unsigned int type = header[6];
+    unsigned int type = header[6];
     const uint32_t length = a | (b << 8);
+    const bool recyclable =
+        type >= kRecyclableFullType && type <= kRecyclableLastType;
+    const int header_size = recyclable ? kRecyclableHeaderSize : kHeaderSize;
     // 长度超出了，汇报错误
-    if (kHeaderSize + length > buffer_.size()) {
+    if (header_size + length > buffer_.size()) {
       size_t drop_size = buffer_.size();
       buffer_.clear();
       if (!eof_) {
+        if (recycled_) {
+          // 回收的文件中新写入的内容到此为止，之后是旧内容
+          eof_ = true;
+          return kEof;
+        }
         ReportCorruption(drop_size, "bad record length");
         return kBadRecord;
       }
@@ -234,7 +246,8 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
     }
 
     if (type == kZeroType && length == 0) {
-      // 对于Zero Type类型，不汇报错误
+      // 对于Zero Type类型，不汇报错误：预分配的文件中尚未写入的部分读出为 0，
+      // recyclable 格式下 7 到 10 字节的 trailer 也是这样
       buffer_.clear();
       return kBadRecord;
     }
@@ -242,27 +255,48 @@ unsigned int Reader::ReadPhysicalRecord(Slice* result) {
     // 校验CRC32，如果校验出错，则汇报错误，并返回kBadRecord。
     if (checksum_) {
       uint32_t expected_crc = crc32c::Unmask(DecodeFixed32(header));
-      // crc 是基于 type 和 data 来计算的
-      uint32_t actual_crc = crc32c::Value(header + 6, 1 + length);
+      // crc 是基于 type(以及日志文件号) 和 data 来计算的
+      uint32_t actual_crc =
+          crc32c::Value(header + 6, header_size - 6 + length);
       if (actual_crc != expected_crc) {
         size_t drop_size = buffer_.size();
         buffer_.clear();
+        if (recycled_) {
+          eof_ = true;
+          return kEof;
+        }
         ReportCorruption(drop_size, "checksum mismatch");
         return kBadRecord;
       }
     }
 
+    if (recyclable) {
+      if (DecodeFixed32(header + 7) != static_cast<uint32_t>(log_number_)) {
+        // 文件上一次使用时留下的 record
+        buffer_.clear();
+        eof_ = true;
+        return kEof;
+      }
+      recycled_ = true;
+      type -= kRecyclableFullType - kFullType;
+    } else if (recycled_) {
+      // recyclable 格式的文件中不会有其他格式的 record，只能是旧内容
+      buffer_.clear();
+      eof_ = true;
+      return kEof;
+    }
+
     // header 解析完毕, 将当前 record 从 buffer_ 中移除(通过向前移动 buffer_ 底层存储指针实现)
-    buffer_.remove_prefix(kHeaderSize + length);
+    buffer_.remove_prefix(header_size + length);
 
     // 如果record的开始位置在initial offset之前，则跳过，并返回kBadRecord，否则返回record数据和type。
-    if (end_of_buffer_offset_ - buffer_.size() - kHeaderSize - length <
+    if (end_of_buffer_offset_ - buffer_.size() - header_size - length <
         initial_offset_) {
       result->clear();
       return kBadRecord;
     }
 
-    *result = Slice(header + kHeaderSize, length);
+    *result = Slice(header + header_size, length);
     return type;
   }
 }
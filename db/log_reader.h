@@ -29,8 +29,14 @@ class Reader {
   // 如果 reporter 不为空, 则在检测到数据损坏时汇报要丢弃的数据估计大小. 
   // 如果 checksum 为 true, 则在可行的条件比对校验和. 
   // 注意, file 和 reporter 的生命期不能短于 Reader 对象. 
+  // 如果 file 的 Read 直接返回指向文件映射的 Slice(Env::NewMmapSequentialFile),
+  // 单个 block 内的 record(kFullType)也直接指向映射而不拷贝, 只有跨 block 的
+  // record 需要在 scratch 中拼装.
+  // log_number 是日志文件的编号, 用于 recyclable 格式的日志: 编号不同的 record
+  // 是回收的文件中留下的旧内容, 读到它们就说明日志结束了. 读到过 recyclable
+  // record 之后, 长度或者校验和错误的 record 也被当作旧内容, 不再报告损坏.
   Reader(SequentialFile* file, Reporter* reporter, bool checksum,
-         uint64_t initial_offset);
+         uint64_t initial_offset, uint64_t log_number = 0);
 
   Reader(const Reader&) = delete;
   Reader& operator=(const Reader&) = delete;
@@ -51,7 +57,7 @@ class Reader {
     // 无效的物理 record 时返回。
     // 目前出现这种情况的三种情况：
     // * record 记录的 CRC 无效（ReadPhysicalRecord 报告丢弃）
-    // * record 记录为0长度记录（不报告drop）
+    // * record 记录为0长度记录（不报告drop），即预分配文件中未写入的部分或者 trailer
     // * record 记录低于构造函数的initial_offset（不报告drop）
     kBadRecord = kMaxRecordType + 2
   };
@@ -84,6 +90,10 @@ class Reader {
   // resyncing_ 用于跳过起始地址不符合 initial_offset_ 的 record,
   // 如果为 true 表示目前还在定位第一个满足条件的逻辑 record 中.
   bool resyncing_;
+
+  uint64_t const log_number_;
+  // 已经读到过本文件的 recyclable record，之后出现的错误都说明到了新内容的末尾
+  bool recycled_;
 };
 
 }  // namespace log
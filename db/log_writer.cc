@@ -17,12 +17,24 @@ static void InitTypeCrc(uint32_t* type_crc) {
   }
 }
 
-Writer::Writer(WritableFile* dest) : dest_(dest), block_offset_(0) {
+Writer::Writer(WritableFile* dest)
+    : dest_(dest), block_offset_(0), log_number_(0), recyclable_(false) {
   InitTypeCrc(type_crc_);
 }
 
 Writer::Writer(WritableFile* dest, uint64_t dest_length)
-    : dest_(dest), block_offset_(dest_length % kBlockSize) {
+    : dest_(dest),
+      block_offset_(dest_length % kBlockSize),
+      log_number_(0),
+      recyclable_(false) {
+  InitTypeCrc(type_crc_);
+}
+
+Writer::Writer(WritableFile* dest, uint64_t log_number, bool recyclable)
+    : dest_(dest),
+      block_offset_(0),
+      log_number_(log_number),
+      recyclable_(recyclable) {
   InitTypeCrc(type_crc_);
 }
 
@@ -32,26 +44,36 @@ Status Writer::AddRecord(const Slice& slice) {
   const char* ptr = slice.data();
   size_t left = slice.size();
 
-  Status s;
+  const int header_size = recyclable_ ? kRecyclableHeaderSize : kHeaderSize;
+
+  // 每个 block 最多一个 physical record，加上第一个 block 和最后一个 block
+  const size_t max_fragments = left / (kBlockSize - header_size) + 2;
+  if (headers_.size() < max_fragments * kRecyclableHeaderSize) {
+    headers_.resize(max_fragments * kRecyclableHeaderSize);
+  }
+  parts_.clear();
+  char* header = headers_.data();
+
   // 表明这是第一条log record
   bool begin = true;
   do {
-    // 如果当前 block 剩余空间不足容纳 record 的 header(7 字节) 则剩余空间作为 trailer 填充 0, 然后切换到新的 block.
+    // 如果当前 block 剩余空间不足容纳 record 的 header(7 或 11 字节) 则剩余空间作为 trailer 填充 0, 然后切换到新的 block.
     const int leftover = kBlockSize - block_offset_;
     assert(leftover >= 0);
-    if (leftover < kHeaderSize) {
+    if (leftover < header_size) {
       if (leftover > 0) {
-        static_assert(kHeaderSize == 7, "");
-        dest_->Append(Slice("\x00\x00\x00\x00\x00\x00", leftover));
+        static_assert(kRecyclableHeaderSize == 11, "");
+        parts_.push_back(
+            Slice("\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00", leftover));
       }
       block_offset_ = 0;
     }
 
-    // 到这一步, block 最终剩余字节必定大约等于 kHeaderSize
-    assert(kBlockSize - block_offset_ - kHeaderSize >= 0);
+    // 到这一步, block 最终剩余字节必定大约等于 header_size
+    assert(kBlockSize - block_offset_ - header_size >= 0);
 
     // 计算block剩余大小 avail，以及本次log record可写入数据长度 fragment_length
-    const size_t avail = kBlockSize - block_offset_ - kHeaderSize;
+    const size_t avail = kBlockSize - block_offset_ - header_size;
     const size_t fragment_length = (left < avail) ? left : avail;
 
     // 根据两个值，判断log type
@@ -80,47 +102,58 @@ Status Writer::AddRecord(const Slice& slice) {
       type = kMiddleType;
     }
 
-    // 将类型为 type, data 长度为 fragment_length 的 record 写入 log 文件.并更新指针、剩余长度和begin标记
-    s = EmitPhysicalRecord(type, ptr, fragment_length);
+    // 将类型为 type, data 长度为 fragment_length 的 physical record 加入 parts_.并更新指针、剩余长度和begin标记
+    assert(header + kRecyclableHeaderSize <= headers_.data() + headers_.size());
+    EmitPhysicalRecord(type, ptr, fragment_length, header);
+    header += kRecyclableHeaderSize;
     ptr += fragment_length;
     left -= fragment_length;
     begin = false;
-  } while (s.ok() && left > 0);
+  } while (left > 0);
+
+  // 所有 physical record 一起写入：较大的 record 不经过文件的缓冲区，
+  // 与缓冲区中的内容一起用一次 writev 写入(超过 IOV_MAX 个 Slice 时分成多次)
+  Status s = dest_->AppendV(parts_.data(), parts_.size());
+  if (s.ok()) {
+    // 刷入文件
+    s = dest_->Flush();
+  }
   return s;
 }
 
-Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr,
-                                  size_t length) {
-  // data 大小必须能够被 16 位无符号整数表示, 因为 record 的 length 字段只有两字节                                  
+void Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t length,
+                                char* header) {
+  const int header_size = recyclable_ ? kRecyclableHeaderSize : kHeaderSize;
+  // data 大小必须能够被 16 位无符号整数表示, 因为 record 的 length 字段只有两字节
   assert(length <= 0xffff);
   // 要写入的内容不能超过当前 block 剩余空间大小
-  assert(block_offset_ + kHeaderSize + length <= kBlockSize);
+  assert(block_offset_ + header_size + length <= kBlockSize);
 
-  // buf 用于组装 record header，共7byte格式为：
+  // header 共7byte格式为：
   // | CRC32 (4 byte) | payload length lower + high (2 byte) |   type (1byte)|
-  char buf[kHeaderSize];
+  // recyclable 格式在最后多出 4 字节的日志文件号
+  char* buf = header;
   buf[4] = static_cast<char>(length & 0xff);
   buf[5] = static_cast<char>(length >> 8);
-  buf[6] = static_cast<char>(t);
 
-  // 计算 type 和 data 的 crc 并编码安排在最前面 4 个字节
-  uint32_t crc = crc32c::Extend(type_crc_[t], ptr, length);
+  // 计算 type(以及日志文件号)和 data 的 crc 并编码安排在最前面 4 个字节
+  uint32_t crc;
+  if (recyclable_) {
+    t = static_cast<RecordType>(t + kRecyclableFullType - kFullType);
+    EncodeFixed32(buf + 7, static_cast<uint32_t>(log_number_));
+    crc = crc32c::Extend(type_crc_[t], buf + 7, 4);
+  } else {
+    crc = type_crc_[t];
+  }
+  buf[6] = static_cast<char>(t);
+  crc = crc32c::Extend(crc, ptr, length);
   crc = crc32c::Mask(crc);  // 空间调整
   // 将 crc 写入到 header 前四个字节
   EncodeFixed32(buf, crc);
 
-  // 写入 header
-  Status s = dest_->Append(Slice(buf, kHeaderSize));
-  if (s.ok()) {
-    // 写入 payload
-    s = dest_->Append(Slice(ptr, length));
-    if (s.ok()) {
-      // 刷入文件
-      s = dest_->Flush();
-    }
-  }
-  block_offset_ += kHeaderSize + length;
-  return s;
+  parts_.push_back(Slice(buf, header_size));
+  parts_.push_back(Slice(ptr, length));
+  block_offset_ += header_size + length;
 }
 
 }  // namespace log
@@ -2,6 +2,7 @@
 #define STORAGE_LEVELDB_DB_LOG_WRITER_H_
 
 #include <cstdint>
+#include <vector>
 
 #include "log_format.h"
 #include "slice.h"
@@ -23,19 +24,35 @@ class Writer {
   // dest 指向文件初始长度必须为 dest_length; dest 生命期不能短于 writer.
   Writer(WritableFile* dest, uint64_t dest_length);
 
+  // 创建一个 writer 从头写入编号为 log_number 的日志文件 dest.
+  // recyclable 为 true 时使用 recyclable 格式(header 中带有 log_number),
+  // 这时 dest 可以是一个回收的旧日志文件, 其中原有的内容在读取时会被识别出来.
+  // dest 生命期不能短于 writer.
+  Writer(WritableFile* dest, uint64_t log_number, bool recyclable);
+
   Writer(const Writer&) = delete;
   Writer& operator=(const Writer&) = delete;
 
   ~Writer();
 
-  // 写入
+  // 写入一条 record。跨 block 的各个 physical record(以及 block 末尾填充的
+  // trailer)通过一次 AppendV 写入，之后 Flush 一次
   Status AddRecord(const Slice& slice);
 
  private:
-  Status EmitPhysicalRecord(RecordType type, const char* ptr, size_t length);
+  // 把一个 physical record 的 header 编码到 header 中，
+  // header 和 payload 加入 parts_
+  void EmitPhysicalRecord(RecordType type, const char* ptr, size_t length,
+                          char* header);
 
   WritableFile* dest_; // 顺序写文件
   int block_offset_;  // Current offset in block
+  const uint64_t log_number_;
+  const bool recyclable_;
+
+  // AddRecord 中待写入的 Slice 和它们引用的 header，在多次调用之间复用
+  std::vector<Slice> parts_;
+  std::vector<char> headers_;
 
   // crc的值，预先计算出来，以减少计算开销
   uint32_t type_crc_[kMaxRecordType + 1];
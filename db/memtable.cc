@@ -1,30 +1,37 @@
 #include "memtable.h"
+
+#include <algorithm>
+#include <vector>
+
 #include "dbformat.h"
 #include "comparator.h"
 #include "coding.h"
 
 namespace leveldb {
 
-static Slice GetLengthPrefixedSlice(const char* data) {
-  uint32_t len;
-  const char* p = data;
-  p = GetVarint32Ptr(p, p + 5, &len);  // +5: we assume "p" is not corrupted
-  return Slice(p, len);
+MemTable::MemTable(const InternalKeyComparator& comparator,
+                   size_t arena_block_size, bool arena_use_mmap,
+                   const MemTableRepFactory* rep_factory)
+    : comparator_(comparator),
+      refs_(0),
+      arena_(ConcurrentArena::kDefaultShardBlockSize, arena_block_size,
+             arena_use_mmap),
+      rep_(nullptr) {
+  static const MemTableRepFactory* const kDefaultFactory =
+      NewSkipListRepFactory();
+  if (rep_factory == nullptr) {
+    rep_factory = kDefaultFactory;
+  }
+  rep_ = rep_factory->CreateMemTableRep(comparator_, &arena_);
 }
 
-MemTable::MemTable(const InternalKeyComparator& comparator)
-    : comparator_(comparator), refs_(0), table_(comparator_, &arena_) {}
-
-MemTable::~MemTable() { assert(refs_ == 0); }
-
-size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
+MemTable::~MemTable() {
+  assert(refs_.load(std::memory_order_relaxed) == 0);
+  delete rep_;
+}
 
-int MemTable::KeyComparator::operator()(const char* aptr,
-                                        const char* bptr) const {
-  // Internal keys are encoded as length-prefixed strings.
-  Slice a = GetLengthPrefixedSlice(aptr);
-  Slice b = GetLengthPrefixedSlice(bptr);
-  return comparator.Compare(a, b);
+size_t MemTable::ApproximateMemoryUsage() {
+  return arena_.MemoryUsage() + rep_->ApproximateMemoryUsage();
 }
 
 // Encode a suitable internal key target for "target" and return it.
@@ -39,52 +46,54 @@ static const char* EncodeKey(std::string* scratch, const Slice& target) {
 
 class MemTableIterator : public Iterator {
  public:
-  explicit MemTableIterator(MemTable::Table* table) : iter_(table) {}
+  explicit MemTableIterator(MemTableRep* rep) : iter_(rep->GetIterator()) {}
 
   MemTableIterator(const MemTableIterator&) = delete;
   MemTableIterator& operator=(const MemTableIterator&) = delete;
 
-  ~MemTableIterator() override = default;
+  ~MemTableIterator() override { delete iter_; }
 
-  bool Valid() const override { return iter_.Valid(); }
-  void Seek(const Slice& k) override { iter_.Seek(EncodeKey(&tmp_, k)); }
-  void SeekToFirst() override { iter_.SeekToFirst(); }
-  void SeekToLast() override { iter_.SeekToLast(); }
-  void Next() override { iter_.Next(); }
-  void Prev() override { iter_.Prev(); }
-  Slice key() const override { return GetLengthPrefixedSlice(iter_.key()); }
+  bool Valid() const override { return iter_->Valid(); }
+  void Seek(const Slice& k) override { iter_->Seek(EncodeKey(&tmp_, k)); }
+  void SeekToFirst() override { iter_->SeekToFirst(); }
+  void SeekToLast() override { iter_->SeekToLast(); }
+  void Next() override { iter_->Next(); }
+  void Prev() override { iter_->Prev(); }
+  Slice key() const override { return GetLengthPrefixedSlice(iter_->key()); }
   Slice value() const override {
-    Slice key_slice = GetLengthPrefixedSlice(iter_.key());
+    Slice key_slice = GetLengthPrefixedSlice(iter_->key());
     return GetLengthPrefixedSlice(key_slice.data() + key_slice.size());
   }
 
   Status status() const override { return Status::OK(); }
 
  private:
-  MemTable::Table::Iterator iter_;
+  MemTableRep::Iterator* iter_;
   std::string tmp_;  // For passing to EncodeKey
 };
 
-Iterator* MemTable::NewIterator() { return new MemTableIterator(&table_); }
+Iterator* MemTable::NewIterator() { return new MemTableIterator(rep_); }
 
-void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
-                   const Slice& value) {
+size_t MemTable::EncodedLength(const Slice& key, const Slice& value) {
+  // internalKey = UserKey + SequenceNumber(uint64_t)
+  size_t internal_key_size = key.size() + 8;
+  return VarintLength(internal_key_size) + internal_key_size +
+         VarintLength(value.size()) + value.size();
+}
+
+void MemTable::EncodeEntry(char* buf, size_t encoded_len, SequenceNumber s,
+                           ValueType type, const Slice& key,
+                           const Slice& value) {
   // Format of an entry is concatenation of:
   //  key_size     : varint32 of internal_key.size()
   //  key bytes    : char[internal_key.size()]
   //  tag          : uint64((sequence << 8) | type)
   //  value_size   : varint32 of value.size()
   //  value bytes  : char[value.size()]
-  
   size_t key_size = key.size();
   size_t val_size = value.size();
-  // internalKey = UserKey + SequenceNumber(uint64_t)
-  size_t internal_key_size = key_size + 8;  
-  const size_t encoded_len = VarintLength(internal_key_size) +
-                             internal_key_size + VarintLength(val_size) +
-                             val_size;
-  char* buf = arena_.Allocate(encoded_len);
-  
+  size_t internal_key_size = key_size + 8;
+
   char* p = EncodeVarint32(buf, internal_key_size); // key_size
   ::memcpy(p, key.data(), key_size); // key bytes
   p += key_size;
@@ -93,48 +102,129 @@ void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
   p = EncodeVarint32(p, val_size);      // value_size
   ::memcpy(p, value.data(), val_size);   // value bytes
   assert(p + val_size == buf + encoded_len);
-  table_.Insert(buf);   // 保存进跳表
+  (void)encoded_len;  // Silence unused warnings when NDEBUG is defined.
 }
 
-bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
-  // memtable_key = lookupkey的slice内容
-  Slice memkey = key.memtable_key();
-  Table::Iterator iter(&table_);
-  // 通过用户传入的比较模块 & skiplist迭代器 定位到第一个大于或等于memtable_key 的entry
-  iter.Seek(memkey.data());
-  if (iter.Valid()) {
-    // entry format is:
-    //    klength  varint32
-    //    userkey  char[klength]
-    //    tag      uint64
-    //    vlength  varint32
-    //    value    char[vlength]
-    // Check that it belongs to same user key.  We do not check the
-    // sequence number since the Seek() call above should have skipped
-    // all entries with overly large sequence numbers.
-    const char* entry = iter.key();
-    uint32_t key_length;
-    // 解析 InternalKey 的长度到 key_length
-    const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
-    // 比较当前条目对应的 user_key 与 参数 key 是否相等
-    if (comparator_.comparator.user_comparator()->Compare(
-            Slice(key_ptr, key_length - 8), key.user_key()) == 0) {
-      // 如果相等，取出kTypeValue进行判断
-      const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
-      switch (static_cast<ValueType>(tag & 0xff)) {
-        case kTypeValue: {  // 表示这个key确实存在于memtable，讲value解析出来进行返回
-          Slice v = GetLengthPrefixedSlice(key_ptr + key_length);
-          value->assign(v.data(), v.size());
-          return true;
-        }
-        case kTypeDeletion: 
-          // 表示该 key/value 已经从 Memtable 中删除，这时候将 NotFound 保存在状态码中，并且返回
-          *s = Status::NotFound(Slice());
-          return true;
+void MemTable::Add(SequenceNumber s, ValueType type, const Slice& key,
+                   const Slice& value) {
+  const size_t encoded_len = EncodedLength(key, value);
+  char* buf = rep_->Allocate(encoded_len);
+  EncodeEntry(buf, encoded_len, s, type, key, value);
+  rep_->Insert(buf);   // 保存进 rep_(默认为跳表)
+}
+
+void MemTable::AddConcurrently(SequenceNumber s, ValueType type,
+                               const Slice& key, const Slice& value) {
+  const size_t encoded_len = EncodedLength(key, value);
+  // ConcurrentArena 本身是线程安全的，rep_->Allocate 可以并发调用
+  char* buf = rep_->Allocate(encoded_len);
+  EncodeEntry(buf, encoded_len, s, type, key, value);
+  rep_->InsertConcurrently(buf);
+}
+
+bool MemTable::SaveEntry(const char* entry, const LookupKey& key,
+                         Slice* value, Status* s) const {
+  if (entry == nullptr) {
+    return false;
+  }
+  // entry format is:
+  //    klength  varint32
+  //    userkey  char[klength]
+  //    tag      uint64
+  //    vlength  varint32
+  //    value    char[vlength]
+  // Check that it belongs to same user key.  We do not check the
+  // sequence number since the Seek() call above should have skipped
+  // all entries with overly large sequence numbers.
+  uint32_t key_length;
+  // 解析 InternalKey 的长度到 key_length
+  const char* key_ptr = GetVarint32Ptr(entry, entry + 5, &key_length);
+  // 比较当前条目对应的 user_key 与 参数 key 是否相等
+  if (comparator_.comparator.user_comparator()->Compare(
+          Slice(key_ptr, key_length - 8), key.user_key()) == 0) {
+    // 如果相等，取出kTypeValue进行判断
+    const uint64_t tag = DecodeFixed64(key_ptr + key_length - 8);
+    switch (static_cast<ValueType>(tag & 0xff)) {
+      case kTypeValue: {  // 表示这个key确实存在于memtable，讲value解析出来进行返回
+        *value = GetLengthPrefixedSlice(key_ptr + key_length);
+        return true;
       }
+      case kTypeDeletion:
+        // 表示该 key/value 已经从 Memtable 中删除，这时候将 NotFound 保存在状态码中，并且返回
+        *s = Status::NotFound(Slice());
+        return true;
     }
   }
   return false;
 }
 
+bool MemTable::Get(const LookupKey& key, std::string* value, Status* s) {
+  // 定位到第一个大于或等于 memtable_key 的 entry(hash 实现只在 key 所在的桶中查找)
+  Slice v;
+  Status entry_status;
+  if (!SaveEntry(rep_->Lookup(key), key, &v, &entry_status)) {
+    return false;
+  }
+  if (entry_status.ok()) {
+    value->assign(v.data(), v.size());
+  } else {
+    *s = entry_status;
+  }
+  return true;
+}
+
+static void UnrefMemTable(void* arg1, void* /*arg2*/) {
+  reinterpret_cast<MemTable*>(arg1)->Unref();
+}
+
+bool MemTable::Get(const LookupKey& key, PinnableSlice* value, Status* s) {
+  Slice v;
+  Status entry_status;
+  if (!SaveEntry(rep_->Lookup(key), key, &v, &entry_status)) {
+    return false;
+  }
+  if (entry_status.ok()) {
+    // entry 在 arena 中，arena 与 memtable 一起释放，持有引用即可保证 v 有效
+    Ref();
+    value->PinSlice(v, &UnrefMemTable, this, nullptr);
+  } else {
+    *s = entry_status;
+  }
+  return true;
+}
+
+void MemTable::MultiGet(const LookupKey* const* keys, size_t n,
+                        std::string* values, Status* statuses, bool* found) {
+  // finger search 要求目标升序，按 internal key 排序下标(同一 user key 按序列号降序)
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  const InternalKeyComparator& icmp = comparator_.comparator;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return icmp.Compare(keys[a]->internal_key(), keys[b]->internal_key()) < 0;
+  });
+
+  std::vector<const LookupKey*> sorted(n);
+  for (size_t i = 0; i < n; i++) {
+    sorted[i] = keys[order[i]];
+  }
+  std::vector<const char*> entries(n);
+  rep_->LookupSorted(sorted.data(), n, entries.data());
+  for (size_t i = 0; i < n; i++) {
+    const size_t k = order[i];
+    Slice v;
+    Status entry_status;
+    found[k] = SaveEntry(entries[i], *keys[k], &v, &entry_status);
+    if (!found[k]) {
+      continue;
+    }
+    if (entry_status.ok()) {
+      values[k].assign(v.data(), v.size());
+    } else {
+      statuses[k] = entry_status;
+    }
+  }
+}
+
 }  // namespace leveldb
@@ -1,10 +1,12 @@
 #ifndef STORAGE_LEVELDB_DB_MEMTABLE_H_
 #define STORAGE_LEVELDB_DB_MEMTABLE_H_
 
+#include <atomic>
 #include <string>
-#include "skiplist.h"
-#include "arena.h"
+#include "concurrent_arena.h"
 #include "dbformat.h"
+#include "memtablerep.h"
+#include "pinnable_slice.h"
 #include "status.h"
 #include "iterator.h"
 
@@ -17,19 +19,27 @@ class MemTable {
  public:
   // MemTables are reference counted.  The initial reference count
   // is zero and the caller must call Ref() at least once.
-  explicit MemTable(const InternalKeyComparator& comparator);
+  // arena_block_size / arena_use_mmap 控制底层 arena 的块大小以及是否使用
+  // mmap(大页)申请块，见 arena.h 和 concurrent_arena.h。
+  // 较大的 memtable 建议使用 2MB 的 mmap 块。
+  // rep_factory 选择底层数据结构(见 memtablerep.h)，为 nullptr 时使用跳表。
+  explicit MemTable(const InternalKeyComparator& comparator,
+                    size_t arena_block_size = ConcurrentArena::kDefaultBlockSize,
+                    bool arena_use_mmap = false,
+                    const MemTableRepFactory* rep_factory = nullptr);
 
   MemTable(const MemTable&) = delete;
   MemTable& operator=(const MemTable&) = delete;
 
   // Increase reference count.
-  void Ref() { ++refs_; }
+  // 引用计数是原子的：Get 返回的 PinnableSlice 可能在不持有 DB 锁的线程中释放引用。
+  void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
 
   // Drop reference count.  Delete if no more references exist.
   void Unref() {
-    --refs_;
-    assert(refs_ >= 0);
-    if (refs_ <= 0) {
+    const int old_refs = refs_.fetch_sub(1, std::memory_order_acq_rel);
+    assert(old_refs >= 1);
+    if (old_refs == 1) {
       delete this;
     }
   }
@@ -47,29 +57,48 @@ class MemTable {
   void Add(SequenceNumber seq, ValueType type, const Slice& key,
            const Slice& value);
 
+  // 同 Add，但允许多个写线程同时向同一个 memtable 插入(无需外部加锁)。
+  // 不能与 Add 并发混用；并发读依然是安全的。
+  void AddConcurrently(SequenceNumber seq, ValueType type, const Slice& key,
+                       const Slice& value);
+
   // 如果 memtable 包含 key 的 value，则将其存储在 *value 中并返回 true。
   // 如果 memtable 包含 key 的 detetion，则存储 NotFound() 错误在 *status 中并返回 true。
   // 否则，返回 false。
   bool Get(const LookupKey& key, std::string* value, Status* s);
 
+  // 同上，但不拷贝 value：*value 直接指向 arena 中的 entry，并持有 memtable 的
+  // 一个引用，直到 value 被 Reset 或者析构。REQUIRES: value 没有被 pin 住。
+  bool Get(const LookupKey& key, PinnableSlice* value, Status* s);
+
+  // 批量 Get：对 keys[0, n) 分别做与 Get 相同的查找，结果写入 values[i] / statuses[i]，
+  // found[i] 为对应 Get 的返回值；keys 不要求有序，也可以重复。
+  // 内部按 internal key 排序后交给 MemTableRep::LookupSorted，跳表实现用同一个
+  // finger search 迭代器依次查找，相邻 key 复用上一次的查找路径，批量较大
+  // (几十到几百个 key)时比逐个 Get 少很多比较和 cache miss。
+  void MultiGet(const LookupKey* const* keys, size_t n, std::string* values,
+                Status* statuses, bool* found);
+
  private:
   friend class MemTableIterator;
-  friend class MemTableBackwardIterator;
 
-  struct KeyComparator {
-    const InternalKeyComparator comparator;
-    explicit KeyComparator(const InternalKeyComparator& c) : comparator(c) {}
-    int operator()(const char* a, const char* b) const;
-  };
+  ~MemTable();  // Private since only Unref() should be used to delete it
 
-  typedef SkipList<const char*, KeyComparator> Table;
+  // entry 为跳表中第一个不小于 key 的条目(没有则为 nullptr)。entry 不属于 key 时
+  // 返回 false；是 key 的删除标记时 *s 为 NotFound，否则 *value 指向 entry 中的 value。
+  bool SaveEntry(const char* entry, const LookupKey& key, Slice* value,
+                 Status* s) const;
 
-  ~MemTable();  // Private since only Unref() should be used to delete it
+  // 将一条 entry 编码到 buf 中，buf 的长度必须为 EncodedLength 的返回值
+  static size_t EncodedLength(const Slice& key, const Slice& value);
+  static void EncodeEntry(char* buf, size_t encoded_len, SequenceNumber s,
+                          ValueType type, const Slice& key,
+                          const Slice& value);
   
-  KeyComparator comparator_;    // key值比较模块，提供给skiplist
-  int refs_;
-  Arena arena_; // 内存分配模块，提供给skiplist
-  Table table_;
+  MemTableRep::KeyComparator comparator_;    // key值比较模块，提供给 rep_
+  std::atomic<int> refs_;
+  ConcurrentArena arena_; // 内存分配模块，提供给 rep_，支持多个写线程同时分配
+  MemTableRep* rep_;      // 保存 entry 的数据结构，默认为跳表
 };
 
 }  // namespace leveldb
@@ -0,0 +1,375 @@
+#include "memtablerep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "hash.h"
+#include "inline_skiplist.h"
+#include "mutex.h"
+#include "skiplist.h"
+
+namespace leveldb {
+
+int MemTableRep::KeyComparator::operator()(const char* aptr,
+                                           const char* bptr) const {
+  // Internal keys are encoded as length-prefixed strings.
+  Slice a = GetLengthPrefixedSlice(aptr);
+  Slice b = GetLengthPrefixedSlice(bptr);
+  return comparator.Compare(a, b);
+}
+
+uint64_t MemTableRep::KeyComparator::KeyPrefix(const char* entry) const {
+  if (!bytewise) {
+    return 0;
+  }
+  Slice user_key = ExtractUserKey(GetLengthPrefixedSlice(entry));
+  unsigned char buf[8] = {0};
+  memcpy(buf, user_key.data(), std::min<size_t>(user_key.size(), sizeof(buf)));
+  return (static_cast<uint64_t>(buf[0]) << 56) |
+         (static_cast<uint64_t>(buf[1]) << 48) |
+         (static_cast<uint64_t>(buf[2]) << 40) |
+         (static_cast<uint64_t>(buf[3]) << 32) |
+         (static_cast<uint64_t>(buf[4]) << 24) |
+         (static_cast<uint64_t>(buf[5]) << 16) |
+         (static_cast<uint64_t>(buf[6]) << 8) | static_cast<uint64_t>(buf[7]);
+}
+
+void MemTableRep::LookupSorted(const LookupKey* const* keys, size_t n,
+                               const char** entries) {
+  for (size_t i = 0; i < n; i++) {
+    entries[i] = Lookup(*keys[i]);
+  }
+}
+
+namespace {
+
+typedef InlineSkipList<const MemTableRep::KeyComparator&> InlineEntryList;
+
+class SkipListRep : public MemTableRep {
+ public:
+  SkipListRep(const KeyComparator& cmp, Allocator* allocator)
+      : MemTableRep(allocator), table_(cmp, allocator) {}
+
+  // entry 直接分配在跳表节点之后
+  char* Allocate(size_t len) override { return table_.AllocateKey(len); }
+
+  void Insert(const char* entry) override { table_.Insert(entry); }
+
+  void InsertConcurrently(const char* entry) override {
+    table_.InsertConcurrently(entry);
+  }
+
+  const char* Lookup(const LookupKey& key) override {
+    InlineEntryList::Iterator iter(&table_);
+    iter.Seek(key.memtable_key().data());
+    return iter.Valid() ? iter.key() : nullptr;
+  }
+
+  void LookupSorted(const LookupKey* const* keys, size_t n,
+                    const char** entries) override {
+    // 相邻的 key 复用上一次的查找路径
+    InlineEntryList::FingerIterator iter(&table_);
+    for (size_t i = 0; i < n; i++) {
+      iter.Seek(keys[i]->memtable_key().data());
+      entries[i] = iter.Valid() ? iter.key() : nullptr;
+    }
+  }
+
+  Iterator* GetIterator() override;
+
+ private:
+  class ListIterator;
+
+  InlineEntryList table_;
+};
+
+class SkipListRep::ListIterator : public MemTableRep::Iterator {
+ public:
+  explicit ListIterator(const InlineEntryList* list) : iter_(list) {}
+
+  bool Valid() const override { return iter_.Valid(); }
+  const char* key() const override { return iter_.key(); }
+  void Next() override { iter_.Next(); }
+  void Prev() override { iter_.Prev(); }
+  void Seek(const char* memtable_key) override { iter_.Seek(memtable_key); }
+  void SeekToFirst() override { iter_.SeekToFirst(); }
+  void SeekToLast() override { iter_.SeekToLast(); }
+
+ private:
+  InlineEntryList::Iterator iter_;
+};
+
+MemTableRep::Iterator* SkipListRep::GetIterator() {
+  return new ListIterator(&table_);
+}
+
+typedef SkipList<const char*, const MemTableRep::KeyComparator&> EntryList;
+typedef std::vector<const char*> EntryVector;
+
+// 遍历一个排好序的 entry 数组；共享数组的所有权，数组在迭代器存在期间不会被修改
+class VectorIterator : public MemTableRep::Iterator {
+ public:
+  VectorIterator(std::shared_ptr<const EntryVector> entries,
+                 const MemTableRep::KeyComparator& cmp)
+      : entries_(std::move(entries)), cmp_(cmp), pos_(entries_->size()) {}
+
+  bool Valid() const override { return pos_ < entries_->size(); }
+  const char* key() const override {
+    assert(Valid());
+    return (*entries_)[pos_];
+  }
+  void Next() override {
+    assert(Valid());
+    pos_++;
+  }
+  void Prev() override {
+    assert(Valid());
+    pos_ = (pos_ == 0) ? entries_->size() : pos_ - 1;
+  }
+  void Seek(const char* memtable_key) override {
+    const MemTableRep::KeyComparator& cmp = cmp_;
+    pos_ = std::lower_bound(entries_->begin(), entries_->end(), memtable_key,
+                            [&cmp](const char* a, const char* b) {
+                              return cmp(a, b) < 0;
+                            }) -
+           entries_->begin();
+  }
+  void SeekToFirst() override { pos_ = 0; }
+  void SeekToLast() override {
+    pos_ = entries_->empty() ? 0 : entries_->size() - 1;
+  }
+
+ private:
+  std::shared_ptr<const EntryVector> entries_;
+  const MemTableRep::KeyComparator& cmp_;
+  size_t pos_;  // entries_->size() 表示无效
+};
+
+// 按 user key 前缀哈希分桶，每个桶一个跳表。
+// 桶数组和各个桶的跳表都从 allocator 分配，桶在第一次写入时才创建。
+class HashSkipListRep : public MemTableRep {
+ public:
+  HashSkipListRep(const KeyComparator& cmp, Allocator* allocator,
+                  size_t prefix_length, size_t bucket_count)
+      : MemTableRep(allocator),
+        cmp_(cmp),
+        prefix_length_(prefix_length),
+        bucket_count_(std::max<size_t>(bucket_count, 1)) {
+    char* mem = allocator_->AllocateAligned(sizeof(std::atomic<EntryList*>) *
+                                            bucket_count_);
+    buckets_ = reinterpret_cast<std::atomic<EntryList*>*>(mem);
+    for (size_t i = 0; i < bucket_count_; i++) {
+      new (&buckets_[i]) std::atomic<EntryList*>(nullptr);
+    }
+  }
+
+  void Insert(const char* entry) override {
+    GetOrCreateBucket(GetLengthPrefixedSlice(entry), false)->Insert(entry);
+  }
+
+  void InsertConcurrently(const char* entry) override {
+    GetOrCreateBucket(GetLengthPrefixedSlice(entry), true)
+        ->InsertConcurrently(entry);
+  }
+
+  const char* Lookup(const LookupKey& key) override {
+    // 同一个 user key 的所有版本都在同一个桶中，只需要搜索这一个桶
+    EntryList* bucket = buckets_[BucketIndex(key.internal_key())].load(
+        std::memory_order_acquire);
+    if (bucket == nullptr) {
+      return nullptr;
+    }
+    EntryList::Iterator iter(bucket);
+    iter.Seek(key.memtable_key().data());
+    return iter.Valid() ? iter.key() : nullptr;
+  }
+
+  // 把所有桶的 entry 收集到一个数组中排序后遍历
+  Iterator* GetIterator() override {
+    std::shared_ptr<EntryVector> entries = std::make_shared<EntryVector>();
+    for (size_t i = 0; i < bucket_count_; i++) {
+      EntryList* bucket = buckets_[i].load(std::memory_order_acquire);
+      if (bucket != nullptr) {
+        EntryList::Iterator iter(bucket);
+        for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+          entries->push_back(iter.key());
+        }
+      }
+    }
+    const KeyComparator& cmp = cmp_;
+    std::sort(entries->begin(), entries->end(),
+              [&cmp](const char* a, const char* b) { return cmp(a, b) < 0; });
+    return new VectorIterator(std::move(entries), cmp_);
+  }
+
+ private:
+  size_t BucketIndex(const Slice& internal_key) const {
+    Slice user_key = ExtractUserKey(internal_key);
+    return Hash(user_key.data(), std::min(prefix_length_, user_key.size()), 0) %
+           bucket_count_;
+  }
+
+  EntryList* GetOrCreateBucket(const Slice& internal_key, bool concurrent) {
+    std::atomic<EntryList*>& slot = buckets_[BucketIndex(internal_key)];
+    EntryList* bucket = slot.load(std::memory_order_acquire);
+    if (bucket != nullptr) {
+      return bucket;
+    }
+    char* mem = allocator_->AllocateAligned(sizeof(EntryList));
+    bucket = new (mem) EntryList(cmp_, allocator_);
+    if (!concurrent) {
+      slot.store(bucket, std::memory_order_release);
+      return bucket;
+    }
+    EntryList* expected = nullptr;
+    if (!slot.compare_exchange_strong(expected, bucket,
+                                      std::memory_order_release,
+                                      std::memory_order_acquire)) {
+      // 其他线程先创建了这个桶，本线程分配的跳表留在 allocator 中不再使用
+      bucket = expected;
+    }
+    return bucket;
+  }
+
+  const KeyComparator& cmp_;
+  const size_t prefix_length_;
+  const size_t bucket_count_;
+  std::atomic<EntryList*>* buckets_;
+};
+
+// 追加写入的数组。[0, sorted_) 有序，之后是尚未排序的新 entry；读取前把新 entry
+// 排序并与有序部分合并。读者持有数组的 shared_ptr，写入或排序时如果数组正在被
+// 读者使用就先复制一份(copy-on-write)，因此读者看到的数组不会被修改。
+class VectorRep : public MemTableRep {
+ public:
+  VectorRep(const KeyComparator& cmp, Allocator* allocator)
+      : MemTableRep(allocator), cmp_(cmp), entries_(std::make_shared<EntryVector>()), sorted_(0) {}
+
+  void Insert(const char* entry) override {
+    MutexLock l(&mutex_);
+    EntryVector* entries = MutableEntries();
+    // 按升序追加时数组保持有序，不需要排序
+    if (sorted_ == entries->size() &&
+        (sorted_ == 0 || cmp_(entries->back(), entry) < 0)) {
+      sorted_++;
+    }
+    entries->push_back(entry);
+  }
+
+  void InsertConcurrently(const char* entry) override { Insert(entry); }
+
+  const char* Lookup(const LookupKey& key) override {
+    std::shared_ptr<const EntryVector> entries = SortedEntries();
+    auto it = std::lower_bound(entries->begin(), entries->end(),
+                               key.memtable_key().data(), LessThan());
+    return it == entries->end() ? nullptr : *it;
+  }
+
+  void LookupSorted(const LookupKey* const* keys, size_t n,
+                    const char** entries) override {
+    std::shared_ptr<const EntryVector> sorted = SortedEntries();
+    // keys 升序，每次只需要在上一个结果之后查找
+    auto it = sorted->begin();
+    for (size_t i = 0; i < n; i++) {
+      it = std::lower_bound(it, sorted->end(), keys[i]->memtable_key().data(),
+                            LessThan());
+      entries[i] = it == sorted->end() ? nullptr : *it;
+    }
+  }
+
+  Iterator* GetIterator() override {
+    return new VectorIterator(SortedEntries(), cmp_);
+  }
+
+  size_t ApproximateMemoryUsage() override {
+    MutexLock l(&mutex_);
+    return entries_->capacity() * sizeof(const char*);
+  }
+
+ private:
+  struct Less {
+    const KeyComparator* cmp;
+    bool operator()(const char* a, const char* b) const {
+      return (*cmp)(a, b) < 0;
+    }
+  };
+  Less LessThan() const { return Less{&cmp_}; }
+
+  // REQUIRES: mutex_ 已加锁
+  EntryVector* MutableEntries() {
+    // 只有在持有 mutex_ 时才会复制 entries_，use_count() 为 1 说明没有读者
+    if (entries_.use_count() > 1) {
+      entries_ = std::make_shared<EntryVector>(*entries_);
+    }
+    return entries_.get();
+  }
+
+  std::shared_ptr<const EntryVector> SortedEntries() {
+    MutexLock l(&mutex_);
+    if (sorted_ < entries_->size()) {
+      EntryVector* entries = MutableEntries();
+      auto middle = entries->begin() + sorted_;
+      std::sort(middle, entries->end(), LessThan());
+      std::inplace_merge(entries->begin(), middle, entries->end(), LessThan());
+      sorted_ = entries->size();
+    }
+    return entries_;
+  }
+
+  const KeyComparator& cmp_;
+  Mutex mutex_;
+  std::shared_ptr<EntryVector> entries_;
+  size_t sorted_;  // entries_ 中有序前缀的长度
+};
+
+class SkipListRepFactory : public MemTableRepFactory {
+ public:
+  MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+                                 Allocator* allocator) const override {
+    return new SkipListRep(cmp, allocator);
+  }
+  const char* Name() const override { return "SkipListRepFactory"; }
+};
+
+class HashSkipListRepFactory : public MemTableRepFactory {
+ public:
+  HashSkipListRepFactory(size_t prefix_length, size_t bucket_count)
+      : prefix_length_(prefix_length), bucket_count_(bucket_count) {}
+
+  MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+                                 Allocator* allocator) const override {
+    return new HashSkipListRep(cmp, allocator, prefix_length_, bucket_count_);
+  }
+  const char* Name() const override { return "HashSkipListRepFactory"; }
+
+ private:
+  const size_t prefix_length_;
+  const size_t bucket_count_;
+};
+
+class VectorRepFactory : public MemTableRepFactory {
+ public:
+  MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+                                 Allocator* allocator) const override {
+    return new VectorRep(cmp, allocator);
+  }
+  const char* Name() const override { return "VectorRepFactory"; }
+};
+
+}  // namespace
+
+MemTableRepFactory* NewSkipListRepFactory() { return new SkipListRepFactory; }
+
+MemTableRepFactory* NewHashSkipListRepFactory(size_t prefix_length,
+                                              size_t bucket_count) {
+  return new HashSkipListRepFactory(prefix_length, bucket_count);
+}
+
+MemTableRepFactory* NewVectorRepFactory() { return new VectorRepFactory; }
+
+}  // namespace leveldb
@@ -0,0 +1,126 @@
+#ifndef STORAGE_LEVELDB_DB_MEMTABLEREP_H_
+#define STORAGE_LEVELDB_DB_MEMTABLEREP_H_
+
+#include <cstddef>
+
+#include "allocator.h"
+#include "dbformat.h"
+
+namespace leveldb {
+
+// 解析 entry 开头的长度前缀字符串(memtable 中的 internal key)
+inline Slice GetLengthPrefixedSlice(const char* data) {
+  uint32_t len;
+  const char* p = data;
+  p = GetVarint32Ptr(p, p + 5, &len);  // +5: we assume "p" is not corrupted
+  return Slice(p, len);
+}
+
+// MemTable 底层保存 entry 的数据结构。
+// entry 的格式见 MemTable::EncodeEntry，以长度前缀的 internal key 开头。
+// MemTable 通过 Allocate 申请 entry 的内存，写入之后再调用 Insert；
+// rep 可以把 entry 与自己的索引节点放在同一块内存中(默认的跳表实现)。
+//
+// 线程安全：Insert 由调用者保证互斥；InsertConcurrently 可以被多个线程同时调用；
+// 读操作(Lookup/迭代器)可以与任意一种插入并发。
+class MemTableRep {
+ public:
+  // 比较两条 entry 开头的 internal key
+  struct KeyComparator {
+    const InternalKeyComparator comparator;
+    // user key 按字节序比较时，user key 的前 8 字节可以作为有序前缀
+    const bool bytewise;
+
+    explicit KeyComparator(const InternalKeyComparator& c)
+        : comparator(c), bytewise(c.user_comparator() == BytewiseComparator()) {}
+    int operator()(const char* a, const char* b) const;
+
+    // user key 前 8 字节按大端序组成的整数，不足 8 字节补 0，满足
+    // KeyPrefix(a) < KeyPrefix(b) 时 a < b，供 InlineSkipList 跳过完整比较。
+    // 非字节序的比较器返回 0。
+    uint64_t KeyPrefix(const char* entry) const;
+  };
+
+  // 按 internal key 有序遍历 entry
+  class Iterator {
+   public:
+    virtual ~Iterator() = default;
+
+    virtual bool Valid() const = 0;
+    // 当前 entry。REQUIRES: Valid()
+    virtual const char* key() const = 0;
+    virtual void Next() = 0;
+    virtual void Prev() = 0;
+    // 定位到第一个不小于 memtable_key(长度前缀的 internal key)的 entry
+    virtual void Seek(const char* memtable_key) = 0;
+    virtual void SeekToFirst() = 0;
+    virtual void SeekToLast() = 0;
+  };
+
+  explicit MemTableRep(Allocator* allocator) : allocator_(allocator) {}
+
+  MemTableRep(const MemTableRep&) = delete;
+  MemTableRep& operator=(const MemTableRep&) = delete;
+
+  virtual ~MemTableRep() = default;
+
+  // 为一条 len 字节的 entry 分配内存，可以被多个线程同时调用。
+  // 返回的内存只能用于之后的 Insert/InsertConcurrently。默认直接从 allocator 分配。
+  virtual char* Allocate(size_t len) { return allocator_->Allocate(len); }
+
+  // 插入一条由 Allocate 分配并已写入的 entry，要求 rep 中没有与它 internal key 相同的 entry
+  virtual void Insert(const char* entry) = 0;
+
+  // 同 Insert，但允许多个线程同时调用
+  virtual void InsertConcurrently(const char* entry) = 0;
+
+  // 点查：若 rep 中存在 user key 与 key 相同、序列号不大于 key 的 entry，返回其中
+  // 序列号最大的一条；否则返回 nullptr 或者任意一条 user key 不同的 entry。
+  virtual const char* Lookup(const LookupKey& key) = 0;
+
+  // 批量点查：entries[i] 为 Lookup(*keys[i]) 的结果。keys 按 internal key 升序。
+  // 默认实现逐个调用 Lookup。
+  virtual void LookupSorted(const LookupKey* const* keys, size_t n,
+                            const char** entries);
+
+  // 返回一个遍历全部 entry 的迭代器，调用者负责 delete
+  virtual Iterator* GetIterator() = 0;
+
+  // 除 allocator 以外额外占用的内存(例如索引数组)
+  virtual size_t ApproximateMemoryUsage() { return 0; }
+
+ protected:
+  Allocator* const allocator_;
+};
+
+// 创建 MemTableRep。Options::memtable_factory 或 MemTable 的构造函数通过它选择实现。
+class MemTableRepFactory {
+ public:
+  virtual ~MemTableRepFactory() = default;
+
+  // 返回的 rep 只能引用 cmp 和 allocator，它们的生命周期都比 rep 长
+  virtual MemTableRep* CreateMemTableRep(const MemTableRep::KeyComparator& cmp,
+                                         Allocator* allocator) const = 0;
+
+  virtual const char* Name() const = 0;
+};
+
+// 跳表(默认实现)：插入和查找都是 O(log n)，支持并发插入，批量查找使用 finger search。
+// entry 内联在跳表节点中，节点同时缓存 user key 的 8 字节前缀，见 inline_skiplist.h。
+MemTableRepFactory* NewSkipListRepFactory();
+
+// 按 user key 的前 prefix_length 字节(不足时取整个 user key)哈希到 bucket_count 个桶，
+// 每个桶是一个独立的跳表。点查只搜索一个桶，适合以点查为主、前缀分布较散的负载；
+// 有序遍历需要先把所有桶的 entry 收集起来排序，代价为 O(n log n)。
+MemTableRepFactory* NewHashSkipListRepFactory(size_t prefix_length,
+                                              size_t bucket_count = 50000);
+
+// 追加写入的数组，第一次读取时才把新写入的部分排序并与已排序部分合并。
+// 适合先批量写入、再集中读取(flush)的导入场景；读写交替时每次读都要重新排序。
+MemTableRepFactory* NewVectorRepFactory();
+
+// 以上函数返回的对象由调用者 delete，必须在所有使用它的 MemTable/DB 释放之后。
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_MEMTABLEREP_H_
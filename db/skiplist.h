@@ -1,11 +1,14 @@
 #ifndef SKIPLIST_H_
 #define SKIPLIST_H_
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstdlib>
+#include <functional>
+#include <thread>
 
-#include "arena.h"
+#include "allocator.h"
 #include "random.h"
 
 namespace leveldb
@@ -23,18 +26,42 @@ class SkipList
 private:
     // 跳表中的节点
     struct Node;
+    enum { kMaxHeight = 12 };   // 可以增长到的最大高度
 
 public:
-    explicit SkipList(Comparator cmp, Arena* arena);
+    // 节点内存从 allocator 分配；使用 InsertConcurrently 时 allocator 必须是线程安全的
+    explicit SkipList(Comparator cmp, Allocator* allocator);
 
     SkipList(const SkipList&) = delete;
     SkipList& operator=(const SkipList&) = delete;
 
     // Insert key into the list. 插入前确保list中无要插入的key
     void Insert(const Key& key);
+    // 与 Insert 相同，但允许多个线程同时调用：每一层通过 CAS 链接新节点。
+    // 可以与读操作并发，但不能与 Insert 并发混用；同样要求 key 不重复。
+    // 节点内存直接从 allocator 分配，需要配合 ConcurrentArena 这类线程安全的实现。
+    void InsertConcurrently(const Key& key);
     // Returns true iff an entry that compares equal to key is in the list.
     bool Contains(const Key& key) const;
 
+    // 插入位置提示：缓存上一次 InsertWithHint 在每一层的前驱(splice)。
+    // 同一个 hint 只能用于同一个跳表，初始为空，第一次使用时做一次完整查找。
+    class InsertHint
+    {
+    public:
+        InsertHint() : height_(0) {}
+    private:
+        friend class SkipList;
+        int height_;                // prev_ 中已经初始化的层数
+        Node* prev_[kMaxHeight];    // 每一层最后一个小于上一次插入 key 的节点
+    };
+
+    // 与 Insert 相同，但先验证 hint 中缓存的前驱：从第 0 层往上找到第一层前驱小于 key、
+    // 后继不小于 key 的层，只在这一层以下重新查找。key 按升序(或大致升序)到达时，
+    // 通常第 0 层就能命中，均摊 O(1) 次比较；hint 失效时退化为从 head_ 开始的完整查找。
+    // 与 Insert 一样需要外部同步，可以与 Insert 混用。
+    void InsertWithHint(const Key& key, InsertHint* hint);
+
     // 跳表迭代器，用于遍历
     class Iterator
     {
@@ -52,9 +79,26 @@ public:
         Node* node_;    //当前指向的节点
     };
 
-private:
-    enum { kMaxHeight = 12 };   // 可以增长到的最大高度
+    // 按升序依次定位一批 key 的迭代器(finger search)。
+    // 保存上一次 Seek 在每一层经过的最后一个小于目标的节点(finger)，下一次 Seek
+    // 先沿着 finger 向上回溯到还能向后跳的最高层，再从那里向下查找；相邻两个目标
+    // 之间隔着 d 个节点时代价为 O(log d)，而不是每次都从 head_ 开始的 O(log n)。
+    // 每次 Seek 的 target 必须不小于上一次的 target。可以与 Insert 并发。
+    class FingerIterator
+    {
+    public:
+        explicit FingerIterator(const SkipList* list);
+        bool Valid() const;
+        const Key& key() const;
+        void Seek(const Key& target);   // 将node_调整到第0层大于等于target的节点
+    private:
+        const SkipList* list_;
+        Node* node_;
+        int height_;                    // finger_ 中已经初始化的层数
+        Node* finger_[kMaxHeight];      // 上一次查找在每一层的前驱
+    };
 
+private:
     inline int GetMaxHeight() const
     {
         return max_height_.load(std::memory_order_relaxed);
@@ -63,6 +107,8 @@ private:
     Node* NewNode(const Key& key, int height);
     // 高度随机增加，增加多少不确定
     int RandomHeight();
+    // rnd_ 不是线程安全的，并发插入时每个线程使用自己的随机数生成器
+    int RandomHeight(Random* rnd);
     // key值相等返回true
     bool Equal(const Key& a, const Key& b) const { return (compare_(a, b) == 0); }
     // Return true if key is greater than the data stored in "n"，不包括等于
@@ -74,10 +120,14 @@ private:
     Node* FindLessThan(const Key& key) const;
     // 返回跳表第0层的尾部节点
     Node* FindLast() const;
+    // 从 before 开始在第 level 层向后查找 key 的插入位置：
+    // *out_prev 为该层最后一个小于 key 的节点，*out_next 为其后继
+    void FindSpliceForLevel(const Key& key, Node* before, int level,
+                            Node** out_prev, Node** out_next) const;
 
 private:
     Comparator const compare_;      // 比较
-    Arena* const arena_;            // Arena used for allocations of nodes
+    Allocator* const allocator_;    // Allocator used for allocations of nodes
     Node* const head_;              // 头节点
     std::atomic<int> max_height_;   // 当前跳表最大高度
     Random rnd_;
@@ -121,6 +171,14 @@ struct SkipList<Key, Comparator>::Node
         assert(n >= 0);
         next_[n].store(x, std::memory_order_relaxed);
     }
+    // 仅当第 n 层的后继仍为 expected 时才设置为 x，成功时带 release 语义
+    bool CASNext(int n, Node* expected, Node* x)
+    {
+        assert(n >= 0);
+        return next_[n].compare_exchange_strong(expected, x,
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed);
+    }
 
 private:
 	// 作为Node的最后一个成员变量,由于Node通过placement new的方式构造，因此next_实际上是一个不定长的数组
@@ -133,7 +191,7 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::NewNode(
     const Key& key, int height)
 {
     // node数据结构的大小+（height-1）个所需存储的指向下一个Node的空间（每一层都需要指向下一个结点）
-    char* const node_memory = arena_->AllocateAligned(
+    char* const node_memory = allocator_->AllocateAligned(
         sizeof(Node) + sizeof(std::atomic<Node*>) * (height - 1));
     return new (node_memory) Node(key); //使用new 的步骤2，placement new，来调用node的构造函数。
 }
@@ -198,8 +256,85 @@ inline void SkipList<Key, Comparator>::Iterator::SeekToLast()
     }
 }
 
+template <typename Key, class Comparator>
+inline SkipList<Key, Comparator>::FingerIterator::FingerIterator(const SkipList* list)
+    : list_(list), node_(nullptr), height_(0)
+{
+}
+
+template <typename Key, class Comparator>
+inline bool SkipList<Key, Comparator>::FingerIterator::Valid() const
+{
+    return node_ != nullptr;
+}
+
+template <typename Key, class Comparator>
+inline const Key& SkipList<Key, Comparator>::FingerIterator::key() const
+{
+    assert(Valid());
+    return node_->key;
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::FingerIterator::Seek(const Key& target)
+{
+    // 跳表高度只增不减，新增的层从 head_ 开始
+    const int max_height = list_->GetMaxHeight();
+    for (int i = height_; i < max_height; i++)
+    {
+        finger_[i] = list_->head_;
+    }
+    height_ = max_height;
+
+    // 1.向上回溯：上一层的 finger 仍能向后跳(后继小于 target)时才上去。
+    //   finger_[i] 都小于上一次的 target，因此也小于这一次的，从任何一层开始向下找都是正确的
+    int level = 0;
+    while (level + 1 < max_height &&
+           list_->KeyIsAfterNode(target, finger_[level + 1]->Next(level + 1)))
+    {
+        level++;
+    }
+
+    // 2.从 finger_[level] 开始向下查找，并更新经过的每一层的 finger。
+    //   比较当前节点时预取接下来可能访问的节点：同一层的下一个节点，以及下一层的后继，
+    //   让两次 cache miss 与比较重叠
+    Node* x = finger_[level];
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (next != nullptr)
+        {
+            __builtin_prefetch(next->NoBarrier_Next(level));
+        }
+        if (level > 0)
+        {
+            __builtin_prefetch(x->NoBarrier_Next(level - 1));
+        }
+        if (list_->KeyIsAfterNode(target, next))
+        {
+            x = next;
+        }
+        else
+        {
+            finger_[level] = x;
+            if (level == 0)
+            {
+                node_ = next;
+                return;
+            }
+            level--;
+        }
+    }
+}
+
 template <typename Key, class Comparator>
 int SkipList<Key, Comparator>::RandomHeight()
+{
+    return RandomHeight(&rnd_);
+}
+
+template <typename Key, class Comparator>
+int SkipList<Key, Comparator>::RandomHeight(Random* rnd)
 {
     static const unsigned int kBranching = 4;
     int height = 1;
@@ -209,7 +344,7 @@ int SkipList<Key, Comparator>::RandomHeight()
     // 如果节点个数为 n，那么有 12 层的节点有 n/12 个，11 层的有 n/12+n/12(需要把12层的也加上)，
     // 节点太多，最上层平均前进一次才右移 12 个节点，下面层就更不用说了，效率低；
     // 作者的方法是每一层会按照4的倍数减少，出现4层的概率只有出现3层概率的1/4，这样查询起来效率是不是大大提升了呢
-    while (height < kMaxHeight && rnd_.OneIn(kBranching))
+    while (height < kMaxHeight && rnd->OneIn(kBranching))
     {
         height++;
     }
@@ -309,9 +444,31 @@ typename SkipList<Key, Comparator>::Node* SkipList<Key, Comparator>::FindLast()
 }
 
 template <typename Key, class Comparator>
-SkipList<Key, Comparator>::SkipList(Comparator cmp, Arena* arena)
+void SkipList<Key, Comparator>::FindSpliceForLevel(const Key& key, Node* before,
+                                                   int level, Node** out_prev,
+                                                   Node** out_next) const
+{
+    Node* x = before;
+    while (true)
+    {
+        Node* next = x->Next(level);
+        if (KeyIsAfterNode(key, next))
+        {
+            x = next;
+        }
+        else
+        {
+            *out_prev = x;
+            *out_next = next;
+            return;
+        }
+    }
+}
+
+template <typename Key, class Comparator>
+SkipList<Key, Comparator>::SkipList(Comparator cmp, Allocator* allocator)
     : compare_(cmp),
-    arena_(arena),
+    allocator_(allocator),
     head_(NewNode(0, kMaxHeight)),
     max_height_(1),
     rnd_(0xdeadbeef)
@@ -359,6 +516,125 @@ void SkipList<Key, Comparator>::Insert(const Key& key)
     }
 }
 
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertConcurrently(const Key& key)
+{
+    // 每个线程一个随机数生成器，种子取自线程 id
+    static thread_local Random rnd(static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id())));
+
+    // 1.先在当前跳表上找一遍各层的前驱，此时其他线程可能还在插入，
+    //   这里得到的 prev 只保证 key 比 prev[i] 大，链接时会再逐层修正。
+    //   max_height 必须在查找之前读取：高度只增不减，查找至少填充了 [0, max_height)
+    int max_height = GetMaxHeight();
+    Node* prev[kMaxHeight];
+    FindGreaterOrEqual(key, prev);
+
+    // 2.随机高度；新增层的前驱一律从 head_ 开始，head_ 比任何 key 都小，总是合法的前驱。
+    //   max_height_ 可能被多个线程同时抬高，用 CAS 保证只增不减
+    int height = RandomHeight(&rnd);
+    for (int i = max_height; i < height; i++)
+    {
+        prev[i] = head_;
+    }
+    while (height > max_height)
+    {
+        // 失败时 max_height 被更新为最新值，若其他线程已经抬到更高就退出
+        if (max_height_.compare_exchange_weak(max_height, height,
+                                              std::memory_order_relaxed))
+        {
+            break;
+        }
+    }
+
+    // 3.从第 0 层往上逐层链接。每一层先从 prev[i] 向后修正出准确的前驱/后继，
+    //   再 CAS 前驱的 next；失败说明有别的线程刚在这里插入了节点，重新查找即可。
+    //   先链接低层保证节点一旦在高层可见，它在低层一定也可见。
+    Node* x = NewNode(key, height);
+    for (int i = 0; i < height; i++)
+    {
+        while (true)
+        {
+            Node* next;
+            FindSpliceForLevel(key, prev[i], i, &prev[i], &next);
+            assert(next == nullptr || !Equal(key, next->key));
+            x->NoBarrier_SetNext(i, next);
+            if (prev[i]->CASNext(i, next, x))
+            {
+                break;
+            }
+        }
+    }
+}
+
+template <typename Key, class Comparator>
+void SkipList<Key, Comparator>::InsertWithHint(const Key& key, InsertHint* hint)
+{
+    Node** prev = hint->prev_;
+    const int max_height = GetMaxHeight();
+    // head_ 比任何 key 都小，新增的层从 head_ 开始总是合法的前驱
+    for (int i = hint->height_; i < max_height; i++)
+    {
+        prev[i] = head_;
+    }
+
+    // 1.验证缓存的 splice：找到最低的一层 level，其前驱小于 key 且当前后继不小于 key。
+    //   缓存的前驱满足 prev[i + 1] <= prev[i]，上层前驱只会更靠左，因此越往上越容易命中
+    int level = 0;
+    while (level < max_height)
+    {
+        if ((prev[level] == head_ || compare_(prev[level]->key, key) < 0) &&
+            !KeyIsAfterNode(key, prev[level]->Next(level)))
+        {
+            break;
+        }
+        level++;
+    }
+
+    Node* next;
+    if (level == max_height)
+    {
+        // 所有层都不可用(key 远离上一次插入的位置)，从 head_ 开始完整查找，
+        // 得到的每一层前驱都是准确的，第 3 步不需要再修正
+        FindGreaterOrEqual(key, prev);
+    }
+    else
+    {
+        // 2.level 以下从 prev[level] 向下重新查找
+        for (int i = level - 1; i >= 0; i--)
+        {
+            FindSpliceForLevel(key, prev[i + 1], i, &prev[i], &next);
+        }
+    }
+    assert(prev[0]->Next(0) == nullptr || !Equal(key, prev[0]->Next(0)->key));
+
+    int height = RandomHeight();
+    if (height > max_height)
+    {
+        for (int i = max_height; i < height; i++)
+        {
+            prev[i] = head_;
+        }
+        max_height_.store(height, std::memory_order_relaxed);
+    }
+
+    // 3.level 以上的前驱都小于 key，但其他 Insert 可能在它后面插入了节点，
+    //   链接前从缓存的前驱向后修正到准确位置
+    Node* x = NewNode(key, height);
+    for (int i = 0; i < height; i++)
+    {
+        if (i > level)
+        {
+            FindSpliceForLevel(key, prev[i], i, &prev[i], &next);
+        }
+        x->NoBarrier_SetNext(i, prev[i]->NoBarrier_Next(i));
+        prev[i]->SetNext(i, x);
+        // 下一个 key 大概率紧跟在 x 之后
+        prev[i] = x;
+    }
+    hint->height_ = std::max(max_height, height);
+}
+
 template <typename Key, class Comparator>
 bool SkipList<Key, Comparator>::Contains(const Key& key) const
 {
@@ -0,0 +1,45 @@
+#ifndef STORAGE_LEVELDB_DB_WRITE_BATCH_INTERNAL_H_
+#define STORAGE_LEVELDB_DB_WRITE_BATCH_INTERNAL_H_
+
+#include "dbformat.h"
+#include "write_batch.h"
+
+namespace leveldb {
+
+class MemTable;
+
+// WriteBatchInternal provides static methods for manipulating a
+// WriteBatch that we don't want in the public WriteBatch interface.
+class WriteBatchInternal {
+ public:
+  // 返回 batch 中的更新条数
+  static int Count(const WriteBatch* batch);
+
+  // 设置 batch 中的更新条数
+  static void SetCount(WriteBatch* batch, int n);
+
+  // 返回 batch 中第一条更新的序列号，后续更新的序列号依次加 1
+  static SequenceNumber Sequence(const WriteBatch* batch);
+
+  // 设置 batch 中第一条更新的序列号
+  static void SetSequence(WriteBatch* batch, SequenceNumber seq);
+
+  // batch 的编码，可以原样写入 WAL
+  static Slice Contents(const WriteBatch* batch) { return Slice(batch->rep_); }
+
+  static size_t ByteSize(const WriteBatch* batch) { return batch->rep_.size(); }
+
+  // 用一条 WAL 记录(或复制收到的数据)恢复 batch，contents 的格式必须与 Contents() 相同
+  static void SetContents(WriteBatch* batch, const Slice& contents);
+
+  // 把 batch 中的更新依次插入 memtable，key/value 直接从 batch 的编码中取出，
+  // 不产生中间的字符串拷贝
+  static Status InsertInto(const WriteBatch* batch, MemTable* memtable);
+
+  // 把 src 中的更新追加到 dst 的末尾
+  static void Append(WriteBatch* dst, const WriteBatch* src);
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_WRITE_BATCH_INTERNAL_H_
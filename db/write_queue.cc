@@ -0,0 +1,190 @@
+#include "write_queue.h"
+
+#include "env.h"
+#include "log_writer.h"
+#include "memtable.h"
+#include "write_batch_internal.h"
+
+namespace leveldb {
+
+// 等待写入的线程
+struct WriteQueue::Writer {
+  Writer(Mutex* mu, bool s, WriteBatch* b)
+      : batch(b), sync(s), done(false), cv(mu) {}
+
+  Status status;
+  WriteBatch* batch;
+  bool sync;
+  bool done;
+  CondVar cv;
+};
+
+WriteQueue::WriteQueue(log::Writer* log, WritableFile* logfile, MemTable* mem,
+                       SequenceNumber last_sequence)
+    : log_(log),
+      logfile_(logfile),
+      mem_(mem),
+      last_sequence_(last_sequence),
+      num_records_(0),
+      num_syncs_(0) {}
+
+WriteQueue::~WriteQueue() { assert(writers_.empty()); }
+
+Status WriteQueue::Put(const WriteOptions& options, const Slice& key,
+                       const Slice& value) {
+  WriteBatch batch;
+  batch.Put(key, value);
+  return Write(options, &batch);
+}
+
+Status WriteQueue::Delete(const WriteOptions& options, const Slice& key) {
+  WriteBatch batch;
+  batch.Delete(key);
+  return Write(options, &batch);
+}
+
+void WriteQueue::SwitchMemTable(log::Writer* log, WritableFile* logfile,
+                                MemTable* mem) {
+  // batch 为 nullptr 的写入者不会被合并进其他写入组
+  Writer w(&mutex_, false, nullptr);
+
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  while (&w != writers_.front()) {
+    w.cv.Wait();
+  }
+  log_ = log;
+  logfile_ = logfile;
+  mem_ = mem;
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+}
+
+SequenceNumber WriteQueue::LastSequence() {
+  MutexLock l(&mutex_);
+  return last_sequence_;
+}
+
+uint64_t WriteQueue::NumLogRecords() {
+  MutexLock l(&mutex_);
+  return num_records_;
+}
+
+uint64_t WriteQueue::NumSyncs() {
+  MutexLock l(&mutex_);
+  return num_syncs_;
+}
+
+Status WriteQueue::Write(const WriteOptions& options, WriteBatch* updates) {
+  Writer w(&mutex_, options.sync, updates);
+
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  // 不是队首的线程等待，直到被 leader 写完或者轮到自己成为 leader
+  while (!w.done && &w != writers_.front()) {
+    w.cv.Wait();
+  }
+  if (w.done) {
+    return w.status;
+  }
+
+  // 当前线程成为 leader
+  Status status = bg_error_;
+  Writer* last_writer = &w;
+  if (status.ok()) {
+    WriteBatch* write_batch = BuildWriteGroup(&last_writer);
+    WriteBatchInternal::SetSequence(write_batch, last_sequence_ + 1);
+    const int count = WriteBatchInternal::Count(write_batch);
+
+    // 写日志和插入 memtable 时释放锁，新来的写线程可以继续排队，它们会组成
+    // 下一个写入组。此时只有 leader 会访问 log_ 和 write_batch。
+    {
+      mutex_.Unlock();
+      status = log_->AddRecord(WriteBatchInternal::Contents(write_batch));
+      const bool sync = w.sync;
+      if (status.ok() && sync) {
+        status = logfile_->Sync();
+      }
+      if (status.ok()) {
+        status = WriteBatchInternal::InsertInto(write_batch, mem_);
+      }
+      mutex_.Lock();
+      num_records_++;
+      if (sync) {
+        num_syncs_++;
+      }
+    }
+    if (status.ok()) {
+      last_sequence_ += count;
+    } else {
+      // 日志中可能已经写入了部分内容，状态未知，之后的写入全部失败
+      bg_error_ = status;
+    }
+    if (write_batch == &tmp_batch_) {
+      tmp_batch_.Clear();
+    }
+  }
+
+  // 通知组内的 follower 写入已完成
+  while (true) {
+    Writer* ready = writers_.front();
+    writers_.pop_front();
+    if (ready != &w) {
+      ready->status = status;
+      ready->done = true;
+      ready->cv.Signal();
+    }
+    if (ready == last_writer) break;
+  }
+
+  // 唤醒下一个写入组的 leader
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
+
+  return status;
+}
+
+WriteBatch* WriteQueue::BuildWriteGroup(Writer** last_writer) {
+  assert(!writers_.empty());
+  Writer* first = writers_.front();
+  WriteBatch* result = first->batch;
+  assert(result != nullptr);
+
+  // 限制写入组的大小；如果第一个写入很小，则限制得更小，以免小写入的延迟
+  // 被大量合并的数据拖慢
+  size_t size = WriteBatchInternal::ByteSize(first->batch);
+  size_t max_size = 1 << 20;
+  if (size <= (128 << 10)) {
+    max_size = size + (128 << 10);
+  }
+
+  *last_writer = first;
+  std::deque<Writer*>::iterator iter = writers_.begin();
+  ++iter;  // Advance past "first"
+  for (; iter != writers_.end(); ++iter) {
+    Writer* w = *iter;
+    // 不把要求 sync 的写入放进不做 sync 的写入组
+    if (w->sync && !first->sync) break;
+
+    // SwitchMemTable 的占位写入者，它之后的写入要写到新的 memtable
+    if (w->batch == nullptr) break;
+
+    size += WriteBatchInternal::ByteSize(w->batch);
+    if (size > max_size) break;
+
+    // 组内有多个写入者时合并到 tmp_batch_，不修改调用者的 batch
+    if (result == first->batch) {
+      result = &tmp_batch_;
+      assert(WriteBatchInternal::Count(result) == 0);
+      WriteBatchInternal::Append(result, first->batch);
+    }
+    WriteBatchInternal::Append(result, w->batch);
+    *last_writer = w;
+  }
+  return result;
+}
+
+}  // namespace leveldb
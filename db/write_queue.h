@@ -0,0 +1,88 @@
+#ifndef STORAGE_LEVELDB_DB_WRITE_QUEUE_H_
+#define STORAGE_LEVELDB_DB_WRITE_QUEUE_H_
+
+#include <deque>
+#include <string>
+
+#include "dbformat.h"
+#include "mutex.h"
+#include "options.h"
+#include "slice.h"
+#include "status.h"
+#include "write_batch.h"
+
+namespace leveldb {
+
+class MemTable;
+class WritableFile;
+
+namespace log {
+class Writer;
+}
+
+// 组提交(group commit)写入队列。
+//
+// 并发的写线程排队进入 writers_，队首的线程成为 leader：它把队列中紧随其后的
+// 写入合并成一个写入组，编码为一条 WAL 记录，只调用一次 AddRecord 和(需要时)
+// 一次 Sync，然后把整组写入插入 memtable，最后唤醒组内的 follower。
+// 这样 N 个并发的 sync 写入只需要一次 fsync，而不是 N 次。
+//
+// 每个写入组编码为一个 WriteBatch(格式见 write_batch.cc)，原样作为一条 WAL 记录。
+class WriteQueue {
+ public:
+  // log/logfile/mem 的生命期不能短于 WriteQueue；logfile 为 log 写入的文件，
+  // 用于 Sync。last_sequence 为已经写入的最后一个序列号。
+  WriteQueue(log::Writer* log, WritableFile* logfile, MemTable* mem,
+             SequenceNumber last_sequence);
+
+  WriteQueue(const WriteQueue&) = delete;
+  WriteQueue& operator=(const WriteQueue&) = delete;
+
+  ~WriteQueue();
+
+  // 原子地写入 updates 中的所有更新，可以被多个线程同时调用。
+  Status Write(const WriteOptions& options, WriteBatch* updates);
+
+  // 写入 key->value，可以被多个线程同时调用。
+  Status Put(const WriteOptions& options, const Slice& key,
+             const Slice& value);
+
+  // 删除 key，可以被多个线程同时调用。
+  Status Delete(const WriteOptions& options, const Slice& key);
+
+  // 把之后的写入切换到新的日志和 memtable。该操作像写入一样在队列中排队，
+  // 在它之前的写入组全部完成之后才执行，返回后 WriteQueue 不再访问旧的 log/logfile/mem。
+  void SwitchMemTable(log::Writer* log, WritableFile* logfile, MemTable* mem);
+
+  // 返回最后一个已经写入 memtable 的序列号
+  SequenceNumber LastSequence();
+
+  // 返回目前为止写入日志的记录(写入组)数以及 Sync 的次数，用于观察合并效果
+  uint64_t NumLogRecords();
+  uint64_t NumSyncs();
+
+ private:
+  struct Writer;
+
+  // 从队首开始选出一个写入组，返回合并后的 batch，*last_writer 为组内最后一个写入者。
+  // 组内只有一个写入者时直接返回它的 batch，不做拷贝。
+  // REQUIRES: mutex_ 已加锁，writers_ 不为空
+  WriteBatch* BuildWriteGroup(Writer** last_writer);
+
+  // 只有位于队首的写入者(leader 或者 SwitchMemTable)会访问
+  log::Writer* log_;
+  WritableFile* logfile_;
+  MemTable* mem_;
+
+  Mutex mutex_;
+  std::deque<Writer*> writers_;  // 等待写入的线程，队首为当前的 leader
+  SequenceNumber last_sequence_;
+  WriteBatch tmp_batch_;  // 合并写入组的缓冲区，只有 leader 会使用
+  uint64_t num_records_;
+  uint64_t num_syncs_;
+  Status bg_error_;  // 日志写入失败后，之后的写入都返回该错误
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_WRITE_QUEUE_H_
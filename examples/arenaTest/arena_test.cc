@@ -1,7 +1,10 @@
 #include "arena.h"
+#include "concurrent_arena.h"
 #include "random.h"
 #include "gtest/gtest.h"
 
+#include <thread>
+
 namespace leveldb
 {
 
@@ -78,4 +81,119 @@ TEST(ArenaTest, Simple)
     }
 }
 
+TEST(ArenaTest, MmapBlocks)
+{
+    // 2MB 的 mmap 块，小分配都落在同一个块里；大于块大小 1/4 的分配单独申请
+    const size_t kBlock = 2 * 1024 * 1024;
+    char* first = nullptr;
+    for (int round = 0; round < 2; round++)
+    {
+        Arena arena(kBlock, true);
+        char* small = arena.AllocateAligned(100);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(small) & 7, 0u);
+        memset(small, 0xab, 100);
+        char* big = arena.Allocate(kBlock);
+        memset(big, 0xcd, kBlock);
+        ASSERT_GE(arena.MemoryUsage(), 2 * kBlock);
+        ASSERT_LE(arena.MemoryUsage(), 2 * kBlock + 64);
+        for (int i = 0; i < 100; i++)
+        {
+            ASSERT_EQ(int(small[i]) & 0xff, 0xab);
+        }
+        if (round == 0)
+        {
+            first = small;
+        }
+        else
+        {
+            // 上一个 Arena 析构时块归还给了块池，这次应当复用同一个块
+            ASSERT_EQ(first, small);
+        }
+    }
+}
+
+TEST(ConcurrentArenaTest, Simple)
+{
+    ConcurrentArena arena;
+    std::vector<std::pair<size_t, char*>> allocated;
+    size_t bytes = 0;
+    Random rnd(301);
+    for (int i = 0; i < 20000; i++)
+    {
+        size_t s = rnd.OneIn(100) ? rnd.Uniform(6000) + 1 : rnd.Uniform(100) + 1;
+        char* r = rnd.OneIn(2) ? arena.AllocateAligned(s) : arena.Allocate(s);
+        memset(r, i % 256, s);
+        bytes += s;
+        allocated.push_back(std::make_pair(s, r));
+        ASSERT_GE(arena.MemoryUsage(), bytes);
+    }
+    for (size_t i = 0; i < allocated.size(); i++)
+    {
+        for (size_t b = 0; b < allocated[i].first; b++)
+        {
+            ASSERT_EQ(int(allocated[i].second[b]) & 0xff, i % 256);
+        }
+    }
+}
+
+TEST(ConcurrentArenaTest, ShardsComeFromBlocks)
+{
+    // shard 从共享 Arena 的块中切出：第一次分配只申请一个完整的块
+    {
+        ConcurrentArena arena(4096, 2 * 1024 * 1024, true);
+        memset(arena.Allocate(100), 1, 100);
+        ASSERT_EQ(arena.MemoryUsage(), 2 * 1024 * 1024 + sizeof(char*));
+    }
+    // 块小于 shard 的 4 倍时按 4 倍取，否则 shard 会绕过块单独申请
+    {
+        ConcurrentArena arena(4096, 4096, false);
+        memset(arena.Allocate(100), 1, 100);
+        ASSERT_EQ(arena.MemoryUsage(), 4 * 4096 + sizeof(char*));
+    }
+}
+
+TEST(ConcurrentArenaTest, MultiThreaded)
+{
+    // 每个线程往自己分配到的内存里写入自己的编号，若不同线程拿到了重叠的内存，校验会失败
+    const int kThreads = 8;
+    const int kAllocsPerThread = 20000;
+    ConcurrentArena arena;
+    std::vector<std::vector<std::pair<size_t, char*>>> allocated(kThreads);
+    std::vector<size_t> bytes(kThreads, 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++)
+    {
+        threads.emplace_back([&, t]() {
+            Random rnd(t + 1);
+            for (int i = 0; i < kAllocsPerThread; i++)
+            {
+                size_t s = rnd.OneIn(500) ? rnd.Uniform(5000) + 1 : rnd.Uniform(64) + 1;
+                char* r = rnd.OneIn(2) ? arena.AllocateAligned(s) : arena.Allocate(s);
+                memset(r, t, s);
+                allocated[t].push_back(std::make_pair(s, r));
+                bytes[t] += s;
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    size_t total = 0;
+    for (int t = 0; t < kThreads; t++)
+    {
+        total += bytes[t];
+        for (auto& a : allocated[t])
+        {
+            for (size_t b = 0; b < a.first; b++)
+            {
+                ASSERT_EQ(a.second[b], t);
+            }
+        }
+    }
+    ASSERT_GE(arena.MemoryUsage(), total);
+}
+
 }  // namespace leveldb
@@ -0,0 +1,71 @@
+// 布隆过滤器基准：NewBloomFilterPolicy 与 NewBlockedBloomFilterPolicy 的误判率和单次查询耗时对比。
+// 过滤器大小超过 L2 时，原始格式的一次否定查询可能访问多条 cache line，差别更明显。
+// 用法: ./bloom_bench [key 个数, 默认 1000000] [bits_per_key, 默认 10]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "coding.h"
+#include "filter_policy.h"
+#include "slice.h"
+
+using namespace leveldb;
+
+static void Run(const char* name, const FilterPolicy* policy, int num)
+{
+    std::vector<std::string> storage(num);
+    std::vector<Slice> keys(num);
+    for (int i = 0; i < num; i++)
+    {
+        PutFixed32(&storage[i], i);
+        keys[i] = Slice(storage[i]);
+    }
+    std::string filter;
+    policy->CreateFilter(&keys[0], num, &filter);
+
+    // 每个 key 都必须匹配
+    for (int i = 0; i < num; i++)
+    {
+        if (!policy->KeyMayMatch(keys[i], filter))
+        {
+            std::fprintf(stderr, "%s: key %d missing\n", name, i);
+            std::exit(1);
+        }
+    }
+
+    const int kProbes = 10000000;
+    char buf[4];
+    int false_positives = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kProbes; i++)
+    {
+        // 不在集合中的 key，乘以奇数打散顺序，避免连续访问相邻的块
+        EncodeFixed32(buf, 0x80000000u + static_cast<uint32_t>(i) * 2654435761u % 0x7fffffffu);
+        if (policy->KeyMayMatch(Slice(buf, sizeof(buf)), filter))
+        {
+            false_positives++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::printf("%-34s %12zu %10.3f%% %12.1f\n", name, filter.size(),
+                100.0 * false_positives / kProbes, seconds * 1e9 / kProbes);
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const int bits_per_key = argc > 2 ? std::atoi(argv[2]) : 10;
+
+    std::printf("keys: %d, bits_per_key: %d\n", num, bits_per_key);
+    std::printf("%-34s %12s %11s %12s\n", "policy", "bytes", "fp rate", "ns/probe");
+    const FilterPolicy* legacy = NewBloomFilterPolicy(bits_per_key);
+    const FilterPolicy* blocked = NewBlockedBloomFilterPolicy(bits_per_key);
+    Run(legacy->Name(), legacy, num);
+    Run(blocked->Name(), blocked, num);
+    delete legacy;
+    delete blocked;
+    return 0;
+}
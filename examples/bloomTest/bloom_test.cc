@@ -15,7 +15,7 @@ static Slice Key(int i, char* buffer)
 class BloomTest : public testing::Test
 {
 public:
-    BloomTest() : policy_(NewBloomFilterPolicy(10)) {}
+    explicit BloomTest(const FilterPolicy* policy = NewBloomFilterPolicy(10)) : policy_(policy) {}
 
     ~BloomTest() { delete policy_; }
 
@@ -40,6 +40,7 @@ public:
     }
 
     size_t FilterSize() const { return filter_.size(); }
+    const std::string& filter() const { return filter_; }
 
     // 打印filter内容
     void DumpFilter() {
@@ -166,3 +167,66 @@ TEST_F(BloomTest, VaryingLengths) {
 
 // Different bits-per-byte
 
+class BlockedBloomTest : public BloomTest
+{
+public:
+    BlockedBloomTest() : BloomTest(NewBlockedBloomFilterPolicy(10)) {}
+};
+
+TEST_F(BlockedBloomTest, Small) {
+  Add("hello");
+  Add("world");
+  ASSERT_TRUE(Matches("hello"));
+  ASSERT_TRUE(Matches("world"));
+  ASSERT_TRUE(!Matches("x"));
+  ASSERT_TRUE(!Matches("foo"));
+  // 一个 64 字节的块 + k + 格式标记
+  ASSERT_EQ(66u, FilterSize());
+}
+
+TEST_F(BlockedBloomTest, VaryingLengths) {
+  char buffer[sizeof(int)];
+  for (int length = 1; length <= 10000; length = length < 100 ? length + 7 : length * 2) {
+    Reset();
+    for (int i = 0; i < length; i++) {
+      Add(Key(i, buffer));
+    }
+    Build();
+    ASSERT_EQ(0u, (FilterSize() - 2) % 64) << length;
+    ASSERT_LE(FilterSize(), static_cast<size_t>((length * 10 / 8) + 66)) << length;
+    for (int i = 0; i < length; i++) {
+      ASSERT_TRUE(Matches(Key(i, buffer))) << "Length " << length << "; key " << i;
+    }
+    double rate = FalsePositiveRate();
+    if (kVerbose >= 1) {
+      std::fprintf(stderr, "False positives: %5.2f%% @ length = %6d ; bytes = %6d\n",
+                   rate * 100.0, length, static_cast<int>(FilterSize()));
+    }
+    ASSERT_LE(rate, 0.03);
+  }
+}
+
+TEST_F(BlockedBloomTest, FormatCompatibility) {
+  char buffer[sizeof(int)];
+  const FilterPolicy* legacy = NewBloomFilterPolicy(10);
+  const FilterPolicy* blocked = NewBlockedBloomFilterPolicy(10);
+  std::vector<std::string> storage;
+  std::vector<Slice> keys;
+  for (int i = 0; i < 1000; i++) {
+    storage.push_back(Key(i, buffer).ToString());
+  }
+  for (size_t i = 0; i < storage.size(); i++) {
+    keys.push_back(Slice(storage[i]));
+  }
+  std::string old_filter, new_filter;
+  legacy->CreateFilter(&keys[0], static_cast<int>(keys.size()), &old_filter);
+  blocked->CreateFilter(&keys[0], static_cast<int>(keys.size()), &new_filter);
+
+  // 新策略可以读取旧格式；旧策略读到新格式时(k > 30)一律视为匹配
+  ASSERT_TRUE(blocked->KeyMayMatch(keys[7], old_filter));
+  ASSERT_TRUE(!blocked->KeyMayMatch(Key(1000000007, buffer), old_filter));
+  ASSERT_TRUE(legacy->KeyMayMatch(Key(1000000007, buffer), new_filter));
+  ASSERT_TRUE(legacy->KeyMayMatch(keys[7], new_filter));
+  delete legacy;
+  delete blocked;
+}
@@ -0,0 +1,93 @@
+// 缓存多线程读基准：ShardedLRUCache 与 ClockCache 的吞吐和命中率对比。
+// 每个线程按偏斜分布(80% 的访问落在 20% 的 key 上)查找，未命中时插入。
+// 用法: ./cache_bench [每个线程的操作次数, 默认 1000000] [最大线程数, 默认 32]
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "cache.h"
+#include "coding.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static const int kCapacity = 50000;
+static const int kKeySpace = 100000;
+
+static void NoopDeleter(const Slice& key, void* value) {}
+
+struct Result
+{
+    double mops;
+    double hit_rate;
+};
+
+static Result Run(Cache* cache, int threads, int per_thread)
+{
+    std::atomic<long long> hits(0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            Random rnd(t + 1);
+            char buf[4];
+            long long local_hits = 0;
+            for (int i = 0; i < per_thread; i++)
+            {
+                uint32_t k = rnd.OneIn(5) ? rnd.Uniform(kKeySpace)
+                                          : rnd.Uniform(kKeySpace / 5);
+                EncodeFixed32(buf, k);
+                Slice key(buf, sizeof(buf));
+                Cache::Handle* h = cache->Lookup(key);
+                if (h != nullptr)
+                {
+                    local_hits++;
+                }
+                else
+                {
+                    h = cache->Insert(key, reinterpret_cast<void*>(uintptr_t{k}), 1,
+                                      &NoopDeleter);
+                }
+                cache->Release(h);
+            }
+            hits.fetch_add(local_hits);
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    Result r;
+    r.mops = static_cast<double>(threads) * per_thread / seconds / 1e6;
+    r.hit_rate = static_cast<double>(hits.load()) / (static_cast<double>(threads) * per_thread);
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    const int per_thread = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const int max_threads = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    std::printf("hardware threads: %u, ops per thread: %d, capacity: %d, keys: %d\n",
+                std::thread::hardware_concurrency(), per_thread, kCapacity, kKeySpace);
+    std::printf("%8s %12s %10s %14s %12s\n", "threads", "LRU(Mops)", "LRU hit",
+                "Clock(Mops)", "Clock hit");
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        Cache* lru = NewLRUCache(kCapacity);
+        Cache* clock = NewClockCache(kCapacity, 1);
+        Result a = Run(lru, threads, per_thread);
+        Result b = Run(clock, threads, per_thread);
+        std::printf("%8d %12.2f %10.3f %14.2f %12.3f\n", threads, a.mops, a.hit_rate,
+                    b.mops, b.hit_rate);
+        delete lru;
+        delete clock;
+    }
+    return 0;
+}
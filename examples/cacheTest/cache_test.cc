@@ -1,4 +1,5 @@
 #include "cache.h"
+#include <thread>
 #include <vector>
 #include "coding.h"
 
@@ -30,7 +31,7 @@ public:
         current_->deleted_values_.push_back(DecodeValue(v));
     }
 
-    CacheTest() : cache_(NewLRUCache(kCacheSize)) { current_ = this; }
+    explicit CacheTest(Cache* cache = NewLRUCache(kCacheSize)) : cache_(cache) { current_ = this; }
 
     ~CacheTest() { delete cache_; }
 
@@ -171,11 +172,84 @@ void CacheTest_Prune(void)
     printf("lookup 200 ret=%d\n",ct.Lookup(2));
 }
 
+// 与 LRU 相同的基本语义：命中/未命中、更新、删除、被引用的 entry 不会被释放
+void CacheTest_ClockCache(void)
+{
+    CacheTest ct(NewClockCache(CacheTest::kCacheSize, 1));
+    assert(ct.Lookup(100) == -1);
+    ct.Insert(100, 101);
+    ct.Insert(200, 201);
+    assert(ct.Lookup(100) == 101);
+    assert(ct.Lookup(200) == 201);
+
+    // update：旧值被释放
+    ct.Insert(100, 102);
+    assert(ct.Lookup(100) == 102);
+    assert(ct.deleted_keys_.size() == 1 && ct.deleted_values_[0] == 101);
+
+    // 持有 handle 时 Erase，直到 Release 才调用 deleter
+    Cache::Handle* h = ct.cache_->Lookup(EncodeKey(200));
+    ct.Erase(200);
+    assert(ct.Lookup(200) == -1);
+    assert(ct.deleted_keys_.size() == 1);
+    ct.cache_->Release(h);
+    assert(ct.deleted_keys_.size() == 2 && ct.deleted_values_[1] == 201);
+
+    // 超过容量后淘汰，被引用的 entry 不会被淘汰，经常访问的 entry 尽量保留
+    Cache::Handle* pinned = ct.InsertAndReturnHandle(300, 301);
+    for (int i = 0; i < CacheTest::kCacheSize * 3; i++)
+    {
+        ct.Insert(1000 + i, 2000 + i);
+        assert(ct.Lookup(100) == 102);
+    }
+    assert(ct.cache_->TotalCharge() <= static_cast<size_t>(CacheTest::kCacheSize) + 16);
+    assert(DecodeValue(ct.cache_->Value(pinned)) == 301);
+    ct.cache_->Release(pinned);
+
+    ct.cache_->Prune();
+    assert(ct.cache_->TotalCharge() == 0);
+    assert(ct.Lookup(100) == -1);
+
+    // 多线程并发查找、插入、删除
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++)
+    {
+        threads.emplace_back([&ct, t]() {
+            for (int i = 0; i < 20000; i++)
+            {
+                int key = (i * 7 + t) % 3000;
+                Cache::Handle* handle = ct.cache_->Lookup(EncodeKey(key));
+                if (handle != nullptr)
+                {
+                    assert(DecodeValue(ct.cache_->Value(handle)) == key + 1);
+                    ct.cache_->Release(handle);
+                }
+                else if (i % 13 == 0)
+                {
+                    ct.cache_->Erase(EncodeKey(key));
+                }
+                else
+                {
+                    ct.cache_->Release(ct.cache_->Insert(EncodeKey(key), EncodeValue(key + 1), 1,
+                                                         [](const Slice&, void*) {}));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    assert(ct.cache_->TotalCharge() <= static_cast<size_t>(CacheTest::kCacheSize) + 16);
+    printf("clock cache ok\n");
+}
+
 int main(void)
 {
     //CacheTest_HitAndMiss();
     //CacheTest_Erase();
     //CacheTest_EntriesArePinned();
     CacheTest_Prune();
+    CacheTest_ClockCache();
     return 0;
 }
@@ -1,5 +1,8 @@
 #include "crc32c.h"
 
+#include <string>
+
+#include "random.h"
 #include "gtest/gtest.h"
 
 namespace leveldb {
@@ -48,5 +51,32 @@ TEST(CRC, Mask) {
   ASSERT_EQ(crc, Unmask(Unmask(Mask(Mask(crc)))));
 }
 
+TEST(CRC, AcceleratedMatchesPortable) {
+  // 覆盖未对齐的起始地址、字节收尾以及三路交错的长/短块路径
+  Random rnd(301);
+  std::string data(100000, '\0');
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(rnd.Uniform(256));
+  }
+
+  const bool accelerated = AcceleratedCRC32C(0, "TestCRCBuffer", 13) != 0;
+  for (size_t offset = 0; offset < 8; offset++) {
+    for (size_t n = 0; n < 2000; n += 1 + n / 16) {
+      const uint32_t expected = ExtendPortable(0, data.data() + offset, n);
+      ASSERT_EQ(expected, Extend(0, data.data() + offset, n));
+      if (accelerated) {
+        ASSERT_EQ(expected, AcceleratedCRC32C(0, data.data() + offset, n));
+      }
+    }
+  }
+
+  const size_t kLarge[] = {12287, 12288, 12289, 32768, 99992};
+  for (size_t n : kLarge) {
+    const uint32_t init = ExtendPortable(0, "seed", 4);
+    ASSERT_EQ(ExtendPortable(init, data.data() + 3, n),
+              Extend(init, data.data() + 3, n));
+  }
+}
+
 }  // namespace crc32c
 }  // namespace leveldb
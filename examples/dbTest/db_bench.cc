@@ -0,0 +1,162 @@
+// memtable flush 基准：顺序写入时每次 Put 的延迟分布。
+// "inline" 为对照组：memtable 写满后由写线程自己把它写成 sstable，这期间写入全部等待；
+// "background" 为 DB 的实现：写满的 memtable 交给 Env::HIGH 线程池 flush，只有等待
+// flush 的 memtable 达到 max_write_buffer_number - 1 个时才等待。
+// 数据库建在 Env::GetTestDirectory() 下。
+// 用法: ./db_bench [写入次数, 默认 200000] [write_buffer_size(KB), 默认 1024]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "builder.h"
+#include "comparator.h"
+#include "db.h"
+#include "env.h"
+#include "iterator.h"
+#include "log_writer.h"
+#include "memtable.h"
+#include "table_cache.h"
+#include "version_edit.h"
+#include "write_queue.h"
+
+using namespace leveldb;
+
+static const int kValueSize = 100;
+
+static uint64_t NowNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string MakeKey(int i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    return std::string(buf);
+}
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+static void Report(const char* name, std::vector<uint64_t>* latencies, double secs)
+{
+    std::sort(latencies->begin(), latencies->end());
+    auto pct = [&](double p) {
+        return (*latencies)[std::min(latencies->size() - 1,
+                                     static_cast<size_t>(latencies->size() * p))] / 1000.0;
+    };
+    std::printf("%-28s %9.0f writes/s  p50 %6.1fus  p99 %8.1fus  p99.9 %9.1fus  max %9.1fus\n",
+                name, latencies->size() / secs, pct(0.5), pct(0.99), pct(0.999),
+                latencies->back() / 1000.0);
+}
+
+// 对照组：写满后在写线程中同步 flush
+static void RunInline(const std::string& dbname, int writes, size_t write_buffer_size)
+{
+    Env* env = Env::Default();
+    env->CreateDir(dbname);
+    InternalKeyComparator icmp(BytewiseComparator());
+    Options options;
+    options.comparator = &icmp;
+    TableCache table_cache(dbname, options, 100);
+
+    uint64_t file_number = 1;
+    WritableFile* logfile;
+    Check(env->NewWritableFile(dbname + "/inline.log", &logfile));
+    log::Writer* log = new log::Writer(logfile);
+    MemTable* mem = new MemTable(icmp);
+    mem->Ref();
+    WriteQueue queue(log, logfile, mem, 0);
+
+    const std::string value(kValueSize, 'x');
+    std::vector<uint64_t> latencies(writes);
+    uint64_t start = NowNanos();
+    for (int i = 0; i < writes; i++)
+    {
+        uint64_t t0 = NowNanos();
+        if (mem->ApproximateMemoryUsage() > write_buffer_size)
+        {
+            MemTable* new_mem = new MemTable(icmp);
+            new_mem->Ref();
+            queue.SwitchMemTable(log, logfile, new_mem);
+            FileMetaData meta;
+            meta.number = file_number++;
+            Iterator* iter = mem->NewIterator();
+            Check(BuildTable(dbname, env, options, &table_cache, iter, &meta));
+            delete iter;
+            mem->Unref();
+            mem = new_mem;
+        }
+        Check(queue.Put(WriteOptions(), MakeKey(i), value));
+        latencies[i] = NowNanos() - t0;
+    }
+    double secs = (NowNanos() - start) / 1e9;
+    Report("inline flush", &latencies, secs);
+
+    mem->Unref();
+    delete log;
+    logfile->Close();
+    delete logfile;
+    DestroyDB(dbname, Options());
+}
+
+static void RunBackground(const std::string& dbname, int writes,
+                          size_t write_buffer_size, int max_write_buffer_number)
+{
+    Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = write_buffer_size;
+    options.max_write_buffer_number = max_write_buffer_number;
+    DestroyDB(dbname, options);
+    DB* db;
+    Check(DB::Open(options, dbname, &db));
+
+    const std::string value(kValueSize, 'x');
+    std::vector<uint64_t> latencies(writes);
+    uint64_t start = NowNanos();
+    for (int i = 0; i < writes; i++)
+    {
+        uint64_t t0 = NowNanos();
+        Check(db->Put(WriteOptions(), MakeKey(i), value));
+        latencies[i] = NowNanos() - t0;
+    }
+    double secs = (NowNanos() - start) / 1e9;
+
+    char name[64];
+    std::snprintf(name, sizeof(name), "background, %d memtables", max_write_buffer_number);
+    Report(name, &latencies, secs);
+    std::string stall, flushes;
+    db->GetProperty("leveldb.write-stall-micros", &stall);
+    db->GetProperty("leveldb.num-flushes", &flushes);
+    std::printf("%-28s flushes %s, write stall %.1fms\n", "", flushes.c_str(),
+                std::atof(stall.c_str()) / 1000.0);
+    delete db;
+    DestroyDB(dbname, options);
+}
+
+int main(int argc, char** argv)
+{
+    int writes = argc > 1 ? std::atoi(argv[1]) : 200000;
+    size_t write_buffer_size = (argc > 2 ? std::atoi(argv[2]) : 1024) * 1024;
+    std::string dir;
+    Env::Default()->GetTestDirectory(&dir);
+    std::string dbname = dir + "/db_bench";
+
+    std::printf("%d writes, %dB values, write_buffer_size %zuKB\n",
+                writes, kValueSize, write_buffer_size / 1024);
+    RunInline(dbname, writes, write_buffer_size);
+    RunBackground(dbname, writes, write_buffer_size, 2);
+    RunBackground(dbname, writes, write_buffer_size, 3);
+    RunBackground(dbname, writes, write_buffer_size, 4);
+    return 0;
+}
@@ -0,0 +1,772 @@
+#include "db.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db_impl.h"
+#include "env.h"
+#include "filename.h"
+#include "memtablerep.h"
+#include "version_edit.h"
+#include "gtest/gtest.h"
+#include "write_batch.h"
+
+namespace leveldb {
+
+// 调度 flush 任务之前先阻塞，用来模拟 flush 跟不上写入的情况
+class SlowFlushEnv : public EnvWrapper {
+ public:
+  explicit SlowFlushEnv(Env* base)
+      : EnvWrapper(base),
+        flush_jobs_(0),
+        sync_dirs_(0),
+        blocked_(false),
+        cv_(&mu_) {}
+
+  using EnvWrapper::Schedule;
+  void Schedule(void (*function)(void*), void* arg, Priority pri) override {
+    if (pri == Env::HIGH) {
+      flush_jobs_++;
+    }
+    Job* job = new Job{this, function, arg};
+    target()->Schedule(&SlowFlushEnv::Run, job, pri);
+  }
+
+  Status SyncDir(const std::string& dirname) override {
+    sync_dirs_++;
+    return target()->SyncDir(dirname);
+  }
+
+  void Block() {
+    MutexLock l(&mu_);
+    blocked_ = true;
+  }
+
+  void Unblock() {
+    MutexLock l(&mu_);
+    blocked_ = false;
+    cv_.SignalAll();
+  }
+
+  std::atomic<int> flush_jobs_;
+  std::atomic<int> sync_dirs_;
+
+ private:
+  struct Job {
+    SlowFlushEnv* env;
+    void (*function)(void*);
+    void* arg;
+  };
+
+  static void Run(void* arg) {
+    Job* job = reinterpret_cast<Job*>(arg);
+    {
+      MutexLock l(&job->env->mu_);
+      while (job->env->blocked_) {
+        job->env->cv_.Wait();
+      }
+    }
+    (*job->function)(job->arg);
+    delete job;
+  }
+
+  Mutex mu_;
+  bool blocked_;
+  CondVar cv_;
+};
+
+class DBTest : public testing::Test {
+ public:
+  DBTest() : env_(Env::Default()), db_(nullptr) {
+    std::string dir;
+    Env::Default()->GetTestDirectory(&dir);
+    dbname_ = dir + "/db_test";
+    options_.env = &env_;
+    options_.create_if_missing = true;
+    DestroyDB(dbname_, options_);
+  }
+
+  ~DBTest() {
+    delete db_;
+    DestroyDB(dbname_, options_);
+  }
+
+  void Open() {
+    delete db_;
+    db_ = nullptr;
+    ASSERT_TRUE(DB::Open(options_, dbname_, &db_).ok());
+  }
+
+  DBImpl* dbfull() { return reinterpret_cast<DBImpl*>(db_); }
+
+  Status Put(const std::string& k, const std::string& v) {
+    return db_->Put(WriteOptions(), k, v);
+  }
+
+  std::string Get(const std::string& k) {
+    std::string result;
+    Status s = db_->Get(ReadOptions(), k, &result);
+    if (s.IsNotFound()) {
+      result = "NOT_FOUND";
+    } else if (!s.ok()) {
+      result = s.ToString();
+    }
+    return result;
+  }
+
+  uint64_t Property(const std::string& name) {
+    std::string value;
+    EXPECT_TRUE(db_->GetProperty("leveldb." + name, &value));
+    return std::stoull(value);
+  }
+
+  int CountFiles(FileType want) {
+    std::vector<std::string> filenames;
+    env_.GetChildren(dbname_, &filenames);
+    int count = 0;
+    uint64_t number;
+    FileType type;
+    for (const std::string& f : filenames) {
+      if (ParseFileName(f, &number, &type) && type == want) {
+        count++;
+      }
+    }
+    return count;
+  }
+
+  static std::string Key(int i) {
+    char buf[100];
+    std::snprintf(buf, sizeof(buf), "key%06d", i);
+    return std::string(buf);
+  }
+
+ protected:
+  SlowFlushEnv env_;
+  std::string dbname_;
+  Options options_;
+  DB* db_;
+};
+
+TEST_F(DBTest, Empty) {
+  Open();
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ(0, Property("num-files"));
+  ASSERT_EQ(1, CountFiles(kLogFile));
+}
+
+TEST_F(DBTest, OpenOptions) {
+  options_.create_if_missing = false;
+  DB* db;
+  ASSERT_TRUE(DB::Open(options_, dbname_, &db).IsInvalidArgument());
+  ASSERT_TRUE(db == nullptr);
+
+  options_.create_if_missing = true;
+  Open();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  delete db_;
+  db_ = nullptr;
+
+  options_.error_if_exists = true;
+  ASSERT_TRUE(DB::Open(options_, dbname_, &db).IsInvalidArgument());
+
+  options_.error_if_exists = false;
+  options_.create_if_missing = false;
+  Open();
+  ASSERT_EQ("v1", Get("foo"));
+}
+
+TEST_F(DBTest, Recover) {
+  options_.write_buffer_size = 64 << 10;
+  Open();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_TRUE(Put("baz", "v5").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_TRUE(Put("foo", "v2").ok());
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "baz").ok());
+
+  // 未 flush 的写入从日志中恢复，并覆盖 sstable 中较老的数据
+  Open();
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("baz"));
+  ASSERT_EQ(1, CountFiles(kLogFile));
+
+  // 序列号也被恢复，重新打开后的写入比之前的新
+  ASSERT_TRUE(Put("foo", "v3").ok());
+  Open();
+  ASSERT_EQ("v3", Get("foo"));
+
+  // 有多个 immutable memtable 等待 flush 时关闭
+  env_.Block();
+  const std::string value(1000, 'v');
+  int n = 0;
+  while (Property("num-immutable-mem-table") < 2) {
+    ASSERT_TRUE(Put(Key(n++), value).ok());
+  }
+  // 析构会等待已经调度的后台任务，先解除阻塞
+  env_.Unblock();
+  Open();
+  for (int i = 0; i < n; i++) {
+    ASSERT_EQ(value, Get(Key(i)));
+  }
+  ASSERT_EQ("v3", Get("foo"));
+}
+
+TEST_F(DBTest, ParallelRecovery) {
+  // 只写日志，不 flush
+  options_.write_buffer_size = 64 << 20;
+  Open();
+  std::string big(100000, 'b');  // 跨越多个 block 的 record
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_TRUE(Put(Key(i), i % 100 == 0 ? big : Key(i) + "v").ok());
+  }
+  ASSERT_TRUE(db_->Delete(WriteOptions(), Key(7)).ok());
+  ASSERT_EQ(0, Property("num-files"));
+
+  // 恢复时 memtable 多次写满，写成多个 L0 文件
+  options_.recovery_threads = 4;
+  options_.write_buffer_size = 256 << 10;
+  Open();
+  ASSERT_GT(Property("num-files"), 1u);
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_EQ(i == 7 ? "NOT_FOUND" : (i % 100 == 0 ? big : Key(i) + "v"),
+              Get(Key(i)));
+  }
+
+  // 序列号被恢复
+  ASSERT_TRUE(Put(Key(1), "new").ok());
+  Open();
+  ASSERT_EQ("new", Get(Key(1)));
+}
+
+TEST_F(DBTest, RecycleLogFiles) {
+  options_.recycle_log_file_num = 1;
+  Open();
+  // 第一个日志写满，之后被回收
+  std::string value(1000, 'v');
+  for (int i = 0; i < 200; i++) {
+    ASSERT_TRUE(Put(Key(i), value).ok());
+  }
+  ASSERT_TRUE(Put("a", "v1").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(2, CountFiles(kLogFile));  // 当前日志和保留的旧日志
+
+  // 新的日志由第一个日志重命名得到，重命名在写入之前已经持久化到目录中
+  const int sync_dirs = env_.sync_dirs_;
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "a").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(2, CountFiles(kLogFile));
+  ASSERT_EQ(sync_dirs + 1, env_.sync_dirs_);
+  ASSERT_TRUE(Put("b", "v2").ok());
+
+  // 当前日志只写入了一条记录，之后是第一个日志留下的旧记录
+  std::vector<std::string> filenames;
+  env_.GetChildren(dbname_, &filenames);
+  uint64_t number;
+  FileType type;
+  uint64_t max_log_size = 0;
+  for (const std::string& f : filenames) {
+    uint64_t size;
+    if (ParseFileName(f, &number, &type) && type == kLogFile &&
+        env_.GetFileSize(dbname_ + "/" + f, &size).ok()) {
+      max_log_size = std::max(max_log_size, size);
+    }
+  }
+  ASSERT_GT(max_log_size, 200000u);
+
+  // 恢复时旧记录不能被重放，否则 "a" 会从 memtable 中重新出现
+  Open();
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("v2", Get("b"));
+  ASSERT_EQ(value, Get(Key(7)));
+  options_.recovery_threads = 3;
+  Open();
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("v2", Get("b"));
+}
+
+TEST_F(DBTest, RecycleLogFilesManySwitches) {
+  options_.recycle_log_file_num = 2;
+  options_.preallocate_log_files = true;
+  options_.write_buffer_size = 32 << 10;
+  Open();
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_TRUE(Put(Key(i % 1000), Key(i)).ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_WaitForCompaction().ok());
+  ASSERT_GT(Property("num-flushes"), 5u);
+  // 当前日志、等待 flush 的日志和最多两个保留的日志
+  ASSERT_LE(CountFiles(kLogFile), 2 + options_.max_write_buffer_number);
+  for (int i = 19000; i < 20000; i++) {
+    ASSERT_EQ(Key(i), Get(Key(i % 1000)));
+  }
+  Open();
+  for (int i = 19000; i < 20000; i++) {
+    ASSERT_EQ(Key(i), Get(Key(i % 1000)));
+  }
+}
+
+TEST_F(DBTest, DirectIO) {
+  options_.use_direct_reads = true;
+  options_.use_direct_io_for_flush_and_compaction = true;
+  options_.write_buffer_size = 64 << 10;
+  Open();
+  std::vector<std::string> values(1500);
+  std::string value(500, 'v');
+  for (int i = 0; i < 3000; i++) {
+    value[i % value.size()]++;
+    ASSERT_TRUE(Put(Key(i % 1500), value).ok());
+    values[i % 1500] = value;
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  ASSERT_EQ(0, Property("num-files-at-level0"));
+  ASSERT_GT(Property("num-files-at-level1"), 0u);
+
+  // 输出的 sstable 大小不是 4KB 的整数倍，读取时按对齐的范围读入
+  for (int round = 0; round < 2; round++) {
+    for (int i = 0; i < 1500; i++) {
+      ASSERT_EQ(values[i], Get(Key(i)));
+    }
+    Open();
+  }
+}
+
+// arena 的块大小和 mmap 选项传给每个 memtable：第一次写入就申请一个完整的块
+TEST_F(DBTest, MemTableArenaOptions) {
+  Open();
+  ASSERT_TRUE(Put("a", "v1").ok());
+  // 默认为 write_buffer_size / 8
+  ASSERT_GE(Property("approximate-memory-usage"),
+            options_.write_buffer_size / 8);
+
+  options_.arena_block_size = 2 << 20;
+  options_.arena_use_mmap = true;
+  Open();
+  ASSERT_TRUE(Put("b", "v2").ok());
+  ASSERT_GE(Property("approximate-memory-usage"), 2u << 20);
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_TRUE(Put("c", "v3").ok());
+  ASSERT_GE(Property("approximate-memory-usage"), 2u << 20);
+  Open();
+  ASSERT_EQ("v1", Get("a"));
+  ASSERT_EQ("v2", Get("b"));
+  ASSERT_EQ("v3", Get("c"));
+}
+
+TEST_F(DBTest, MemTableOutputPushedDown) {
+  Open();
+  ASSERT_TRUE(Put("a", "va").ok());
+  ASSERT_TRUE(Put("z", "vz").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  // 不与任何文件重叠，直接放到 kMaxMemCompactLevel
+  ASSERT_EQ(1, Property("num-files-at-level" +
+                        std::to_string(config::kMaxMemCompactLevel)));
+
+  ASSERT_TRUE(Put("m", "vm").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  // 与 L2 的文件重叠，只能放在它的上一层
+  ASSERT_EQ(1, Property("num-files-at-level1"));
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ("vm", Get("m"));
+  ASSERT_EQ("vz", Get("z"));
+}
+
+TEST_F(DBTest, CompactionDropsObsoleteEntries) {
+  Open();
+  for (int i = 0; i < 100; i++) {
+    ASSERT_TRUE(Put(Key(i), "old").ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(db_->Delete(WriteOptions(), Key(i)).ok());
+    } else {
+      ASSERT_TRUE(Put(Key(i), "new").ok());
+    }
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(1, Property("num-files-at-level1"));
+  ASSERT_EQ(1, Property("num-files-at-level2"));
+
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ(0, Property("num-files-at-level1"));
+  ASSERT_EQ(1, Property("num-files-at-level2"));
+  // 100 个被覆盖的旧值，以及下层已经没有数据的 50 个删除标记
+  ASSERT_EQ(150, Property("compaction-dropped-entries"));
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(i % 2 == 0 ? "NOT_FOUND" : "new", Get(Key(i)));
+  }
+
+  // compaction 的结果在重新打开后依然有效，输入文件已被删除
+  Open();
+  ASSERT_EQ(1, CountFiles(kTableFile));
+  ASSERT_EQ("NOT_FOUND", Get(Key(0)));
+  ASSERT_EQ("new", Get(Key(1)));
+}
+
+TEST_F(DBTest, DeletionKeptAboveOlderData) {
+  Open();
+  ASSERT_TRUE(Put("a", "va").ok());
+  ASSERT_TRUE(Put("z", "vz").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());  // L2
+  ASSERT_TRUE(Put("b", "vb").ok());
+  ASSERT_TRUE(Put("y", "vy").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());  // L1
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "a").ok());
+  ASSERT_TRUE(Put("c", "vc").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());  // L0
+  ASSERT_EQ(1, Property("num-files-at-level0"));
+
+  // L2 中还有 "a" 的旧值，L0 -> L1 的 compaction 不能丢掉删除标记
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  ASSERT_EQ(0, Property("num-files-at-level0"));
+  ASSERT_EQ(0, Property("compaction-dropped-entries"));
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ(2, Property("compaction-dropped-entries"));
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("vb", Get("b"));
+  ASSERT_EQ("vz", Get("z"));
+}
+
+TEST_F(DBTest, L0FilesTriggerCompaction) {
+  Open();
+  // 每个文件都覆盖相同的范围，只能放在 L0
+  for (int round = 0; round < config::kL0_CompactionTrigger + 2; round++) {
+    for (int i = 0; i < 100; i++) {
+      ASSERT_TRUE(Put(Key(i), "v" + std::to_string(round)).ok());
+    }
+    ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_WaitForCompaction().ok());
+  ASSERT_LT(Property("num-files-at-level0"), config::kL0_CompactionTrigger);
+  ASSERT_GT(Property("compaction-dropped-entries"), 0);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ("v" + std::to_string(config::kL0_CompactionTrigger + 1),
+              Get(Key(i)));
+  }
+}
+
+TEST_F(DBTest, SeeksTriggerCompaction) {
+  Open();
+  ASSERT_TRUE(Put("a", "va").ok());
+  ASSERT_TRUE(Put("z", "vz").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_TRUE(Put("b", "vb").ok());
+  ASSERT_TRUE(Put("y", "vy").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(1, Property("num-files-at-level1"));
+  ASSERT_EQ(1, Property("num-files-at-level2"));
+
+  // 查找 "m" 要先经过 L1 的文件再到 L2，每次都消耗 L1 文件的 seek 预算
+  // (小文件的预算为 100 次)，用完后它被合并到 L2
+  for (int i = 0; i < 200 && Property("num-files-at-level1") > 0; i++) {
+    ASSERT_EQ("NOT_FOUND", Get("m"));
+    ASSERT_TRUE(dbfull()->TEST_WaitForCompaction().ok());
+  }
+  ASSERT_EQ(0, Property("num-files-at-level1"));
+  ASSERT_EQ("vb", Get("b"));
+}
+
+TEST_F(DBTest, PutDeleteGet) {
+  Open();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_TRUE(Put("foo", "v2").ok());
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "foo").ok());
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+
+  WriteBatch batch;
+  batch.Put("a", "va");
+  batch.Put("b", "vb");
+  ASSERT_TRUE(db_->Write(WriteOptions(), &batch).ok());
+  ASSERT_EQ("va", Get("a"));
+  ASSERT_EQ("vb", Get("b"));
+}
+
+TEST_F(DBTest, GetPinnableSlice) {
+  Open();
+  const std::string big(16384, 'v');
+  ASSERT_TRUE(Put("foo", big).ok());
+  ASSERT_TRUE(Put("bar", "v1").ok());
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "bar").ok());
+
+  // memtable 中的 value 不拷贝
+  PinnableSlice value;
+  ASSERT_TRUE(db_->Get(ReadOptions(), "foo", &value).ok());
+  ASSERT_TRUE(value.IsPinned());
+  ASSERT_EQ(big, value.ToString());
+  ASSERT_TRUE(db_->Get(ReadOptions(), "bar", &value).IsNotFound());
+  ASSERT_FALSE(value.IsPinned());
+
+  // pin 住的 memtable 在 flush 之后依然有效
+  ASSERT_TRUE(db_->Get(ReadOptions(), "foo", &value).ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_TRUE(Put("foo", "new").ok());
+  ASSERT_EQ(big, value.ToString());
+
+  // 从 sstable 读出的 value 拷贝到自己的 buffer
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_TRUE(db_->Get(ReadOptions(), "foo", &value).ok());
+  ASSERT_FALSE(value.IsPinned());
+  ASSERT_EQ("new", value.ToString());
+  ASSERT_EQ("new", Get("foo"));
+}
+
+TEST_F(DBTest, FlushMemTable) {
+  Open();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_TRUE(Put("bar", "v2").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(1, Property("num-files"));
+  ASSERT_EQ(1, Property("num-flushes"));
+  ASSERT_EQ(1, CountFiles(kTableFile));
+  // flush 完成后 memtable 对应的日志被删除，只剩新的日志
+  ASSERT_EQ(1, CountFiles(kLogFile));
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+
+  // 较新的 memtable 和 sstable 中的数据覆盖较老的
+  ASSERT_TRUE(Put("foo", "v3").ok());
+  ASSERT_TRUE(db_->Delete(WriteOptions(), "bar").ok());
+  ASSERT_EQ("v3", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(2, Property("num-files"));
+  ASSERT_EQ("v3", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+}
+
+TEST_F(DBTest, MemTableSwitchesAtWriteBufferSize) {
+  options_.write_buffer_size = 100 << 10;
+  Open();
+  const std::string value(1000, 'v');
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(Put(Key(i), value).ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_WaitForFlush().ok());
+  // 1MB 的数据在 100KB 的 write buffer 下至少切换、flush 了数次
+  ASSERT_GE(Property("num-flushes"), 5);
+  ASSERT_EQ(Property("num-flushes"), Property("num-files"));
+  ASSERT_EQ(0, Property("num-immutable-mem-table"));
+  ASSERT_LT(Property("approximate-memory-usage"), 2 * options_.write_buffer_size);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(value, Get(Key(i)));
+  }
+}
+
+TEST_F(DBTest, WritesStallOnlyWhenMemTablesPending) {
+  options_.write_buffer_size = 64 << 10;
+  options_.max_write_buffer_number = 3;
+  Open();
+
+  // flush 被阻塞时，写入可以继续填满两个 immutable memtable 和一个活跃 memtable
+  env_.Block();
+  const std::string value(1000, 'v');
+  int i = 0;
+  while (Property("num-immutable-mem-table") < 2) {
+    ASSERT_TRUE(Put(Key(i++), value).ok());
+  }
+  ASSERT_EQ(0, Property("write-stall-micros"));
+  ASSERT_EQ(0, Property("num-flushes"));
+
+  // 活跃 memtable 也写满之后，下一个写入阻塞直到 flush 完成
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (int j = 0; j < 200; j++) {
+      ASSERT_TRUE(Put(Key(i + j), value).ok());
+    }
+    done = true;
+  });
+  env_.SleepForMicroseconds(100000);
+  ASSERT_FALSE(done.load());
+  // 阻塞期间读操作不受影响
+  ASSERT_EQ(value, Get(Key(0)));
+
+  env_.Unblock();
+  writer.join();
+  ASSERT_TRUE(done.load());
+  ASSERT_GT(Property("write-stall-micros"), 0);
+  ASSERT_TRUE(dbfull()->TEST_WaitForFlush().ok());
+  ASSERT_GE(Property("num-flushes"), 2);
+  for (int j = 0; j < i + 200; j++) {
+    ASSERT_EQ(value, Get(Key(j)));
+  }
+}
+
+TEST_F(DBTest, FlushUsesHighPriorityPool) {
+  Open();
+  ASSERT_TRUE(Put("foo", "v1").ok());
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(1, env_.flush_jobs_.load());
+}
+
+TEST_F(DBTest, ConcurrentWritesAndReads) {
+  options_.write_buffer_size = 64 << 10;
+  Open();
+  const int kThreads = 4;
+  const int kWritesPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < kWritesPerThread; i++) {
+        int k = t * kWritesPerThread + i;
+        ASSERT_TRUE(Put(Key(k), "value" + std::to_string(k)).ok());
+        // 自己写入的数据立即可见，不管它在哪个 memtable 或者 sstable 中
+        if (i % 10 == 0) {
+          ASSERT_EQ("value" + std::to_string(k), Get(Key(k)));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(dbfull()->TEST_WaitForFlush().ok());
+  ASSERT_GT(Property("num-files"), 0);
+  for (int k = 0; k < kThreads * kWritesPerThread; k++) {
+    ASSERT_EQ("value" + std::to_string(k), Get(Key(k)));
+  }
+}
+
+// 参数为 LOW 线程池的线程数
+class SubcompactionTest : public DBTest,
+                          public testing::WithParamInterface<int> {};
+
+TEST_P(SubcompactionTest, SplitLevel0Compaction) {
+  const int low_threads = GetParam();
+  const int saved_threads = env_.GetBackgroundThreads(Env::LOW);
+  env_.SetBackgroundThreads(low_threads, Env::LOW);
+  options_.max_subcompactions = 4;
+  Open();
+
+  const int kNumKeys = 3000;
+  const std::string value(100, 'x');
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_TRUE(Put(Key(i), "v1" + value).ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_TRUE(Put(Key(i), "v2" + value).ok());
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  for (int i = 0; i < kNumKeys; i++) {
+    if (i % 2 == 0) {
+      ASSERT_TRUE(db_->Delete(WriteOptions(), Key(i)).ok());
+    } else {
+      ASSERT_TRUE(Put(Key(i), "v3" + value).ok());
+    }
+  }
+  ASSERT_TRUE(dbfull()->TEST_FlushMemTable().ok());
+  ASSERT_EQ(1, Property("num-files-at-level0"));
+  ASSERT_EQ(1, Property("num-files-at-level1"));
+  ASSERT_EQ(1, Property("num-files-at-level2"));
+
+  // 每个子 compaction 写出自己的输出文件，一起提交到 L1
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  ASSERT_EQ(4, Property("num-subcompactions"));
+  ASSERT_EQ(0, Property("num-files-at-level0"));
+  ASSERT_GE(Property("num-files-at-level1"), 4);
+  // v2 全部被覆盖；L2 中还有旧值，删除标记都要保留
+  ASSERT_EQ(kNumKeys, Property("compaction-dropped-entries"));
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i % 2 == 0 ? "NOT_FOUND" : "v3" + value, Get(Key(i)));
+  }
+
+  // L1 的输出互不重叠，可以继续正常地 compaction 到 L2
+  dbfull()->TEST_CompactRange(1, nullptr, nullptr);
+  ASSERT_EQ(0, Property("num-files-at-level1"));
+  ASSERT_EQ(kNumKeys * 2 + kNumKeys / 2, Property("compaction-dropped-entries"));
+  Open();
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i % 2 == 0 ? "NOT_FOUND" : "v3" + value, Get(Key(i)));
+  }
+  env_.SetBackgroundThreads(saved_threads, Env::LOW);
+}
+
+// LOW 线程池只有一个线程时由 compaction 线程自己执行全部子 compaction
+INSTANTIATE_TEST_SUITE_P(LowThreads, SubcompactionTest,
+                         testing::Values(1, 4));
+
+// 参数为 memtable 的实现：0 跳表，1 前缀哈希跳表，2 数组
+class MemTableRepDBTest : public DBTest,
+                          public testing::WithParamInterface<int> {};
+
+TEST_P(MemTableRepDBTest, PutGetFlushReopen) {
+  std::unique_ptr<MemTableRepFactory> factory;
+  switch (GetParam()) {
+    case 0:
+      factory.reset(NewSkipListRepFactory());
+      break;
+    case 1:
+      factory.reset(NewHashSkipListRepFactory(4, 64));
+      break;
+    default:
+      factory.reset(NewVectorRepFactory());
+      break;
+  }
+  options_.memtable_factory = factory.get();
+  options_.write_buffer_size = 64 * 1024;
+  Open();
+
+  // 写入过程中多次写满 memtable，flush 通过 rep 的迭代器有序输出
+  const int kNumKeys = 3000;
+  for (int i = kNumKeys - 1; i >= 0; i--) {
+    ASSERT_TRUE(Put(Key(i), "v1_" + std::to_string(i)).ok());
+    if (i % 7 == 0) {
+      ASSERT_EQ("v1_" + std::to_string(i), Get(Key(i)));
+    }
+  }
+  for (int i = 0; i < kNumKeys; i += 3) {
+    ASSERT_TRUE(db_->Delete(WriteOptions(), Key(i)).ok());
+  }
+  // flush 在后台进行，等它完成之后再检查计数
+  ASSERT_TRUE(dbfull()->TEST_WaitForCompaction().ok());
+  ASSERT_GT(Property("num-flushes"), 0);
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i % 3 == 0 ? "NOT_FOUND" : "v1_" + std::to_string(i), Get(Key(i)));
+  }
+
+  // 重新打开时日志恢复到新建的 memtable 中
+  Open();
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(i % 3 == 0 ? "NOT_FOUND" : "v1_" + std::to_string(i), Get(Key(i)));
+  }
+  // factory 必须比 DB 活得久
+  delete db_;
+  db_ = nullptr;
+}
+
+INSTANTIATE_TEST_SUITE_P(Reps, MemTableRepDBTest, testing::Values(0, 1, 2));
+
+TEST(VersionEditTest, EncodeDecode) {
+  VersionEdit edit;
+  for (int i = 0; i < 4; i++) {
+    edit.AddFile(3, 3000 + i, 1024 + i, InternalKey("foo", 100 + i, kTypeValue),
+                 InternalKey("zoo", 200 + i, kTypeDeletion));
+    edit.RemoveFile(4, 4000 + i);
+    edit.SetCompactPointer(i, InternalKey("x", 900 + i, kTypeValue));
+  }
+  edit.SetComparatorName("foo");
+  edit.SetLogNumber(100);
+  edit.SetNextFile(200);
+  edit.SetLastSequence(1000);
+
+  std::string encoded, encoded2;
+  edit.EncodeTo(&encoded);
+  VersionEdit parsed;
+  ASSERT_TRUE(parsed.DecodeFrom(encoded).ok());
+  parsed.EncodeTo(&encoded2);
+  ASSERT_EQ(encoded, encoded2);
+
+  ASSERT_TRUE(parsed.DecodeFrom(Slice(encoded.data(), encoded.size() - 1))
+                  .IsCorruption());
+}
+
+}  // namespace leveldb
@@ -0,0 +1,171 @@
+// Direct I/O 基准：大量写入持续触发 flush 和 compaction 的同时，另一个线程随机读取
+// 一小部分热点 key，比较两种配置下读取的稳态延迟：
+//   buffered    sstable 的读写都经过页缓存(默认)
+//   direct      Options::use_direct_reads 和 use_direct_io_for_flush_and_compaction，
+//               热点数据只在 block_cache 中，compaction 的输入输出不进入页缓存，
+//               输入按 compaction_readahead_size 对齐预读
+// 两种配置使用同样大小的 block_cache。输出读取延迟的平均、p50、p99、p99.9，写入吞吐，
+// 以及结束时数据库的 sstable 在页缓存中的大小(mincore)。
+// 页缓存的污染只有在内存紧张时才会挤出热点数据，内存充足时主要比较的是
+// compaction 与读取争抢 CPU 和磁盘时的延迟。
+// 数据库建在 Env::GetTestDirectory() 下，tmpfs 不支持 O_DIRECT，会退回普通读写。
+// 用法: ./direct_io_bench [写入量(MB), 默认 512] [热点 key 数, 默认 20000]
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "cache.h"
+#include "db.h"
+#include "env.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static const int kValueSize = 1000;
+
+static std::string MakeKey(int i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    return std::string(buf);
+}
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+// 数据库中的 sstable 在页缓存中的字节数
+static double CachedTableMB(const std::string& dbname)
+{
+    std::vector<std::string> children;
+    Env::Default()->GetChildren(dbname, &children);
+    const size_t page = ::sysconf(_SC_PAGESIZE);
+    size_t resident = 0;
+    for (const std::string& child : children)
+    {
+        if (child.size() < 4 || child.compare(child.size() - 4, 4, ".ldb") != 0)
+        {
+            continue;
+        }
+        const std::string fname = dbname + "/" + child;
+        int fd = ::open(fname.c_str(), O_RDONLY);
+        off_t size = ::lseek(fd, 0, SEEK_END);
+        if (size > 0)
+        {
+            void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            std::vector<unsigned char> vec((size + page - 1) / page);
+            ::mincore(base, size, vec.data());
+            for (unsigned char v : vec)
+            {
+                resident += v & 1;
+            }
+            ::munmap(base, size);
+        }
+        ::close(fd);
+    }
+    return resident * page / 1048576.0;
+}
+
+static void Run(const char* name, const std::string& dbname, bool direct,
+                int write_mb, int hot_keys)
+{
+    Options options;
+    options.create_if_missing = true;
+    options.block_cache = NewLRUCache(32 << 20);
+    options.use_direct_reads = direct;
+    options.use_direct_io_for_flush_and_compaction = direct;
+    DestroyDB(dbname, options);
+
+    DB* db;
+    Check(DB::Open(options, dbname, &db));
+    Random rnd(301);
+    std::string value(kValueSize, 'v');
+    for (int i = 0; i < hot_keys; i++)
+    {
+        value[i % kValueSize] = 'a' + rnd.Uniform(26);
+        Check(db->Put(WriteOptions(), MakeKey(i), value));
+    }
+    // 热点数据先被读一遍(进入 block_cache 或页缓存)
+    std::string result;
+    for (int i = 0; i < hot_keys; i++)
+    {
+        db->Get(ReadOptions(), MakeKey(i), &result);
+    }
+
+    std::atomic<bool> done(false);
+    std::vector<double> micros;
+    std::thread reader([&]() {
+        Random r(17);
+        std::string v;
+        while (!done.load(std::memory_order_acquire))
+        {
+            const std::string key = MakeKey(r.Uniform(hot_keys));
+            auto start = std::chrono::steady_clock::now();
+            Check(db->Get(ReadOptions(), key, &v));
+            micros.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    });
+
+    // 写入热点范围之外的随机 key，持续触发各层的 compaction
+    const int num = static_cast<int>((static_cast<int64_t>(write_mb) << 20) / (kValueSize + 16));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num; i++)
+    {
+        value[i % kValueSize] = 'a' + rnd.Uniform(26);
+        Check(db->Put(WriteOptions(), MakeKey(hot_keys + rnd.Uniform(num)), value));
+    }
+    double secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    done.store(true, std::memory_order_release);
+    reader.join();
+    const double cached = CachedTableMB(dbname);
+    delete db;
+    DestroyDB(dbname, options);
+    delete options.block_cache;
+
+    double sum = 0;
+    for (double m : micros)
+    {
+        sum += m;
+    }
+    std::sort(micros.begin(), micros.end());
+    const size_t n = micros.size();
+    std::printf("%-9s %9zu %8.1f %8.1f %8.1f %9.1f %9.1f %11.1f\n", name, n,
+                sum / n, micros[n / 2], micros[n * 99 / 100],
+                micros[n * 999 / 1000], write_mb / secs, cached);
+}
+
+int main(int argc, char** argv)
+{
+    const int write_mb = argc > 1 ? std::atoi(argv[1]) : 512;
+    const int hot_keys = argc > 2 ? std::atoi(argv[2]) : 20000;
+    std::string dir;
+    Env::Default()->GetTestDirectory(&dir);
+    const std::string dbname = dir + "/direct_io_bench";
+
+    std::printf("%d MB written, %d hot keys of %dB, 32MB block cache\n",
+                write_mb, hot_keys, kValueSize);
+    std::printf("%-9s %9s %8s %8s %8s %9s %9s %11s\n", "io", "reads", "avg(us)",
+                "p50(us)", "p99(us)", "p999(us)", "write MB/s", "cached(MB)");
+    for (int round = 0; round < 2; round++)
+    {
+        Run("buffered", dbname, false, write_mb, hot_keys);
+        Run("direct", dbname, true, write_mb, hot_keys);
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+// 日志恢复基准：同一份日志按 recovery_threads = 1/2/4/8 恢复时 DB::Open 的耗时。
+// 每轮重新建库，写入的数据全部留在日志中(write_buffer_size 大于数据量)，
+// 然后关闭并重新打开。恢复包括读日志、校验 CRC、写入 memtable 和最后写出 L0 文件。
+// recovery_threads > 1 时前两步与写入 memtable 并行，核数少时看不到加速。
+// 数据库建在 Env::GetTestDirectory() 下。
+// 用法: ./recovery_bench [日志大小(MB), 默认 128] [value 大小, 默认 1000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "db.h"
+#include "env.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static double Now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string MakeKey(int i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    return std::string(buf);
+}
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+static void Run(const std::string& dbname, int log_mb, int value_size, int threads)
+{
+    Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = static_cast<size_t>(log_mb + 64) << 20;
+    DestroyDB(dbname, options);
+
+    DB* db;
+    Check(DB::Open(options, dbname, &db));
+    const int num = static_cast<int>((static_cast<int64_t>(log_mb) << 20) / (value_size + 16));
+    Random rnd(301);
+    std::string value(value_size, 'v');
+    for (int i = 0; i < num; i++)
+    {
+        value[i % value_size] = 'a' + rnd.Uniform(26);
+        Check(db->Put(WriteOptions(), MakeKey(i), value));
+    }
+    delete db;
+
+    options.recovery_threads = threads;
+    double start = Now();
+    Check(DB::Open(options, dbname, &db));
+    double secs = Now() - start;
+
+    std::string result;
+    Check(db->Get(ReadOptions(), MakeKey(num - 1), &result));
+    std::printf("recovery_threads %2d  %7.3fs  %7.1f MB/s\n", threads, secs, log_mb / secs);
+    delete db;
+    DestroyDB(dbname, options);
+}
+
+int main(int argc, char** argv)
+{
+    int log_mb = argc > 1 ? std::atoi(argv[1]) : 128;
+    int value_size = argc > 2 ? std::atoi(argv[2]) : 1000;
+    std::string dir;
+    Env::Default()->GetTestDirectory(&dir);
+    std::string dbname = dir + "/recovery_bench";
+
+    std::printf("%d MB log, %dB values, %u hardware threads\n",
+                log_mb, value_size, std::thread::hardware_concurrency());
+    for (int threads = 1; threads <= 8; threads *= 2)
+    {
+        Run(dbname, log_mb, value_size, threads);
+    }
+    return 0;
+}
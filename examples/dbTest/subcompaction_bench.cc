@@ -0,0 +1,124 @@
+// 子 compaction 基准：同一份 L0 -> L1 compaction 按 1~16 个子 compaction 执行的耗时。
+// 每轮把全部 key 按随机顺序重写一遍并 flush：第一个文件放到 L2，第二个放到 L1，
+// 之后的都留在 L0，最后手动 compaction L0 和 L1(由 InternalKeyComparator 归并)。
+// key 数要让一轮的数据小于 L1 的大小上限(10MB)，否则 L1 会先被自动 compaction。
+// LOW 线程池的线程数设置为与子 compaction 数相同；核数少于子 compaction 数时，
+// 多出来的子 compaction 只会排队，看不到加速。
+// 数据库建在 Env::GetTestDirectory() 下。
+// 用法: ./subcompaction_bench [key 数, 默认 60000] [L0 文件数, 默认 3]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db.h"
+#include "db_impl.h"
+#include "env.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static const int kValueSize = 100;
+
+static double Now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string MakeKey(int i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016d", i);
+    return std::string(buf);
+}
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+static uint64_t Property(DB* db, const std::string& name)
+{
+    std::string value;
+    db->GetProperty("leveldb." + name, &value);
+    return std::strtoull(value.c_str(), nullptr, 10);
+}
+
+static void Run(const std::string& dbname, int num_keys, int l0_files, int subcompactions)
+{
+    Options options;
+    options.create_if_missing = true;
+    // 每轮的数据都放在一个 memtable 中
+    options.write_buffer_size = 1 << 30;
+    options.max_file_size = 8 << 20;
+    options.max_subcompactions = subcompactions;
+    options.env->SetBackgroundThreads(subcompactions, Env::LOW);
+    DestroyDB(dbname, options);
+    DB* db;
+    Check(DB::Open(options, dbname, &db));
+    DBImpl* dbimpl = reinterpret_cast<DBImpl*>(db);
+
+    std::vector<int> order(num_keys);
+    for (int i = 0; i < num_keys; i++)
+    {
+        order[i] = i;
+    }
+    Random rnd(301);
+    std::string value(kValueSize, 'x');
+    for (int round = 0; round < l0_files + 2; round++)
+    {
+        for (int i = num_keys - 1; i > 0; i--)
+        {
+            std::swap(order[i], order[rnd.Uniform(i + 1)]);
+        }
+        value[0] = 'a' + round;
+        for (int i = 0; i < num_keys; i++)
+        {
+            Check(db->Put(WriteOptions(), MakeKey(order[i]), value));
+        }
+        Check(dbimpl->TEST_FlushMemTable());
+    }
+    if (Property(db, "num-files-at-level0") != static_cast<uint64_t>(l0_files))
+    {
+        std::fprintf(stderr, "unexpected L0 file count %d\n",
+                     static_cast<int>(Property(db, "num-files-at-level0")));
+        std::exit(1);
+    }
+
+    double start = Now();
+    dbimpl->TEST_CompactRange(0, nullptr, nullptr);
+    double secs = Now() - start;
+
+    double input_mb = 1.0 * num_keys * (l0_files + 1) * (16 + 8 + kValueSize) / 1048576;
+    std::printf("subcompactions %2d  %7.3fs  %7.1f MB/s  L1 files %3d  split into %d\n",
+                subcompactions, secs, input_mb / secs,
+                static_cast<int>(Property(db, "num-files-at-level1")),
+                static_cast<int>(std::max<uint64_t>(1, Property(db, "num-subcompactions"))));
+    delete db;
+    DestroyDB(dbname, options);
+}
+
+int main(int argc, char** argv)
+{
+    int num_keys = argc > 1 ? std::atoi(argv[1]) : 60000;
+    int l0_files = argc > 2 ? std::atoi(argv[2]) : 3;
+    std::string dir;
+    Env::Default()->GetTestDirectory(&dir);
+    std::string dbname = dir + "/subcompaction_bench";
+
+    std::printf("%d keys, %dB values, %d L0 files + 1 L1 file, %u hardware threads\n",
+                num_keys, kValueSize, l0_files, std::thread::hardware_concurrency());
+    for (int n = 1; n <= 16; n *= 2)
+    {
+        Run(dbname, num_keys, l0_files, n);
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+// io_uring Env 基准：
+//  1. 随机 4KB 读：逐个 pread 与 io_uring MultiRead(每批 32 个请求)对比；
+//  2. WAL 式的追加 + Sync：PosixEnv 与 io_uring(write+fdatasync 链)对比。
+// 文件写在 Env::GetTestDirectory() 下，读测试的数据大多在 page cache 中，
+// 更能体现系统调用次数的差别；冷数据/NVMe 上的收益来自更深的设备队列。
+// 用法: ./env_bench [读取次数, 默认 200000] [sync 次数, 默认 2000]
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "env.h"
+#include "env_io_uring.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static const size_t kFileSize = 64 << 20;
+static const size_t kReadSize = 4096;
+static const int kBatch = 32;
+
+static double Now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void BenchReads(const std::string& fname, int reads)
+{
+    Random rnd(301);
+    std::vector<uint64_t> offsets(reads);
+    for (int i = 0; i < reads; i++)
+    {
+        offsets[i] = static_cast<uint64_t>(rnd.Uniform(kFileSize / kReadSize)) * kReadSize;
+    }
+    std::vector<char> scratch(kBatch * kReadSize);
+
+    // 逐个 pread
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    double start = Now();
+    for (int i = 0; i < reads; i++)
+    {
+        if (::pread(fd, &scratch[0], kReadSize, offsets[i]) != static_cast<ssize_t>(kReadSize))
+        {
+            std::fprintf(stderr, "pread failed\n");
+            std::exit(1);
+        }
+    }
+    double pread_secs = Now() - start;
+    ::close(fd);
+
+    // io_uring MultiRead
+    Env* env = NewIoUringEnv(Env::Default());
+    RandomAccessFile* file;
+    env->NewRandomAccessFile(fname, &file);
+    std::vector<RandomAccessFile::ReadRequest> reqs(kBatch);
+    start = Now();
+    for (int i = 0; i + kBatch <= reads; i += kBatch)
+    {
+        for (int j = 0; j < kBatch; j++)
+        {
+            reqs[j].offset = offsets[i + j];
+            reqs[j].n = kReadSize;
+            reqs[j].scratch = &scratch[j * kReadSize];
+        }
+        if (!file->MultiRead(reqs.data(), kBatch).ok())
+        {
+            std::fprintf(stderr, "MultiRead failed\n");
+            std::exit(1);
+        }
+    }
+    double uring_secs = Now() - start;
+    delete file;
+    delete env;
+
+    std::printf("random 4KB reads:  pread %8.0f reads/s   io_uring MultiRead(%d) %8.0f reads/s\n",
+                reads / pread_secs, kBatch, (reads / kBatch * kBatch) / uring_secs);
+}
+
+static double BenchSyncs(Env* env, const std::string& fname, int syncs)
+{
+    WritableFile* file;
+    env->NewWritableFile(fname, &file);
+    std::string record(4000, 'x');
+    double start = Now();
+    for (int i = 0; i < syncs; i++)
+    {
+        file->Append(record);
+        if (!file->Sync().ok())
+        {
+            std::fprintf(stderr, "Sync failed\n");
+            std::exit(1);
+        }
+    }
+    double secs = Now() - start;
+    file->Close();
+    delete file;
+    env->RemoveFile(fname);
+    return syncs / secs;
+}
+
+int main(int argc, char** argv)
+{
+    int reads = argc > 1 ? std::atoi(argv[1]) : 200000;
+    int syncs = argc > 2 ? std::atoi(argv[2]) : 2000;
+    std::printf("io_uring available: %s\n", IoUringAvailable() ? "yes" : "no");
+
+    Env* posix = Env::Default();
+    std::string dir;
+    posix->GetTestDirectory(&dir);
+    std::string fname = dir + "/env_bench.dat";
+
+    WritableFile* file;
+    posix->NewWritableFile(fname, &file);
+    std::string block(1 << 20, 'a');
+    for (size_t i = 0; i < kFileSize; i += block.size())
+    {
+        file->Append(block);
+    }
+    file->Close();
+    delete file;
+    BenchReads(fname, reads);
+    posix->RemoveFile(fname);
+
+    Env* uring = NewIoUringEnv(posix);
+    double posix_rate = BenchSyncs(posix, fname, syncs);
+    double uring_rate = BenchSyncs(uring, fname, syncs);
+    std::printf("append 4KB + Sync: posix %8.0f syncs/s   io_uring write+fdatasync link %8.0f syncs/s\n",
+                posix_rate, uring_rate);
+    delete uring;
+    return 0;
+}
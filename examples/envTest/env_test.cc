@@ -1,8 +1,14 @@
 #include "env.h"
 #include <algorithm>
+#include <thread>
+#include <vector>
+#include "aligned_buffer.h"
+#include "env_io_uring.h"
+#include "gather_write.h"
 #include "gtest/gtest.h"
 #include "mutex.h"
 #include "random.h"
+#include "thread_pool.h"
 
 namespace leveldb {
 
@@ -63,6 +69,65 @@ TEST_F(EnvTest, ReadWrite) {
   delete sequential_file;
 }
 
+TEST_F(EnvTest, MmapSequentialFile) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  std::string test_file_name = test_dir + "/mmap_sequential_file.txt";
+
+  // 足够大，让读过的部分被分批丢弃
+  Random rnd(301);
+  std::string data(5 * 1048576 + 123, ' ');
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<char>(' ' + rnd.Uniform(95));
+  }
+  WritableFile* writable_file;
+  ASSERT_TRUE(env_->NewWritableFile(test_file_name, &writable_file).ok());
+  ASSERT_TRUE(writable_file->Append(data).ok());
+  ASSERT_TRUE(writable_file->Close().ok());
+  delete writable_file;
+
+  SequentialFile* sequential_file;
+  ASSERT_TRUE(
+      env_->NewMmapSequentialFile(test_file_name, &sequential_file).ok());
+  std::string read_result;
+  char scratch[1];
+  Slice read;
+  // 不使用 scratch
+  ASSERT_TRUE(sequential_file->Read(100, &read, scratch).ok());
+  ASSERT_EQ(100, read.size());
+  read_result.append(read.data(), read.size());
+  ASSERT_TRUE(sequential_file->Skip(1000).ok());
+  read_result.append(data, 100, 1000);
+  while (true) {
+    ASSERT_TRUE(sequential_file->Read(rnd.Skewed(18), &read, scratch).ok());
+    if (read.empty() && read_result.size() == data.size()) {
+      break;
+    }
+    read_result.append(read.data(), read.size());
+  }
+  ASSERT_EQ(data, read_result);
+  // 到达文件尾之后 Skip 停在文件尾
+  ASSERT_TRUE(sequential_file->Skip(10).ok());
+  ASSERT_TRUE(sequential_file->Read(10, &read, scratch).ok());
+  ASSERT_TRUE(read.empty());
+  delete sequential_file;
+
+  // 空文件退回到普通的顺序读
+  ASSERT_TRUE(env_->NewWritableFile(test_file_name, &writable_file).ok());
+  ASSERT_TRUE(writable_file->Close().ok());
+  delete writable_file;
+  ASSERT_TRUE(
+      env_->NewMmapSequentialFile(test_file_name, &sequential_file).ok());
+  ASSERT_TRUE(sequential_file->Read(10, &read, scratch).ok());
+  ASSERT_TRUE(read.empty());
+  delete sequential_file;
+
+  ASSERT_TRUE(env_->NewMmapSequentialFile(test_dir + "/non_existent_file",
+                                          &sequential_file)
+                  .IsNotFound());
+  env_->RemoveFile(test_file_name);
+}
+
 TEST_F(EnvTest, RunImmediately) {
   struct RunState {
     Mutex mu;
@@ -225,4 +290,567 @@ TEST_F(EnvTest, ReopenAppendableFile) {
   env_->RemoveFile(test_file_name);
 }
 
+TEST_F(EnvTest, ReuseWritableFile) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  std::string old_file_name = test_dir + "/reuse_writable_file_old.txt";
+  std::string test_file_name = test_dir + "/reuse_writable_file.txt";
+  env_->RemoveFile(test_file_name);
+  ASSERT_TRUE(WriteStringToFile(env_, "hello world!", old_file_name).ok());
+
+  // 从开头覆盖写入，后面的旧内容保留
+  WritableFile* writable_file;
+  ASSERT_TRUE(env_->ReuseWritableFile(test_file_name, old_file_name,
+                                      &writable_file).ok());
+  ASSERT_TRUE(writable_file->Append("42").ok());
+  ASSERT_TRUE(writable_file->Sync().ok());
+  ASSERT_TRUE(writable_file->Close().ok());
+  delete writable_file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, test_file_name, &data).ok());
+  ASSERT_EQ(std::string("42llo world!"), data);
+  ASSERT_FALSE(env_->FileExists(old_file_name));
+
+  // 旧文件不存在时失败
+  ASSERT_FALSE(env_->ReuseWritableFile(test_file_name, old_file_name,
+                                       &writable_file).ok());
+  env_->RemoveFile(test_file_name);
+}
+
+// 用 AppendV 写入大小不一的若干组 Slice(包括超过一次 writev 的 iovec 数的一组)，
+// 中间穿插 Append，返回应该写入的内容
+static std::string AppendVMixed(WritableFile* file) {
+  Random rnd(301);
+  std::string expected;
+  std::vector<std::string> pieces;
+  for (int round = 0; round < 40; round++) {
+    pieces.clear();
+    const bool many = (round % 10 == 9);
+    const int n = many ? kGatherWriteMaxIov + 8 : 1 + rnd.Uniform(3);
+    for (int i = 0; i < n; i++) {
+      const size_t len = many ? rnd.Uniform(100)
+                              : rnd.OneIn(3) ? rnd.Uniform(100000)
+                                             : rnd.Uniform(20);
+      pieces.push_back(std::string(len, static_cast<char>('a' + rnd.Uniform(26))));
+    }
+    std::vector<Slice> slices(pieces.begin(), pieces.end());
+    EXPECT_TRUE(file->AppendV(slices.data(), slices.size()).ok());
+    for (const std::string& piece : pieces) {
+      expected += piece;
+    }
+    if (rnd.OneIn(2)) {
+      std::string small(rnd.Uniform(10), 'x');
+      EXPECT_TRUE(file->Append(small).ok());
+      expected += small;
+    }
+  }
+  return expected;
+}
+
+TEST_F(EnvTest, SyncDir) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  ASSERT_TRUE(env_->SyncDir(test_dir).ok());
+  ASSERT_TRUE(env_->SyncDir(test_dir + "/non_existent_dir").IsNotFound());
+}
+
+TEST_F(EnvTest, PreallocateWritableFile) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  std::string test_file_name = test_dir + "/preallocate_writable_file.txt";
+
+  WritableFile* writable_file;
+  ASSERT_TRUE(env_->NewWritableFile(test_file_name, &writable_file).ok());
+  ASSERT_TRUE(writable_file->Append("hello").ok());
+  ASSERT_TRUE(writable_file->Preallocate(100000).ok());
+  ASSERT_TRUE(writable_file->Append(" world").ok());
+  ASSERT_TRUE(writable_file->Sync().ok());
+  ASSERT_TRUE(writable_file->Close().ok());
+  delete writable_file;
+
+  // 文件系统不支持 fallocate 时文件大小不变
+  uint64_t size;
+  ASSERT_TRUE(env_->GetFileSize(test_file_name, &size).ok());
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, test_file_name, &data).ok());
+  ASSERT_EQ(size, data.size());
+  ASSERT_EQ(std::string("hello world"), data.substr(0, 11));
+  ASSERT_EQ(std::string(size - 11, '\0'), data.substr(11));
+  env_->RemoveFile(test_file_name);
+}
+
+TEST_F(EnvTest, AppendV) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  const std::string fname = test_dir + "/append_v.txt";
+  WritableFile* file;
+  ASSERT_TRUE(env_->NewWritableFile(fname, &file).ok());
+  std::string expected = AppendVMixed(file);
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, fname, &data).ok());
+  ASSERT_TRUE(expected == data);
+  env_->RemoveFile(fname);
+}
+
+TEST_F(EnvTest, DirectWritableFile) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  const std::string fname = test_dir + "/direct_writable_file.txt";
+  WritableFile* file;
+  ASSERT_TRUE(env_->NewDirectWritableFile(fname, &file).ok());
+  Random rnd(301);
+  std::string expected;
+  for (int i = 0; i < 200; i++) {
+    std::string piece(rnd.OneIn(10) ? rnd.Uniform(300000) : rnd.Uniform(5000),
+                      static_cast<char>('a' + rnd.Uniform(26)));
+    ASSERT_TRUE(file->Append(piece).ok());
+    ASSERT_TRUE(file->Flush().ok());
+    expected += piece;
+    if (rnd.OneIn(20)) {
+      // Sync 之后文件的大小和内容都是完整的，不包括对齐补上的 0
+      ASSERT_TRUE(file->Sync().ok());
+      uint64_t size;
+      ASSERT_TRUE(env_->GetFileSize(fname, &size).ok());
+      ASSERT_EQ(expected.size(), size);
+    }
+  }
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, fname, &data).ok());
+  ASSERT_EQ(expected.size(), data.size());
+  ASSERT_TRUE(expected == data);
+  env_->RemoveFile(fname);
+}
+
+TEST_F(EnvTest, DirectRandomAccessFile) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  const std::string fname = test_dir + "/direct_random_access_file.txt";
+  Random rnd(301);
+  std::string data;
+  for (int i = 0; i < 100000; i++) {
+    data.push_back(static_cast<char>(rnd.Uniform(256)));
+  }
+  ASSERT_TRUE(WriteStringToFile(env_, data, fname).ok());
+
+  RandomAccessFile* file;
+  ASSERT_TRUE(env_->NewDirectRandomAccessFile(fname, &file).ok());
+  std::string scratch(20000, '\0');
+  Slice result;
+  for (int i = 0; i < 1000; i++) {
+    // 任意的偏移和长度，包括越过文件尾的读取
+    const uint64_t offset = rnd.Uniform(data.size() + 100);
+    const size_t n = rnd.Uniform(scratch.size());
+    ASSERT_TRUE(file->Read(offset, n, &result, &scratch[0]).ok());
+    const size_t expected =
+        offset >= data.size() ? 0 : std::min<size_t>(n, data.size() - offset);
+    ASSERT_EQ(expected, result.size());
+    ASSERT_TRUE(Slice(data.data() + std::min<size_t>(offset, data.size()),
+                      expected) == result);
+  }
+
+  // 偏移、长度和 scratch 都对齐时直接读入 scratch，包括读到文件尾
+  AlignedBuffer aligned(kDirectIOAlignment, 3 * kDirectIOAlignment);
+  ASSERT_TRUE(file->Read(kDirectIOAlignment, 2 * kDirectIOAlignment, &result,
+                         aligned.data()).ok());
+  ASSERT_TRUE(Slice(data.data() + kDirectIOAlignment,
+                    2 * kDirectIOAlignment) == result);
+  const uint64_t tail = TruncateToAlignment(data.size(), kDirectIOAlignment);
+  ASSERT_TRUE(file->Read(tail, aligned.capacity(), &result,
+                         aligned.data()).ok());
+  ASSERT_TRUE(Slice(data.data() + tail, data.size() - tail) == result);
+
+  // 超过线程缓冲区上限的读取
+  std::string large(2 * 1024 * 1024, '\0');
+  ASSERT_TRUE(file->Read(1, large.size(), &result, &large[0]).ok());
+  ASSERT_TRUE(Slice(data.data() + 1, data.size() - 1) == result);
+  delete file;
+  env_->RemoveFile(fname);
+}
+
+class IoUringEnvTest : public testing::Test {
+ public:
+  IoUringEnvTest() : env_(NewIoUringEnv(Env::Default())) {
+    env_->GetTestDirectory(&test_dir_);
+  }
+
+  ~IoUringEnvTest() { delete env_; }
+
+  // 用 io_uring Env 写入 size 字节的随机数据，每写入若干次 Sync 一次
+  std::string WriteFile(const std::string& fname, size_t size) {
+    Random rnd(301);
+    WritableFile* file;
+    EXPECT_TRUE(env_->NewWritableFile(fname, &file).ok());
+    std::string data;
+    while (data.size() < size) {
+      std::string r(1 + rnd.Skewed(17), ' ');
+      for (size_t i = 0; i < r.size(); i++) {
+        r[i] = static_cast<char>(' ' + rnd.Uniform(95));
+      }
+      EXPECT_TRUE(file->Append(r).ok());
+      data += r;
+      if (rnd.OneIn(8)) {
+        EXPECT_TRUE(file->Sync().ok());
+      }
+    }
+    EXPECT_TRUE(file->Sync().ok());
+    EXPECT_TRUE(file->Close().ok());
+    delete file;
+    return data;
+  }
+
+  Env* env_;
+  std::string test_dir_;
+};
+
+TEST_F(IoUringEnvTest, WriteSyncRead) {
+  std::fprintf(stderr, "io_uring available: %d\n", IoUringAvailable());
+  const std::string fname = test_dir_ + "/io_uring_write_sync_read.txt";
+  std::string data = WriteFile(fname, 2 * 1048576);
+
+  std::string contents;
+  ASSERT_TRUE(ReadFileToString(Env::Default(), fname, &contents).ok());
+  ASSERT_EQ(data, contents);
+
+  RandomAccessFile* file;
+  ASSERT_TRUE(env_->NewRandomAccessFile(fname, &file).ok());
+  std::string scratch(4096, '\0');
+  Slice result;
+  ASSERT_TRUE(file->Read(12345, 4096, &result, &scratch[0]).ok());
+  ASSERT_EQ(data.substr(12345, 4096), result.ToString());
+  // 读到文件末尾时与 pread 相同，返回较少的数据
+  ASSERT_TRUE(file->Read(data.size() - 10, 4096, &result, &scratch[0]).ok());
+  ASSERT_EQ(data.substr(data.size() - 10), result.ToString());
+  delete file;
+  env_->RemoveFile(fname);
+}
+
+TEST_F(IoUringEnvTest, MultiRead) {
+  const std::string fname = test_dir_ + "/io_uring_multi_read.txt";
+  std::string data = WriteFile(fname, 1048576);
+
+  RandomAccessFile* file;
+  ASSERT_TRUE(env_->NewRandomAccessFile(fname, &file).ok());
+  // 请求数多于 ring 的队列长度，需要分多次提交
+  const int kNumReqs = 300;
+  Random rnd(17);
+  std::vector<RandomAccessFile::ReadRequest> reqs(kNumReqs);
+  std::vector<std::string> buffers(kNumReqs);
+  for (int i = 0; i < kNumReqs; i++) {
+    buffers[i].resize(1 + rnd.Uniform(8192));
+    reqs[i].offset = rnd.Uniform(data.size());
+    reqs[i].n = buffers[i].size();
+    reqs[i].scratch = &buffers[i][0];
+  }
+  ASSERT_TRUE(file->MultiRead(reqs.data(), reqs.size()).ok());
+  for (int i = 0; i < kNumReqs; i++) {
+    ASSERT_TRUE(reqs[i].status.ok());
+    ASSERT_EQ(data.substr(reqs[i].offset, reqs[i].n), reqs[i].result.ToString());
+  }
+
+  // 多个线程同时 MultiRead，各自使用自己的 ring
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      std::vector<RandomAccessFile::ReadRequest> local(16);
+      std::vector<std::string> bufs(16, std::string(512, '\0'));
+      for (int iter = 0; iter < 200; iter++) {
+        for (int i = 0; i < 16; i++) {
+          local[i].offset = ((t * 7919 + iter * 31 + i) * 4099) % data.size();
+          local[i].n = 512;
+          local[i].scratch = &bufs[i][0];
+        }
+        ASSERT_TRUE(file->MultiRead(local.data(), local.size()).ok());
+        for (int i = 0; i < 16; i++) {
+          ASSERT_EQ(data.substr(local[i].offset, 512), local[i].result.ToString());
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  delete file;
+  env_->RemoveFile(fname);
+}
+
+// sqe 的长度只有 32 位，更长的读取被拒绝，同一批中的其他请求不受影响
+TEST_F(IoUringEnvTest, MultiReadTooLarge) {
+  if (!IoUringAvailable()) {
+    return;
+  }
+  const std::string fname = test_dir_ + "/io_uring_multi_read_too_large.txt";
+  std::string data = WriteFile(fname, 8192);
+
+  RandomAccessFile* file;
+  ASSERT_TRUE(env_->NewRandomAccessFile(fname, &file).ok());
+  char scratch[2][100];
+  RandomAccessFile::ReadRequest reqs[2];
+  reqs[0].offset = 0;
+  reqs[0].n = (static_cast<size_t>(1) << 32) + 100;
+  reqs[0].scratch = scratch[0];
+  reqs[1].offset = 10;
+  reqs[1].n = 100;
+  reqs[1].scratch = scratch[1];
+  ASSERT_TRUE(file->MultiRead(reqs, 2).IsInvalidArgument());
+  ASSERT_TRUE(reqs[0].status.IsInvalidArgument());
+  ASSERT_EQ(0u, reqs[0].result.size());
+  ASSERT_TRUE(reqs[1].status.ok());
+  ASSERT_EQ(data.substr(10, 100), reqs[1].result.ToString());
+  delete file;
+  env_->RemoveFile(fname);
+}
+
+TEST_F(IoUringEnvTest, ReopenAppendableFile) {
+  const std::string fname = test_dir_ + "/io_uring_appendable.txt";
+  env_->RemoveFile(fname);
+
+  WritableFile* file;
+  ASSERT_TRUE(env_->NewAppendableFile(fname, &file).ok());
+  ASSERT_TRUE(file->Append("hello world!").ok());
+  ASSERT_TRUE(file->Sync().ok());
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  ASSERT_TRUE(env_->NewAppendableFile(fname, &file).ok());
+  ASSERT_TRUE(file->Append("42").ok());
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, fname, &data).ok());
+  ASSERT_EQ(std::string("hello world!42"), data);
+  env_->RemoveFile(fname);
+}
+
+TEST_F(IoUringEnvTest, ReuseWritableFile) {
+  const std::string old_fname = test_dir_ + "/io_uring_reuse_old.txt";
+  const std::string fname = test_dir_ + "/io_uring_reuse.txt";
+  ASSERT_TRUE(WriteStringToFile(env_, "hello world!", old_fname).ok());
+
+  WritableFile* file;
+  ASSERT_TRUE(env_->ReuseWritableFile(fname, old_fname, &file).ok());
+  ASSERT_TRUE(file->Append("42").ok());
+  ASSERT_TRUE(file->Sync().ok());
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, fname, &data).ok());
+  ASSERT_EQ(std::string("42llo world!"), data);
+  env_->RemoveFile(fname);
+}
+
+TEST_F(IoUringEnvTest, AppendV) {
+  const std::string fname = test_dir_ + "/io_uring_append_v.txt";
+  WritableFile* file;
+  ASSERT_TRUE(env_->NewWritableFile(fname, &file).ok());
+  std::string expected = AppendVMixed(file);
+  ASSERT_TRUE(file->Sync().ok());
+  std::string tail(5000, 't');
+  const Slice slices[2] = {Slice("head"), Slice(tail)};
+  ASSERT_TRUE(file->AppendV(slices, 2).ok());
+  expected += "head" + tail;
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  std::string data;
+  ASSERT_TRUE(ReadFileToString(env_, fname, &data).ok());
+  ASSERT_TRUE(expected == data);
+  env_->RemoveFile(fname);
+}
+
+// 默认的 MultiRead 依次调用 Read
+TEST_F(EnvTest, DefaultMultiRead) {
+  std::string test_dir;
+  env_->GetTestDirectory(&test_dir);
+  const std::string fname = test_dir + "/default_multi_read.txt";
+  ASSERT_TRUE(WriteStringToFile(env_, "0123456789", fname).ok());
+  RandomAccessFile* file;
+  ASSERT_TRUE(env_->NewRandomAccessFile(fname, &file).ok());
+  char scratch[2][4];
+  RandomAccessFile::ReadRequest reqs[2];
+  reqs[0].offset = 2;
+  reqs[0].n = 3;
+  reqs[0].scratch = scratch[0];
+  reqs[1].offset = 7;
+  reqs[1].n = 3;
+  reqs[1].scratch = scratch[1];
+  ASSERT_TRUE(file->MultiRead(reqs, 2).ok());
+  ASSERT_EQ("234", reqs[0].result.ToString());
+  ASSERT_EQ("789", reqs[1].result.ToString());
+  delete file;
+  env_->RemoveFile(fname);
+}
+
+// 一个可以阻塞后台线程的任务：Run 等待 Release() 后才返回
+struct BlockingJob {
+  Mutex mu;
+  CondVar cv{&mu};
+  int started = 0;
+  int finished = 0;
+  bool released = false;
+
+  static void Run(void* arg) {
+    BlockingJob* job = reinterpret_cast<BlockingJob*>(arg);
+    MutexLock l(&job->mu);
+    job->started++;
+    job->cv.SignalAll();
+    while (!job->released) {
+      job->cv.Wait();
+    }
+    job->finished++;
+    job->cv.SignalAll();
+  }
+
+  void WaitStarted(int n) {
+    MutexLock l(&mu);
+    while (started < n) {
+      cv.Wait();
+    }
+  }
+
+  void Release() {
+    MutexLock l(&mu);
+    released = true;
+    cv.SignalAll();
+  }
+
+  void WaitFinished(int n) {
+    MutexLock l(&mu);
+    while (finished < n) {
+      cv.Wait();
+    }
+  }
+};
+
+// LOW 线程池被长任务占满时，HIGH 任务依然可以执行
+TEST_F(EnvTest, PriorityPoolsAreIndependent) {
+  BlockingJob compaction;
+  env_->Schedule(&BlockingJob::Run, &compaction, Env::LOW);
+  compaction.WaitStarted(1);
+
+  BlockingJob flush;
+  flush.Release();
+  env_->Schedule(&BlockingJob::Run, &flush, Env::HIGH);
+  flush.WaitFinished(1);
+
+  // LOW 只有一个线程，后续的 LOW 任务排队
+  BlockingJob queued;
+  queued.Release();
+  env_->Schedule(&BlockingJob::Run, &queued, Env::LOW);
+  ASSERT_EQ(1, env_->GetThreadPoolQueueLen(Env::LOW));
+  ASSERT_EQ(0, env_->GetThreadPoolQueueLen(Env::HIGH));
+
+  compaction.Release();
+  queued.WaitFinished(1);
+  compaction.WaitFinished(1);
+}
+
+TEST_F(EnvTest, WaitForJoin) {
+  State state(0, 20);
+  for (int i = 0; i < 20; i++) {
+    env_->Schedule(&ThreadBody, &state, i % 2 == 0 ? Env::LOW : Env::HIGH);
+  }
+  env_->WaitForJoin();
+  {
+    MutexLock l(&state.mu);
+    ASSERT_EQ(20, state.val);
+  }
+
+  // join 之后还可以继续 Schedule
+  State again(0, 1);
+  env_->Schedule(&ThreadBody, &again);
+  env_->WaitForJoin();
+  MutexLock l(&again.mu);
+  ASSERT_EQ(1, again.val);
+}
+
+TEST(ThreadPoolTest, ResizeAtRuntime) {
+  ThreadPool pool(1);
+  BlockingJob job;
+  for (int i = 0; i < 4; i++) {
+    pool.Schedule(&BlockingJob::Run, &job);
+  }
+  job.WaitStarted(1);
+  ASSERT_EQ(3, pool.GetQueueLen());
+
+  // 增加线程后，排队的任务立即开始执行
+  pool.SetBackgroundThreads(4);
+  ASSERT_EQ(4, pool.GetBackgroundThreads());
+  job.WaitStarted(4);
+  ASSERT_EQ(0, pool.GetQueueLen());
+
+  // 减少线程不会打断正在执行的任务
+  pool.SetBackgroundThreads(1);
+  job.Release();
+  job.WaitFinished(4);
+
+  BlockingJob more;
+  more.Release();
+  for (int i = 0; i < 10; i++) {
+    pool.Schedule(&BlockingJob::Run, &more);
+  }
+  more.WaitFinished(10);
+  ASSERT_EQ(1, pool.GetBackgroundThreads());
+
+  Env::ThreadPoolStats stats;
+  pool.JoinAllThreads(true);
+  pool.GetStats(&stats);
+  ASSERT_EQ(14, stats.jobs_completed);
+  ASSERT_EQ(0, stats.queue_len);
+  ASSERT_EQ(0, stats.running_jobs);
+}
+
+TEST(ThreadPoolTest, Stats) {
+  ThreadPool pool(1);
+  BlockingJob job;
+  pool.Schedule(&BlockingJob::Run, &job);
+  job.WaitStarted(1);
+  BlockingJob queued;
+  queued.Release();
+  pool.Schedule(&BlockingJob::Run, &queued);
+
+  Env::ThreadPoolStats stats;
+  pool.GetStats(&stats);
+  ASSERT_EQ(1, stats.queue_len);
+  ASSERT_EQ(1, stats.running_jobs);
+  ASSERT_EQ(0, stats.jobs_completed);
+
+  Env::Default()->SleepForMicroseconds(20000);
+  job.Release();
+  pool.JoinAllThreads(true);
+  pool.GetStats(&stats);
+  ASSERT_EQ(2, stats.jobs_completed);
+  // 第一个任务运行了至少 20ms，第二个任务排队了至少 20ms
+  ASSERT_GE(stats.max_run_micros, 20000);
+  ASSERT_GE(stats.max_queue_micros, 20000);
+  ASSERT_GE(stats.total_run_micros, stats.max_run_micros);
+}
+
+TEST(ThreadPoolTest, JoinWithoutWaitingDropsQueuedJobs) {
+  ThreadPool pool(1);
+  BlockingJob job;
+  pool.Schedule(&BlockingJob::Run, &job);
+  job.WaitStarted(1);
+  BlockingJob dropped;
+  dropped.Release();
+  pool.Schedule(&BlockingJob::Run, &dropped);
+
+  std::thread releaser([&job]() {
+    Env::Default()->SleepForMicroseconds(10000);
+    job.Release();
+  });
+  pool.JoinAllThreads(false);
+  releaser.join();
+  ASSERT_EQ(1, job.finished);
+  ASSERT_EQ(0, dropped.started);
+}
+
 }  // namespace leveldb
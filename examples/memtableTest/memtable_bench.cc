@@ -0,0 +1,272 @@
+// MemTable::Get / 迭代器 Seek 基准：默认 64KB new[] 块与 2MB mmap(大页)块的对比。
+// 同时用 perf_event_open 统计 Get 阶段的 dTLB load miss，没有权限时显示 n/a。
+// 第二部分对比批量查询：逐个 Get 与 MultiGet(排序后 finger search)在不同批量下的每 key 耗时。
+// 第三部分对比大 value 的读取：拷贝到 std::string 的 Get 与直接指向 arena 的 PinnableSlice Get。
+// 用法: ./memtable_bench [写入条数, 默认 500000] [查询次数, 默认 1000000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "comparator.h"
+#include "dbformat.h"
+#include "memtable.h"
+#include "random.h"
+
+using namespace leveldb;
+
+// 打开当前线程的 dTLB read miss 计数器，失败返回 -1
+static int OpenTlbCounter()
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static std::string MakeKey(uint64_t i)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%016llx",
+                  static_cast<unsigned long long>(i * 0x9e3779b97f4a7c15ull));
+    return std::string(buf);
+}
+
+static void Run(const char* name, size_t block_size, bool use_mmap,
+                int num, int reads)
+{
+    InternalKeyComparator cmp(BytewiseComparator());
+    MemTable* mem = new MemTable(cmp, block_size, use_mmap);
+    mem->Ref();
+    const std::string value(100, 'v');
+    for (int i = 0; i < num; i++)
+    {
+        mem->Add(i + 1, kTypeValue, MakeKey(i), value);
+    }
+
+    Random rnd(301);
+    int fd = OpenTlbCounter();
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    int found = 0;
+    std::string result;
+    Status s;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        LookupKey lkey(MakeKey(rnd.Uniform(num)), kMaxSequenceNumber);
+        if (mem->Get(lkey, &result, &s))
+        {
+            found++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    char misses[32] = "n/a";
+    if (fd >= 0)
+    {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) == sizeof(count))
+        {
+            std::snprintf(misses, sizeof(misses), "%.2f",
+                          static_cast<double>(count) / reads);
+        }
+        close(fd);
+    }
+
+    // 迭代器 Seek：与 Get 走相同的查找路径，但通过 Iterator 接口
+    Iterator* iter = mem->NewIterator();
+    int seek_found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        InternalKey ikey(MakeKey(rnd.Uniform(num)), kMaxSequenceNumber, kValueTypeForSeek);
+        iter->Seek(ikey.Encode());
+        if (iter->Valid())
+        {
+            seek_found++;
+        }
+    }
+    double seek_seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    delete iter;
+
+    std::printf("%-16s %12.1f %12.1f %14s %12.1f %8d\n", name, seconds * 1e9 / reads,
+                seek_seconds * 1e9 / reads, misses,
+                mem->ApproximateMemoryUsage() / 1048576.0, found + seek_found);
+    mem->Unref();
+}
+
+static void RunMultiGet(int num, int reads, int batch)
+{
+    InternalKeyComparator cmp(BytewiseComparator());
+    MemTable* mem = new MemTable(cmp);
+    mem->Ref();
+    const std::string value(100, 'v');
+    for (int i = 0; i < num; i++)
+    {
+        mem->Add(i + 1, kTypeValue, MakeKey(i), value);
+    }
+
+    // 预先构造好所有批次的 LookupKey，两种方式查询完全相同的 key
+    Random rnd(301);
+    const int batches = reads / batch;
+    std::vector<std::unique_ptr<LookupKey>> owned;
+    std::vector<const LookupKey*> keys;
+    for (int i = 0; i < batches * batch; i++)
+    {
+        owned.emplace_back(new LookupKey(MakeKey(rnd.Uniform(num)), kMaxSequenceNumber));
+        keys.push_back(owned.back().get());
+    }
+
+    std::vector<std::string> values(batch);
+    std::vector<Status> statuses(batch);
+    std::unique_ptr<bool[]> found(new bool[batch]);
+
+    int get_found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int b = 0; b < batches; b++)
+    {
+        for (int i = 0; i < batch; i++)
+        {
+            if (mem->Get(*keys[b * batch + i], &values[i], &statuses[i]))
+            {
+                get_found++;
+            }
+        }
+    }
+    double get_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    int multiget_found = 0;
+    start = std::chrono::steady_clock::now();
+    for (int b = 0; b < batches; b++)
+    {
+        mem->MultiGet(&keys[b * batch], batch, values.data(), statuses.data(), found.get());
+        for (int i = 0; i < batch; i++)
+        {
+            multiget_found += found[i];
+        }
+    }
+    double multiget_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const double total = static_cast<double>(batches) * batch;
+    std::printf("%-8d %14.1f %18.1f %9.2fx %8s\n", batch, get_secs * 1e9 / total,
+                multiget_secs * 1e9 / total, get_secs / multiget_secs,
+                get_found == multiget_found ? "yes" : "NO");
+    mem->Unref();
+}
+
+static void RunPinned(int reads, size_t value_size)
+{
+    // 每种 value 大小写入约 64MB 数据
+    const int num = static_cast<int>((64u << 20) / value_size);
+    InternalKeyComparator cmp(BytewiseComparator());
+    MemTable* mem = new MemTable(cmp);
+    mem->Ref();
+    const std::string value(value_size, 'v');
+    for (int i = 0; i < num; i++)
+    {
+        mem->Add(i + 1, kTypeValue, MakeKey(i), value);
+    }
+
+    std::vector<std::string> keys(reads);
+    Random rnd(301);
+    for (int i = 0; i < reads; i++)
+    {
+        keys[i] = MakeKey(rnd.Uniform(num));
+    }
+
+    // 每次查询使用新的 std::string：一次分配加一次拷贝
+    size_t bytes = 0;
+    Status s;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        std::string result;
+        mem->Get(LookupKey(keys[i], kMaxSequenceNumber), &result, &s);
+        bytes += result.size();
+    }
+    double fresh_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // 复用同一个 std::string：容量够用之后只剩拷贝
+    std::string reused;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        mem->Get(LookupKey(keys[i], kMaxSequenceNumber), &reused, &s);
+        bytes += reused.size();
+    }
+    double reused_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    // PinnableSlice：只增减 memtable 的引用计数
+    PinnableSlice pinned;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        pinned.Reset();
+        mem->Get(LookupKey(keys[i], kMaxSequenceNumber), &pinned, &s);
+        bytes += pinned.size();
+    }
+    double pinned_secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    pinned.Reset();
+
+    std::printf("%-8zu %16.1f %16.1f %16.1f %9.2fx %8s\n", value_size,
+                fresh_secs * 1e9 / reads, reused_secs * 1e9 / reads,
+                pinned_secs * 1e9 / reads, fresh_secs / pinned_secs,
+                bytes == 3 * value_size * reads ? "yes" : "NO");
+    mem->Unref();
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 500000;
+    const int reads = argc > 2 ? std::atoi(argv[2]) : 1000000;
+
+    std::printf("entries: %d, lookups: %d\n", num, reads);
+    std::printf("%-16s %12s %12s %14s %12s %8s\n", "arena", "Get(ns/op)",
+                "Seek(ns/op)", "dTLB miss/op", "usage(MB)", "found");
+    Run("64KB new[]", ConcurrentArena::kDefaultBlockSize, false, num, reads);
+    Run("2MB mmap", 2 * 1024 * 1024, true, num, reads);
+    // 第二次 mmap 运行复用块池中上一个 memtable 归还的块
+    Run("2MB mmap(pool)", 2 * 1024 * 1024, true, num, reads);
+
+    std::printf("\n%-8s %14s %18s %10s %8s\n", "batch", "Get(ns/key)",
+                "MultiGet(ns/key)", "speedup", "same");
+    for (int batch : {50, 100, 200, 500})
+    {
+        RunMultiGet(num, reads, batch);
+    }
+
+    std::printf("\n%-8s %16s %16s %16s %10s %8s\n", "value", "string(ns/op)",
+                "reused(ns/op)", "pinned(ns/op)", "speedup", "same");
+    for (size_t value_size : {1024, 4096, 16384})
+    {
+        RunPinned(reads, value_size);
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+#include "memtable.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "comparator.h"
+#include "dbformat.h"
+#include "gtest/gtest.h"
+#include "memtablerep.h"
+#include "random.h"
+
+namespace leveldb {
+
+class MemTableTest : public testing::Test {
+ public:
+  MemTableTest() : cmp_(BytewiseComparator()), mem_(new MemTable(cmp_)) {
+    mem_->Ref();
+  }
+
+  ~MemTableTest() { mem_->Unref(); }
+
+  std::string Get(const std::string& key, SequenceNumber seq) {
+    LookupKey lkey(key, seq);
+    std::string value;
+    Status s;
+    if (!mem_->Get(lkey, &value, &s)) {
+      return "NOT_FOUND";
+    }
+    return s.ok() ? value : "DELETED";
+  }
+
+ protected:
+  InternalKeyComparator cmp_;
+  MemTable* mem_;
+};
+
+TEST_F(MemTableTest, Empty) {
+  ASSERT_EQ("NOT_FOUND", Get("foo", 100));
+  Iterator* iter = mem_->NewIterator();
+  iter->SeekToFirst();
+  ASSERT_TRUE(!iter->Valid());
+  delete iter;
+}
+
+TEST_F(MemTableTest, AddAndGet) {
+  mem_->Add(1, kTypeValue, "foo", "v1");
+  mem_->Add(2, kTypeValue, "bar", "v2");
+  mem_->Add(3, kTypeValue, "foo", "v3");
+  mem_->Add(4, kTypeDeletion, "bar", "");
+
+  ASSERT_EQ("v1", Get("foo", 1));
+  ASSERT_EQ("v1", Get("foo", 2));
+  ASSERT_EQ("v3", Get("foo", 3));
+  ASSERT_EQ("v2", Get("bar", 3));
+  ASSERT_EQ("DELETED", Get("bar", 4));
+  ASSERT_EQ("NOT_FOUND", Get("bar", 1));
+  ASSERT_EQ("NOT_FOUND", Get("baz", 10));
+}
+
+TEST_F(MemTableTest, GetPinned) {
+  const std::string big(8192, 'x');
+  mem_->Add(1, kTypeValue, "foo", big);
+  mem_->Add(2, kTypeDeletion, "foo", "");
+
+  Status s;
+  PinnableSlice value;
+  ASSERT_TRUE(mem_->Get(LookupKey("foo", 1), &value, &s));
+  ASSERT_TRUE(s.ok());
+  ASSERT_TRUE(value.IsPinned());
+  ASSERT_EQ(big, value.ToString());
+  // 没有拷贝到 PinnableSlice 自己的 buffer
+  ASSERT_TRUE(value.GetSelf()->empty());
+
+  PinnableSlice deleted;
+  ASSERT_TRUE(mem_->Get(LookupKey("foo", 2), &deleted, &s));
+  ASSERT_TRUE(s.IsNotFound());
+  ASSERT_FALSE(deleted.IsPinned());
+
+  PinnableSlice missing;
+  s = Status::OK();
+  ASSERT_FALSE(mem_->Get(LookupKey("bar", 2), &missing, &s));
+  ASSERT_TRUE(s.ok());
+  ASSERT_FALSE(missing.IsPinned());
+
+  // value 持有 memtable 的引用：原持有者释放之后数据依然有效，Reset 时才删除
+  mem_->Unref();
+  ASSERT_EQ(big, value.ToString());
+  value.Reset();
+  ASSERT_FALSE(value.IsPinned());
+  ASSERT_TRUE(value.empty());
+  mem_ = new MemTable(cmp_);
+  mem_->Ref();
+}
+
+TEST_F(MemTableTest, IteratorOrder) {
+  mem_->Add(1, kTypeValue, "b", "1");
+  mem_->Add(2, kTypeValue, "a", "2");
+  mem_->Add(3, kTypeValue, "b", "3");
+
+  // 相同 user key 时序列号大的排在前面
+  Iterator* iter = mem_->NewIterator();
+  iter->SeekToFirst();
+  std::vector<std::string> result;
+  for (; iter->Valid(); iter->Next()) {
+    ParsedInternalKey ikey;
+    ASSERT_TRUE(ParseInternalKey(iter->key(), &ikey));
+    result.push_back(ikey.user_key.ToString() + "@" +
+                     std::to_string(ikey.sequence) + "=" +
+                     iter->value().ToString());
+  }
+  delete iter;
+  std::vector<std::string> expected = {"a@2=2", "b@3=3", "b@1=1"};
+  ASSERT_EQ(expected, result);
+}
+
+TEST_F(MemTableTest, AddConcurrently) {
+  const int kThreads = 8;
+  const int kPerThread = 5000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < kPerThread; i++) {
+        const SequenceNumber seq = t * kPerThread + i + 1;
+        std::string key = "key" + std::to_string(seq);
+        mem_->AddConcurrently(seq, kTypeValue, key, "value" + key);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  int count = 0;
+  Iterator* iter = mem_->NewIterator();
+  std::string last;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    std::string key = ExtractUserKey(iter->key()).ToString();
+    if (count > 0) {
+      ASSERT_LT(last, key);
+    }
+    last = key;
+    count++;
+  }
+  delete iter;
+  ASSERT_EQ(kThreads * kPerThread, count);
+
+  for (int seq = 1; seq <= kThreads * kPerThread; seq += 97) {
+    std::string key = "key" + std::to_string(seq);
+    ASSERT_EQ("value" + key, Get(key, kMaxSequenceNumber));
+  }
+}
+
+TEST_F(MemTableTest, MultiGet) {
+  const int kNum = 2000;
+  for (int i = 0; i < kNum; i += 2) {
+    std::string key = "key" + std::to_string(i);
+    mem_->Add(i + 1, kTypeValue, key, "v1" + key);
+    if (i % 10 == 0) {
+      mem_->Add(kNum + i + 1, kTypeDeletion, key, "");
+    } else if (i % 6 == 0) {
+      mem_->Add(kNum + i + 1, kTypeValue, key, "v2" + key);
+    }
+  }
+
+  // 乱序、含重复、含不存在的 key，以及看不到后续更新的旧快照
+  Random rnd(301);
+  for (int batch : {1, 50, 500}) {
+    std::vector<std::unique_ptr<LookupKey>> owned;
+    std::vector<const LookupKey*> keys;
+    for (int i = 0; i < batch; i++) {
+      std::string key = "key" + std::to_string(rnd.Uniform(kNum + 10));
+      SequenceNumber seq = rnd.OneIn(3) ? kNum : kMaxSequenceNumber;
+      owned.emplace_back(new LookupKey(key, seq));
+      keys.push_back(owned.back().get());
+      if (rnd.OneIn(10)) {
+        keys.push_back(owned.back().get());
+      }
+    }
+
+    const size_t n = keys.size();
+    std::vector<std::string> values(n);
+    std::vector<Status> statuses(n);
+    std::unique_ptr<bool[]> found(new bool[n]);
+    mem_->MultiGet(keys.data(), n, values.data(), statuses.data(), found.get());
+    for (size_t i = 0; i < n; i++) {
+      std::string value;
+      Status s;
+      bool expected = mem_->Get(*keys[i], &value, &s);
+      ASSERT_EQ(expected, found[i]) << keys[i]->user_key().ToString();
+      if (expected) {
+        ASSERT_EQ(s.ok(), statuses[i].ok());
+        if (s.ok()) {
+          ASSERT_EQ(value, values[i]);
+        }
+      }
+    }
+  }
+}
+
+// 按字节逆序比较 user key，跳表节点中缓存的字节序前缀不能用于这种比较器
+class ReverseComparator : public Comparator {
+ public:
+  const char* Name() const override { return "test.ReverseComparator"; }
+  int Compare(const Slice& a, const Slice& b) const override {
+    return -BytewiseComparator()->Compare(a, b);
+  }
+  void FindShortestSeparator(std::string*, const Slice&) const override {}
+  void FindShortSuccessor(std::string*) const override {}
+};
+
+TEST(MemTableCustomComparatorTest, ReverseOrder) {
+  ReverseComparator reverse;
+  InternalKeyComparator cmp(&reverse);
+  MemTable* mem = new MemTable(cmp);
+  mem->Ref();
+  for (int i = 0; i < 1000; i++) {
+    std::string key = "key" + std::to_string(i * 7919 % 1000);
+    mem->Add(i + 1, kTypeValue, key, "v" + key);
+  }
+  std::string last;
+  int count = 0;
+  Iterator* iter = mem->NewIterator();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    std::string key = ExtractUserKey(iter->key()).ToString();
+    if (count > 0) {
+      ASSERT_GT(last, key);
+    }
+    last = key;
+    count++;
+  }
+  delete iter;
+  ASSERT_EQ(1000, count);
+  for (int i = 0; i < 1000; i += 13) {
+    std::string key = "key" + std::to_string(i);
+    LookupKey lkey(key, kMaxSequenceNumber);
+    std::string value;
+    Status s;
+    ASSERT_TRUE(mem->Get(lkey, &value, &s));
+    ASSERT_EQ("v" + key, value);
+  }
+  mem->Unref();
+}
+
+// 对每种 MemTableRep 运行相同的测试
+class MemTableRepTest : public testing::TestWithParam<int> {
+ public:
+  MemTableRepTest() : cmp_(BytewiseComparator()) {
+    switch (GetParam()) {
+      case 0:
+        factory_.reset(NewSkipListRepFactory());
+        break;
+      case 1:
+        // 桶很少，保证不同前缀会落在同一个桶中
+        factory_.reset(NewHashSkipListRepFactory(4, 16));
+        break;
+      default:
+        factory_.reset(NewVectorRepFactory());
+        break;
+    }
+    mem_ = new MemTable(cmp_, ConcurrentArena::kDefaultBlockSize, false, factory_.get());
+    mem_->Ref();
+  }
+
+  ~MemTableRepTest() { mem_->Unref(); }
+
+  std::string Get(const std::string& key, SequenceNumber seq) {
+    LookupKey lkey(key, seq);
+    std::string value;
+    Status s;
+    if (!mem_->Get(lkey, &value, &s)) {
+      return "NOT_FOUND";
+    }
+    return s.ok() ? value : "DELETED";
+  }
+
+  // 按 internal key 顺序返回全部 entry
+  std::vector<std::string> Scan(bool backward) {
+    std::vector<std::string> result;
+    Iterator* iter = mem_->NewIterator();
+    if (backward) {
+      iter->SeekToLast();
+    } else {
+      iter->SeekToFirst();
+    }
+    while (iter->Valid()) {
+      ParsedInternalKey ikey("", 0, kTypeValue);
+      EXPECT_TRUE(ParseInternalKey(iter->key(), &ikey));
+      result.push_back(ikey.user_key.ToString() + "@" +
+                       std::to_string(ikey.sequence));
+      if (backward) {
+        iter->Prev();
+      } else {
+        iter->Next();
+      }
+    }
+    delete iter;
+    if (backward) {
+      std::reverse(result.begin(), result.end());
+    }
+    return result;
+  }
+
+ protected:
+  InternalKeyComparator cmp_;
+  std::unique_ptr<MemTableRepFactory> factory_;
+  MemTable* mem_;
+};
+
+TEST_P(MemTableRepTest, AddAndGet) {
+  ASSERT_EQ("NOT_FOUND", Get("foo", 100));
+  mem_->Add(1, kTypeValue, "foo", "v1");
+  mem_->Add(2, kTypeValue, "bar", "v2");
+  mem_->Add(3, kTypeValue, "foo", "v3");
+  mem_->Add(4, kTypeDeletion, "bar", "");
+
+  ASSERT_EQ("v1", Get("foo", 1));
+  ASSERT_EQ("v1", Get("foo", 2));
+  ASSERT_EQ("v3", Get("foo", 3));
+  ASSERT_EQ("v2", Get("bar", 3));
+  ASSERT_EQ("DELETED", Get("bar", 4));
+  ASSERT_EQ("NOT_FOUND", Get("bar", 1));
+  ASSERT_EQ("NOT_FOUND", Get("baz", 10));
+
+  // 读之后继续写入，之后的读要能看到新数据
+  mem_->Add(5, kTypeValue, "baz", "v5");
+  mem_->Add(6, kTypeValue, "aaa", "v6");
+  ASSERT_EQ("v5", Get("baz", 10));
+  ASSERT_EQ("v6", Get("aaa", 10));
+}
+
+TEST_P(MemTableRepTest, IteratorMatchesModel) {
+  Random rnd(301);
+  for (int i = 0; i < 3000; i++) {
+    std::string key = "k" + std::to_string(rnd.Uniform(500));
+    mem_->Add(i + 1, kTypeValue, key, "v" + std::to_string(i));
+    // 写入过程中穿插读，vector 实现需要反复合并
+    if (i % 500 == 0) {
+      ASSERT_EQ("v" + std::to_string(i), Get(key, i + 1));
+    }
+  }
+  std::vector<std::string> forward = Scan(false);
+  ASSERT_EQ(3000u, forward.size());
+  ASSERT_EQ(forward, Scan(true));
+  for (size_t i = 1; i < forward.size(); i++) {
+    std::string a = forward[i - 1], b = forward[i];
+    std::string ua = a.substr(0, a.find('@')), ub = b.substr(0, b.find('@'));
+    ASSERT_TRUE(ua < ub || (ua == ub && std::stoull(a.substr(a.find('@') + 1)) >
+                                            std::stoull(b.substr(b.find('@') + 1))))
+        << a << " " << b;
+  }
+
+  // Seek 定位到第一个不小于目标的 internal key
+  Iterator* iter = mem_->NewIterator();
+  InternalKey target("k25", kMaxSequenceNumber, kValueTypeForSeek);
+  iter->Seek(target.Encode());
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_GE(ExtractUserKey(iter->key()).ToString(), std::string("k25"));
+  delete iter;
+}
+
+TEST_P(MemTableRepTest, MultiGet) {
+  for (int i = 0; i < 1000; i++) {
+    std::string key = "key" + std::to_string(i);
+    mem_->Add(i + 1, kTypeValue, key, "v" + key);
+    if (i % 3 == 0) {
+      mem_->Add(1000 + i + 1, kTypeDeletion, key, "");
+    }
+  }
+  Random rnd(301);
+  std::vector<std::unique_ptr<LookupKey>> owned;
+  std::vector<const LookupKey*> keys;
+  for (int i = 0; i < 300; i++) {
+    SequenceNumber seq = rnd.OneIn(2) ? 1000 : kMaxSequenceNumber;
+    owned.emplace_back(
+        new LookupKey("key" + std::to_string(rnd.Uniform(1100)), seq));
+    keys.push_back(owned.back().get());
+  }
+  const size_t n = keys.size();
+  std::vector<std::string> values(n);
+  std::vector<Status> statuses(n);
+  std::unique_ptr<bool[]> found(new bool[n]);
+  mem_->MultiGet(keys.data(), n, values.data(), statuses.data(), found.get());
+  for (size_t i = 0; i < n; i++) {
+    std::string key = keys[i]->user_key().ToString();
+    SequenceNumber seq = DecodeFixed64(keys[i]->internal_key().data() +
+                                       keys[i]->internal_key().size() - 8) >> 8;
+    std::string expected = Get(key, seq);
+    if (!found[i]) {
+      ASSERT_EQ("NOT_FOUND", expected);
+    } else if (!statuses[i].ok()) {
+      ASSERT_EQ("DELETED", expected);
+    } else {
+      ASSERT_EQ(expected, values[i]);
+    }
+  }
+}
+
+TEST_P(MemTableRepTest, AddConcurrently) {
+  const int kThreads = 4;
+  const int kPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < kPerThread; i++) {
+        const SequenceNumber seq = t * kPerThread + i + 1;
+        std::string key = "key" + std::to_string(seq);
+        mem_->AddConcurrently(seq, kTypeValue, key, "value" + key);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(static_cast<size_t>(kThreads * kPerThread), Scan(false).size());
+  for (int seq = 1; seq <= kThreads * kPerThread; seq += 37) {
+    std::string key = "key" + std::to_string(seq);
+    ASSERT_EQ("value" + key, Get(key, kMaxSequenceNumber));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Reps, MemTableRepTest, testing::Values(0, 1, 2));
+
+}  // namespace leveldb
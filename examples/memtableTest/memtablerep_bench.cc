@@ -0,0 +1,107 @@
+// MemTableRep 基准：跳表、前缀哈希跳表、数组三种实现的写入、点查和全量扫描吞吐。
+// key 形如 "tenant%04d:%016llx"，前 10 字节为租户前缀(哈希实现按它分桶)，顺序随机。
+// 点查在全部写入之后进行；数组实现的第一次读取包含整体排序的时间，单独列出。
+// 用法: ./memtablerep_bench [写入条数, 默认 500000] [查询次数, 默认 500000] [租户数, 默认 1000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "comparator.h"
+#include "dbformat.h"
+#include "memtable.h"
+#include "memtablerep.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static double Now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static std::string MakeKey(uint64_t i, int tenants)
+{
+    char buf[48];
+    std::snprintf(buf, sizeof(buf), "tenant%04d:%016llx", static_cast<int>(i % tenants),
+                  static_cast<unsigned long long>(i * 0x9e3779b97f4a7c15ull));
+    return std::string(buf);
+}
+
+static void Run(const char* name, const MemTableRepFactory* factory, int num, int reads,
+                int tenants)
+{
+    InternalKeyComparator cmp(BytewiseComparator());
+    MemTable* mem = new MemTable(cmp, ConcurrentArena::kDefaultBlockSize, false, factory);
+    mem->Ref();
+    const std::string value(100, 'v');
+
+    double start = Now();
+    for (int i = 0; i < num; i++)
+    {
+        mem->Add(i + 1, kTypeValue, MakeKey(i, tenants), value);
+    }
+    double insert_secs = Now() - start;
+
+    // 第一次读取：数组实现在这里完成排序
+    std::string result;
+    Status s;
+    start = Now();
+    {
+        LookupKey lkey(MakeKey(0, tenants), kMaxSequenceNumber);
+        mem->Get(lkey, &result, &s);
+    }
+    double first_read_secs = Now() - start;
+
+    Random rnd(301);
+    int found = 0;
+    start = Now();
+    for (int i = 0; i < reads; i++)
+    {
+        LookupKey lkey(MakeKey(rnd.Uniform(num), tenants), kMaxSequenceNumber);
+        if (mem->Get(lkey, &result, &s))
+        {
+            found++;
+        }
+    }
+    double get_secs = Now() - start;
+
+    // 全量有序扫描(flush 的访问模式)；哈希实现需要先收集全部桶再排序
+    int scanned = 0;
+    start = Now();
+    Iterator* iter = mem->NewIterator();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+    {
+        scanned++;
+    }
+    delete iter;
+    double scan_secs = Now() - start;
+
+    std::printf("%-12s %12.2f %14.1f %12.2f %12.2f %10.1f %8s\n", name,
+                num / insert_secs / 1e6, first_read_secs * 1e3, reads / get_secs / 1e6,
+                scanned / scan_secs / 1e6, mem->ApproximateMemoryUsage() / 1048576.0,
+                found == reads && scanned == num ? "yes" : "NO");
+    mem->Unref();
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 500000;
+    const int reads = argc > 2 ? std::atoi(argv[2]) : 500000;
+    const int tenants = argc > 3 ? std::atoi(argv[3]) : 1000;
+
+    std::unique_ptr<MemTableRepFactory> skiplist(NewSkipListRepFactory());
+    std::unique_ptr<MemTableRepFactory> hash(NewHashSkipListRepFactory(10));
+    std::unique_ptr<MemTableRepFactory> vec(NewVectorRepFactory());
+
+    std::printf("entries: %d, lookups: %d, tenants: %d\n", num, reads, tenants);
+    std::printf("%-12s %12s %14s %12s %12s %10s %8s\n", "rep", "insert(Mops)",
+                "1st read(ms)", "get(Mops)", "scan(Mops)", "usage(MB)", "ok");
+    Run("skiplist", skiplist.get(), num, reads, tenants);
+    Run("hash", hash.get(), num, reads, tenants);
+    Run("vector", vec.get(), num, reads, tenants);
+    return 0;
+}
@@ -0,0 +1,127 @@
+// log::Reader 基准：普通顺序读(read 到 Reader 的 block buffer)与 mmap 顺序读
+// (Env::NewMmapSequentialFile，单 block 的 record 直接指向映射)读完整个日志的
+// 耗时、CPU 时间，以及读完之后该文件仍留在页缓存中的大小(mincore)。
+// 每次读取之前先用 POSIX_FADV_DONTNEED 把文件移出页缓存。
+// 日志建在 Env::GetTestDirectory() 下。
+// 用法: ./log_bench [日志大小(MB), 默认 256] [record 大小, 默认 200]
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "env.h"
+#include "log_reader.h"
+#include "log_writer.h"
+
+using namespace leveldb;
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+// 文件在页缓存中的字节数
+static double CachedMB(const std::string& fname)
+{
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    void* base = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    const size_t page = ::sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vec((size + page - 1) / page);
+    ::mincore(base, size, vec.data());
+    size_t resident = 0;
+    for (unsigned char v : vec)
+    {
+        resident += v & 1;
+    }
+    ::munmap(base, size);
+    ::close(fd);
+    return resident * page / 1048576.0;
+}
+
+static void Evict(const std::string& fname)
+{
+    int fd = ::open(fname.c_str(), O_RDONLY);
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+
+static void Run(const char* name, const std::string& fname, bool use_mmap, double log_mb)
+{
+    Env* env = Env::Default();
+    Evict(fname);
+    SequentialFile* file;
+    Check(use_mmap ? env->NewMmapSequentialFile(fname, &file)
+                   : env->NewSequentialFile(fname, &file));
+
+    auto start = std::chrono::steady_clock::now();
+    std::clock_t cpu_start = std::clock();
+    log::Reader reader(file, nullptr, true /*checksum*/, 0 /*initial_offset*/);
+    Slice record;
+    std::string scratch;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    while (reader.ReadRecord(&record, &scratch))
+    {
+        records++;
+        bytes += record.size();
+    }
+    double cpu_secs = static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    double secs = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    delete file;
+
+    std::printf("%-8s %9.1f %9.1f %10.1f %12.1f %10llu\n", name, secs * 1e3,
+                cpu_secs * 1e3, log_mb / secs, CachedMB(fname),
+                static_cast<unsigned long long>(records));
+}
+
+int main(int argc, char** argv)
+{
+    const int log_mb = argc > 1 ? std::atoi(argv[1]) : 256;
+    const int record_size = argc > 2 ? std::atoi(argv[2]) : 200;
+    Env* env = Env::Default();
+    std::string dir;
+    env->GetTestDirectory(&dir);
+    const std::string fname = dir + "/log_bench.log";
+
+    WritableFile* dest;
+    Check(env->NewWritableFile(fname, &dest));
+    {
+        log::Writer writer(dest);
+        std::string record(record_size, 'r');
+        const int64_t num = (static_cast<int64_t>(log_mb) << 20) / (record_size + log::kHeaderSize);
+        for (int64_t i = 0; i < num; i++)
+        {
+            record[i % record_size]++;
+            Check(writer.AddRecord(record));
+        }
+    }
+    Check(dest->Sync());
+    Check(dest->Close());
+    delete dest;
+    uint64_t size;
+    Check(env->GetFileSize(fname, &size));
+
+    std::printf("%.1f MB log, %dB records\n", size / 1048576.0, record_size);
+    std::printf("%-8s %9s %9s %10s %12s %10s\n", "file", "wall(ms)", "cpu(ms)",
+                "MB/s", "cached(MB)", "records");
+    for (int i = 0; i < 2; i++)
+    {
+        Run("read", fname, false, size / 1048576.0);
+        Run("mmap", fname, true, size / 1048576.0);
+    }
+    env->RemoveFile(fname);
+    return 0;
+}
@@ -0,0 +1,102 @@
+// 同步写日志的延迟：每条 record 写入后 Sync(fdatasync)一次，比较三种日志文件：
+//   new         新建的空文件，每次 Sync 都要分配块、更新文件大小
+//   prealloc    新建后用 fallocate 预分配(Options::preallocate_log_files)
+//   recycled    回收的旧日志文件，从头覆盖写入(Options::recycle_log_file_num)，
+//               使用 recyclable 格式
+// 输出每次 AddRecord + Sync 的平均、p50、p99 延迟。
+// 日志建在 Env::GetTestDirectory() 下，tmpfs 上看不出差别。
+// 用法: ./log_sync_bench [record 数, 默认 5000] [record 大小, 默认 200]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "env.h"
+#include "log_format.h"
+#include "log_writer.h"
+
+using namespace leveldb;
+
+static void Check(const Status& s)
+{
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        std::exit(1);
+    }
+}
+
+static void Run(const char* name, WritableFile* file, log::Writer* writer,
+                int num, int record_size)
+{
+    std::string record(record_size, 'r');
+    std::vector<double> micros;
+    micros.reserve(num);
+    for (int i = 0; i < num; i++)
+    {
+        record[i % record_size]++;
+        auto start = std::chrono::steady_clock::now();
+        Check(writer->AddRecord(record));
+        Check(file->Sync());
+        micros.push_back(std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    double sum = 0;
+    for (double m : micros)
+    {
+        sum += m;
+    }
+    std::sort(micros.begin(), micros.end());
+    std::printf("%-10s %10.1f %10.1f %10.1f\n", name, sum / num,
+                micros[num / 2], micros[num * 99 / 100]);
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 5000;
+    const int record_size = argc > 2 ? std::atoi(argv[2]) : 200;
+    Env* env = Env::Default();
+    std::string dir;
+    env->GetTestDirectory(&dir);
+    const std::string fname = dir + "/log_sync_bench.log";
+    const std::string old_fname = dir + "/log_sync_bench_old.log";
+    const uint64_t log_size =
+        static_cast<uint64_t>(num) * (record_size + log::kRecyclableHeaderSize) * 11 / 10;
+
+    std::printf("%d records of %dB, Sync after each\n", num, record_size);
+    std::printf("%-10s %10s %10s %10s\n", "file", "avg(us)", "p50(us)", "p99(us)");
+    for (int round = 0; round < 2; round++)
+    {
+        WritableFile* file;
+        Check(env->NewWritableFile(fname, &file));
+        {
+            log::Writer writer(file, 1, false);
+            Run("new", file, &writer, num, record_size);
+        }
+        Check(file->Close());
+        delete file;
+
+        Check(env->NewWritableFile(fname, &file));
+        Check(file->Preallocate(log_size));
+        {
+            log::Writer writer(file, 2, false);
+            Run("prealloc", file, &writer, num, record_size);
+        }
+        Check(file->Close());
+        delete file;
+
+        // 上一个日志已经写满并同步，作为回收的文件
+        Check(env->RenameFile(fname, old_fname));
+        Check(env->ReuseWritableFile(fname, old_fname, &file));
+        {
+            log::Writer writer(file, 3, true);
+            Run("recycled", file, &writer, num, record_size);
+        }
+        Check(file->Close());
+        delete file;
+        env->RemoveFile(fname);
+    }
+    return 0;
+}
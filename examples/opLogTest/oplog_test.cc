@@ -1,9 +1,11 @@
 #include "gtest/gtest.h"
+#include "log_parallel_reader.h"
 #include "log_reader.h"
 #include "log_writer.h"
 #include "env.h"
 #include "coding.h"
 #include "crc32c.h"
+#include "gather_write.h"
 #include "random.h"
 
 namespace leveldb {
@@ -38,11 +40,53 @@ class LogTest : public testing::Test {
       : reading_(false),
         writer_(new Writer(&dest_)),
         reader_(new Reader(&source_, &report_, true /*checksum*/,
-                           0 /*initial_offset*/)) {}
+                           0 /*initial_offset*/)),
+        parallel_reader_(nullptr),
+        parallel_workers_(0),
+        parallel_chunk_size_(0),
+        log_number_(0) {}
 
   ~LogTest() {
     delete writer_;
     delete reader_;
+    delete parallel_reader_;
+  }
+
+  // 之后的 Read() 使用 ParallelReader
+  void UseParallelReader(int num_workers, size_t chunk_size) {
+    delete parallel_reader_;
+    parallel_reader_ = new ParallelReader(&source_, &report_, true /*checksum*/,
+                                          num_workers, chunk_size, log_number_);
+    parallel_workers_ = num_workers;
+    parallel_chunk_size_ = chunk_size;
+  }
+
+  // 之后用 recyclable 格式写入编号为 log_number 的日志，Read() 也按这个编号读取
+  void UseRecyclableFormat(uint64_t log_number) {
+    log_number_ = log_number;
+    delete writer_;
+    writer_ = new Writer(&dest_, log_number, true /*recyclable*/);
+    delete reader_;
+    reader_ = new Reader(&source_, &report_, true /*checksum*/,
+                         0 /*initial_offset*/, log_number);
+    if (parallel_reader_ != nullptr) {
+      UseParallelReader(parallel_workers_, parallel_chunk_size_);
+    }
+  }
+
+  // 模拟回收日志文件：之后用 recyclable 格式从头覆盖写入编号为 log_number 的
+  // 日志，原有内容中超出新内容的部分仍然留在文件中
+  void RecycleLog(uint64_t log_number) {
+    recycled_contents_ = dest_.contents_;
+    dest_.contents_.clear();
+    UseRecyclableFormat(log_number);
+  }
+
+  // 模拟预分配：文件大小变为 size，未写入的部分为 0
+  void Preallocate(size_t size) {
+    if (dest_.contents_.size() < size) {
+      dest_.contents_.resize(size);
+    }
   }
 
   void ReopenForAppend() {
@@ -57,14 +101,31 @@ class LogTest : public testing::Test {
 
   size_t WrittenBytes() const { return dest_.contents_.size(); }
 
+  // 清零 AppendV、writev 和 Flush 的计数
+  void ResetWriteCalls() {
+    dest_.appendv_calls_ = 0;
+    dest_.writev_calls_ = 0;
+    dest_.flushes_ = 0;
+  }
+  int AppendVCalls() const { return dest_.appendv_calls_; }
+  int WritevCalls() const { return dest_.writev_calls_; }
+  int Flushes() const { return dest_.flushes_; }
+
   std::string Read() {
     if (!reading_) {
       reading_ = true;
+      if (dest_.contents_.size() < recycled_contents_.size()) {
+        dest_.contents_.append(recycled_contents_, dest_.contents_.size(),
+                               std::string::npos);
+      }
       source_.contents_ = Slice(dest_.contents_);
     }
     std::string scratch;
     Slice record;
-    if (reader_->ReadRecord(&record, &scratch)) {
+    const bool ok = parallel_reader_ != nullptr
+                        ? parallel_reader_->ReadRecord(&record, &scratch)
+                        : reader_->ReadRecord(&record, &scratch);
+    if (ok) {
       return record.ToString();
     } else {
       return "EOF";
@@ -154,18 +215,65 @@ class LogTest : public testing::Test {
     delete offset_reader;
   }
 
+  void CheckParallelRecordOffsets(size_t chunk_size) {
+    WriteInitialOffsetLog();
+    reading_ = true;
+    source_.contents_ = Slice(dest_.contents_);
+    ParallelReader parallel_reader(&source_, &report_, true /*checksum*/,
+                                   2 /*num_workers*/, chunk_size);
+    for (int i = 0; i < num_initial_offset_records_; i++) {
+      Slice record;
+      std::string scratch;
+      ASSERT_TRUE(parallel_reader.ReadRecord(&record, &scratch));
+      ASSERT_EQ(initial_offset_record_sizes_[i], record.size());
+      ASSERT_EQ(initial_offset_last_record_offsets_[i],
+                parallel_reader.LastRecordOffset());
+      ASSERT_EQ((char)('a' + i), record.data()[0]);
+    }
+    Slice record;
+    std::string scratch;
+    ASSERT_TRUE(!parallel_reader.ReadRecord(&record, &scratch));
+  }
+
  private:
+  // 记录 AppendV、writev(GatherAppend 中的写入)和 Flush 的次数
   class StringDest : public WritableFile {
    public:
+    StringDest() : appendv_calls_(0), writev_calls_(0), flushes_(0) {}
+
     Status Close() override { return Status::OK(); }
-    Status Flush() override { return Status::OK(); }
+    Status Flush() override {
+      flushes_++;
+      return Status::OK();
+    }
     Status Sync() override { return Status::OK(); }
     Status Append(const Slice& slice) override {
       contents_.append(slice.data(), slice.size());
       return Status::OK();
     }
+    // 同 PosixWritableFile::AppendV，只是没有缓冲区，writev 追加到 contents_
+    Status AppendV(const Slice* data, size_t n) override {
+      appendv_calls_++;
+      size_t pos = 0;
+      return GatherAppend(
+          data, n, nullptr, &pos, [this](const Slice& s) { return Append(s); },
+          [this](const struct ::iovec* iov, int count) {
+            writev_calls_++;
+            ssize_t written = 0;
+            for (int i = 0; i < count; i++) {
+              contents_.append(static_cast<const char*>(iov[i].iov_base),
+                               iov[i].iov_len);
+              written += iov[i].iov_len;
+            }
+            return written;
+          },
+          [](int error_number) { return Status::IOError("writev"); });
+    }
 
     std::string contents_;
+    int appendv_calls_;
+    int writev_calls_;
+    int flushes_;
   };
 
   class StringSource : public SequentialFile {
@@ -229,6 +337,11 @@ class LogTest : public testing::Test {
   bool reading_;
   Writer* writer_;
   Reader* reader_;
+  ParallelReader* parallel_reader_;
+  int parallel_workers_;
+  size_t parallel_chunk_size_;
+  uint64_t log_number_;
+  std::string recycled_contents_;
 };
 
 size_t LogTest::initial_offset_record_sizes_[] = {
@@ -289,6 +402,32 @@ TEST_F(LogTest, Fragmentation) {
   ASSERT_EQ("EOF", Read());
 }
 
+// 跨越多个 block 的 record 的所有 physical record(包括 trailer)通过一次
+// AppendV 写入，GatherAppend 中只有一次 writev，之后 Flush 一次
+TEST_F(LogTest, OneAppendVPerRecord) {
+  Write("small");
+  Write(BigString("x", kBlockSize - 2 * kHeaderSize - 5 - 3));  // 留下 trailer
+  ResetWriteCalls();
+  Write(BigString("large", 100000));
+  ASSERT_EQ(1, AppendVCalls());
+  ASSERT_EQ(1, WritevCalls());
+  ASSERT_EQ(1, Flushes());
+
+  // 小的 record 经过文件的缓冲区，不调用 writev
+  ResetWriteCalls();
+  Write("tiny");
+  ASSERT_EQ(1, AppendVCalls());
+  ASSERT_EQ(0, WritevCalls());
+  ASSERT_EQ(1, Flushes());
+
+  ASSERT_EQ("small", Read());
+  ASSERT_EQ(BigString("x", kBlockSize - 2 * kHeaderSize - 5 - 3), Read());
+  ASSERT_EQ(BigString("large", 100000), Read());
+  ASSERT_EQ("tiny", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
 TEST_F(LogTest, MarginalTrailer) {
   // Make a trailer that is exactly the same length as an empty record.
   const int n = kBlockSize - 2 * kHeaderSize;
@@ -510,6 +649,95 @@ TEST_F(LogTest, ErrorJoinsRecords) {
   ASSERT_GE(dropped, 2 * kBlockSize);
 }
 
+TEST_F(LogTest, PreallocatedSpaceIsSkipped) {
+  Write("foo");
+  Write(BigString("bar", 2 * kBlockSize));
+  Preallocate(5 * kBlockSize + 100);
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(BigString("bar", 2 * kBlockSize), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(LogTest, RecyclableReadWrite) {
+  UseRecyclableFormat(7);
+  Write("foo");
+  Write("");
+  Write(BigString("bar", 100000));
+  Write("xxxx");
+  ASSERT_EQ(7 * kRecyclableHeaderSize + 3 + 100000 + 4, WrittenBytes());
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("", Read());
+  ASSERT_EQ(BigString("bar", 100000), Read());
+  ASSERT_EQ("xxxx", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecyclableTrailer) {
+  // 留下 7 字节的 trailer：足够放下一个 7 字节的 header，但不够 recyclable 格式
+  UseRecyclableFormat(7);
+  const int n = kBlockSize - 2 * kRecyclableHeaderSize + 4;
+  Write(BigString("foo", n));
+  ASSERT_EQ(kBlockSize - kHeaderSize, WrittenBytes());
+  Write("bar");
+  ASSERT_EQ(BigString("foo", n), Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecycledLogStopsAtOldRecords) {
+  UseRecyclableFormat(1);
+  for (int i = 0; i < 10000; i++) {
+    Write(NumberString(i));
+  }
+  RecycleLog(2);
+  Write("foo");
+  Write(BigString("bar", kBlockSize));
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(BigString("bar", kBlockSize), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(LogTest, RecycledLogWithoutNewRecords) {
+  UseRecyclableFormat(1);
+  Write("foo");
+  RecycleLog(2);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(LogTest, RecycledLogOfOtherFormat) {
+  // 旧内容是普通格式，新内容在旧 record 的中间结束
+  Write(BigString("x", 3 * kBlockSize));
+  RecycleLog(2);
+  Write("foo");
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(LogTest, RecycledLogIgnoresIncompleteRecord) {
+  UseRecyclableFormat(1);
+  for (int i = 0; i < 10000; i++) {
+    Write(NumberString(i));
+  }
+  RecycleLog(2);
+  Write("foo");
+  Write(BigString("bar", 2 * kBlockSize));
+  // 写入端在写完第二条 record 之前退出：最后一个分片没有写入，之后是旧内容
+  ShrinkSize(WrittenBytes() - 2 * kBlockSize);
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
 TEST_F(LogTest, ReadStart) { CheckInitialOffsetRecord(0, 0); }
 
 TEST_F(LogTest, ReadSecondOneOff) { CheckInitialOffsetRecord(1, 1); }
@@ -550,5 +778,234 @@ TEST_F(LogTest, ReadEnd) { CheckOffsetPastEndReturnsNoRecords(0); }
 
 TEST_F(LogTest, ReadPastEnd) { CheckOffsetPastEndReturnsNoRecords(5); }
 
+// ParallelReader 对同样的输入给出与 Reader 相同的结果。chunk 只有 2 个 block，
+// 让 record 跨越 chunk 边界。
+class ParallelLogTest : public LogTest {
+ public:
+  ParallelLogTest() { UseParallelReader(3, kChunkSize); }
+
+  static const size_t kChunkSize = 2 * kBlockSize;
+};
+
+const size_t ParallelLogTest::kChunkSize;
+
+TEST_F(ParallelLogTest, Empty) { ASSERT_EQ("EOF", Read()); }
+
+TEST_F(ParallelLogTest, ReadWrite) {
+  Write("foo");
+  Write("bar");
+  Write("");
+  Write("xxxx");
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("", Read());
+  ASSERT_EQ("xxxx", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());
+}
+
+TEST_F(ParallelLogTest, ManyBlocks) {
+  for (int i = 0; i < 100000; i++) {
+    Write(NumberString(i));
+  }
+  for (int i = 0; i < 100000; i++) {
+    ASSERT_EQ(NumberString(i), Read());
+  }
+  ASSERT_EQ("EOF", Read());
+}
+
+TEST_F(ParallelLogTest, Fragmentation) {
+  Write("small");
+  Write(BigString("medium", 50000));
+  Write(BigString("large", 100000));
+  ASSERT_EQ("small", Read());
+  ASSERT_EQ(BigString("medium", 50000), Read());
+  ASSERT_EQ(BigString("large", 100000), Read());
+  ASSERT_EQ("EOF", Read());
+}
+
+TEST_F(ParallelLogTest, MarginalTrailer) {
+  const int n = kBlockSize - 2 * kHeaderSize;
+  Write(BigString("foo", n));
+  ASSERT_EQ(kBlockSize - kHeaderSize, WrittenBytes());
+  Write("");
+  Write("bar");
+  ASSERT_EQ(BigString("foo", n), Read());
+  ASSERT_EQ("", Read());
+  ASSERT_EQ("bar", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(ParallelLogTest, AlignedEof) {
+  // 文件长度恰好是 chunk 的整数倍时，最后一次读取返回 0 字节
+  Write(BigString("foo", 2 * kBlockSize - 2 * kHeaderSize));
+  ASSERT_EQ(kChunkSize, WrittenBytes());
+  ASSERT_EQ(BigString("foo", 2 * kBlockSize - 2 * kHeaderSize), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(ParallelLogTest, RandomRead) {
+  const int N = 500;
+  Random write_rnd(301);
+  for (int i = 0; i < N; i++) {
+    Write(RandomSkewedString(i, &write_rnd));
+  }
+  Random read_rnd(301);
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(RandomSkewedString(i, &read_rnd), Read());
+  }
+  ASSERT_EQ("EOF", Read());
+}
+
+TEST_F(ParallelLogTest, RecordOffsets) { CheckParallelRecordOffsets(kChunkSize); }
+
+TEST_F(ParallelLogTest, RecordOffsetsSingleBlockChunks) {
+  CheckParallelRecordOffsets(kBlockSize);
+}
+
+TEST_F(ParallelLogTest, ReadError) {
+  Write("foo");
+  ForceError();
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());
+  // 丢弃一次读取的长度，只报告一次
+  ASSERT_EQ(kChunkSize, DroppedBytes());
+  ASSERT_EQ("OK", MatchError("read error"));
+}
+
+TEST_F(ParallelLogTest, BadRecordType) {
+  Write("foo");
+  IncrementByte(6, 100);
+  FixChecksum(0, 3);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(3, DroppedBytes());
+  ASSERT_EQ("OK", MatchError("unknown record type"));
+}
+
+TEST_F(ParallelLogTest, TruncatedTrailingRecordIsIgnored) {
+  Write("foo");
+  ShrinkSize(4);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(ParallelLogTest, BadLength) {
+  const int kPayloadSize = kBlockSize - kHeaderSize;
+  Write(BigString("bar", kPayloadSize));
+  Write("foo");
+  IncrementByte(4, 1);
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(kBlockSize, DroppedBytes());
+  ASSERT_EQ("OK", MatchError("bad record length"));
+}
+
+TEST_F(ParallelLogTest, BadLengthAtEndIsIgnored) {
+  Write("foo");
+  ShrinkSize(1);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(ParallelLogTest, ChecksumMismatch) {
+  Write("foo");
+  IncrementByte(0, 10);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(10, DroppedBytes());
+  ASSERT_EQ("OK", MatchError("checksum mismatch"));
+}
+
+TEST_F(ParallelLogTest, UnexpectedFirstType) {
+  Write("foo");
+  Write(BigString("bar", 100000));
+  SetByte(6, kFirstType);
+  FixChecksum(0, 3);
+  ASSERT_EQ(BigString("bar", 100000), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(3, DroppedBytes());
+  ASSERT_EQ("OK", MatchError("partial record without end"));
+}
+
+TEST_F(ParallelLogTest, MissingLastIsIgnored) {
+  Write(BigString("bar", kBlockSize));
+  ShrinkSize(14);
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("", ReportMessage());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(ParallelLogTest, ErrorJoinsRecords) {
+  Write(BigString("foo", kBlockSize));
+  Write(BigString("bar", kBlockSize));
+  Write("correct");
+
+  // 破坏的 block 跨越第一个 chunk 的边界
+  for (int offset = kBlockSize; offset < 2 * kBlockSize; offset++) {
+    SetByte(offset, 'x');
+  }
+
+  ASSERT_EQ("correct", Read());
+  ASSERT_EQ("EOF", Read());
+  const size_t dropped = DroppedBytes();
+  ASSERT_LE(dropped, 2 * kBlockSize + 100);
+  ASSERT_GE(dropped, 2 * kBlockSize);
+}
+
+TEST_F(ParallelLogTest, PreallocatedSpaceIsSkipped) {
+  Write("foo");
+  Write(BigString("bar", 2 * kBlockSize));
+  Preallocate(5 * kBlockSize + 100);
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(BigString("bar", 2 * kBlockSize), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(ParallelLogTest, RecyclableRandomRead) {
+  UseRecyclableFormat(7);
+  const int N = 500;
+  Random write_rnd(301);
+  for (int i = 0; i < N; i++) {
+    Write(RandomSkewedString(i, &write_rnd));
+  }
+  Random read_rnd(301);
+  for (int i = 0; i < N; i++) {
+    ASSERT_EQ(RandomSkewedString(i, &read_rnd), Read());
+  }
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+}
+
+TEST_F(ParallelLogTest, RecycledLogStopsAtOldRecords) {
+  UseRecyclableFormat(1);
+  for (int i = 0; i < 10000; i++) {
+    Write(NumberString(i));
+  }
+  RecycleLog(2);
+  Write("foo");
+  Write(BigString("bar", kBlockSize));
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ(BigString("bar", kBlockSize), Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
+TEST_F(ParallelLogTest, RecycledLogOfOtherFormat) {
+  Write(BigString("x", 3 * kBlockSize));
+  RecycleLog(2);
+  Write("foo");
+  ASSERT_EQ("foo", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ("EOF", Read());
+  ASSERT_EQ(0, DroppedBytes());
+  ASSERT_EQ("", ReportMessage());
+}
+
 }  // namespace log
 }  // namespace leveldb
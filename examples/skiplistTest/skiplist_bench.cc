@@ -0,0 +1,93 @@
+// 跳表多线程插入基准：外部加锁 + Insert 与无锁 InsertConcurrently 的对比。
+// 用法: ./skiplist_bench [总插入条数, 默认 200000] [最大线程数, 默认 32]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "concurrent_arena.h"
+#include "skiplist.h"
+
+using namespace leveldb;
+
+typedef uint64_t Key;
+
+struct KeyComparator
+{
+    int operator()(const Key& a, const Key& b) const
+    {
+        if (a < b) return -1;
+        if (a > b) return +1;
+        return 0;
+    }
+};
+
+typedef SkipList<Key, KeyComparator> List;
+
+// 第 t 个线程插入的第 i 个 key；乘以奇数在 2^64 上是双射，保证不重复且顺序随机
+static Key MakeKey(int i, int t, int threads)
+{
+    return (static_cast<Key>(i) * threads + t + 1) * 0x9e3779b97f4a7c15ull;
+}
+
+// 返回每秒插入的百万条数
+static double RunInsert(int threads, int total, bool concurrent)
+{
+    // 加锁插入时用普通 Arena，并发插入必须使用线程安全的 ConcurrentArena
+    Arena arena;
+    ConcurrentArena concurrent_arena;
+    KeyComparator cmp;
+    List list(cmp, concurrent ? static_cast<Allocator*>(&concurrent_arena)
+                              : static_cast<Allocator*>(&arena));
+    std::mutex mu;
+
+    const int per_thread = total / threads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; i++)
+            {
+                const Key key = MakeKey(i, t, threads);
+                if (concurrent)
+                {
+                    list.InsertConcurrently(key);
+                }
+                else
+                {
+                    std::lock_guard<std::mutex> l(mu);
+                    list.Insert(key);
+                }
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return per_thread * threads / seconds / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    const int total = argc > 1 ? std::atoi(argv[1]) : 200000;
+    const int max_threads = argc > 2 ? std::atoi(argv[2]) : 32;
+
+    std::printf("hardware threads: %u, keys per run: %d\n",
+                std::thread::hardware_concurrency(), total);
+    std::printf("%8s %20s %24s\n", "threads", "mutex+Insert(Mops)",
+                "InsertConcurrently(Mops)");
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        double locked = RunInsert(threads, total, false);
+        double lock_free = RunInsert(threads, total, true);
+        std::printf("%8d %20.2f %24.2f\n", threads, locked, lock_free);
+    }
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <set>
+#include "arena.h"
 #include "skiplist.h"
 
 using namespace leveldb;
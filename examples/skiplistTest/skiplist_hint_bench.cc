@@ -0,0 +1,114 @@
+// 跳表单线程插入基准：Insert 与 InsertWithHint 在不同 key 顺序下的对比。
+// sequential 为严格升序；mostly-sorted 为升序中每隔 32 个 key 交换一对相邻的 key，
+// 再混入 1% 的随机 key；random 为完全随机。
+// 同时统计每次插入平均的 key 比较次数。
+// 用法: ./skiplist_hint_bench [插入条数, 默认 1000000]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "arena.h"
+#include "random.h"
+#include "skiplist.h"
+
+using namespace leveldb;
+
+typedef uint64_t Key;
+
+static uint64_t compares = 0;
+
+struct KeyComparator
+{
+    int operator()(const Key& a, const Key& b) const
+    {
+        compares++;
+        if (a < b) return -1;
+        if (a > b) return +1;
+        return 0;
+    }
+};
+
+typedef SkipList<Key, KeyComparator> List;
+
+static std::vector<Key> MakeKeys(const char* workload, int num)
+{
+    std::vector<Key> keys(num);
+    for (int i = 0; i < num; i++)
+    {
+        keys[i] = static_cast<Key>(i) * 2 + 2;
+    }
+    Random rnd(301);
+    if (workload[0] == 'r')
+    {
+        for (int i = num - 1; i > 0; i--)
+        {
+            std::swap(keys[i], keys[rnd.Uniform(i + 1)]);
+        }
+    }
+    else if (workload[0] == 'm')
+    {
+        for (int i = 0; i + 1 < num; i += 32)
+        {
+            std::swap(keys[i], keys[i + 1]);
+        }
+        for (int i = 0; i < num / 100; i++)
+        {
+            // 奇数 key 不会与升序部分重复
+            keys[rnd.Uniform(num)] = (static_cast<Key>(rnd.Next()) << 1) | 1;
+        }
+    }
+    return keys;
+}
+
+static void Run(const char* workload, int num)
+{
+    std::vector<Key> keys = MakeKeys(workload, num);
+    double mops[2];
+    double cmps[2];
+    for (int hinted = 0; hinted < 2; hinted++)
+    {
+        Arena arena;
+        KeyComparator cmp;
+        List list(cmp, &arena);
+        List::InsertHint hint;
+        compares = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < num; i++)
+        {
+            // mostly-sorted 中随机的奇数 key 可能重复
+            if (workload[0] == 'm' && (keys[i] & 1) && list.Contains(keys[i]))
+            {
+                continue;
+            }
+            if (hinted)
+            {
+                list.InsertWithHint(keys[i], &hint);
+            }
+            else
+            {
+                list.Insert(keys[i]);
+            }
+        }
+        double seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+        mops[hinted] = num / seconds / 1e6;
+        cmps[hinted] = static_cast<double>(compares) / num;
+    }
+    std::printf("%-14s %12.2f %10.1f %16.2f %10.1f %9.2fx\n", workload, mops[0], cmps[0],
+                mops[1], cmps[1], mops[1] / mops[0]);
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    std::printf("keys per run: %d\n", num);
+    std::printf("%-14s %12s %10s %16s %10s %10s\n", "workload", "Insert(Mops)", "cmp/op",
+                "WithHint(Mops)", "cmp/op", "speedup");
+    Run("sequential", num);
+    Run("mostly-sorted", num);
+    Run("random", num);
+    return 0;
+}
@@ -1,5 +1,14 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "concurrent_arena.h"
+#include "inline_skiplist.h"
 #include "skiplist.h"
 
 using namespace leveldb;
@@ -104,10 +113,302 @@ void SkipTest_InsertAndLookup()
 
 }
 
+// 多个线程通过 InsertConcurrently 同时插入互不相同的 key，结束后检查有序且无遗漏
+void SkipTest_ConcurrentInsert()
+{
+	const int kThreads = 8;
+	const int kPerThread = 10000;
+	ConcurrentArena arena;
+	Comparator cmp;
+	SkipList<Key, Comparator> list(cmp, &arena);
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kThreads; t++)
+	{
+		threads.emplace_back([&list, t]() {
+			for (int i = 0; i < kPerThread; i++)
+			{
+				// 乘以奇数在 2^64 上是双射，保证各线程的 key 互不相同且顺序打乱
+				Key key = (static_cast<Key>(i) * kThreads + t + 1) * 0x9e3779b97f4a7c15ull;
+				list.InsertConcurrently(key);
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	int count = 0;
+	bool sorted = true;
+	SkipList<Key, Comparator>::Iterator iter(&list);
+	Key last = 0;
+	for (iter.SeekToFirst(); iter.Valid(); iter.Next())
+	{
+		if (count > 0 && !(last < iter.key()))
+		{
+			sorted = false;
+		}
+		last = iter.key();
+		count++;
+	}
+	printf("concurrent insert: count=%d expected=%d sorted=%s\n", count,
+		   kThreads * kPerThread, sorted ? "true" : "false");
+	assert(sorted && count == kThreads * kPerThread);
+}
+
+// FingerIterator 按升序 Seek 一批 key(含重复、不存在以及超出末尾的 key)，结果与 Iterator::Seek 一致
+void SkipTest_FingerSeek()
+{
+	const int N = 20000;
+	Random rnd(301);
+	Arena arena;
+	Comparator cmp;
+	SkipList<Key, Comparator> list(cmp, &arena);
+	std::set<Key> keys;
+	while (keys.size() < N)
+	{
+		Key key = rnd.Next() % (N * 4);
+		if (keys.insert(key).second)
+		{
+			list.Insert(key);
+		}
+	}
+
+	std::vector<Key> targets;
+	for (int i = 0; i < 2000; i++)
+	{
+		targets.push_back(rnd.Next() % (N * 4 + 10));
+	}
+	targets.push_back(targets[0]);
+	std::sort(targets.begin(), targets.end());
+
+	bool ok = true;
+	SkipList<Key, Comparator>::FingerIterator finger(&list);
+	SkipList<Key, Comparator>::Iterator iter(&list);
+	for (size_t i = 0; i < targets.size(); i++)
+	{
+		finger.Seek(targets[i]);
+		iter.Seek(targets[i]);
+		if (finger.Valid() != iter.Valid() ||
+			(iter.Valid() && finger.key() != iter.key()))
+		{
+			ok = false;
+		}
+		// 每隔一段插入新 key，finger 在两次 Seek 之间要能看到后来插入的节点
+		if (i % 100 == 0)
+		{
+			Key key = targets[i] + 1;
+			if (keys.insert(key).second)
+			{
+				list.Insert(key);
+			}
+		}
+	}
+	printf("finger seek: targets=%zu match=%s\n", targets.size(), ok ? "true" : "false");
+	assert(ok);
+}
+
+// InsertWithHint 在升序、逆序、随机以及与 Insert 混用的情况下，结果与 std::set 一致
+void SkipTest_InsertWithHint()
+{
+	const int N = 20000;
+	Random rnd(301);
+	Arena arena;
+	Comparator cmp;
+	SkipList<Key, Comparator> list(cmp, &arena);
+	SkipList<Key, Comparator>::InsertHint hint;
+	std::set<Key> keys;
+
+	for (int i = 0; i < N; i++)
+	{
+		Key key;
+		switch (i / (N / 4))
+		{
+			case 0: key = 1000000 + i; break;			// 升序
+			case 1: key = 1000000 - i; break;			// 逆序
+			case 2: key = rnd.Next() % (N * 100); break;	// 随机
+			default: key = 2000000 + i * 2 + rnd.Uniform(3); break;	// 大致升序
+		}
+		if (!keys.insert(key).second)
+		{
+			continue;
+		}
+		// 偶尔不带 hint 插入，hint 中缓存的前驱需要被修正
+		if (i % 7 == 0)
+		{
+			list.Insert(key);
+		}
+		else
+		{
+			list.InsertWithHint(key, &hint);
+		}
+	}
+
+	bool ok = true;
+	SkipList<Key, Comparator>::Iterator iter(&list);
+	iter.SeekToFirst();
+	for (std::set<Key>::iterator it = keys.begin(); it != keys.end(); ++it)
+	{
+		if (!iter.Valid() || iter.key() != *it)
+		{
+			ok = false;
+			break;
+		}
+		iter.Next();
+	}
+	ok = ok && !iter.Valid();
+	for (std::set<Key>::iterator it = keys.begin(); it != keys.end(); ++it)
+	{
+		ok = ok && list.Contains(*it);
+	}
+	printf("insert with hint: count=%zu match=%s\n", keys.size(), ok ? "true" : "false");
+	assert(ok);
+}
+
+// InlineSkipList 的 key 为以 '\0' 结尾的字符串，前缀取前 8 字节(不足补 0)
+struct StringComparator {
+	int operator()(const char* a, const char* b) const {
+		return strcmp(a, b);
+	}
+	uint64_t KeyPrefix(const char* key) const {
+		uint64_t prefix = 0;
+		for (int i = 0; i < 8 && key[i] != '\0'; i++) {
+			prefix |= static_cast<uint64_t>(static_cast<unsigned char>(key[i])) << (56 - 8 * i);
+		}
+		return prefix;
+	}
+};
+
+typedef InlineSkipList<StringComparator> StringList;
+
+static void InsertString(StringList* list, const std::string& key, bool concurrent)
+{
+	char* buf = list->AllocateKey(key.size() + 1);
+	memcpy(buf, key.c_str(), key.size() + 1);
+	if (concurrent)
+	{
+		list->InsertConcurrently(buf);
+	}
+	else
+	{
+		list->Insert(buf);
+	}
+}
+
+// 前 8 字节相同(需要完整比较)与不同(前缀即可区分)的 key 混合，结果与 std::set 一致
+void SkipTest_InlineInsertAndSeek()
+{
+	Random rnd(301);
+	Arena arena;
+	StringList list(StringComparator(), &arena);
+	std::set<std::string> keys;
+	for (int i = 0; i < 5000; i++)
+	{
+		std::string key = rnd.OneIn(2) ? "shared_prefix_" + std::to_string(rnd.Uniform(3000))
+									   : std::to_string(rnd.Uniform(100000));
+		if (rnd.OneIn(20))
+		{
+			key = key.substr(0, 1 + rnd.Uniform(3));
+		}
+		if (keys.insert(key).second)
+		{
+			InsertString(&list, key, false);
+		}
+	}
+
+	bool ok = true;
+	StringList::Iterator iter(&list);
+	iter.SeekToFirst();
+	for (std::set<std::string>::iterator it = keys.begin(); it != keys.end(); ++it)
+	{
+		ok = ok && iter.Valid() && *it == iter.key() && list.Contains(it->c_str());
+		if (!ok) break;
+		iter.Next();
+	}
+	ok = ok && !iter.Valid();
+
+	// Seek / Prev / FingerIterator 与 std::set::lower_bound 对照
+	std::vector<std::string> targets;
+	for (int i = 0; i < 1000; i++)
+	{
+		targets.push_back(rnd.OneIn(2) ? "shared_prefix_" + std::to_string(rnd.Uniform(3000))
+									   : std::to_string(rnd.Uniform(100000)));
+	}
+	std::sort(targets.begin(), targets.end());
+	StringList::FingerIterator finger(&list);
+	for (size_t i = 0; i < targets.size() && ok; i++)
+	{
+		std::set<std::string>::iterator expected = keys.lower_bound(targets[i]);
+		iter.Seek(targets[i].c_str());
+		finger.Seek(targets[i].c_str());
+		if (expected == keys.end())
+		{
+			ok = !iter.Valid() && !finger.Valid();
+			continue;
+		}
+		ok = iter.Valid() && *expected == iter.key() && finger.Valid() && *expected == finger.key();
+		if (ok && expected != keys.begin())
+		{
+			iter.Prev();
+			ok = iter.Valid() && *std::prev(expected) == iter.key();
+		}
+	}
+	iter.SeekToLast();
+	ok = ok && iter.Valid() && *keys.rbegin() == iter.key();
+	printf("inline insert and seek: count=%zu match=%s\n", keys.size(), ok ? "true" : "false");
+	assert(ok);
+}
+
+// 多个线程通过 InlineSkipList::InsertConcurrently 同时插入
+void SkipTest_InlineConcurrentInsert()
+{
+	const int kThreads = 4;
+	const int kPerThread = 5000;
+	ConcurrentArena arena;
+	StringList list(StringComparator(), &arena);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kThreads; t++)
+	{
+		threads.emplace_back([&list, t]() {
+			for (int i = 0; i < kPerThread; i++)
+			{
+				InsertString(&list, "key" + std::to_string(i * kThreads + t), true);
+			}
+		});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	int count = 0;
+	bool sorted = true;
+	std::string last;
+	StringList::Iterator iter(&list);
+	for (iter.SeekToFirst(); iter.Valid(); iter.Next())
+	{
+		if (count > 0 && !(last < iter.key()))
+		{
+			sorted = false;
+		}
+		last = iter.key();
+		count++;
+	}
+	printf("inline concurrent insert: count=%d expected=%d sorted=%s\n", count,
+		   kThreads * kPerThread, sorted ? "true" : "false");
+	assert(sorted && count == kThreads * kPerThread);
+}
+
 int main()
 {
     //SkipTestEmpty();
 	SkipTest_InsertAndLookup();
+	SkipTest_ConcurrentInsert();
+	SkipTest_FingerSeek();
+	SkipTest_InsertWithHint();
+	SkipTest_InlineInsertAndSeek();
+	SkipTest_InlineConcurrentInsert();
 
 
     return 0;
@@ -0,0 +1,90 @@
+// 数据块格式基准：不同块大小(4K-64K)下，前缀压缩 + 重启点与不压缩(每个 entry 都是重启点)
+// 的块大小对比，以及块内随机 Seek 的耗时。key 带有较长的租户前缀。
+// 用法: ./block_bench [每种块大小的 Seek 次数, 默认 1000000]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "block.h"
+#include "block_builder.h"
+#include "comparator.h"
+#include "format.h"
+#include "iterator.h"
+#include "options.h"
+#include "random.h"
+
+using namespace leveldb;
+
+static std::string MakeKey(int tenant, int i)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "tenant-%010d/orders/%012d", tenant, i);
+    return std::string(buf);
+}
+
+// 返回每次 Seek 的纳秒数
+static double BenchSeek(const std::string& contents, const std::vector<std::string>& keys,
+                        int seeks)
+{
+    BlockContents bc;
+    bc.data = contents;
+    bc.cachable = false;
+    bc.heap_allocated = false;
+    Block block(bc);
+    Iterator* iter = block.NewIterator(BytewiseComparator());
+    Random rnd(301);
+    size_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < seeks; i++)
+    {
+        // 每次都新建迭代器的代价太高，这里先定位到开头，避免利用上一次的位置
+        iter->SeekToFirst();
+        iter->Seek(keys[rnd.Uniform(keys.size())]);
+        found += iter->Valid();
+    }
+    double ns = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / seeks;
+    if (found != static_cast<size_t>(seeks))
+    {
+        std::fprintf(stderr, "seek missed\n");
+        std::exit(1);
+    }
+    delete iter;
+    return ns;
+}
+
+int main(int argc, char** argv)
+{
+    int seeks = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const std::string value(16, 'v');
+
+    std::printf("%-8s %-8s %8s %10s %10s %8s %12s\n", "block", "restart", "entries",
+                "raw bytes", "blk bytes", "ratio", "seek ns/op");
+    for (size_t block_size = 4096; block_size <= 65536; block_size *= 2)
+    {
+        for (int interval : {1, 16})
+        {
+            Options options;
+            options.block_restart_interval = interval;
+            BlockBuilder builder(&options);
+            std::vector<std::string> keys;
+            size_t raw = 0;
+            // 与 TableBuilder 一样，在估计大小超过 block_size 时结束本块
+            for (int i = 0; builder.CurrentSizeEstimate() < block_size; i++)
+            {
+                std::string key = MakeKey(42, i * 7);
+                builder.Add(key, value);
+                raw += key.size() + value.size();
+                keys.push_back(key);
+            }
+            std::string contents = builder.Finish().ToString();
+            double ns = BenchSeek(contents, keys, seeks);
+            std::printf("%-8zu %-8d %8zu %10zu %10zu %8.2f %12.1f\n", block_size, interval,
+                        keys.size(), raw, contents.size(),
+                        static_cast<double>(raw) / contents.size(), ns);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// sstable 读写吞吐基准：顺序写入、全表扫描、随机点查。
+// 用法: ./table_bench [条数, 默认 1000000] [value 大小, 默认 100] [block_size, 默认 4096]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "cache.h"
+#include "env.h"
+#include "filter_policy.h"
+#include "iterator.h"
+#include "options.h"
+#include "random.h"
+#include "table.h"
+#include "table_builder.h"
+
+using namespace leveldb;
+
+static double Now()
+{
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void MakeKey(char* buf, size_t size, int i)
+{
+    std::snprintf(buf, size, "%016d", i);
+}
+
+static void SaveHit(void* arg, const Slice& k, const Slice& v)
+{
+    ++*reinterpret_cast<int*>(arg);
+}
+
+int main(int argc, char** argv)
+{
+    const int num = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    const int value_size = argc > 2 ? std::atoi(argv[2]) : 100;
+    const size_t block_size = argc > 3 ? std::atoi(argv[3]) : 4096;
+
+    Env* env = Env::Default();
+    std::string dir;
+    env->GetTestDirectory(&dir);
+    const std::string fname = dir + "/table_bench.ldb";
+
+    const FilterPolicy* policy = NewBloomFilterPolicy(10);
+    Cache* cache = NewLRUCache(64 << 20);
+    Options options;
+    options.block_size = block_size;
+    options.filter_policy = policy;
+    options.block_cache = cache;
+
+    // 顺序写入
+    Random rnd(301);
+    std::string value;
+    for (int i = 0; i < value_size; i++)
+    {
+        value.push_back(static_cast<char>(' ' + rnd.Uniform(95)));
+    }
+    WritableFile* file;
+    Status s = env->NewWritableFile(fname, &file);
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        return 1;
+    }
+    char key[32];
+    double start = Now();
+    TableBuilder builder(options, file);
+    for (int i = 0; i < num; i++)
+    {
+        MakeKey(key, sizeof(key), i);
+        builder.Add(key, value);
+    }
+    s = builder.Finish();
+    if (s.ok()) s = file->Sync();
+    if (s.ok()) s = file->Close();
+    delete file;
+    double elapsed = Now() - start;
+    const uint64_t file_size = builder.FileSize();
+    std::printf("entries: %d, value size: %d, block size: %zu, file size: %.1f MB\n",
+                num, value_size, block_size, file_size / 1048576.0);
+    std::printf("%-12s %10.2f MB/s %10.2f Mops\n", "write", file_size / 1048576.0 / elapsed,
+                num / elapsed / 1e6);
+
+    RandomAccessFile* rfile;
+    Table* table = nullptr;
+    s = env->NewRandomAccessFile(fname, &rfile);
+    if (s.ok()) s = Table::Open(options, rfile, file_size, &table);
+    if (!s.ok())
+    {
+        std::fprintf(stderr, "%s\n", s.ToString().c_str());
+        return 1;
+    }
+
+    // 全表扫描，带 crc 校验，不填充 cache
+    ReadOptions scan_options;
+    scan_options.verify_checksums = true;
+    scan_options.fill_cache = false;
+    start = Now();
+    Iterator* iter = table->NewIterator(scan_options);
+    int count = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next())
+    {
+        count++;
+    }
+    delete iter;
+    elapsed = Now() - start;
+    std::printf("%-12s %10.2f MB/s %10.2f Mops (%d entries)\n", "scan",
+                file_size / 1048576.0 / elapsed, count / elapsed / 1e6, count);
+
+    // 随机点查：一半存在，一半不存在(由过滤器排除)
+    const int reads = num < 1000000 ? num : 1000000;
+    int hits = 0;
+    start = Now();
+    for (int i = 0; i < reads; i++)
+    {
+        int k = rnd.Uniform(num);
+        if (i & 1)
+        {
+            MakeKey(key, sizeof(key), k);
+        }
+        else
+        {
+            std::snprintf(key, sizeof(key), "%016d~", k);
+        }
+        table->InternalGet(ReadOptions(), key, &hits, &SaveHit);
+    }
+    elapsed = Now() - start;
+    std::printf("%-12s %10.2f us/op %8.2f Mops (%d returned an entry)\n", "random get",
+                elapsed * 1e6 / reads, reads / elapsed / 1e6, hits);
+
+    delete table;
+    delete rfile;
+    delete cache;
+    delete policy;
+    env->RemoveFile(fname);
+    return 0;
+}
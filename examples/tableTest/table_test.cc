@@ -0,0 +1,511 @@
+#include "table.h"
+
+#include <cstring>
+#include <map>
+#include <string>
+
+#include "block.h"
+#include "block_builder.h"
+#include "cache.h"
+#include "comparator.h"
+#include "env.h"
+#include "filter_policy.h"
+#include "format.h"
+#include "gtest/gtest.h"
+#include "iterator.h"
+#include "options.h"
+#include "random.h"
+#include "table_builder.h"
+
+namespace leveldb {
+
+// 内存中的文件，写入后交给 StringSource 读取
+class StringSink : public WritableFile {
+ public:
+  ~StringSink() override = default;
+
+  const std::string& contents() const { return contents_; }
+  std::string* mutable_contents() { return &contents_; }
+
+  Status Close() override { return Status::OK(); }
+  Status Flush() override { return Status::OK(); }
+  Status Sync() override { return Status::OK(); }
+
+  Status Append(const Slice& data) override {
+    contents_.append(data.data(), data.size());
+    return Status::OK();
+  }
+
+ private:
+  std::string contents_;
+};
+
+class StringSource : public RandomAccessFile {
+ public:
+  explicit StringSource(const Slice& contents)
+      : contents_(contents.data(), contents.size()), reads_(0) {}
+
+  ~StringSource() override = default;
+
+  uint64_t Size() const { return contents_.size(); }
+  int reads() const { return reads_; }
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    if (offset > contents_.size()) {
+      return Status::InvalidArgument("invalid Read offset");
+    }
+    if (offset + n > contents_.size()) {
+      n = contents_.size() - offset;
+    }
+    std::memcpy(scratch, &contents_[offset], n);
+    *result = Slice(scratch, n);
+    reads_++;
+    return Status::OK();
+  }
+
+ private:
+  std::string contents_;
+  mutable int reads_;
+};
+
+static std::string RandomString(Random* rnd, int len) {
+  std::string r;
+  for (int i = 0; i < len; i++) {
+    r.push_back(static_cast<char>(' ' + rnd->Uniform(95)));
+  }
+  return r;
+}
+
+class TableTest : public testing::Test {
+ public:
+  TableTest() : source_(nullptr), table_(nullptr) {}
+  ~TableTest() {
+    delete table_;
+    delete source_;
+  }
+
+  void Add(const std::string& key, const std::string& value) {
+    data_[key] = value;
+  }
+
+  // 把 data_ 写成 sstable 并打开
+  void Finish(const Options& options) {
+    StringSink sink;
+    TableBuilder builder(options, &sink);
+    for (const auto& kv : data_) {
+      builder.Add(kv.first, kv.second);
+    }
+    ASSERT_TRUE(builder.Finish().ok());
+    ASSERT_EQ(sink.contents().size(), builder.FileSize());
+    ASSERT_EQ(data_.size(), builder.NumEntries());
+    contents_ = sink.contents();
+    Open(options);
+  }
+
+  Status Open(const Options& options) {
+    delete table_;
+    delete source_;
+    table_ = nullptr;
+    source_ = new StringSource(contents_);
+    return Table::Open(options, source_, source_->Size(), &table_);
+  }
+
+  // 用迭代器正向、反向遍历并与 data_ 比较
+  void CheckIteration() {
+    Iterator* iter = table_->NewIterator(ReadOptions());
+    auto it = data_.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+      ASSERT_TRUE(it != data_.end());
+      ASSERT_EQ(it->first, iter->key().ToString());
+      ASSERT_EQ(it->second, iter->value().ToString());
+    }
+    ASSERT_TRUE(it == data_.end());
+
+    auto rit = data_.rbegin();
+    for (iter->SeekToLast(); iter->Valid(); iter->Prev(), ++rit) {
+      ASSERT_TRUE(rit != data_.rend());
+      ASSERT_EQ(rit->first, iter->key().ToString());
+    }
+    ASSERT_TRUE(rit == data_.rend());
+    ASSERT_TRUE(iter->status().ok());
+    delete iter;
+  }
+
+  static void SaveValue(void* arg, const Slice& k, const Slice& v) {
+    std::pair<std::string, std::string>* p =
+        reinterpret_cast<std::pair<std::string, std::string>*>(arg);
+    p->first = k.ToString();
+    p->second = v.ToString();
+  }
+
+  // 返回 table_ 中 >= key 的第一个 entry 的 key，没有时返回空串
+  std::string Get(const std::string& key) {
+    std::pair<std::string, std::string> result;
+    Status s = table_->InternalGet(ReadOptions(), key, &result, &SaveValue);
+    EXPECT_TRUE(s.ok());
+    return result.first;
+  }
+
+ protected:
+  std::map<std::string, std::string> data_;
+  std::string contents_;
+  StringSource* source_;
+  Table* table_;
+};
+
+TEST_F(TableTest, Empty) {
+  Options options;
+  Finish(options);
+  Iterator* iter = table_->NewIterator(ReadOptions());
+  iter->SeekToFirst();
+  ASSERT_TRUE(!iter->Valid());
+  iter->Seek("foo");
+  ASSERT_TRUE(!iter->Valid());
+  delete iter;
+}
+
+TEST_F(TableTest, SimpleSingleBlock) {
+  Add("abc", "v1");
+  Add("abd", "v2");
+  Add("xyz", "v3");
+  Options options;
+  Finish(options);
+  CheckIteration();
+  ASSERT_EQ("abd", Get("abcc"));
+  ASSERT_EQ("xyz", Get("xyz"));
+  ASSERT_EQ("", Get("zzz"));
+}
+
+TEST_F(TableTest, ManyBlocks) {
+  Random rnd(301);
+  for (int i = 0; i < 5000; i++) {
+    Add(RandomString(&rnd, 1 + rnd.Uniform(30)), RandomString(&rnd, rnd.Uniform(200)));
+  }
+  Options options;
+  options.block_size = 256;
+  Finish(options);
+  CheckIteration();
+
+  // Seek 到每个已存在的 key
+  Iterator* iter = table_->NewIterator(ReadOptions());
+  for (const auto& kv : data_) {
+    iter->Seek(kv.first);
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(kv.first, iter->key().ToString());
+    ASSERT_EQ(kv.second, iter->value().ToString());
+  }
+  delete iter;
+}
+
+// 设置 readahead_size 的迭代器读出的内容不变，但文件的读取次数少得多
+TEST_F(TableTest, Readahead) {
+  Random rnd(301);
+  for (int i = 0; i < 5000; i++) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%08d", i);
+    Add(buf, RandomString(&rnd, rnd.Uniform(200)));
+  }
+  Options options;
+  options.block_size = 256;
+  Finish(options);
+
+  ReadOptions read_options;
+  read_options.readahead_size = 64 * 1024;
+  const int opened_reads = source_->reads();
+  Iterator* iter = table_->NewIterator(read_options);
+  auto it = data_.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+    ASSERT_TRUE(it != data_.end());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    ASSERT_EQ(it->second, iter->value().ToString());
+  }
+  ASSERT_TRUE(it == data_.end());
+  ASSERT_TRUE(iter->status().ok());
+  const int readahead_reads = source_->reads() - opened_reads;
+
+  // 预读缓冲区之外的 Seek 也能读到正确的内容
+  iter->Seek("00004000");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(data_["00004000"], iter->value().ToString());
+  iter->Seek("00000010");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(data_["00000010"], iter->value().ToString());
+  delete iter;
+
+  const int plain_start = source_->reads();
+  iter = table_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  delete iter;
+  const int plain_reads = source_->reads() - plain_start;
+  ASSERT_EQ(5000, count);
+  ASSERT_GT(plain_reads, 100);
+  // 每 64KB 读一次文件
+  ASSERT_LE(readahead_reads, static_cast<int>(contents_.size() / 65536 + 1));
+}
+
+TEST_F(TableTest, FilterAndCache) {
+  for (int i = 0; i < 1000; i++) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "key%06d", i * 2);
+    Add(buf, std::string(50, 'x'));
+  }
+  const FilterPolicy* policy = NewBloomFilterPolicy(10);
+  Cache* cache = NewLRUCache(1 << 20);
+  Options options;
+  options.block_size = 512;
+  options.filter_policy = policy;
+  options.block_cache = cache;
+  Finish(options);
+  CheckIteration();
+
+  // 存在的 key 必须能找到；不存在的 key 大部分被过滤器排除，不会返回下一个 key
+  int filtered = 0;
+  for (int i = 0; i < 1000; i++) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "key%06d", i * 2);
+    ASSERT_EQ(buf, Get(buf));
+    std::snprintf(buf, sizeof(buf), "key%06d", i * 2 + 1);
+    if (Get(buf).empty()) filtered++;
+  }
+  ASSERT_GT(filtered, 950);
+  ASSERT_GT(cache->TotalCharge(), 0u);
+
+  delete table_;
+  table_ = nullptr;
+  delete cache;
+  delete policy;
+}
+
+TEST_F(TableTest, ChecksumMismatch) {
+  for (int i = 0; i < 100; i++) {
+    Add("key" + std::to_string(1000 + i), "value");
+  }
+  Options options;
+  Finish(options);
+
+  // 修改第一个数据块中的一个字节
+  contents_[10] ^= 0x1;
+  ASSERT_TRUE(Open(options).ok());
+  ReadOptions read_options;
+  read_options.verify_checksums = true;
+  Iterator* iter = table_->NewIterator(read_options);
+  iter->SeekToFirst();
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_TRUE(iter->status().IsCorruption());
+  delete iter;
+
+  // 损坏的 footer
+  contents_.resize(contents_.size() - 1);
+  ASSERT_TRUE(Open(options).IsCorruption());
+}
+
+TEST_F(TableTest, ApproximateOffsetOf) {
+  Random rnd(301);
+  Add("k01", "hello");
+  Add("k02", "hello2");
+  Add("k03", std::string(10000, 'x'));
+  Add("k04", std::string(200000, 'x'));
+  Add("k05", std::string(300000, 'x'));
+  Add("k06", "hello3");
+  Add("k07", std::string(100000, 'x'));
+  Options options;
+  options.block_size = 1024;
+  Finish(options);
+
+  ASSERT_LE(table_->ApproximateOffsetOf("abc"), 0u);
+  ASSERT_LE(table_->ApproximateOffsetOf("k01"), 0u);
+  ASSERT_GE(table_->ApproximateOffsetOf("k04"), 10000u);
+  ASSERT_LE(table_->ApproximateOffsetOf("k04"), 11000u);
+  ASSERT_GE(table_->ApproximateOffsetOf("k05"), 210000u);
+  ASSERT_LE(table_->ApproximateOffsetOf("k05"), 211000u);
+  ASSERT_GE(table_->ApproximateOffsetOf("xyz"), 610000u);
+  ASSERT_LE(table_->ApproximateOffsetOf("xyz"), 612000u);
+}
+
+// 通过 Env 写入真实文件再读出
+TEST_F(TableTest, EnvFile) {
+  Env* env = Env::Default();
+  std::string dir;
+  ASSERT_TRUE(env->GetTestDirectory(&dir).ok());
+  const std::string fname = dir + "/table_test.ldb";
+
+  WritableFile* file;
+  ASSERT_TRUE(env->NewWritableFile(fname, &file).ok());
+  Options options;
+  TableBuilder builder(options, file);
+  for (int i = 0; i < 10000; i++) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%08d", i);
+    builder.Add(buf, std::string(buf) + "-value");
+  }
+  ASSERT_TRUE(builder.Finish().ok());
+  ASSERT_TRUE(file->Sync().ok());
+  ASSERT_TRUE(file->Close().ok());
+  delete file;
+
+  uint64_t size;
+  ASSERT_TRUE(env->GetFileSize(fname, &size).ok());
+  ASSERT_EQ(builder.FileSize(), size);
+  RandomAccessFile* rfile;
+  ASSERT_TRUE(env->NewRandomAccessFile(fname, &rfile).ok());
+  Table* table;
+  ASSERT_TRUE(Table::Open(options, rfile, size, &table).ok());
+  Iterator* iter = table->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  ASSERT_EQ(10000, count);
+  iter->Seek("00005000");
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ("00005000-value", iter->value().ToString());
+  delete iter;
+  delete table;
+  delete rfile;
+  env->RemoveFile(fname);
+}
+
+// 直接在 BlockBuilder 生成的块上迭代，覆盖不同的重启间隔
+class BlockTest : public testing::TestWithParam<int> {
+ public:
+  // 生成块并返回块的大小；块内容保存在 contents_ 中
+  size_t Build(const std::map<std::string, std::string>& data) {
+    options_.block_restart_interval = GetParam();
+    BlockBuilder builder(&options_);
+    for (const auto& kv : data) {
+      builder.Add(kv.first, kv.second);
+    }
+    contents_ = builder.Finish().ToString();
+    return contents_.size();
+  }
+
+  Block* NewBlock() {
+    BlockContents contents;
+    contents.data = contents_;
+    contents.cachable = false;
+    contents.heap_allocated = false;
+    return new Block(contents);
+  }
+
+ protected:
+  Options options_;
+  std::string contents_;
+};
+
+TEST_P(BlockTest, IterateAndSeek) {
+  Random rnd(301);
+  std::map<std::string, std::string> data;
+  for (int i = 0; i < 2000; i++) {
+    // 带有较长公共前缀的 key
+    std::string key = "tenant" + std::to_string(rnd.Uniform(4)) + "/" +
+                      RandomString(&rnd, 1 + rnd.Uniform(12));
+    data[key] = RandomString(&rnd, rnd.Uniform(20));
+  }
+  Build(data);
+  Block* block = NewBlock();
+  Iterator* iter = block->NewIterator(BytewiseComparator());
+
+  // 正向和反向遍历
+  auto it = data.begin();
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+    ASSERT_TRUE(it != data.end());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    ASSERT_EQ(it->second, iter->value().ToString());
+  }
+  ASSERT_TRUE(it == data.end());
+  auto rit = data.rbegin();
+  for (iter->SeekToLast(); iter->Valid(); iter->Prev(), ++rit) {
+    ASSERT_TRUE(rit != data.rend());
+    ASSERT_EQ(rit->first, iter->key().ToString());
+  }
+  ASSERT_TRUE(rit == data.rend());
+
+  // Seek 到已存在的 key 以及 key 之间的位置，顺序和乱序交替
+  for (int i = 0; i < 2000; i++) {
+    std::string target = "tenant" + std::to_string(rnd.Uniform(5)) + "/" +
+                         RandomString(&rnd, 1 + rnd.Uniform(12));
+    if (i % 2 == 0) {
+      auto pos = data.begin();
+      std::advance(pos, rnd.Uniform(data.size()));
+      target = pos->first;
+    }
+    iter->Seek(target);
+    auto expected = data.lower_bound(target);
+    if (expected == data.end()) {
+      ASSERT_TRUE(!iter->Valid());
+    } else {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(expected->first, iter->key().ToString());
+      ASSERT_EQ(expected->second, iter->value().ToString());
+    }
+  }
+  ASSERT_TRUE(iter->status().ok());
+  delete iter;
+  delete block;
+}
+
+TEST_P(BlockTest, PrefixCompression) {
+  std::map<std::string, std::string> data;
+  for (int i = 0; i < 1000; i++) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "tenant-0000000042/table-users/%08d", i);
+    data[buf] = "v";
+  }
+  size_t raw = 0;
+  for (const auto& kv : data) {
+    raw += kv.first.size() + kv.second.size();
+  }
+  size_t size = Build(data);
+  if (GetParam() == 1) {
+    // 每个 entry 都是重启点，不做前缀压缩
+    ASSERT_GT(size, raw);
+  } else if (GetParam() >= 16) {
+    ASSERT_LT(size * 2, raw);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(RestartInterval, BlockTest,
+                         testing::Values(1, 2, 16, 128));
+
+// index 块中保存的是数据块之间的最短分隔串，而不是每个块的最后一个 key
+TEST_F(TableTest, ShortIndexKeys) {
+  for (int i = 0; i < 200; i++) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "key%06d", i * 2);
+    Add(std::string(buf) + std::string(100, 'x'), "v");
+  }
+  Options options;
+  options.block_size = 256;
+  Finish(options);
+  CheckIteration();
+
+  // 从 footer 找到 index 块并遍历
+  Footer footer;
+  Slice input(contents_.data() + contents_.size() - Footer::kEncodedLength,
+              Footer::kEncodedLength);
+  ASSERT_TRUE(footer.DecodeFrom(&input).ok());
+  BlockContents index_contents;
+  ASSERT_TRUE(ReadBlock(source_, ReadOptions(), footer.index_handle(),
+                        &index_contents).ok());
+  Block index_block(index_contents);
+  Iterator* iter = index_block.NewIterator(options.comparator);
+  int blocks = 0;
+  size_t key_bytes = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    blocks++;
+    key_bytes += iter->key().size();
+  }
+  ASSERT_TRUE(iter->status().ok());
+  delete iter;
+  ASSERT_GT(blocks, 10);
+  // "key000012xxx..." 与 "key000014xxx..." 之间的分隔串为 "key000013"；
+  // 只有 "key000018xxx..." 与 "key000020xxx..." 这样进位的边界无法缩短。
+  // 最后一个块使用 FindShortSuccessor 得到 "l"
+  ASSERT_LT(key_bytes, blocks * 40);
+}
+
+}  // namespace leveldb
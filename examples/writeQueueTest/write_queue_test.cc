@@ -0,0 +1,258 @@
+#include "write_queue.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "coding.h"
+#include "comparator.h"
+#include "env.h"
+#include "gtest/gtest.h"
+#include "log_reader.h"
+#include "log_writer.h"
+#include "memtable.h"
+#include "write_batch_internal.h"
+
+namespace leveldb {
+
+// 写入内存的日志文件，Sync 时可以模拟磁盘延迟或者返回错误
+class StringDest : public WritableFile {
+ public:
+  Status Close() override { return Status::OK(); }
+  Status Flush() override { return Status::OK(); }
+  Status Sync() override {
+    syncs_++;
+    if (sync_delay_micros_ > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(sync_delay_micros_));
+    }
+    return force_sync_error_ ? Status::IOError("sync error") : Status::OK();
+  }
+  Status Append(const Slice& slice) override {
+    contents_.append(slice.data(), slice.size());
+    return Status::OK();
+  }
+
+  std::string contents_;
+  std::atomic<int> syncs_{0};
+  int sync_delay_micros_ = 0;
+  bool force_sync_error_ = false;
+};
+
+class StringSource : public SequentialFile {
+ public:
+  explicit StringSource(const Slice& contents) : contents_(contents) {}
+
+  Status Read(size_t n, Slice* result, char* scratch) override {
+    if (n > contents_.size()) {
+      n = contents_.size();
+    }
+    *result = Slice(contents_.data(), n);
+    contents_.remove_prefix(n);
+    return Status::OK();
+  }
+
+  Status Skip(uint64_t n) override {
+    if (n > contents_.size()) {
+      return Status::NotFound("in-memory file skipped past end");
+    }
+    contents_.remove_prefix(n);
+    return Status::OK();
+  }
+
+ private:
+  Slice contents_;
+};
+
+class WriteQueueTest : public testing::Test {
+ public:
+  WriteQueueTest()
+      : cmp_(BytewiseComparator()),
+        mem_(new MemTable(cmp_)),
+        log_(&dest_),
+        queue_(&log_, &dest_, mem_, 0) {
+    mem_->Ref();
+  }
+
+  ~WriteQueueTest() { mem_->Unref(); }
+
+  std::string Get(const std::string& key) {
+    LookupKey lkey(key, queue_.LastSequence());
+    std::string value;
+    Status s;
+    if (!mem_->Get(lkey, &value, &s)) {
+      return "NOT_FOUND";
+    }
+    return s.ok() ? value : "DELETED";
+  }
+
+  // 读出日志中的所有记录
+  std::vector<std::string> LogRecords() {
+    StringSource source(dest_.contents_);
+    log::Reader reader(&source, nullptr, true /*checksum*/, 0);
+    std::vector<std::string> records;
+    Slice record;
+    std::string scratch;
+    while (reader.ReadRecord(&record, &scratch)) {
+      records.push_back(record.ToString());
+    }
+    return records;
+  }
+
+ protected:
+  InternalKeyComparator cmp_;
+  MemTable* mem_;
+  StringDest dest_;
+  log::Writer log_;
+  WriteQueue queue_;
+};
+
+TEST_F(WriteQueueTest, Empty) {
+  ASSERT_EQ(0, queue_.LastSequence());
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_TRUE(LogRecords().empty());
+}
+
+TEST_F(WriteQueueTest, PutDelete) {
+  WriteOptions options;
+  ASSERT_TRUE(queue_.Put(options, "foo", "v1").ok());
+  ASSERT_TRUE(queue_.Put(options, "bar", "v2").ok());
+  ASSERT_TRUE(queue_.Delete(options, "foo").ok());
+  ASSERT_EQ(3, queue_.LastSequence());
+  ASSERT_EQ("DELETED", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+  ASSERT_EQ(0, dest_.syncs_.load());
+
+  // 单线程写入时每次写入各自成为一条记录
+  std::vector<std::string> records = LogRecords();
+  ASSERT_EQ(3, records.size());
+  ASSERT_EQ(3, queue_.NumLogRecords());
+  for (size_t i = 0; i < records.size(); i++) {
+    ASSERT_EQ(i + 1, DecodeFixed64(records[i].data()));
+    ASSERT_EQ(1, DecodeFixed32(records[i].data() + 8));
+  }
+  ASSERT_EQ(static_cast<char>(kTypeDeletion), records[2][12]);
+}
+
+TEST_F(WriteQueueTest, WriteBatch) {
+  WriteBatch batch;
+  batch.Put("a", "va");
+  batch.Put("b", "vb");
+  batch.Delete("a");
+  ASSERT_TRUE(queue_.Write(WriteOptions(), &batch).ok());
+  ASSERT_EQ(3, queue_.LastSequence());
+  ASSERT_EQ("DELETED", Get("a"));
+  ASSERT_EQ("vb", Get("b"));
+
+  // 整个 batch 原样成为一条 WAL 记录
+  std::vector<std::string> records = LogRecords();
+  ASSERT_EQ(1, records.size());
+  ASSERT_EQ(WriteBatchInternal::Contents(&batch).ToString(), records[0]);
+  ASSERT_EQ(1, WriteBatchInternal::Sequence(&batch));
+}
+
+TEST_F(WriteQueueTest, SyncWrite) {
+  WriteOptions options;
+  options.sync = true;
+  ASSERT_TRUE(queue_.Put(options, "foo", "v1").ok());
+  ASSERT_EQ(1, dest_.syncs_.load());
+  ASSERT_EQ(1, queue_.NumSyncs());
+  ASSERT_EQ("v1", Get("foo"));
+}
+
+TEST_F(WriteQueueTest, ConcurrentSyncWritesAreGrouped) {
+  const int kThreads = 16;
+  const int kWritesPerThread = 50;
+  dest_.sync_delay_micros_ = 1000;
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([this, t]() {
+      WriteOptions options;
+      options.sync = true;
+      for (int i = 0; i < kWritesPerThread; i++) {
+        std::string key = std::to_string(t) + "." + std::to_string(i);
+        ASSERT_TRUE(queue_.Put(options, key, "v" + key).ok());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const int total = kThreads * kWritesPerThread;
+  ASSERT_EQ(total, queue_.LastSequence());
+  for (int t = 0; t < kThreads; t++) {
+    for (int i = 0; i < kWritesPerThread; i++) {
+      std::string key = std::to_string(t) + "." + std::to_string(i);
+      ASSERT_EQ("v" + key, Get(key));
+    }
+  }
+
+  // 日志中的记录序列号连续，条数之和等于写入数；sync 次数少于写入数
+  std::vector<std::string> records = LogRecords();
+  ASSERT_EQ(queue_.NumLogRecords(), records.size());
+  ASSERT_EQ(queue_.NumSyncs(), static_cast<uint64_t>(dest_.syncs_.load()));
+  ASSERT_LT(dest_.syncs_.load(), total);
+  SequenceNumber next = 1;
+  for (const std::string& record : records) {
+    ASSERT_EQ(next, DecodeFixed64(record.data()));
+    next += DecodeFixed32(record.data() + 8);
+  }
+  ASSERT_EQ(total + 1, next);
+}
+
+TEST_F(WriteQueueTest, SwitchMemTable) {
+  WriteOptions options;
+  ASSERT_TRUE(queue_.Put(options, "foo", "v1").ok());
+
+  // 并发写入的同时切换，每个写入恰好落在一个 memtable 和对应的日志中
+  StringDest dest2;
+  log::Writer log2(&dest2);
+  MemTable* mem2 = new MemTable(cmp_);
+  mem2->Ref();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([this, t]() {
+      for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(queue_.Put(WriteOptions(), std::to_string(t * 100 + i), "v").ok());
+      }
+    });
+  }
+  queue_.SwitchMemTable(&log2, &dest2, mem2);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(queue_.Put(options, "bar", "v2").ok());
+  ASSERT_EQ(402, queue_.LastSequence());
+
+  LookupKey lkey("bar", queue_.LastSequence());
+  std::string value;
+  Status s;
+  ASSERT_TRUE(mem2->Get(lkey, &value, &s));
+  ASSERT_EQ("v2", value);
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+  for (int k = 0; k < 400; k++) {
+    LookupKey key(std::to_string(k), queue_.LastSequence());
+    bool in_old = mem_->Get(key, &value, &s);
+    bool in_new = mem2->Get(key, &value, &s);
+    ASSERT_NE(in_old, in_new);
+  }
+  mem2->Unref();
+}
+
+TEST_F(WriteQueueTest, SyncErrorIsSticky) {
+  WriteOptions options;
+  options.sync = true;
+  ASSERT_TRUE(queue_.Put(options, "foo", "v1").ok());
+  dest_.force_sync_error_ = true;
+  ASSERT_TRUE(queue_.Put(options, "bar", "v2").IsIOError());
+  dest_.force_sync_error_ = false;
+  ASSERT_TRUE(queue_.Put(WriteOptions(), "baz", "v3").IsIOError());
+  ASSERT_EQ(1, queue_.LastSequence());
+  ASSERT_EQ("NOT_FOUND", Get("bar"));
+}
+
+}  // namespace leveldb
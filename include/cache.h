@@ -17,6 +17,13 @@ class Cache;
 // 创建具有固定大小容量的缓存。缓存使用 least-recently-used 策略进行淘汰
 Cache* NewLRUCache(size_t capacity);
 
+// 创建具有固定大小容量的缓存，使用 CLOCK(second-chance) 策略进行淘汰。
+// Lookup 和 Release 不加锁，适合读多写少、多线程并发查找的场景。
+// 内部哈希表的槽位个数按 capacity / estimated_entry_charge 预先分配，不会扩容；
+// estimated_entry_charge 应接近 entry 的平均 charge，偏大会导致槽位不足，
+// 超出槽位的 Insert 返回的 handle 不会进入缓存。
+Cache* NewClockCache(size_t capacity, size_t estimated_entry_charge);
+
 class Cache
 {
 public:
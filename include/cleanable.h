@@ -0,0 +1,55 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_CLEANABLE_H_
+#define STORAGE_LEVELDB_INCLUDE_CLEANABLE_H_
+
+#include <cassert>
+
+namespace leveldb {
+
+// 可以注册清理函数的对象，析构或者 Reset 时调用它们(不保证顺序)。
+// 用于让一个对象(迭代器、PinnableSlice)在生命周期内持有它引用的内存，
+// 例如 block cache 的 handle 或者 memtable 的引用。
+class Cleanable {
+ public:
+  Cleanable();
+
+  Cleanable(const Cleanable&) = delete;
+  Cleanable& operator=(const Cleanable&) = delete;
+
+  // 不是虚函数：不通过 Cleanable* 删除对象
+  ~Cleanable();
+
+  // Clients are allowed to register function/arg1/arg2 triples that
+  // will be invoked when this object is destroyed.
+  using CleanupFunction = void (*)(void* arg1, void* arg2);
+  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
+
+  // 立即调用所有已注册的清理函数并清空，之后可以重新注册
+  void Reset();
+
+ private:
+  // Cleanup functions are stored in a single-linked list.
+  // The list's head node is inlined in the object.
+  struct CleanupNode {
+    // True if the node is not used. Only head nodes might be unused.
+    bool IsEmpty() const { return function == nullptr; }
+    // Invokes the cleanup function.
+    void Run() {
+      assert(function != nullptr);
+      (*function)(arg1, arg2);
+    }
+
+    // The head node is used if the function pointer is not null.
+    CleanupFunction function;
+    void* arg1;
+    void* arg2;
+    CleanupNode* next;
+  };
+
+  void DoCleanup();
+
+  CleanupNode cleanup_head_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_CLEANABLE_H_
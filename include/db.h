@@ -0,0 +1,94 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_DB_H_
+#define STORAGE_LEVELDB_INCLUDE_DB_H_
+
+#include <string>
+
+#include "options.h"
+#include "pinnable_slice.h"
+#include "slice.h"
+#include "status.h"
+
+namespace leveldb {
+
+class WriteBatch;
+
+// DB 是一个持久化的有序 key/value 映射。
+// 可以被多个线程同时访问，不需要外部同步。
+class DB {
+ public:
+  // Open the database with the specified "name".
+  // Stores a pointer to a heap-allocated database in *dbptr and returns
+  // OK on success.
+  // Stores nullptr in *dbptr and returns a non-OK status on error.
+  // Caller should delete *dbptr when it is no longer needed.
+  static Status Open(const Options& options, const std::string& name,
+                     DB** dbptr);
+
+  DB() = default;
+
+  DB(const DB&) = delete;
+  DB& operator=(const DB&) = delete;
+
+  virtual ~DB();
+
+  // Set the database entry for "key" to "value".  Returns OK on success,
+  // and a non-OK status on error.
+  // Note: consider setting options.sync = true.
+  virtual Status Put(const WriteOptions& options, const Slice& key,
+                     const Slice& value);
+
+  // Remove the database entry (if any) for "key".  Returns OK on
+  // success, and a non-OK status on error.  It is not an error if "key"
+  // did not exist in the database.
+  // Note: consider setting options.sync = true.
+  virtual Status Delete(const WriteOptions& options, const Slice& key);
+
+  // Apply the specified updates to the database.
+  // Returns OK on success, non-OK on failure.
+  // Note: consider setting options.sync = true.
+  virtual Status Write(const WriteOptions& options, WriteBatch* updates) = 0;
+
+  // If the database contains an entry for "key" store the
+  // corresponding value in *value and return OK.
+  //
+  // If there is no entry for "key" leave *value unchanged and return
+  // a status for which Status::IsNotFound() returns true.
+  //
+  // May return some other Status on an error.
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     std::string* value) = 0;
+
+  // 同上，但 value 命中 memtable 时直接指向 memtable 中的数据而不拷贝，
+  // 并持有该 memtable 直到 value 被 Reset 或者析构(见 pinnable_slice.h)。
+  // 多 KB 的 value 可以省掉一次分配和拷贝。调用前 value 会先被 Reset。
+  // 默认实现调用上面的 Get，把 value 拷贝到 value 自己的 buffer 中。
+  virtual Status Get(const ReadOptions& options, const Slice& key,
+                     PinnableSlice* value);
+
+  // DB implementations can export properties about their state
+  // via this method.  If "property" is a valid property understood by this
+  // DB implementation, fills "*value" with its current value and returns
+  // true.  Otherwise returns false.
+  //
+  // Valid property names include:
+  //
+  //  "leveldb.num-immutable-mem-table" - 等待 flush 的 memtable 数
+  //  "leveldb.num-files" - sstable 文件数
+  //  "leveldb.num-files-at-level<N>" - 第 N 层的文件数
+  //  "leveldb.stats" - 多行文本，每层的文件数、大小和 compaction 统计
+  //  "leveldb.sstables" - 多行文本，每层所有文件的编号、大小和 key 范围
+  //  "leveldb.num-flushes" - 已经完成的 memtable flush 次数
+  //  "leveldb.compaction-dropped-entries" - compaction 丢弃的旧版本和删除标记数
+  //  "leveldb.num-subcompactions" - 被拆分的 compaction 中执行的子 compaction 数
+  //  "leveldb.write-stall-micros" - 写入因为 memtable 或 L0 文件过多而等待的总时间
+  //  "leveldb.approximate-memory-usage" - 所有 memtable 的内存用量(字节)
+  virtual bool GetProperty(const Slice& property, std::string* value) = 0;
+};
+
+// Destroy the contents of the specified database.
+// Be very careful using this method.
+Status DestroyDB(const std::string& name, const Options& options);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_DB_H_
@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 
+#include "slice.h"
 #include "status.h"
 
 namespace leveldb {
@@ -14,7 +15,6 @@ class FileLock;
 class Logger;
 class RandomAccessFile;
 class SequentialFile;
-class Slice;
 class WritableFile;
 
 class Env {
@@ -43,6 +43,13 @@ class Env {
   virtual Status NewSequentialFile(const std::string& fname,
                                    SequentialFile** result) = 0;
 
+  // 同 NewSequentialFile，但通过 mmap 读取：Read 返回的 *result 直接指向映射的
+  // 内存而不拷贝到 scratch，在下一次 Read 之前有效。已经读过的部分会被移出映射
+  // 并从页缓存中丢弃，适合只读一遍的文件(例如恢复时的日志)。
+  // 默认实现调用 NewSequentialFile。
+  virtual Status NewMmapSequentialFile(const std::string& fname,
+                                       SequentialFile** result);
+
   // Create an object supporting random-access reads from the file with the
   // specified name.  On success, stores a pointer to the new file in
   // *result and returns OK.  On failure stores nullptr in *result and
@@ -54,6 +61,13 @@ class Env {
   virtual Status NewRandomAccessFile(const std::string& fname,
                                      RandomAccessFile** result) = 0;
 
+  // 同 NewRandomAccessFile，但读取绕过页缓存(O_DIRECT)：每次 Read 按 4KB 对齐
+  // 读入对齐的缓冲区，再把请求的部分拷贝到 scratch。适合由 block_cache 缓存
+  // 热点数据的 sstable。文件系统不支持时退回 NewRandomAccessFile。
+  // 默认实现调用 NewRandomAccessFile。
+  virtual Status NewDirectRandomAccessFile(const std::string& fname,
+                                           RandomAccessFile** result);
+
   // Create an object that writes to a new file with the specified
   // name.  Deletes any existing file with the same name and creates a
   // new file.  On success, stores a pointer to the new file in
@@ -64,6 +78,14 @@ class Env {
   virtual Status NewWritableFile(const std::string& fname,
                                  WritableFile** result) = 0;
 
+  // 同 NewWritableFile，但写入绕过页缓存(O_DIRECT)：Append 的数据先拷贝到
+  // 一个较大的对齐缓冲区，写满后整块写入。Flush 不写文件，不足 4KB 的尾部
+  // 补 0 后在 Sync 和 Close 时写入，再把文件截断到实际大小。
+  // 适合只顺序写一次的文件(flush 和 compaction 输出的 sstable)。
+  // 文件系统不支持时退回 NewWritableFile。默认实现调用 NewWritableFile。
+  virtual Status NewDirectWritableFile(const std::string& fname,
+                                       WritableFile** result);
+
   // Create an object that either appends to an existing file, or
   // writes to a new file (if the file does not exist to begin with).
   // On success, stores a pointer to the new file in *result and
@@ -79,6 +101,15 @@ class Env {
   virtual Status NewAppendableFile(const std::string& fname,
                                    WritableFile** result);
 
+  // 把不再使用的 old_fname 重命名为 fname 并打开用于写入：与 NewWritableFile
+  // 不同，不截断文件，从文件开头覆盖写入。文件已经分配的块和大小都被保留，
+  // 写入不超过原来的大小时 Sync 不需要更新元数据。调用者必须能够区分新写入的
+  // 内容和文件中原有的旧内容(例如 recyclable 格式的日志)。
+  // 默认实现重命名之后调用 NewWritableFile。
+  virtual Status ReuseWritableFile(const std::string& fname,
+                                   const std::string& old_fname,
+                                   WritableFile** result);
+
   // Returns true iff the named file exists.
   virtual bool FileExists(const std::string& fname) = 0;
 
@@ -137,6 +168,11 @@ class Env {
   virtual Status RenameFile(const std::string& src,
                             const std::string& target) = 0;
 
+  // 把目录本身(其中的文件名，例如 RenameFile 和新建文件的结果)持久化到磁盘。
+  // 文件的 Sync 只保证文件的内容，不保证目录项。
+  // 默认实现什么也不做。
+  virtual Status SyncDir(const std::string& dirname);
+
   // Lock the specified file.  Used to prevent concurrent access to
   // the same db by multiple processes.  On failure, stores nullptr in
   // *lock and returns non-OK.
@@ -166,6 +202,44 @@ class Env {
   // serialized.
   virtual void Schedule(void (*function)(void* arg), void* arg) = 0;
 
+  // 后台任务的优先级，每个优先级有独立的任务队列和线程池。
+  // HIGH 用于 memtable flush 这类耗时短、阻塞写入的任务，
+  // LOW 用于 compaction 这类耗时长的任务，二者互不阻塞。
+  enum Priority { LOW = 0, HIGH = 1, TOTAL = 2 };
+
+  // 同 Schedule(function, arg)，但放入 pri 对应的线程池。
+  // 默认实现忽略优先级，调用 Schedule(function, arg)。
+  virtual void Schedule(void (*function)(void* arg), void* arg, Priority pri);
+
+  // 调整 pri 线程池的线程数，可以在运行时调用。减少线程数时不会打断正在执行的任务。
+  // 默认实现不做任何事。
+  virtual void SetBackgroundThreads(int num, Priority pri);
+
+  // 返回 pri 线程池的线程数。默认实现返回 1。
+  virtual int GetBackgroundThreads(Priority pri);
+
+  // 返回 pri 线程池中等待执行的任务数。默认实现返回 0。
+  virtual unsigned int GetThreadPoolQueueLen(Priority pri);
+
+  // 线程池的统计信息，时间单位为微秒
+  struct ThreadPoolStats {
+    unsigned int queue_len = 0;       // 等待执行的任务数
+    int running_jobs = 0;             // 正在执行的任务数
+    int num_threads = 0;              // 线程数
+    uint64_t jobs_completed = 0;      // 已完成的任务数
+    uint64_t total_queue_micros = 0;  // 已完成任务从入队到开始执行的总时间
+    uint64_t max_queue_micros = 0;
+    uint64_t total_run_micros = 0;    // 已完成任务的总执行时间
+    uint64_t max_run_micros = 0;
+  };
+
+  // 获取 pri 线程池的统计信息。默认实现全部置 0。
+  virtual void GetThreadPoolStats(Priority pri, ThreadPoolStats* stats);
+
+  // 有序关闭后台线程：等待所有已经 Schedule 的任务执行完，然后 join 所有后台线程。
+  // 之后再次调用 Schedule 会重新创建线程。默认实现不做任何事。
+  virtual void WaitForJoin();
+
   // Start a new thread, invoking "function(arg)" within the new thread.
   // When "function(arg)" returns, the thread will be destroyed.
   virtual void StartThread(void (*function)(void* arg), void* arg) = 0;
@@ -221,6 +295,21 @@ class RandomAccessFile {
   // 读取位置距离文件起始位置的偏移量，这样就可以实现随机读了
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
+
+  // MultiRead 中的一个读请求，offset/n/scratch 由调用者填写，result/status 为输出
+  struct ReadRequest {
+    uint64_t offset;
+    size_t n;
+    char* scratch;
+    Slice result;
+    Status status;
+  };
+
+  // 一次提交多个读请求，每个请求的结果和状态保存在对应的 ReadRequest 中。
+  // 返回第一个失败请求的状态，全部成功时返回 OK。
+  // 默认实现依次调用 Read；支持异步 I/O 的实现(如 io_uring)会把所有请求一起提交，
+  // 让设备队列保持足够的深度。与 Read 一样可以被多个线程同时调用。
+  virtual Status MultiRead(ReadRequest* reqs, size_t num_reqs) const;
 };
 
 // 用于顺序写入的文件抽象类，实现必须提供缓冲，因为调用者可能一次将小片段附加到文件中。
@@ -234,9 +323,20 @@ class WritableFile {
   virtual ~WritableFile();
 
   virtual Status Append(const Slice& data) = 0;
+
+  // 依次追加 data[0, n)，等价于对每个 Slice 调用 Append，但实现可以不经过
+  // 自己的缓冲区而把它们一次写入文件(例如 writev)。
+  // 默认实现依次调用 Append。
+  virtual Status AppendV(const Slice* data, size_t n);
+
   virtual Status Close() = 0;
   virtual Status Flush() = 0;
   virtual Status Sync() = 0;
+
+  // 为文件预先分配 [0, size) 的空间(文件大小随之变为 size，未写入的部分读出为 0)，
+  // 之后在这个范围内的写入不再需要分配块和增大文件。不支持时忽略。
+  // 默认实现什么也不做。
+  virtual Status Preallocate(uint64_t size);
 };
 
 // 用于写入日志消息的抽象类
@@ -294,16 +394,32 @@ class EnvWrapper : public Env {
   Status NewSequentialFile(const std::string& f, SequentialFile** r) override {
     return target_->NewSequentialFile(f, r);
   }
+  Status NewMmapSequentialFile(const std::string& f,
+                               SequentialFile** r) override {
+    return target_->NewMmapSequentialFile(f, r);
+  }
   Status NewRandomAccessFile(const std::string& f,
                              RandomAccessFile** r) override {
     return target_->NewRandomAccessFile(f, r);
   }
+  Status NewDirectRandomAccessFile(const std::string& f,
+                                   RandomAccessFile** r) override {
+    return target_->NewDirectRandomAccessFile(f, r);
+  }
   Status NewWritableFile(const std::string& f, WritableFile** r) override {
     return target_->NewWritableFile(f, r);
   }
+  Status NewDirectWritableFile(const std::string& f,
+                               WritableFile** r) override {
+    return target_->NewDirectWritableFile(f, r);
+  }
   Status NewAppendableFile(const std::string& f, WritableFile** r) override {
     return target_->NewAppendableFile(f, r);
   }
+  Status ReuseWritableFile(const std::string& f, const std::string& old_f,
+                           WritableFile** r) override {
+    return target_->ReuseWritableFile(f, old_f, r);
+  }
   bool FileExists(const std::string& f) override {
     return target_->FileExists(f);
   }
@@ -326,6 +442,9 @@ class EnvWrapper : public Env {
   Status RenameFile(const std::string& s, const std::string& t) override {
     return target_->RenameFile(s, t);
   }
+  Status SyncDir(const std::string& d) override {
+    return target_->SyncDir(d);
+  }
   Status LockFile(const std::string& f, FileLock** l) override {
     return target_->LockFile(f, l);
   }
@@ -333,6 +452,22 @@ class EnvWrapper : public Env {
   void Schedule(void (*f)(void*), void* a) override {
     return target_->Schedule(f, a);
   }
+  void Schedule(void (*f)(void*), void* a, Priority pri) override {
+    return target_->Schedule(f, a, pri);
+  }
+  void SetBackgroundThreads(int num, Priority pri) override {
+    return target_->SetBackgroundThreads(num, pri);
+  }
+  int GetBackgroundThreads(Priority pri) override {
+    return target_->GetBackgroundThreads(pri);
+  }
+  unsigned int GetThreadPoolQueueLen(Priority pri) override {
+    return target_->GetThreadPoolQueueLen(pri);
+  }
+  void GetThreadPoolStats(Priority pri, ThreadPoolStats* stats) override {
+    return target_->GetThreadPoolStats(pri, stats);
+  }
+  void WaitForJoin() override { return target_->WaitForJoin(); }
   void StartThread(void (*f)(void*), void* a) override {
     return target_->StartThread(f, a);
   }
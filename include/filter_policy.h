@@ -40,6 +40,13 @@ public:
 // trailing spaces in keys.
 const FilterPolicy* NewBloomFilterPolicy(int bits_per_key);
 
+// 分块(cache line 对齐的 64 字节块)布隆过滤器：每个 key 的所有探测都落在同一个块内，
+// 一次查询只访问一条 cache line，支持 AVX2 时并行计算探测位置。
+// 同样的 bits_per_key 下误判率与 NewBloomFilterPolicy 相近(10 bits/key 约 1%)。
+// 生成的过滤器通过最后一个字节(原格式中 k 的位置，取值 > 30)区分格式：
+// 旧版本读到时视为匹配；本策略也能读取 NewBloomFilterPolicy 生成的过滤器。
+const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key);
+
 }  // namespace leveldb
 
 #endif  // FILTER_POLICY_H_
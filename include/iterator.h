@@ -1,13 +1,16 @@
 #ifndef STORAGE_LEVELDB_INCLUDE_ITERATOR_H_
 #define STORAGE_LEVELDB_INCLUDE_ITERATOR_H_
 
+#include "cleanable.h"
 #include "slice.h"
 #include "status.h"
 
 namespace leveldb {
 
 // 实现skiplist时使用了迭代器，这里接口的功能同skiplist
-class Iterator {
+// 通过 Cleanable::RegisterCleanup 注册的函数在迭代器析构时调用，用来释放迭代器
+// 引用的 block、table cache handle 等资源。
+class Iterator : public Cleanable {
  public:
   Iterator();
 
@@ -57,34 +60,6 @@ class Iterator {
 
   // If an error has occurred, return it.  Else return an ok status.
   virtual Status status() const = 0;
-
-  // Clients are allowed to register function/arg1/arg2 triples that
-  // will be invoked when this iterator is destroyed.
-  //
-  // Note that unlike all of the preceding methods, this method is
-  // not abstract and therefore clients should not override it.
-  using CleanupFunction = void (*)(void* arg1, void* arg2);
-  void RegisterCleanup(CleanupFunction function, void* arg1, void* arg2);
-
- private:
-  // Cleanup functions are stored in a single-linked list.
-  // The list's head node is inlined in the iterator.
-  struct CleanupNode {
-    // True if the node is not used. Only head nodes might be unused.
-    bool IsEmpty() const { return function == nullptr; }
-    // Invokes the cleanup function.
-    void Run() {
-      assert(function != nullptr);
-      (*function)(arg1, arg2);
-    }
-
-    // The head node is used if the function pointer is not null.
-    CleanupFunction function;
-    void* arg1;
-    void* arg2;
-    CleanupNode* next;
-  };
-  CleanupNode cleanup_head_;
 };
 
 // Return an empty iterator (yields nothing).
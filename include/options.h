@@ -0,0 +1,155 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
+#define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
+
+#include <cstddef>
+
+namespace leveldb {
+
+class Cache;
+class Comparator;
+class Env;
+class FilterPolicy;
+class MemTableRepFactory;
+
+// 数据块在磁盘上的压缩类型，记录在每个块的 trailer 中。
+// 目前只支持不压缩，保留该字段以便以后加入新的压缩算法。
+enum CompressionType {
+  // NOTE: do not change the values of existing entries, as these are
+  // part of the persistent format on disk.
+  kNoCompression = 0x0
+};
+
+// 控制数据库以及 sstable 写入和读取行为的参数
+struct Options {
+  // Create an Options object with default values for all fields.
+  Options();
+
+  // key 的排序方法，sstable 中的 key 按照该比较器有序存放。
+  // 读取 sstable 时使用的比较器必须与写入时相同。
+  // Default: a comparator that uses lexicographic byte-wise ordering
+  const Comparator* comparator;
+
+  // 如果为 true，数据库不存在时创建它。
+  bool create_if_missing = false;
+
+  // 如果为 true，数据库已经存在时报错。
+  bool error_if_exists = false;
+
+  // 如果为 true，读取时对数据做更严格的检查，发现损坏时尽早报错。
+  bool paranoid_checks = false;
+
+  // 文件读写以及调度后台任务(flush 在 Env::HIGH 线程池中执行)所使用的环境。
+  // Default: Env::Default()
+  Env* env;
+
+  // 活跃 memtable 的内存用量超过该值时，它变为只读(immutable)，由后台任务写成
+  // sstable，新的写入进入一个新的 memtable。
+  // 较大的值可以提高批量写入的性能，但会占用更多内存，重启时恢复日志也更慢。
+  size_t write_buffer_size = 4 * 1024 * 1024;
+
+  // memtable 从 arena 中分配内存，arena 每次向系统申请这么大的块。
+  // 为 0 时取 write_buffer_size / 8。不小于 16KB(memtable 的各个写线程从块中
+  // 切出 4KB 的 shard，块太小时 shard 会绕过块单独申请)。
+  size_t arena_block_size = 0;
+
+  // 如果为 true，arena 的块用匿名 mmap 申请并尽量使用大页(MAP_HUGETLB，失败时
+  // madvise(MADV_HUGEPAGE))，减少较大 memtable 上查找的 TLB 缺失；memtable 释放后
+  // 块留给下一个 memtable 复用。此时 arena_block_size 建议设为 2MB。
+  bool arena_use_mmap = false;
+
+  // 内存中最多同时存在的 memtable 数(包括活跃的 memtable)。
+  // 等待 flush 的 immutable memtable 达到 max_write_buffer_number - 1 个时，
+  // 写入会阻塞直到其中一个 flush 完成；在此之前写入不会等待 flush。
+  // 内存用量的上限约为 write_buffer_size * max_write_buffer_number。至少为 2。
+  int max_write_buffer_number = 3;
+
+  // memtable 底层数据结构的工厂，见 db/memtablerep.h 中的 NewSkipListRepFactory、
+  // NewHashSkipListRepFactory 和 NewVectorRepFactory。为 nullptr 时使用跳表。
+  const MemTableRepFactory* memtable_factory = nullptr;
+
+  // 同时打开的 sstable 文件数上限(TableCache 的容量)。
+  int max_open_files = 1000;
+
+  // 数据块的缓存。为 nullptr 时不缓存，每次读取都从文件中读出并校验。
+  Cache* block_cache = nullptr;
+
+  // 每个数据块(未压缩)的近似大小，超过该大小时结束当前块。
+  size_t block_size = 4 * 1024;
+
+  // compaction 输出的 sstable 达到该大小时切换到下一个文件。
+  // 较大的文件意味着更少的文件数和更长的 compaction 时间。
+  size_t max_file_size = 2 * 1024 * 1024;
+
+  // L0 -> L1 的 compaction 最多按 key 范围拆分为多少个子 compaction 并行执行。
+  // 除了执行 compaction 的线程，其余子 compaction 通过 Env::Schedule 提交到
+  // LOW 线程池，并行度还受该线程池的线程数限制(Env::SetBackgroundThreads)。
+  // 为 1 时不拆分。
+  int max_subcompactions = 1;
+
+  // 打开数据库时恢复日志所用的校验线程数。大于 1 时由一个线程按 1MB 预读日志，
+  // recovery_threads 个线程并行校验各个 block 的 CRC，打开数据库的线程按顺序把
+  // 记录写入 memtable，三者同时进行(见 log_parallel_reader.h)。
+  // 为 1 时在打开数据库的线程中依次完成。日志较大时可以缩短重启时间。
+  int recovery_threads = 1;
+
+  // 新建日志文件时用 fallocate 预分配 write_buffer_size 的 1.1 倍空间(约为
+  // 一个日志文件写满时的大小)。之后的写入不再增大文件，同步写入的 fdatasync
+  // 只需要写数据(和已分配块的状态)，不需要更新 inode 中的文件大小。
+  // 未写入的部分读出为 0(kZeroType)，恢复时跳过。
+  bool preallocate_log_files = false;
+
+  // 最多保留多少个不再需要的日志文件用于回收。新的日志文件优先由回收的文件
+  // 重命名得到，从头覆盖写入，文件的块都已经写过，同步写入时 fdatasync 不需要
+  // 任何元数据更新。为 0 时删除不再需要的日志文件。
+  // 大于 0 时日志使用 recyclable 格式(record 头部带有日志文件号，见
+  // db/log_format.h)，恢复时通过它区分新写入的内容和文件中残留的旧内容。
+  size_t recycle_log_file_num = 0;
+
+  // 如果为 true，sstable 的读取绕过页缓存(O_DIRECT，见
+  // Env::NewDirectRandomAccessFile)，每次读取按 4KB 对齐。compaction 读入的数据
+  // 不会挤出页缓存中的热点数据；相应地热点数据只能由 block_cache 缓存，
+  // 打开该选项时应该设置足够大的 block_cache。
+  bool use_direct_reads = false;
+
+  // use_direct_reads 为 true 时 compaction 顺序读取输入的 sstable，每次对齐读入
+  // 这么多字节(见 ReadOptions::readahead_size)，代替页缓存的预读。
+  size_t compaction_readahead_size = 2 * 1024 * 1024;
+
+  // 如果为 true，flush 和 compaction 输出的 sstable 绕过页缓存写入(O_DIRECT，见
+  // Env::NewDirectWritableFile)，先拷贝到 1MB 的对齐缓冲区，写满后整块写入。
+  bool use_direct_io_for_flush_and_compaction = false;
+
+  // 块内每隔多少个 key 设置一个重启点。重启点处保存完整的 key，
+  // 其余 key 只保存与前一个 key 不同的后缀。大多数情况下不需要修改。
+  int block_restart_interval = 16;
+
+  // 不为 nullptr 时，为每个 sstable 生成过滤器，用来在读取数据块之前排除不存在的 key。
+  // 通常使用 NewBloomFilterPolicy() 或 NewBlockedBloomFilterPolicy()。
+  const FilterPolicy* filter_policy = nullptr;
+};
+
+// 控制读操作的参数
+struct ReadOptions {
+  // 如果为 true，从文件中读出的所有数据都会做 crc 校验。
+  bool verify_checksums = false;
+
+  // 本次读取的数据块是否放入 block_cache。批量扫描时可以设为 false。
+  bool fill_cache = true;
+
+  // 大于 0 时迭代器读取数据块时每次从文件读入这么多字节，之后的数据块从
+  // 中读取，适合顺序扫描绕过页缓存(O_DIRECT)打开的 sstable。为 0 时每个
+  // 数据块读一次文件。只影响 Table::NewIterator。
+  size_t readahead_size = 0;
+};
+
+// 控制写操作的参数
+struct WriteOptions {
+  // 如果为 true，写入在返回之前会调用 WritableFile::Sync() 把日志刷到磁盘上，
+  // 这样机器崩溃也不会丢失该写入。为 false 时只保证进程崩溃不丢数据。
+  // 同一个写入组中只要有一个写入要求 sync，整组只做一次 Sync。
+  bool sync = false;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
@@ -0,0 +1,72 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
+#define STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
+
+#include <string>
+
+#include "cleanable.h"
+#include "slice.h"
+
+namespace leveldb {
+
+// 作为 Get 的输出，可以直接指向数据所在的内存(例如 memtable 的 arena)而不拷贝。
+// 这时 PinnableSlice 通过注册的清理函数持有这块内存(例如 memtable 的引用)，
+// 直到 Reset 或者析构。不能直接指向时，数据被拷贝到自己的 buffer 中。
+//
+// 被 pin 住的内存在 Reset 之前不会释放，长时间持有会推迟 memtable 的回收，
+// 用完之后应该尽快 Reset。同一个 PinnableSlice 再次使用之前也需要 Reset。
+class PinnableSlice : public Slice, public Cleanable {
+ public:
+  PinnableSlice() : buf_(&self_space_), pinned_(false) {}
+  // 不能 pin 时数据拷贝到 *buf 中，*buf 的生命周期必须比 PinnableSlice 长
+  explicit PinnableSlice(std::string* buf) : buf_(buf), pinned_(false) {}
+
+  PinnableSlice(const PinnableSlice&) = delete;
+  PinnableSlice& operator=(const PinnableSlice&) = delete;
+
+  // 指向 s 而不拷贝。(*release)(arg1, arg2) 在 Reset 或者析构时调用，
+  // 在那之前 s 指向的内存必须保持有效。
+  void PinSlice(const Slice& s, CleanupFunction release, void* arg1,
+                void* arg2) {
+    assert(!pinned_);
+    pinned_ = true;
+    SetSlice(s);
+    RegisterCleanup(release, arg1, arg2);
+  }
+
+  // 把 s 拷贝到自己的 buffer 中
+  void PinSelf(const Slice& s) {
+    assert(!pinned_);
+    buf_->assign(s.data(), s.size());
+    SetSlice(*buf_);
+  }
+
+  // 数据已经写入 GetSelf() 返回的 buffer
+  void PinSelf() {
+    assert(!pinned_);
+    SetSlice(*buf_);
+  }
+
+  // 自己的 buffer，配合 PinSelf() 使用
+  std::string* GetSelf() { return buf_; }
+
+  // 是否直接指向外部内存
+  bool IsPinned() const { return pinned_; }
+
+  // 释放 pin 住的内存并清空
+  void Reset() {
+    Cleanable::Reset();
+    pinned_ = false;
+    SetSlice(Slice());
+  }
+
+ private:
+  void SetSlice(const Slice& s) { *static_cast<Slice*>(this) = s; }
+
+  std::string self_space_;
+  std::string* buf_;
+  bool pinned_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_PINNABLE_SLICE_H_
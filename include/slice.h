@@ -74,7 +74,14 @@ inline int Slice::compare(const Slice& b) const
     int r = ::memcmp(data_, b.data_, min_size);
     if (r == 0)
     {
-        (size_ < b.size_) ? (r = -1) : (r = +1);
+        if (size_ < b.size_)
+        {
+            r = -1;
+        }
+        else if (size_ > b.size_)
+        {
+            r = +1;
+        }
     }
     return r;
 }
@@ -0,0 +1,89 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_TABLE_H_
+#define STORAGE_LEVELDB_INCLUDE_TABLE_H_
+
+#include <cstdint>
+
+#include "iterator.h"
+
+namespace leveldb {
+
+class Block;
+class BlockHandle;
+class Footer;
+struct Options;
+class RandomAccessFile;
+struct ReadOptions;
+
+// Table 是一个有序的 key/value 映射，数据存放在 sstable 文件中，格式见 table_builder.h。
+// Table 是不可变的，多个线程可以不加锁地同时访问。
+class Table {
+ public:
+  // Attempt to open the table that is stored in bytes [0..file_size)
+  // of "file", and read the metadata entries necessary to allow
+  // retrieving data from the table.
+  //
+  // If successful, returns ok and sets "*table" to the newly opened
+  // table.  The client should delete "*table" when no longer needed.
+  // If there was an error while initializing the table, sets "*table"
+  // to nullptr and returns a non-ok status.  Does not take ownership of
+  // "*file", but the client must ensure that "file" remains live
+  // for the duration of the returned table's lifetime.
+  //
+  // *file must remain live while this Table is in use.
+  static Status Open(const Options& options, RandomAccessFile* file,
+                     uint64_t file_size, Table** table);
+
+  Table(const Table&) = delete;
+  Table& operator=(const Table&) = delete;
+
+  ~Table();
+
+  // Returns a new iterator over the table contents.
+  // The result of NewIterator() is initially invalid (caller must
+  // call one of the Seek methods on the iterator before using it).
+  Iterator* NewIterator(const ReadOptions&) const;
+
+  // Given a key, return an approximate byte offset in the file where
+  // the data for that key begins (or would begin if the key were
+  // present in the file).  The returned value is in terms of file
+  // bytes, and so includes effects like compression of the underlying data.
+  // E.g., the approximate offset of the last key in the table will
+  // be close to the file length.
+  uint64_t ApproximateOffsetOf(const Slice& key) const;
+
+  // 返回 index block 的迭代器：每个 entry 对应一个数据块，key 为不小于块内
+  // 最后一个 key 的分隔 key，value 为编码的 BlockHandle。不读取数据块，
+  // 可以用来按数据块把 key 空间切分成大小相近的区间。
+  Iterator* NewIndexIterator() const;
+
+  // 点查询：定位第一个 >= key 的 entry，找到时调用
+  // (*handle_result)(arg, 找到的 key, value)。先用过滤器排除不存在的 key。
+  Status InternalGet(const ReadOptions&, const Slice& key, void* arg,
+                     void (*handle_result)(void* arg, const Slice& k,
+                                           const Slice& v));
+
+ private:
+  struct Rep;
+
+  struct ReadaheadState;
+
+  static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+  static Iterator* ReadaheadBlockReader(void*, const ReadOptions&,
+                                        const Slice&);
+  static void DeleteReadaheadState(void* arg, void* ignored);
+
+  // 从 file 读出 index_value 指向的数据块(或者从 block_cache 中取得)，返回块的迭代器
+  Iterator* ReadBlockIterator(RandomAccessFile* file, const ReadOptions&,
+                              const Slice& index_value) const;
+
+  explicit Table(Rep* rep) : rep_(rep) {}
+
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const Slice& filter_handle_value);
+
+  Rep* const rep_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_TABLE_H_
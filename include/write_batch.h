@@ -0,0 +1,62 @@
+#ifndef STORAGE_LEVELDB_INCLUDE_WRITE_BATCH_H_
+#define STORAGE_LEVELDB_INCLUDE_WRITE_BATCH_H_
+
+#include <string>
+
+#include "status.h"
+
+namespace leveldb {
+
+class Slice;
+
+// WriteBatch 保存一组需要原子地写入的更新(Put/Delete)，按照加入的顺序生效。
+// 内部是一段紧凑的二进制编码(见 write_batch.cc)，可以原样作为一条 log 记录写入
+// WAL，恢复或复制时再原样解析出来。
+//
+// 多个线程可以不加锁地调用 WriteBatch 的 const 方法，
+// 但只要有一个线程调用非 const 方法，所有线程都需要外部同步。
+class WriteBatch {
+ public:
+  class Handler {
+   public:
+    virtual ~Handler();
+    virtual void Put(const Slice& key, const Slice& value) = 0;
+    virtual void Delete(const Slice& key) = 0;
+  };
+
+  WriteBatch();
+
+  // Intentionally copyable.
+  WriteBatch(const WriteBatch&) = default;
+  WriteBatch& operator=(const WriteBatch&) = default;
+
+  ~WriteBatch();
+
+  // 写入 key->value
+  void Put(const Slice& key, const Slice& value);
+
+  // 如果存在 key 则删除
+  void Delete(const Slice& key);
+
+  // 清空 batch 中的所有更新
+  void Clear();
+
+  // 返回 batch 编码后的大小，也就是写入 WAL 的记录大小
+  size_t ApproximateSize() const;
+
+  // 把 source 中的更新追加到当前 batch 的末尾。
+  // This operation is O(source size) but faster than iterating over source.
+  void Append(const WriteBatch& source);
+
+  // 按照加入的顺序把每条更新交给 handler，传入的 Slice 直接指向 batch 内部的数据
+  Status Iterate(Handler* handler) const;
+
+ private:
+  friend class WriteBatchInternal;
+
+  std::string rep_;  // See comment in write_batch.cc for the format of rep_
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_WRITE_BATCH_H_
@@ -0,0 +1,59 @@
+#ifndef STORAGE_LEVELDB_TABLE_BLOCK_BUILDER_H_
+#define STORAGE_LEVELDB_TABLE_BLOCK_BUILDER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "slice.h"
+
+namespace leveldb {
+
+struct Options;
+
+// 生成 sstable 中的数据块和 index 块。
+// key 采用前缀压缩：每个 entry 只保存与前一个 key 不同的后缀。每隔
+// block_restart_interval 个 entry 设置一个重启点，重启点处保存完整的 key。
+// 块格式：
+//    entry: varint32 shared | varint32 non_shared | varint32 value 长度
+//           | key 的后缀 (non_shared 字节) | value
+//    trailer: 重启点偏移 (fixed32 * num_restarts) | num_restarts (fixed32)
+// 重启点处 shared == 0。读取时先对重启点数组二分查找，再从重启点线性扫描。
+class BlockBuilder {
+ public:
+  explicit BlockBuilder(const Options* options);
+
+  BlockBuilder(const BlockBuilder&) = delete;
+  BlockBuilder& operator=(const BlockBuilder&) = delete;
+
+  // Reset the contents as if the BlockBuilder was just constructed.
+  void Reset();
+
+  // REQUIRES: Finish() has not been called since the last call to Reset().
+  // REQUIRES: key is larger than any previously added key
+  void Add(const Slice& key, const Slice& value);
+
+  // Finish building the block and return a slice that refers to the
+  // block contents.  The returned slice will remain valid for the
+  // lifetime of this builder or until Reset() is called.
+  Slice Finish();
+
+  // Returns an estimate of the current (uncompressed) size of the block
+  // we are building.
+  size_t CurrentSizeEstimate() const;
+
+  // Return true iff no entries have been added since the last Reset()
+  bool empty() const { return buffer_.empty(); }
+
+ private:
+  const Options* options_;
+  std::string buffer_;              // Destination buffer
+  std::vector<uint32_t> restarts_;  // Restart points
+  int counter_;                     // Number of entries emitted since restart
+  bool finished_;                   // Has Finish() been called?
+  std::string last_key_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_BLOCK_BUILDER_H_
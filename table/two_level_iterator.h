@@ -0,0 +1,23 @@
+#ifndef STORAGE_LEVELDB_TABLE_TWO_LEVEL_ITERATOR_H_
+#define STORAGE_LEVELDB_TABLE_TWO_LEVEL_ITERATOR_H_
+
+#include "iterator.h"
+
+namespace leveldb {
+
+struct ReadOptions;
+
+// 两层迭代器：index_iter 遍历一系列块，每个 index 的 value 交给 block_function
+// 转换成指向块内容的迭代器，最终按顺序返回所有块中的 key/value。
+// 用于 sstable 的 index 块 + 数据块。
+//
+// Takes ownership of "index_iter" and will delete it when no longer needed.
+Iterator* NewTwoLevelIterator(
+    Iterator* index_iter,
+    Iterator* (*block_function)(void* arg, const ReadOptions& options,
+                                const Slice& index_value),
+    void* arg, const ReadOptions& options);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_TWO_LEVEL_ITERATOR_H_
@@ -0,0 +1,54 @@
+#ifndef STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
+#define STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace leveldb {
+
+// O_DIRECT 读写的缓冲区地址、文件偏移和长度都要按该值对齐。
+// 4KB 是常见文件系统的块大小，也是绝大多数设备逻辑块大小的整数倍。
+constexpr const size_t kDirectIOAlignment = 4096;
+
+// alignment 必须是 2 的幂
+inline uint64_t TruncateToAlignment(uint64_t n, size_t alignment) {
+  assert((alignment & (alignment - 1)) == 0);
+  return n & ~static_cast<uint64_t>(alignment - 1);
+}
+
+inline uint64_t RoundUpToAlignment(uint64_t n, size_t alignment) {
+  return TruncateToAlignment(n + alignment - 1, alignment);
+}
+
+// 起始地址按 alignment 对齐、大小为 capacity 的一块内存(posix_memalign)，
+// 析构时释放。capacity 会向上取整为 alignment 的整数倍。
+class AlignedBuffer {
+ public:
+  AlignedBuffer(size_t alignment, size_t capacity)
+      : capacity_(static_cast<size_t>(RoundUpToAlignment(capacity, alignment))) {
+    void* ptr;
+    if (::posix_memalign(&ptr, alignment, capacity_) != 0) {
+      throw std::bad_alloc();
+    }
+    data_ = static_cast<char*>(ptr);
+  }
+
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  ~AlignedBuffer() { std::free(data_); }
+
+  char* data() const { return data_; }
+  size_t capacity() const { return capacity_; }
+
+ private:
+  char* data_;
+  const size_t capacity_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_ALIGNED_BUFFER_H_
@@ -0,0 +1,26 @@
+#ifndef ALLOCATOR_H_
+#define ALLOCATOR_H_
+
+#include <cstddef>
+
+namespace leveldb
+{
+
+// 内存分配接口，SkipList / MemTable 通过它申请节点和 entry 的内存。
+// Arena 为单线程实现，ConcurrentArena 允许多个线程同时分配。
+// 分配出去的内存在 Allocator 析构时统一释放，不支持单独释放。
+class Allocator
+{
+public:
+    virtual ~Allocator() = default;
+
+    virtual char* Allocate(size_t bytes) = 0;
+    // 按指针大小(至少 8 字节)对齐分配
+    virtual char* AllocateAligned(size_t bytes) = 0;
+    // 返回目前从系统申请的总内存
+    virtual size_t MemoryUsage() const = 0;
+};
+
+}  // namespace leveldb
+
+#endif  // ALLOCATOR_H_
@@ -1,13 +1,113 @@
 #include "arena.h"
 
+#include <sys/mman.h>
+
+#include <new>
+#include <utility>
+
+#include "mutex.h"
+#include "no_destructor.h"
+
 namespace leveldb
 {
 
-static const int kBlockSize = 4096;
+namespace
+{
 
-Arena::Arena()
-    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0)
-{}
+const size_t kHugePageSize = 2 * 1024 * 1024;
+// 块池最多缓存的内存总量，超过的块直接 munmap 还给系统
+const size_t kMaxPooledBytes = 256 * 1024 * 1024;
+
+// 用匿名 mmap 申请 bytes 大小的内存，尽量使用大页
+char* MapBlock(size_t bytes)
+{
+    void* p = MAP_FAILED;
+#if defined(MAP_HUGETLB)
+    // 需要系统预留了 hugetlbfs 页(vm.nr_hugepages)，否则会失败
+    if (bytes % kHugePageSize == 0)
+    {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+#endif
+    if (p == MAP_FAILED)
+    {
+        p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            throw std::bad_alloc();
+        }
+#if defined(MADV_HUGEPAGE)
+        // 透明大页，只是建议，内核不支持时忽略错误
+        if (bytes >= kHugePageSize)
+        {
+            madvise(p, bytes, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    return static_cast<char*>(p);
+}
+
+// 进程内共享的 mmap 块池。memtable 释放后，它的块(页已经映射好)留给下一个 memtable 使用，
+// 避免反复 mmap/munmap 以及缺页。
+class BlockPool
+{
+public:
+    BlockPool() : pooled_bytes_(0) {}
+
+    char* Get(size_t bytes)
+    {
+        {
+            MutexLock l(&mu_);
+            for (size_t i = free_.size(); i > 0; i--)
+            {
+                if (free_[i - 1].first == bytes)
+                {
+                    char* block = free_[i - 1].second;
+                    free_.erase(free_.begin() + (i - 1));
+                    pooled_bytes_ -= bytes;
+                    return block;
+                }
+            }
+        }
+        return MapBlock(bytes);
+    }
+
+    void Put(char* block, size_t bytes)
+    {
+        {
+            MutexLock l(&mu_);
+            if (pooled_bytes_ + bytes <= kMaxPooledBytes)
+            {
+                free_.push_back(std::make_pair(bytes, block));
+                pooled_bytes_ += bytes;
+                return;
+            }
+        }
+        munmap(block, bytes);
+    }
+
+private:
+    Mutex mu_;
+    std::vector<std::pair<size_t, char*>> free_;    // (块大小, 块地址)
+    size_t pooled_bytes_;                           // free_ 中所有块的总大小
+};
+
+BlockPool* DefaultBlockPool()
+{
+    static NoDestructor<BlockPool> pool;
+    return pool.get();
+}
+
+}  // namespace
+
+Arena::Arena(size_t block_size, bool use_mmap)
+    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0),
+      block_size_(block_size), use_mmap_(use_mmap), memory_usage_(0)
+{
+    assert(block_size_ > 0);
+}
 
 Arena::~Arena()
 {
@@ -15,20 +115,24 @@ Arena::~Arena()
     {
         delete[] blocks_[i];
     }
+    for (size_t i = 0; i < mmap_blocks_.size(); i++)
+    {
+        DefaultBlockPool()->Put(mmap_blocks_[i], block_size_);
+    }
 }
 
 char* Arena::AllocateFallback(size_t bytes)
 {
     // 申请的内存大于当前块剩余内存，并且大于默认内存块大小的 1 / 4，直接申请一个需要的的 bytes 大小的内存块。
-    if (bytes > kBlockSize / 4) 
+    if (bytes > block_size_ / 4)
     {
         char* result = AllocateNewBlock(bytes);
         return result;
     }
 
     // 当前块剩余内存 < 申请的内存 < 默认内存块大小的 1 / 4 (4096 KB / 4 = 1024 KB)，重新申请一个默认大小的内存块 (4096 KB)。
-    alloc_ptr_ = AllocateNewBlock(kBlockSize);
-    alloc_bytes_remaining_ = kBlockSize;
+    alloc_ptr_ = use_mmap_ ? AllocateMmapBlock() : AllocateNewBlock(block_size_);
+    alloc_bytes_remaining_ = block_size_;
 
     //申请完了进行分配
     char* result = alloc_ptr_;
@@ -83,4 +187,12 @@ char* Arena::AllocateNewBlock(size_t block_bytes)
     return result;
 }
 
+char* Arena::AllocateMmapBlock()
+{
+    char* result = DefaultBlockPool()->Get(block_size_);
+    mmap_blocks_.push_back(result);
+    memory_usage_.fetch_add(block_size_ + sizeof(char*), std::memory_order_relaxed);
+    return result;
+}
+
 }  // namespace leveldb
@@ -7,6 +7,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "allocator.h"
+
 namespace leveldb
 {
 /*
@@ -15,24 +17,30 @@ namespace leveldb
 *    1.bytes < 当前块剩余内存 => 直接在当前块分配。
 *    2.当前块剩余内存 < bytes < 1024 KB (默认内存块大小的 1 / 4) => 直接申请一个默认大小为 4096 KB 的内存块，然后分配内存。
 *    3.bytes > 当前块剩余内存 && bytes > 1024 KB => 直接申请一个新的大小为 bytes 的内存块，并分配内存。
+* 块大小可配置(默认 4096 字节)。use_mmap 为 true 时，默认大小的块改为匿名 mmap 申请，
+* 优先使用大页(MAP_HUGETLB，失败时退回 madvise(MADV_HUGEPAGE))以减少 TLB 缺失；
+* Arena 析构时这些块归还给进程内共享的块池，供下一个同样配置的 Arena(通常是下一个 memtable)复用。
+* 单独申请的大块内存仍然使用 new[]。
 * 相关文章：https://www.jianshu.com/p/f5eebf44dec9
 */
 
-class Arena
+class Arena : public Allocator
 {
 public:
-    Arena();
+    static const size_t kDefaultBlockSize = 4096;
+
+    explicit Arena(size_t block_size = kDefaultBlockSize, bool use_mmap = false);
     ~Arena();
 
     Arena(const Arena&) = delete;
     Arena& operator=(const Arena&) = delete;
     
     // 基本的内存分配函数
-    char* Allocate(size_t bytes);
+    char* Allocate(size_t bytes) override;
     // 按照字节对齐来分配内存
-    char* AllocateAligned(size_t bytes);
+    char* AllocateAligned(size_t bytes) override;
     // 返回目前分配的总的内存
-    size_t MemoryUsage() const
+    size_t MemoryUsage() const override
     {
         return memory_usage_.load(std::memory_order_relaxed);
     }
@@ -42,10 +50,15 @@ private:
     char* AllocateFallback(size_t bytes);
     // new一个指定大小的内存，并加入blocks_管理
     char* AllocateNewBlock(size_t block_bytes);
+    // 从块池或 mmap 取一个 block_size_ 大小的块，并加入 mmap_blocks_ 管理
+    char* AllocateMmapBlock();
 
     char* alloc_ptr_;               // 当前 block 内还未使用的起始地址
     size_t alloc_bytes_remaining_;  // 当前 block 里还有多少字节可以使用
-    std::vector<char*> blocks_;     // 已经申请了的所有的内存块
+    const size_t block_size_;       // 默认内存块大小
+    const bool use_mmap_;           // 默认大小的块是否使用 mmap 申请
+    std::vector<char*> blocks_;     // 用 new[] 申请了的所有的内存块
+    std::vector<char*> mmap_blocks_;// 用 mmap 申请的块，大小都是 block_size_
     std::atomic<size_t> memory_usage_;// 总的内存使用量统计，memory_order没有采用默认的，采用relaxed，用在无多核交互的场景下。
 };
 
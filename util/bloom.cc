@@ -1,7 +1,17 @@
 #include "filter_policy.h"
+
+#include <cstring>
+
 #include "slice.h"
 #include "hash.h"
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define LEVELDB_BLOOM_AVX2 1
+#include <immintrin.h>
+#else
+#define LEVELDB_BLOOM_AVX2 0
+#endif
+
 /*
 其误判率应该和以下参数有关：
 1.哈希函数的个数 k
@@ -19,6 +29,34 @@ static uint32_t BloomHash(const Slice& key)
     return Hash(key.data(), key.size(), 0xbc9f1d34);
 }
 
+// 原始格式：整个 bit 数组上 k 次 double-hashing 探测，最后一个字节记录 k
+static bool LegacyKeyMayMatch(const Slice& key, const Slice& bloom_filter)
+{
+    const size_t len = bloom_filter.size();
+    if (len < 2) return false;
+
+    const char* array = bloom_filter.data();
+    const size_t bits = (len - 1) * 8;
+
+    // Use the encoded k so that we can read filters generated by
+    // bloom filters created using different parameters.
+    const size_t k = array[len - 1];
+    if (k > 30) {
+        // Reserved for potentially new encodings for short bloom filters.
+        // Consider it a match.
+        return true;
+    }
+
+    uint32_t h = BloomHash(key);
+    const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
+    for (size_t j = 0; j < k; j++) {
+        const uint32_t bitpos = h % bits;
+        if ((array[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
+        h += delta;
+    }
+    return true;
+}
+
 class BloomFilterPolicy : public FilterPolicy
 {
 public:
@@ -73,39 +111,181 @@ public:
 
     bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const override
     {
-        const size_t len = bloom_filter.size();
-        if (len < 2) return false;
+        return LegacyKeyMayMatch(key, bloom_filter);
+    }
+
+private:
+    size_t bits_per_key_;
+    size_t k_;
+};
+
+const FilterPolicy* NewBloomFilterPolicy(int bits_per_key)
+{
+    return new BloomFilterPolicy(bits_per_key);
+}
+
+/*
+分块布隆过滤器：每个 key 先用哈希值选中一个 64 字节(一条 cache line)的块，k 次探测都落在这个块里，
+一次查询最多访问一条 cache line。
+格式：
+    [64 字节的块 * num_blocks][k (1 字节)][kBlockedBloomMarker (1 字节)]
+最后一个字节就是原始格式中记录 k 的位置，kBlockedBloomMarker > 30，旧版本读到时视为匹配。
+以后的新格式使用新的 marker 值(32, 33 ...)。
+第 j 次探测的位置为 (h2 * kProbeMultiplier^(j+1)) 的高 9 位，即块内的 bit 编号；
+各次探测之间没有依赖，AVX2 下一次计算 8 个。
+*/
+static const char kBlockedBloomMarker = 31;
+static const size_t kBlockBytes = 64;
+static const size_t kBlockBits = kBlockBytes * 8;
+static const int kMaxBlockedProbes = 16;
+static const uint32_t kProbeMultiplier = 0x9e3779b9;
+
+static constexpr uint32_t ProbeMultiplier(int j)
+{
+    return j == 0 ? kProbeMultiplier : kProbeMultiplier * ProbeMultiplier(j - 1);
+}
+
+// kProbeMultipliers[j] = kProbeMultiplier^(j+1)
+alignas(32) static const uint32_t kProbeMultipliers[kMaxBlockedProbes] = {
+    ProbeMultiplier(0),  ProbeMultiplier(1),  ProbeMultiplier(2),  ProbeMultiplier(3),
+    ProbeMultiplier(4),  ProbeMultiplier(5),  ProbeMultiplier(6),  ProbeMultiplier(7),
+    ProbeMultiplier(8),  ProbeMultiplier(9),  ProbeMultiplier(10), ProbeMultiplier(11),
+    ProbeMultiplier(12), ProbeMultiplier(13), ProbeMultiplier(14), ProbeMultiplier(15),
+};
+
+// 选中的块：把 h 均匀映射到 [0, num_blocks)，避免取模
+static inline uint32_t BlockIndex(uint32_t h, uint32_t num_blocks)
+{
+    return static_cast<uint32_t>((static_cast<uint64_t>(h) * num_blocks) >> 32);
+}
 
-        const char* array = bloom_filter.data();
-        const size_t bits = (len - 1) * 8;
+// 块内探测使用的哈希值。块由 h 的高位决定，这里把低位旋转到高位
+static inline uint32_t ProbeHash(uint32_t h)
+{
+    return (h >> 17) | (h << 15);
+}
+
+static bool BlockMayMatchPortable(const char* block, uint32_t h2, int num_probes)
+{
+    for (int j = 0; j < num_probes; j++)
+    {
+        h2 *= kProbeMultiplier;
+        const uint32_t bitpos = h2 >> 23;
+        if ((block[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
+    }
+    return true;
+}
+
+#if LEVELDB_BLOOM_AVX2
+// 块按小端的 16 个 32 位字看待：bitpos 的高 4 位是字编号，低 5 位是字内 bit，与 Portable 版本等价
+__attribute__((target("avx2")))
+static bool BlockMayMatchAVX2(const char* block, uint32_t h2, int num_probes)
+{
+    const __m256i lower = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i upper = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    for (int base = 0; base < num_probes; base += 8)
+    {
+        const __m256i hashes = _mm256_mullo_epi32(
+            _mm256_set1_epi32(static_cast<int>(h2)),
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(&kProbeMultipliers[base])));
+        // 字编号 0~15：低 3 位在 lower/upper 内选字，第 4 位(移到符号位)选择 lower 还是 upper
+        const __m256i word_index = _mm256_srli_epi32(hashes, 28);
+        const __m256 from_lower = _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(lower, word_index));
+        const __m256 from_upper = _mm256_castsi256_ps(_mm256_permutevar8x32_epi32(upper, word_index));
+        const __m256i words = _mm256_castps_si256(_mm256_blendv_ps(
+            from_lower, from_upper, _mm256_castsi256_ps(_mm256_slli_epi32(word_index, 28))));
+        const __m256i bit_index = _mm256_and_si256(_mm256_srli_epi32(hashes, 23), _mm256_set1_epi32(31));
+        __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bit_index);
+        // 超出 num_probes 的 lane 不参与比较
+        const __m256i active = _mm256_cmpgt_epi32(_mm256_set1_epi32(num_probes - base), lanes);
+        mask = _mm256_and_si256(mask, active);
+        // (~words & mask) == 0 即所有探测位都已置位
+        if (!_mm256_testc_si256(words, mask)) return false;
+    }
+    return true;
+}
+#endif  // LEVELDB_BLOOM_AVX2
+
+class BlockedBloomFilterPolicy : public FilterPolicy
+{
+public:
+    explicit BlockedBloomFilterPolicy(int bits_per_key)
+        : bits_per_key_(bits_per_key), use_avx2_(false)
+    {
+        k_ = static_cast<int>(bits_per_key * 0.69);  // 0.69 =~ ln(2)
+        if (k_ < 1) k_ = 1;
+        if (k_ > kMaxBlockedProbes) k_ = kMaxBlockedProbes;
+#if LEVELDB_BLOOM_AVX2
+        use_avx2_ = __builtin_cpu_supports("avx2");
+#endif
+    }
 
-        // Use the encoded k so that we can read filters generated by
-        // bloom filters created using different parameters.
-        const size_t k = array[len - 1];
-        if (k > 30) {
-            // Reserved for potentially new encodings for short bloom filters.
-            // Consider it a match.
+    const char* Name() const override { return "leveldb.BuiltinBlockedBloomFilter"; }
+
+    void CreateFilter(const Slice* keys, int n, std::string* dst) const override
+    {
+        size_t num_blocks = (n * bits_per_key_ + kBlockBits - 1) / kBlockBits;
+        if (num_blocks < 1) num_blocks = 1;
+
+        const size_t init_size = dst->size();
+        dst->resize(init_size + num_blocks * kBlockBytes, 0);
+        dst->push_back(static_cast<char>(k_));
+        dst->push_back(kBlockedBloomMarker);
+        char* array = &(*dst)[init_size];
+        for (int i = 0; i < n; i++)
+        {
+            const uint32_t h = BloomHash(keys[i]);
+            char* block = array + BlockIndex(h, num_blocks) * kBlockBytes;
+            uint32_t h2 = ProbeHash(h);
+            for (int j = 0; j < k_; j++)
+            {
+                h2 *= kProbeMultiplier;
+                const uint32_t bitpos = h2 >> 23;
+                block[bitpos / 8] |= (1 << (bitpos % 8));
+            }
+        }
+    }
+
+    bool KeyMayMatch(const Slice& key, const Slice& filter) const override
+    {
+        const size_t len = filter.size();
+        if (len < 2) return false;
+
+        const char* array = filter.data();
+        if (array[len - 1] != kBlockedBloomMarker)
+        {
+            // 原始格式(或者更新的格式，由 LegacyKeyMayMatch 视为匹配)
+            return LegacyKeyMayMatch(key, filter);
+        }
+        const size_t bytes = len - 2;
+        const int k = static_cast<unsigned char>(array[len - 2]);
+        if (bytes == 0 || bytes % kBlockBytes != 0 || k < 1 || k > kMaxBlockedProbes)
+        {
+            // 无法识别的编码，视为匹配
             return true;
         }
 
-        uint32_t h = BloomHash(key);
-        const uint32_t delta = (h >> 17) | (h << 15);  // Rotate right 17 bits
-        for (size_t j = 0; j < k; j++) {
-            const uint32_t bitpos = h % bits;
-            if ((array[bitpos / 8] & (1 << (bitpos % 8))) == 0) return false;
-            h += delta;
+        const uint32_t h = BloomHash(key);
+        const char* block = array + BlockIndex(h, bytes / kBlockBytes) * kBlockBytes;
+#if LEVELDB_BLOOM_AVX2
+        if (use_avx2_)
+        {
+            return BlockMayMatchAVX2(block, ProbeHash(h), k);
         }
-        return true;
+#endif
+        return BlockMayMatchPortable(block, ProbeHash(h), k);
     }
 
 private:
     size_t bits_per_key_;
-    size_t k_;
+    int k_;
+    bool use_avx2_;     // 运行时检测 CPU 是否支持 AVX2
 };
 
-const FilterPolicy* NewBloomFilterPolicy(int bits_per_key)
+const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key)
 {
-    return new BloomFilterPolicy(bits_per_key);
+    return new BlockedBloomFilterPolicy(bits_per_key);
 }
 
 }  // namespace leveldb
@@ -0,0 +1,45 @@
+#include "cleanable.h"
+
+namespace leveldb {
+
+Cleanable::Cleanable() {
+  cleanup_head_.function = nullptr;
+  cleanup_head_.next = nullptr;
+}
+
+Cleanable::~Cleanable() { DoCleanup(); }
+
+void Cleanable::Reset() {
+  DoCleanup();
+  cleanup_head_.function = nullptr;
+  cleanup_head_.next = nullptr;
+}
+
+void Cleanable::DoCleanup() {
+  if (!cleanup_head_.IsEmpty()) {
+    cleanup_head_.Run();
+    for (CleanupNode* node = cleanup_head_.next; node != nullptr;) {
+      node->Run();
+      CleanupNode* next_node = node->next;
+      delete node;
+      node = next_node;
+    }
+  }
+}
+
+void Cleanable::RegisterCleanup(CleanupFunction func, void* arg1, void* arg2) {
+  assert(func != nullptr);
+  CleanupNode* node;
+  if (cleanup_head_.IsEmpty()) {
+    node = &cleanup_head_;
+  } else {
+    node = new CleanupNode();
+    node->next = cleanup_head_.next;
+    cleanup_head_.next = node;
+  }
+  node->function = func;
+  node->arg1 = arg1;
+  node->arg2 = arg2;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,491 @@
+#include "cache.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include "hash.h"
+#include "mutex.h"
+
+namespace leveldb
+{
+
+// ClockCache：查找不加锁的缓存实现。
+// 1.每个分片是一个固定大小、线性探测的哈希表，槽位(ClockHandle)在分片生命周期内不会释放，
+//   所以查找线程可以随时读取任意槽位。
+// 2.槽位的状态和引用计数放在同一个 64 位原子变量 meta 中，Lookup/Release 只需要一次
+//   fetch_add/fetch_sub，不需要加锁，也不需要像 LRU 那样移动链表节点。
+// 3.只有引用计数为 0 时才能通过 CAS 把槽位从 Visible/Invisible 改为 Construction 并回收，
+//   持有引用(包括查找时的短暂引用)的槽位不会被回收或复用。
+// 4.淘汰使用 CLOCK(second-chance) 策略：Lookup 命中时置位 clock，扫描指针 hand_ 遇到
+//   clock 置位的槽位先清除并跳过，遇到未置位且引用为 0 的槽位才淘汰。
+// 5.Insert/Erase/淘汰由分片的 mutex_ 串行化，查找路径不会获取这个锁；
+//   只有当 Release 释放了一个已经被删除的 entry 的最后一个引用时，才加锁回收。
+// 6.查找时用 displacements 判断何时停止探测：插入时探测经过的每个槽位 displacements 加 1，
+//   回收时减 1；经过一个 displacements 为 0 且不匹配的槽位就可以确定 key 不存在。
+struct ClockHandle
+{
+    // meta 的高 2 位为状态，低位为引用计数
+    std::atomic<uint64_t> meta;
+    // 探测路径经过该槽位、但存放在后面槽位的 entry 个数
+    std::atomic<uint32_t> displacements;
+    // CLOCK 访问位，命中时置 1，扫描时清 0
+    std::atomic<uint8_t> clock;
+    // 未进入缓存的 entry(容量为 0 或者哈希表已满)，单独申请内存，引用为 0 时直接删除
+    bool detached;
+    uint32_t hash;
+
+    void* value;
+    void (*deleter)(const Slice&, void* value);
+    size_t charge;
+    char* key_data;
+    size_t key_length;
+
+    ClockHandle() : meta(0), displacements(0), clock(0), detached(false),
+                    hash(0), value(nullptr), deleter(nullptr), charge(0),
+                    key_data(nullptr), key_length(0) {}
+
+    Slice key() const { return Slice(key_data, key_length); }
+};
+
+namespace
+{
+
+const int kStateShift = 62;
+const uint64_t kRefsMask = (uint64_t{1} << kStateShift) - 1;
+// 空槽位
+const uint64_t kStateEmpty = 0;
+// 正在写入或回收，只有持有 mutex_ 的线程可以访问
+const uint64_t kStateConstruction = 1;
+// 在缓存中，可以被查找到
+const uint64_t kStateVisible = 2;
+// 已经从缓存删除(Erase 或者被同 key 的 Insert 替换)，等待最后一个引用释放后回收
+const uint64_t kStateInvisible = 3;
+
+const uint64_t kStateOne = uint64_t{1} << kStateShift;
+
+inline uint64_t State(uint64_t meta) { return meta >> kStateShift; }
+inline uint64_t Refs(uint64_t meta) { return meta & kRefsMask; }
+
+// 哈希表最多使用的槽位比例，保证探测序列足够短
+const double kLoadFactor = 0.7;
+// 每个分片最少的槽位个数
+const size_t kMinSlots = 16;
+
+}  // namespace
+
+class ClockCacheShard
+{
+public:
+    ClockCacheShard();
+    ~ClockCacheShard();
+
+    ClockCacheShard(const ClockCacheShard&) = delete;
+    ClockCacheShard& operator=(const ClockCacheShard&) = delete;
+
+    // 与构造函数分离，以便调用方可以轻松地生成分片数组
+    void Init(size_t capacity, size_t estimated_entry_charge);
+
+    Cache::Handle* Insert(const Slice& key, uint32_t hash, void* value,
+                          size_t charge,
+                          void (*deleter)(const Slice& key, void* value));
+    Cache::Handle* Lookup(const Slice& key, uint32_t hash);
+    void Release(Cache::Handle* handle);
+    void Erase(const Slice& key, uint32_t hash);
+    void Prune();
+    size_t TotalCharge() const
+    {
+        MutexLock l(&mutex_);
+        return usage_;
+    }
+
+private:
+    // 释放一个引用；若释放的是 Invisible entry 的最后一个引用，加锁回收
+    void Unref(ClockHandle* e);
+    // 持有 mutex_：找到 key 对应的 Visible 槽位
+    ClockHandle* FindVisible(const Slice& key, uint32_t hash);
+    // 持有 mutex_：把 Visible 的 e 标记为 Invisible，引用为 0 时立即回收
+    void MakeInvisible(ClockHandle* e);
+    // 持有 mutex_：尝试把状态为 state 且引用为 0 的槽位改为 Construction 并回收
+    bool TryReclaim(ClockHandle* e, uint64_t state);
+    // 持有 mutex_：调用 deleter，撤销探测路径上的 displacements，把槽位置为 Empty
+    void FreeEntry(ClockHandle* e);
+    // 持有 mutex_：转动 hand_ 淘汰一个 entry，扫描两圈都没有可淘汰的返回 false
+    bool EvictOne();
+    size_t Index(const ClockHandle* e) const { return e - table_; }
+
+    size_t capacity_;
+    size_t length_;         // 槽位个数，2 的次幂
+    size_t max_occupancy_;  // 最多使用的槽位个数
+    ClockHandle* table_;
+
+    // 互斥锁，保护下列数据以及所有槽位从/到 Construction 状态的转换
+    mutable Mutex mutex_;
+    size_t usage_;          // 缓存中 entry 的 charge 之和(包括 Invisible 的)
+    size_t occupancy_;      // 非 Empty 的槽位个数
+    size_t hand_;           // CLOCK 扫描指针
+};
+
+ClockCacheShard::ClockCacheShard()
+    : capacity_(0), length_(0), max_occupancy_(0), table_(nullptr),
+      usage_(0), occupancy_(0), hand_(0)
+{}
+
+ClockCacheShard::~ClockCacheShard()
+{
+    for (size_t i = 0; i < length_; i++)
+    {
+        ClockHandle* e = &table_[i];
+        uint64_t meta = e->meta.load(std::memory_order_relaxed);
+        // 所有 handle 都必须已经释放
+        assert(Refs(meta) == 0);
+        assert(State(meta) == kStateEmpty || State(meta) == kStateVisible);
+        if (State(meta) == kStateVisible)
+        {
+            (*e->deleter)(e->key(), e->value);
+            free(e->key_data);
+        }
+    }
+    delete[] table_;
+}
+
+void ClockCacheShard::Init(size_t capacity, size_t estimated_entry_charge)
+{
+    assert(table_ == nullptr);
+    capacity_ = capacity;
+    size_t entries = capacity / (estimated_entry_charge > 0 ? estimated_entry_charge : 1);
+    size_t slots = static_cast<size_t>(entries / kLoadFactor) + 1;
+    length_ = kMinSlots;
+    while (length_ < slots)
+    {
+        length_ *= 2;
+    }
+    max_occupancy_ = static_cast<size_t>(length_ * kLoadFactor);
+    table_ = new ClockHandle[length_];
+}
+
+Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash)
+{
+    size_t i = hash & (length_ - 1);
+    for (size_t probes = 0; probes < length_; probes++)
+    {
+        ClockHandle* e = &table_[i];
+        // 先普通读一次，避免在空槽位上产生多余的写
+        if (State(e->meta.load(std::memory_order_acquire)) == kStateVisible)
+        {
+            uint64_t old = e->meta.fetch_add(1, std::memory_order_acquire);
+            // 持有引用之后槽位不会被回收，可以安全地读取 key
+            if (State(old) == kStateVisible && e->hash == hash && key == e->key())
+            {
+                if (e->clock.load(std::memory_order_relaxed) == 0)
+                {
+                    e->clock.store(1, std::memory_order_relaxed);
+                }
+                return reinterpret_cast<Cache::Handle*>(e);
+            }
+            Unref(e);
+        }
+        if (e->displacements.load(std::memory_order_relaxed) == 0)
+        {
+            break;
+        }
+        i = (i + 1) & (length_ - 1);
+    }
+    return nullptr;
+}
+
+void ClockCacheShard::Release(Cache::Handle* handle)
+{
+    ClockHandle* e = reinterpret_cast<ClockHandle*>(handle);
+    if (e->detached)
+    {
+        if (Refs(e->meta.fetch_sub(1, std::memory_order_acq_rel)) == 1)
+        {
+            (*e->deleter)(e->key(), e->value);
+            free(e->key_data);
+            delete e;
+        }
+        return;
+    }
+    Unref(e);
+}
+
+void ClockCacheShard::Unref(ClockHandle* e)
+{
+    uint64_t old = e->meta.fetch_sub(1, std::memory_order_release);
+    assert(Refs(old) > 0);
+    if (old == ((kStateInvisible << kStateShift) | 1))
+    {
+        MutexLock l(&mutex_);
+        TryReclaim(e, kStateInvisible);
+    }
+}
+
+Cache::Handle* ClockCacheShard::Insert(const Slice& key, uint32_t hash,
+                                       void* value, size_t charge,
+                                       void (*deleter)(const Slice& key,
+                                                       void* value))
+{
+    char* key_data = static_cast<char*>(malloc(key.size() > 0 ? key.size() : 1));
+    memcpy(key_data, key.data(), key.size());
+
+    if (capacity_ > 0)
+    {
+        MutexLock l(&mutex_);
+
+        // 同 key 的旧 entry 不再可见，等它的引用全部释放后回收
+        ClockHandle* old = FindVisible(key, hash);
+        if (old != nullptr)
+        {
+            MakeInvisible(old);
+        }
+
+        // 如果超过了容量限制或者哈希表太满，根据 CLOCK 策略淘汰
+        while (usage_ + charge > capacity_ || occupancy_ >= max_occupancy_)
+        {
+            if (!EvictOne())
+            {
+                break;
+            }
+        }
+
+        // 线性探测找到第一个空槽位
+        size_t start = hash & (length_ - 1);
+        for (size_t probes = 0; probes < length_ && occupancy_ < length_; probes++)
+        {
+            ClockHandle* e = &table_[(start + probes) & (length_ - 1)];
+            // 空槽位上可能存在查找线程的短暂引用，等它释放后重试
+            uint64_t expected = kStateEmpty << kStateShift;
+            bool claimed = false;
+            while (!(claimed = e->meta.compare_exchange_weak(
+                         expected, kStateConstruction << kStateShift,
+                         std::memory_order_acquire)) &&
+                   State(expected) == kStateEmpty)
+            {
+                expected = kStateEmpty << kStateShift;
+            }
+            if (!claimed)
+            {
+                continue;
+            }
+
+            e->hash = hash;
+            e->value = value;
+            e->deleter = deleter;
+            e->charge = charge;
+            e->key_data = key_data;
+            e->key_length = key.size();
+            e->clock.store(1, std::memory_order_relaxed);
+            for (size_t j = 0; j < probes; j++)
+            {
+                table_[(start + j) & (length_ - 1)].displacements.fetch_add(
+                    1, std::memory_order_relaxed);
+            }
+            usage_ += charge;
+            occupancy_++;
+            // Construction -> Visible，同时为返回的 handle 加一个引用
+            e->meta.fetch_add(kStateOne + 1, std::memory_order_release);
+            return reinterpret_cast<Cache::Handle*>(e);
+        }
+    }
+
+    // 不缓存(容量为 0，或者所有槽位都被占用且无法淘汰)
+    ClockHandle* e = new ClockHandle;
+    e->meta.store(1, std::memory_order_relaxed);
+    e->detached = true;
+    e->hash = hash;
+    e->value = value;
+    e->deleter = deleter;
+    e->charge = charge;
+    e->key_data = key_data;
+    e->key_length = key.size();
+    return reinterpret_cast<Cache::Handle*>(e);
+}
+
+ClockHandle* ClockCacheShard::FindVisible(const Slice& key, uint32_t hash)
+{
+    size_t i = hash & (length_ - 1);
+    for (size_t probes = 0; probes < length_; probes++)
+    {
+        ClockHandle* e = &table_[i];
+        // 持有 mutex_，Visible 槽位不会被其他线程改变
+        if (State(e->meta.load(std::memory_order_acquire)) == kStateVisible &&
+            e->hash == hash && key == e->key())
+        {
+            return e;
+        }
+        if (e->displacements.load(std::memory_order_relaxed) == 0)
+        {
+            break;
+        }
+        i = (i + 1) & (length_ - 1);
+    }
+    return nullptr;
+}
+
+void ClockCacheShard::MakeInvisible(ClockHandle* e)
+{
+    // Visible(10) -> Invisible(11)，保留引用计数
+    uint64_t old = e->meta.fetch_or(kStateOne, std::memory_order_acq_rel);
+    assert(State(old) == kStateVisible);
+    if (Refs(old) == 0)
+    {
+        // 失败说明有查找线程持有短暂引用，由它在释放时回收
+        TryReclaim(e, kStateInvisible);
+    }
+}
+
+bool ClockCacheShard::TryReclaim(ClockHandle* e, uint64_t state)
+{
+    uint64_t expected = state << kStateShift;
+    if (!e->meta.compare_exchange_strong(expected, kStateConstruction << kStateShift,
+                                         std::memory_order_acquire))
+    {
+        return false;
+    }
+    FreeEntry(e);
+    return true;
+}
+
+void ClockCacheShard::FreeEntry(ClockHandle* e)
+{
+    (*e->deleter)(e->key(), e->value);
+    free(e->key_data);
+    e->key_data = nullptr;
+    usage_ -= e->charge;
+    occupancy_--;
+    for (size_t i = e->hash & (length_ - 1); i != Index(e); i = (i + 1) & (length_ - 1))
+    {
+        table_[i].displacements.fetch_sub(1, std::memory_order_relaxed);
+    }
+    // Construction -> Empty，保留查找线程可能加上的短暂引用
+    e->meta.fetch_sub(kStateOne, std::memory_order_release);
+}
+
+bool ClockCacheShard::EvictOne()
+{
+    for (size_t steps = 0; steps < 2 * length_; steps++)
+    {
+        ClockHandle* e = &table_[hand_];
+        hand_ = (hand_ + 1) & (length_ - 1);
+        uint64_t meta = e->meta.load(std::memory_order_relaxed);
+        if (State(meta) != kStateVisible || Refs(meta) != 0)
+        {
+            continue;
+        }
+        // 第二次机会：最近被访问过的先清除访问位
+        if (e->clock.load(std::memory_order_relaxed) != 0)
+        {
+            e->clock.store(0, std::memory_order_relaxed);
+            continue;
+        }
+        if (TryReclaim(e, kStateVisible))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ClockCacheShard::Erase(const Slice& key, uint32_t hash)
+{
+    MutexLock l(&mutex_);
+    ClockHandle* e = FindVisible(key, hash);
+    if (e != nullptr)
+    {
+        MakeInvisible(e);
+    }
+}
+
+void ClockCacheShard::Prune()
+{
+    MutexLock l(&mutex_);
+    for (size_t i = 0; i < length_; i++)
+    {
+        TryReclaim(&table_[i], kStateVisible);
+    }
+}
+
+static const int kNumShardBits = 4;
+static const int kNumShards = 1 << kNumShardBits;
+
+class ShardedClockCache : public Cache
+{
+public:
+    ShardedClockCache(size_t capacity, size_t estimated_entry_charge) : last_id_(0)
+    {
+        const size_t per_shard = (capacity + (kNumShards - 1)) / kNumShards;
+        for (int s = 0; s < kNumShards; s++)
+        {
+            shard_[s].Init(per_shard, estimated_entry_charge);
+        }
+    }
+    ~ShardedClockCache() override {}
+
+    Handle* Insert(const Slice& key, void* value, size_t charge,
+                   void (*deleter)(const Slice& key, void* value)) override
+    {
+        const uint32_t hash = HashSlice(key);
+        return shard_[Shard(hash)].Insert(key, hash, value, charge, deleter);
+    }
+    Handle* Lookup(const Slice& key) override
+    {
+        const uint32_t hash = HashSlice(key);
+        return shard_[Shard(hash)].Lookup(key, hash);
+    }
+    void Release(Handle* handle) override
+    {
+        ClockHandle* h = reinterpret_cast<ClockHandle*>(handle);
+        shard_[Shard(h->hash)].Release(handle);
+    }
+    void Erase(const Slice& key) override
+    {
+        const uint32_t hash = HashSlice(key);
+        shard_[Shard(hash)].Erase(key, hash);
+    }
+    void* Value(Handle* handle) override
+    {
+        return reinterpret_cast<ClockHandle*>(handle)->value;
+    }
+    uint64_t NewId() override
+    {
+        MutexLock l(&id_mutex_);
+        return ++(last_id_);
+    }
+    void Prune() override
+    {
+        for (int s = 0; s < kNumShards; s++)
+        {
+            shard_[s].Prune();
+        }
+    }
+    size_t TotalCharge() const override
+    {
+        size_t total = 0;
+        for (int s = 0; s < kNumShards; s++)
+        {
+            total += shard_[s].TotalCharge();
+        }
+        return total;
+    }
+
+private:
+    static inline uint32_t HashSlice(const Slice& s)
+    {
+        return Hash(s.data(), s.size(), 0);
+    }
+    // 最高 4 位选择分片，低位用于分片内的哈希表
+    static uint32_t Shard(uint32_t hash) { return hash >> (32 - kNumShardBits); }
+
+private:
+    ClockCacheShard shard_[kNumShards];
+    Mutex id_mutex_;
+    uint64_t last_id_;
+};
+
+Cache* NewClockCache(size_t capacity, size_t estimated_entry_charge)
+{
+    return new ShardedClockCache(capacity, estimated_entry_charge);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,83 @@
+#include "concurrent_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace leveldb
+{
+
+namespace
+{
+
+// 与 Arena::AllocateAligned 保持一致的对齐要求
+const size_t kAlign = (sizeof(void*) > 8) ? sizeof(void*) : 8;
+static_assert((kAlign & (kAlign - 1)) == 0, "Pointer size should be a power of 2");
+
+// id 从 1 开始分配，0 表示线程还没有缓存任何 shard
+std::atomic<uint64_t> g_next_arena_id(1);
+
+// 线程私有的 shard。只有 POD 成员，访问 thread_local 时不需要初始化检查
+struct ThreadShard
+{
+    uint64_t arena_id;      // 所属 ConcurrentArena 的 id
+    char* alloc_ptr;        // shard 内还未使用的起始地址
+    size_t remaining;       // shard 里还有多少字节可以使用
+};
+
+thread_local ThreadShard tls_shard = {0, nullptr, 0};
+
+}  // namespace
+
+ConcurrentArena::ConcurrentArena(size_t shard_block_size, size_t block_size,
+                                 bool use_mmap)
+    : id_(g_next_arena_id.fetch_add(1, std::memory_order_relaxed)),
+      shard_block_size_(shard_block_size),
+      arena_(std::max(block_size, 4 * shard_block_size), use_mmap)
+{
+    assert(shard_block_size_ >= kAlign);
+}
+
+char* ConcurrentArena::AllocateImpl(size_t bytes, bool aligned)
+{
+    assert(bytes > 0);
+    ThreadShard* shard = &tls_shard;
+
+    // 快速路径：在本线程的 shard 上分配
+    if (shard->arena_id == id_)
+    {
+        size_t slop = 0;
+        if (aligned)
+        {
+            size_t current_mod = reinterpret_cast<uintptr_t>(shard->alloc_ptr) & (kAlign - 1);
+            slop = (current_mod == 0 ? 0 : kAlign - current_mod);
+        }
+        if (bytes + slop <= shard->remaining)
+        {
+            char* result = shard->alloc_ptr + slop;
+            shard->alloc_ptr += bytes + slop;
+            shard->remaining -= bytes + slop;
+            return result;
+        }
+    }
+
+    // 大块内存直接从共享 arena 分配，不占用 shard
+    if (bytes > shard_block_size_ / 4)
+    {
+        return AllocateShared(bytes, aligned);
+    }
+
+    // shard 用完(或者还没有)，切一块新的，旧 shard 剩余的空间丢弃
+    char* block = AllocateShared(shard_block_size_, true);
+    shard->arena_id = id_;
+    shard->alloc_ptr = block + bytes;
+    shard->remaining = shard_block_size_ - bytes;
+    return block;
+}
+
+char* ConcurrentArena::AllocateShared(size_t bytes, bool aligned)
+{
+    MutexLock l(&mu_);
+    return aligned ? arena_.AllocateAligned(bytes) : arena_.Allocate(bytes);
+}
+
+}  // namespace leveldb
@@ -0,0 +1,60 @@
+#ifndef CONCURRENT_ARENA_H_
+#define CONCURRENT_ARENA_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "allocator.h"
+#include "arena.h"
+#include "mutex.h"
+
+namespace leveldb
+{
+
+/*
+* 可以被多个线程同时使用的 Arena，用于多个写线程并发插入同一个 memtable。
+* 策略：
+*    1.每个线程持有一块从共享 Arena 切下来的小内存片(shard)，绝大多数分配直接在
+*      本线程的 shard 上移动指针完成，不需要加锁也没有原子操作。
+*    2.shard 用完后加锁从共享 Arena 再切一块；超过 shard 大小 1/4 的分配直接加锁
+*      从共享 Arena 分配，避免浪费 shard 剩余空间。
+*    3.shard 记录所属 ConcurrentArena 的 id(进程内唯一、不复用)，线程切换到另一个
+*      ConcurrentArena 时旧 shard 的剩余空间直接丢弃。
+* MemoryUsage() 返回共享 Arena 已经申请的内存，包含各线程 shard 中尚未用完的部分。
+* block_size / use_mmap 传给共享 Arena，含义见 arena.h。shard 从共享 Arena 的块中切出，
+* block_size 小于 shard 大小的 4 倍时 shard 会超过块的 1/4，每个 shard 都单独用 new[] 申请，
+* 块(以及 mmap)完全用不上，所以 block_size 至少取 4 * shard_block_size。
+*/
+class ConcurrentArena : public Allocator
+{
+public:
+    static const size_t kDefaultShardBlockSize = 4096;
+    static const size_t kDefaultBlockSize = 16 * kDefaultShardBlockSize;
+
+    explicit ConcurrentArena(size_t shard_block_size = kDefaultShardBlockSize,
+                             size_t block_size = kDefaultBlockSize,
+                             bool use_mmap = false);
+    ~ConcurrentArena() override = default;
+
+    ConcurrentArena(const ConcurrentArena&) = delete;
+    ConcurrentArena& operator=(const ConcurrentArena&) = delete;
+
+    char* Allocate(size_t bytes) override { return AllocateImpl(bytes, false); }
+    char* AllocateAligned(size_t bytes) override { return AllocateImpl(bytes, true); }
+    size_t MemoryUsage() const override { return arena_.MemoryUsage(); }
+
+private:
+    char* AllocateImpl(size_t bytes, bool aligned);
+    // 加锁从共享 arena_ 分配
+    char* AllocateShared(size_t bytes, bool aligned);
+
+    const uint64_t id_;                 // 用于识别线程缓存的 shard 是否属于自己
+    const size_t shard_block_size_;     // 每次给线程切出的 shard 大小
+    Mutex mu_;                          // 保护 arena_ 的分配
+    Arena arena_;                       // 共享的底层内存
+};
+
+}  // namespace leveldb
+
+#endif  // CONCURRENT_ARENA_H_
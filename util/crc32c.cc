@@ -256,7 +256,7 @@ constexpr inline const uint8_t* RoundUp(const uint8_t* pointer) {
 // Determine if the CPU running this program can accelerate the CRC32C
 // calculation.
 static bool CanAccelerateCRC32C() {
-  // port::AcceleretedCRC32C returns zero when unable to accelerate.
+  // AcceleratedCRC32C returns zero when unable to accelerate.
   static const char kTestCRCBuffer[] = "TestCRCBuffer";
   static const char kBufSize = sizeof(kTestCRCBuffer) - 1;
   static const uint32_t kTestCRCValue = 0xdcbc59fa;
@@ -269,7 +269,10 @@ uint32_t Extend(uint32_t crc, const char* data, size_t n) {
   if (accelerate) {
     return AcceleratedCRC32C(crc, data, n);
   }
+  return ExtendPortable(crc, data, n);
+}
 
+uint32_t ExtendPortable(uint32_t crc, const char* data, size_t n) {
   const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
   const uint8_t* e = p + n;
   uint32_t l = crc ^ kCRC32Xor;
@@ -33,9 +33,14 @@ inline uint32_t Unmask(uint32_t masked_crc) {
   return ((rot >> 17) | (rot << 15));
 }
 
-inline uint32_t AcceleratedCRC32C(uint32_t crc, const char* buf, size_t size) {
-  return Extend(crc, buf, size);
-}
+// 使用 CPU 指令加速计算 crc32c(x86-64 上为 SSE4.2 crc32 指令，三路交错，
+// 并用 PCLMULQDQ 合并各路结果)。是否可用在运行时通过 CPUID 检测，
+// 不支持时返回 0，Extend() 据此回退到查表实现。
+uint32_t AcceleratedCRC32C(uint32_t crc, const char* buf, size_t size);
+
+// 纯软件的查表实现(kStrideExtensionTable*)，语义同 Extend()。
+// 一般不直接使用，主要用于校验加速实现以及性能对比。
+uint32_t ExtendPortable(uint32_t init_crc, const char* data, size_t n);
 
 }  // namespace crc32c
 }  // namespace leveldb
@@ -7,10 +7,54 @@ Env::Env() = default;
 
 Env::~Env() = default;
 
+Status Env::NewMmapSequentialFile(const std::string& fname,
+                                  SequentialFile** result) {
+  return NewSequentialFile(fname, result);
+}
+
+Status Env::NewDirectRandomAccessFile(const std::string& fname,
+                                     RandomAccessFile** result) {
+  return NewRandomAccessFile(fname, result);
+}
+
+Status Env::NewDirectWritableFile(const std::string& fname,
+                                  WritableFile** result) {
+  return NewWritableFile(fname, result);
+}
+
+Status Env::SyncDir(const std::string& dirname) { return Status::OK(); }
+
 Status Env::NewAppendableFile(const std::string& fname, WritableFile** result) {
   return Status::NotSupported("NewAppendableFile", fname);
 }
 
+Status Env::ReuseWritableFile(const std::string& fname,
+                              const std::string& old_fname,
+                              WritableFile** result) {
+  Status s = RenameFile(old_fname, fname);
+  if (!s.ok()) {
+    *result = nullptr;
+    return s;
+  }
+  return NewWritableFile(fname, result);
+}
+
+void Env::Schedule(void (*function)(void* arg), void* arg, Priority pri) {
+  Schedule(function, arg);
+}
+
+void Env::SetBackgroundThreads(int num, Priority pri) {}
+
+int Env::GetBackgroundThreads(Priority pri) { return 1; }
+
+unsigned int Env::GetThreadPoolQueueLen(Priority pri) { return 0; }
+
+void Env::GetThreadPoolStats(Priority pri, ThreadPoolStats* stats) {
+  *stats = ThreadPoolStats();
+}
+
+void Env::WaitForJoin() {}
+
 Status Env::RemoveDir(const std::string& dirname) { return DeleteDir(dirname); }
 Status Env::DeleteDir(const std::string& dirname) { return RemoveDir(dirname); }
 
@@ -21,8 +65,30 @@ SequentialFile::~SequentialFile() = default;
 
 RandomAccessFile::~RandomAccessFile() = default;
 
+Status RandomAccessFile::MultiRead(ReadRequest* reqs, size_t num_reqs) const {
+  Status result;
+  for (size_t i = 0; i < num_reqs; i++) {
+    ReadRequest* req = &reqs[i];
+    req->status = Read(req->offset, req->n, &req->result, req->scratch);
+    if (result.ok() && !req->status.ok()) {
+      result = req->status;
+    }
+  }
+  return result;
+}
+
 WritableFile::~WritableFile() = default;
 
+Status WritableFile::AppendV(const Slice* data, size_t n) {
+  Status s;
+  for (size_t i = 0; i < n && s.ok(); i++) {
+    s = Append(data[i]);
+  }
+  return s;
+}
+
+Status WritableFile::Preallocate(uint64_t size) { return Status::OK(); }
+
 Logger::~Logger() = default;
 
 FileLock::~FileLock() = default;
@@ -0,0 +1,628 @@
+#include "env_io_uring.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#endif
+#endif
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+
+#if HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+#include "env.h"
+#include "gather_write.h"
+
+namespace leveldb {
+
+#if HAVE_IO_URING
+
+namespace {
+
+constexpr const size_t kWritableFileBufferSize = 65536;
+
+// 每个线程的 ring 的提交队列长度
+constexpr const unsigned kRingEntries = 64;
+
+Status IoUringError(const std::string& context, int error_number) {
+  if (error_number == ENOENT) {
+    return Status::NotFound(context, std::strerror(error_number));
+  } else {
+    return Status::IOError(context, std::strerror(error_number));
+  }
+}
+
+// 对 io_uring 系统调用的最小封装(不依赖 liburing)。
+// 提交队列(SQ)和完成队列(CQ)都映射到用户态，只有本线程访问，
+// 与内核之间通过 head/tail 上的 acquire/release 同步。
+class IoUring {
+ public:
+  IoUring() : ring_fd_(-1), sq_ptr_(nullptr), cq_ptr_(nullptr), sqes_(nullptr) {}
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  ~IoUring() {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+      ::munmap(cq_ptr_, cq_ring_size_);
+    }
+    if (sq_ptr_ != nullptr) {
+      ::munmap(sq_ptr_, sq_ring_size_);
+    }
+    if (ring_fd_ >= 0) {
+      ::close(ring_fd_);
+    }
+  }
+
+  // 返回当前线程的 ring；io_uring 不可用时返回 nullptr
+  static IoUring* ThreadLocal() {
+    static thread_local std::unique_ptr<IoUring> ring;
+    static thread_local bool initialized = false;
+    if (!initialized) {
+      initialized = true;
+      std::unique_ptr<IoUring> r(new IoUring);
+      if (r->Init(kRingEntries)) {
+        ring = std::move(r);
+      }
+    }
+    return ring.get();
+  }
+
+  unsigned entries() const { return sq_entries_; }
+
+  // 返回一个空闲的 sqe；提交队列已满时返回 nullptr
+  io_uring_sqe* NextSqe() {
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    if (sqe_tail_ - head >= sq_entries_) {
+      return nullptr;
+    }
+    const unsigned index = sqe_tail_ & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    sqe_tail_++;
+    return sqe;
+  }
+
+  // 提交所有已准备好的 sqe，并等待至少 min_complete 个完成事件
+  int Enter(unsigned min_complete) {
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    while (true) {
+      const unsigned to_submit =
+          sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+      const unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+      int ret = static_cast<int>(::syscall(__NR_io_uring_enter, ring_fd_,
+                                           to_submit, min_complete, flags,
+                                           nullptr, 0));
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      return ret < 0 ? errno : 0;
+    }
+  }
+
+  // Enter 失败之后调用，保证返回时 ring 中没有本次调用留下的请求：撤回内核还
+  // 没有取走的 sqe，并等待已经提交的请求全部完成(它们还在读写调用者的缓冲区)，
+  // 丢弃其完成事件，以免之后在同一线程上的调用把它们当作自己的结果。
+  // pending 是本次准备的 sqe 中还没有收割完成事件的个数。
+  void Abandon(unsigned pending) {
+    const unsigned head = __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+    pending -= sqe_tail_ - head;
+    sqe_tail_ = head;
+    __atomic_store_n(sq_tail_, sqe_tail_, __ATOMIC_RELEASE);
+    uint64_t user_data;
+    int32_t res;
+    while (pending > 0) {
+      while (pending > 0 && PopCqe(&user_data, &res)) {
+        pending--;
+      }
+      if (pending > 0) {
+        // 没有要提交的 sqe，只等待完成事件；出错时重试
+        Enter(pending);
+      }
+    }
+  }
+
+  // 取出一个完成事件；没有时返回 false
+  bool PopCqe(uint64_t* user_data, int32_t* res) {
+    const unsigned head = *cq_head_;
+    if (head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    const io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+    *user_data = cqe->user_data;
+    *res = cqe->res;
+    __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  bool Init(unsigned entries) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) {
+      return false;
+    }
+    // IORING_OP_READ/WRITE 与 IORING_FEAT_RW_CUR_POS 同在 5.6 内核加入，用后者判断是否支持前者
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    void* sq = ::mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) {
+      return false;
+    }
+    sq_ptr_ = static_cast<char*>(sq);
+    if (single_mmap) {
+      cq_ptr_ = sq_ptr_;
+    } else {
+      void* cq = ::mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+      if (cq == MAP_FAILED) {
+        return false;
+      }
+      cq_ptr_ = static_cast<char*>(cq);
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    sq_head_ = reinterpret_cast<unsigned*>(sq_ptr_ + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq_ptr_ + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq_ptr_ + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq_ptr_ + params.sq_off.array);
+    cq_head_ = reinterpret_cast<unsigned*>(cq_ptr_ + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq_ptr_ + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq_ptr_ + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq_ptr_ + params.cq_off.cqes);
+    sq_entries_ = params.sq_entries;
+    sqe_tail_ = *sq_tail_;
+    return true;
+  }
+
+  int ring_fd_;
+  char* sq_ptr_;
+  char* cq_ptr_;
+  io_uring_sqe* sqes_;
+  size_t sq_ring_size_;
+  size_t cq_ring_size_;
+  size_t sqes_size_;
+
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned* sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned* cq_mask_;
+  io_uring_cqe* cqes_;
+  unsigned sq_entries_;
+  unsigned sqe_tail_;  // 本地准备好的 sqe 的尾部，Enter 时发布给内核
+};
+
+void PrepRw(io_uring_sqe* sqe, uint8_t op, int fd, const void* addr,
+            unsigned len, uint64_t offset, uint64_t user_data) {
+  sqe->opcode = op;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+}
+
+// 使用 io_uring 读取的随机访问文件。没有可用的 ring 时使用 pread。
+class IoUringRandomAccessFile final : public RandomAccessFile {
+ public:
+  IoUringRandomAccessFile(std::string filename, int fd)
+      : fd_(fd), filename_(std::move(filename)) {}
+
+  ~IoUringRandomAccessFile() override { ::close(fd_); }
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    ReadRequest req;
+    req.offset = offset;
+    req.n = n;
+    req.scratch = scratch;
+    Status status = MultiRead(&req, 1);
+    *result = req.result;
+    return status;
+  }
+
+  Status MultiRead(ReadRequest* reqs, size_t num_reqs) const override {
+    IoUring* ring = IoUring::ThreadLocal();
+    if (ring == nullptr) {
+      return PreadAll(reqs, num_reqs);
+    }
+
+    // 尽可能多地填满提交队列，每次 Enter 提交新请求并至少收割一个完成事件
+    size_t next = 0;
+    size_t done = 0;
+    while (done < num_reqs) {
+      while (next < num_reqs) {
+        ReadRequest* req = &reqs[next];
+        if (req->n > kMaxReadSize) {
+          // sqe 的长度只有 32 位
+          req->result = Slice(req->scratch, 0);
+          req->status = Status::InvalidArgument(filename_, "read too large");
+          next++;
+          done++;
+          continue;
+        }
+        io_uring_sqe* sqe = ring->NextSqe();
+        if (sqe == nullptr) break;
+        PrepRw(sqe, IORING_OP_READ, fd_, req->scratch,
+               static_cast<unsigned>(req->n), req->offset, next);
+        next++;
+      }
+      if (done == num_reqs) {
+        break;
+      }
+      int err = ring->Enter(1);
+      if (err != 0) {
+        // 已经提交的读取还会写入 scratch，等它们完成之后才能返回
+        ring->Abandon(static_cast<unsigned>(next - done));
+        return IoUringError(filename_, err);
+      }
+      uint64_t index;
+      int32_t res;
+      while (ring->PopCqe(&index, &res)) {
+        ReadRequest* req = &reqs[index];
+        if (res < 0) {
+          req->result = Slice(req->scratch, 0);
+          req->status = IoUringError(filename_, -res);
+        } else {
+          // 与 pread 相同，读到文件末尾时返回的数据可能少于 n
+          req->result = Slice(req->scratch, res);
+          req->status = Status::OK();
+        }
+        done++;
+      }
+    }
+
+    for (size_t i = 0; i < num_reqs; i++) {
+      if (!reqs[i].status.ok()) return reqs[i].status;
+    }
+    return Status::OK();
+  }
+
+ private:
+  static constexpr size_t kMaxReadSize = std::numeric_limits<unsigned>::max();
+
+  Status PreadAll(ReadRequest* reqs, size_t num_reqs) const {
+    Status result;
+    for (size_t i = 0; i < num_reqs; i++) {
+      ReadRequest* req = &reqs[i];
+      ssize_t read_size =
+          ::pread(fd_, req->scratch, req->n, static_cast<off_t>(req->offset));
+      req->result = Slice(req->scratch, (read_size < 0) ? 0 : read_size);
+      req->status =
+          (read_size < 0) ? IoUringError(filename_, errno) : Status::OK();
+      if (result.ok() && !req->status.ok()) {
+        result = req->status;
+      }
+    }
+    return result;
+  }
+
+  const int fd_;
+  const std::string filename_;
+};
+
+// 带缓冲的顺序写文件。Append/Flush 与 PosixWritableFile 相同，Sync 时把缓冲区的
+// 写入和 fdatasync 链接在一起，通过一次 io_uring_enter 提交。
+class IoUringWritableFile final : public WritableFile {
+ public:
+  IoUringWritableFile(std::string filename, int fd, uint64_t offset)
+      : pos_(0), fd_(fd), offset_(offset), filename_(std::move(filename)) {}
+
+  ~IoUringWritableFile() override {
+    if (fd_ >= 0) {
+      // Ignoring any potential errors
+      Close();
+    }
+  }
+
+  Status Append(const Slice& data) override {
+    size_t write_size = data.size();
+    const char* write_data = data.data();
+
+    // Fit as much as possible into buffer.
+    size_t copy_size = std::min(write_size, kWritableFileBufferSize - pos_);
+    std::memcpy(buf_ + pos_, write_data, copy_size);
+    write_data += copy_size;
+    write_size -= copy_size;
+    pos_ += copy_size;
+    if (write_size == 0) {
+      return Status::OK();
+    }
+
+    // Can't fit in buffer, so need to do at least one write.
+    Status status = FlushBuffer();
+    if (!status.ok()) {
+      return status;
+    }
+
+    // Small writes go to buffer, large writes are written directly.
+    if (write_size < kWritableFileBufferSize) {
+      std::memcpy(buf_, write_data, write_size);
+      pos_ = write_size;
+      return Status::OK();
+    }
+    return WriteUnbuffered(write_data, write_size);
+  }
+
+  Status AppendV(const Slice* data, size_t n) override {
+    return GatherAppend(
+        data, n, buf_, &pos_, [this](const Slice& s) { return Append(s); },
+        [this](const struct ::iovec* iov, int count) {
+          ssize_t write_result =
+              ::pwritev(fd_, iov, count, static_cast<off_t>(offset_));
+          if (write_result > 0) {
+            offset_ += write_result;
+          }
+          return write_result;
+        },
+        [this](int error_number) {
+          return IoUringError(filename_, error_number);
+        });
+  }
+
+  Status Close() override {
+    Status status = FlushBuffer();
+    const int close_result = ::close(fd_);
+    if (close_result < 0 && status.ok()) {
+      status = IoUringError(filename_, errno);
+    }
+    fd_ = -1;
+    return status;
+  }
+
+  Status Flush() override { return FlushBuffer(); }
+
+  Status Preallocate(uint64_t size) override {
+    if (::fallocate(fd_, 0, 0, static_cast<off_t>(size)) != 0 &&
+        errno != EOPNOTSUPP) {
+      return IoUringError(filename_, errno);
+    }
+    return Status::OK();
+  }
+
+  Status Sync() override {
+    IoUring* ring = IoUring::ThreadLocal();
+    if (ring == nullptr) {
+      Status status = FlushBuffer();
+      if (!status.ok()) {
+        return status;
+      }
+      return SyncFd();
+    }
+
+    // write(buf_) -> fdatasync 链：写入失败或写入不完整时内核会取消后面的 fsync
+    const size_t write_size = pos_;
+    if (write_size > 0) {
+      io_uring_sqe* sqe = ring->NextSqe();
+      assert(sqe != nullptr);
+      PrepRw(sqe, IORING_OP_WRITE, fd_, buf_, static_cast<unsigned>(write_size),
+             offset_, kWriteTag);
+      sqe->flags |= IOSQE_IO_LINK;
+    }
+    io_uring_sqe* sqe = ring->NextSqe();
+    assert(sqe != nullptr);
+    PrepRw(sqe, IORING_OP_FSYNC, fd_, nullptr, 0, 0, kFsyncTag);
+    sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+
+    const unsigned expected = write_size > 0 ? 2 : 1;
+    unsigned completed = 0;
+    int32_t write_res = 0;
+    int32_t fsync_res = 0;
+    while (completed < expected) {
+      int err = ring->Enter(expected - completed);
+      if (err != 0) {
+        // 写入可能还在读 buf_；缓冲区不变，之后重试时在 offset_ 处重写
+        ring->Abandon(expected - completed);
+        return IoUringError(filename_, err);
+      }
+      uint64_t tag;
+      int32_t res;
+      while (ring->PopCqe(&tag, &res)) {
+        (tag == kWriteTag ? write_res : fsync_res) = res;
+        completed++;
+      }
+    }
+
+    if (write_size > 0) {
+      if (write_res < 0) {
+        return IoUringError(filename_, -write_res);
+      }
+      offset_ += write_res;
+      pos_ = 0;
+      if (static_cast<size_t>(write_res) < write_size) {
+        // 写入不完整，fsync 已被取消：同步写完剩余部分后再刷盘
+        Status status = WriteUnbuffered(buf_ + write_res, write_size - write_res);
+        if (!status.ok()) {
+          return status;
+        }
+        return SyncFd();
+      }
+    }
+    if (fsync_res < 0) {
+      return IoUringError(filename_, -fsync_res);
+    }
+    return Status::OK();
+  }
+
+ private:
+  static constexpr uint64_t kWriteTag = 1;
+  static constexpr uint64_t kFsyncTag = 2;
+
+  Status FlushBuffer() {
+    Status status = WriteUnbuffered(buf_, pos_);
+    pos_ = 0;
+    return status;
+  }
+
+  Status WriteUnbuffered(const char* data, size_t size) {
+    while (size > 0) {
+      ssize_t write_result =
+          ::pwrite(fd_, data, size, static_cast<off_t>(offset_));
+      if (write_result < 0) {
+        if (errno == EINTR) {
+          continue;  // Retry
+        }
+        return IoUringError(filename_, errno);
+      }
+      data += write_result;
+      size -= write_result;
+      offset_ += write_result;
+    }
+    return Status::OK();
+  }
+
+  Status SyncFd() {
+    if (::fdatasync(fd_) == 0) {
+      return Status::OK();
+    }
+    return IoUringError(filename_, errno);
+  }
+
+  // buf_[0, pos_ - 1] contains data to be written to fd_ at offset_.
+  char buf_[kWritableFileBufferSize];
+  size_t pos_;
+  int fd_;
+  uint64_t offset_;  // 下一次写入在文件中的偏移
+  const std::string filename_;
+};
+
+bool IsManifest(const std::string& filename) {
+  std::string::size_type separator_pos = filename.rfind('/');
+  Slice basename(filename);
+  if (separator_pos != std::string::npos) {
+    basename.remove_prefix(separator_pos + 1);
+  }
+  return basename.starts_with("MANIFEST");
+}
+
+class IoUringEnv : public EnvWrapper {
+ public:
+  explicit IoUringEnv(Env* base_env)
+      : EnvWrapper(base_env), available_(IoUringAvailable()) {}
+
+  Status NewRandomAccessFile(const std::string& filename,
+                             RandomAccessFile** result) override {
+    if (!available_) {
+      return target()->NewRandomAccessFile(filename, result);
+    }
+    *result = nullptr;
+    int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return IoUringError(filename, errno);
+    }
+    *result = new IoUringRandomAccessFile(filename, fd);
+    return Status::OK();
+  }
+
+  Status NewWritableFile(const std::string& filename,
+                         WritableFile** result) override {
+    if (!available_ || IsManifest(filename)) {
+      return target()->NewWritableFile(filename, result);
+    }
+    return OpenWritable(filename, O_TRUNC, result);
+  }
+
+  Status NewAppendableFile(const std::string& filename,
+                           WritableFile** result) override {
+    if (!available_ || IsManifest(filename)) {
+      return target()->NewAppendableFile(filename, result);
+    }
+    return OpenWritable(filename, 0, result);
+  }
+
+  Status ReuseWritableFile(const std::string& filename,
+                           const std::string& old_filename,
+                           WritableFile** result) override {
+    if (!available_ || IsManifest(filename)) {
+      return target()->ReuseWritableFile(filename, old_filename, result);
+    }
+    *result = nullptr;
+    Status status = target()->RenameFile(old_filename, filename);
+    if (!status.ok()) {
+      return status;
+    }
+    // 从文件开头覆盖写入
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return IoUringError(filename, errno);
+    }
+    *result = new IoUringWritableFile(filename, fd, 0);
+    return Status::OK();
+  }
+
+ private:
+  // 不使用 O_APPEND，写入位置由文件自己维护，这样写入可以带 offset 提交给 io_uring
+  Status OpenWritable(const std::string& filename, int flags,
+                      WritableFile** result) {
+    *result = nullptr;
+    int fd = ::open(filename.c_str(), flags | O_WRONLY | O_CREAT | O_CLOEXEC,
+                    0644);
+    if (fd < 0) {
+      return IoUringError(filename, errno);
+    }
+    struct ::stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+      Status status = IoUringError(filename, errno);
+      ::close(fd);
+      return status;
+    }
+    *result = new IoUringWritableFile(filename, fd, file_stat.st_size);
+    return Status::OK();
+  }
+
+  const bool available_;
+};
+
+}  // namespace
+
+bool IoUringAvailable() { return IoUring::ThreadLocal() != nullptr; }
+
+Env* NewIoUringEnv(Env* base_env) { return new IoUringEnv(base_env); }
+
+#else  // HAVE_IO_URING
+
+bool IoUringAvailable() { return false; }
+
+Env* NewIoUringEnv(Env* base_env) { return new EnvWrapper(base_env); }
+
+#endif  // HAVE_IO_URING
+
+}  // namespace leveldb
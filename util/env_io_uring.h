@@ -0,0 +1,24 @@
+#ifndef STORAGE_LEVELDB_UTIL_ENV_IO_URING_H_
+#define STORAGE_LEVELDB_UTIL_ENV_IO_URING_H_
+
+namespace leveldb {
+
+class Env;
+
+// 返回当前内核是否支持 io_uring(且本进程有权限使用)。
+bool IoUringAvailable();
+
+// 返回一个使用 io_uring 做随机读、追加写和 sync 的 Env，其余操作转发给 base_env。
+//  - RandomAccessFile::MultiRead 把所有读请求一次提交，只等待一次系统调用；
+//  - WritableFile::Sync 把缓冲区的写入和 fdatasync 作为一条链接(IOSQE_IO_LINK)
+//    的请求链提交，一次 io_uring_enter 完成写入和刷盘。
+// 每个线程使用自己的 ring，不需要为每个未完成的 I/O 占用一个线程。
+// io_uring 不可用时(内核太旧、被 seccomp 禁止等)所有操作都退回到 base_env。
+// MANIFEST 文件总是由 base_env 打开，以保留其 sync 目录的语义。
+//
+// 调用者负责 delete 返回的 Env，base_env 的生命期不能短于返回的 Env。
+Env* NewIoUringEnv(Env* base_env);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_ENV_IO_URING_H_
@@ -1,3 +1,8 @@
+// Linux 上用 fdatasync 同步文件：只有文件大小等影响读取的元数据变化时才写 inode
+#if defined(__linux__) && !defined(HAVE_FDATASYNC)
+#define HAVE_FDATASYNC 1
+#endif
+
 #include <dirent.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -7,8 +12,10 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cerrno>
 #include <cstddef>
@@ -17,19 +24,22 @@
 #include <cstdlib>
 #include <cstring>
 #include <limits>
-#include <queue>
+#include <memory>
 #include <set>
 #include <string>
 #include <thread>
 #include <type_traits>
 #include <utility>
 
+#include "aligned_buffer.h"
 #include "mutex.h"
 #include "env.h"
 #include "slice.h"
 #include "status.h"
 #include "env_posix_test_helper.h"
+#include "gather_write.h"
 #include "posix_logger.h"
+#include "thread_pool.h"
 
 namespace leveldb {
 
@@ -53,6 +63,13 @@ constexpr const int kOpenBaseFlags = 0;
 
 constexpr const size_t kWritableFileBufferSize = 65536;
 
+// PosixRandomAccessFile 以 O_DIRECT 读取时每个线程保留的对齐缓冲区的上限，
+// 更大的读取临时分配
+constexpr const size_t kMaxThreadReadBufferSize = 1024 * 1024;
+
+// PosixDirectWritableFile 的对齐缓冲区大小，写满后整块写入
+constexpr const size_t kDirectWritableFileBufferSize = 1024 * 1024;
+
 Status PosixError(const std::string& context, int error_number) {
   if (error_number == ENOENT) {
     return Status::NotFound(context, std::strerror(error_number));
@@ -151,15 +168,89 @@ class PosixSequentialFile final : public SequentialFile {
   const std::string filename_;
 };
 
+// 使用 mmap() 顺序读取文件，Read() 返回的 Slice 直接指向映射的内存。
+// 读过的部分每累积 kDropBytes 字节就从映射中移除(MADV_DONTNEED)并通知内核
+// 丢弃对应的页缓存(POSIX_FADV_DONTNEED)，读一遍大文件不会挤掉其它热数据。
+class PosixMmapSequentialFile final : public SequentialFile {
+ public:
+  // mmap_base[0, length-1] 指向文件的内存映射内容。 它必须是成功调用 mmap() 的结果。
+  // 此实例接管该区域以及 fd 的所有权。
+  PosixMmapSequentialFile(std::string filename, int fd, char* mmap_base,
+                          size_t length, Limiter* mmap_limiter)
+      : fd_(fd),
+        mmap_base_(mmap_base),
+        length_(length),
+        offset_(0),
+        unmapped_(0),
+        uncached_(0),
+        mmap_limiter_(mmap_limiter),
+        filename_(std::move(filename)) {
+    ::madvise(mmap_base_, length_, MADV_SEQUENTIAL);
+  }
+
+  ~PosixMmapSequentialFile() override {
+    ::munmap(static_cast<void*>(mmap_base_), length_);
+    // 映射已经完全移除，读过的部分都可以丢弃
+    ::posix_fadvise(fd_, uncached_, offset_ - uncached_, POSIX_FADV_DONTNEED);
+    ::close(fd_);
+    mmap_limiter_->Release();
+  }
+
+  Status Read(size_t n, Slice* result, char* scratch) override {
+    // 上一次 Read 返回的数据到这里失效
+    DropConsumedPages();
+    n = std::min(n, length_ - offset_);
+    *result = Slice(mmap_base_ + offset_, n);
+    offset_ += n;
+    return Status::OK();
+  }
+
+  Status Skip(uint64_t n) override {
+    offset_ += std::min<uint64_t>(n, length_ - offset_);
+    return Status::OK();
+  }
+
+ private:
+  static const size_t kDropBytes = 1 << 20;
+
+  void DropConsumedPages() {
+    static const size_t kPageSize = ::sysconf(_SC_PAGESIZE);
+    const size_t end = offset_ - offset_ % kPageSize;
+    if (end - unmapped_ < kDropBytes) {
+      return;
+    }
+    // MAP_SHARED 的文件映射被移出之后再访问会重新从文件读入，不影响正确性
+    ::madvise(mmap_base_ + unmapped_, end - unmapped_, MADV_DONTNEED);
+    // 刚移出映射的页可能还没有回到 LRU 链表上，这一次丢弃不掉，
+    // 所以每次都把上一批再丢弃一遍
+    ::posix_fadvise(fd_, uncached_, end - uncached_, POSIX_FADV_DONTNEED);
+    uncached_ = unmapped_;
+    unmapped_ = end;
+  }
+
+  const int fd_;
+  char* const mmap_base_;
+  const size_t length_;
+  size_t offset_;    // 下一次 Read 的位置
+  size_t unmapped_;  // [0, unmapped_) 已经移出映射，总是页对齐
+  size_t uncached_;  // [0, uncached_) 已经确认丢弃了页缓存
+  Limiter* const mmap_limiter_;
+  const std::string filename_;
+};
+
 // 使用 pread() 在文件中实现随机读取访问。
 // 根据 RandomAccessFile API 的要求，此类的实例是线程安全的。 实例是不可变的，Read() 只调用线程安全的库函数。
+// open_flags 为 O_DIRECT 时(fd 也必须以 O_DIRECT 打开)，每次读取按 kDirectIOAlignment
+// 对齐读入线程的对齐缓冲区，再拷贝到 scratch。
 class PosixRandomAccessFile final : public RandomAccessFile {
  public:
   // The new instance takes ownership of |fd|. |fd_limiter| must outlive this
   // instance, and will be used to determine if .
-  PosixRandomAccessFile(std::string filename, int fd, Limiter* fd_limiter)
+  PosixRandomAccessFile(std::string filename, int fd, Limiter* fd_limiter,
+                        int open_flags = 0)
       : has_permanent_fd_(fd_limiter->Acquire()),
         fd_(has_permanent_fd_ ? fd : -1),
+        open_flags_(open_flags),
         fd_limiter_(fd_limiter),
         filename_(std::move(filename)) {
     if (!has_permanent_fd_) {
@@ -180,7 +271,7 @@ class PosixRandomAccessFile final : public RandomAccessFile {
               char* scratch) const override {
     int fd = fd_;
     if (!has_permanent_fd_) {
-      fd = ::open(filename_.c_str(), O_RDONLY | kOpenBaseFlags);
+      fd = ::open(filename_.c_str(), O_RDONLY | open_flags_ | kOpenBaseFlags);
       if (fd < 0) {
         return PosixError(filename_, errno);
       }
@@ -189,7 +280,9 @@ class PosixRandomAccessFile final : public RandomAccessFile {
     assert(fd != -1);
 
     Status status;
-    ssize_t read_size = ::pread(fd, scratch, n, static_cast<off_t>(offset));
+    ssize_t read_size = (open_flags_ == 0)
+                            ? ::pread(fd, scratch, n, static_cast<off_t>(offset))
+                            : ReadAligned(fd, offset, n, scratch);
     *result = Slice(scratch, (read_size < 0) ? 0 : read_size);
     if (read_size < 0) {
       // An error: return a non-ok status.
@@ -204,8 +297,53 @@ class PosixRandomAccessFile final : public RandomAccessFile {
   }
 
  private:
+  // 把 [offset, offset + n) 扩展到对齐的范围读入，返回值同 pread。
+  // offset、n 和 scratch 都已经对齐时(例如预读)直接读入 scratch；否则经过
+  // 线程的对齐缓冲区中转，缓冲区在线程内复用，只在不够大时重新分配。
+  static ssize_t ReadAligned(int fd, uint64_t offset, size_t n, char* scratch) {
+    if (IsAligned(offset) && IsAligned(n) &&
+        IsAligned(reinterpret_cast<uintptr_t>(scratch))) {
+      return ::pread(fd, scratch, n, static_cast<off_t>(offset));
+    }
+    const uint64_t aligned_offset =
+        TruncateToAlignment(offset, kDirectIOAlignment);
+    const size_t skip = static_cast<size_t>(offset - aligned_offset);
+    const size_t read_size_aligned =
+        static_cast<size_t>(RoundUpToAlignment(skip + n, kDirectIOAlignment));
+    std::unique_ptr<AlignedBuffer> oversized;
+    AlignedBuffer* buf;
+    if (read_size_aligned <= kMaxThreadReadBufferSize) {
+      static thread_local std::unique_ptr<AlignedBuffer> thread_buf;
+      if (thread_buf == nullptr || thread_buf->capacity() < read_size_aligned) {
+        thread_buf.reset(
+            new AlignedBuffer(kDirectIOAlignment, read_size_aligned));
+      }
+      buf = thread_buf.get();
+    } else {
+      // 很少见的大读取不占用线程的缓冲区
+      oversized.reset(new AlignedBuffer(kDirectIOAlignment, read_size_aligned));
+      buf = oversized.get();
+    }
+    ssize_t read_size = ::pread(fd, buf->data(), read_size_aligned,
+                                static_cast<off_t>(aligned_offset));
+    if (read_size < 0) {
+      return read_size;
+    }
+    // 读到文件尾时可能少于 skip + n
+    const size_t available =
+        static_cast<size_t>(read_size) > skip ? read_size - skip : 0;
+    const size_t copy_size = std::min(available, n);
+    std::memcpy(scratch, buf->data() + skip, copy_size);
+    return static_cast<ssize_t>(copy_size);
+  }
+
+  static bool IsAligned(uint64_t n) {
+    return TruncateToAlignment(n, kDirectIOAlignment) == n;
+  }
+
   const bool has_permanent_fd_;  // 如果为 false，则在每次读取时打开文件。
   const int fd_;                 // -1 if has_permanent_fd_ is false.
+  const int open_flags_;         // 0 或者 O_DIRECT，每次读取时打开文件也使用它
   Limiter* const fd_limiter_;
   const std::string filename_;
 };
@@ -290,6 +428,17 @@ class PosixWritableFile final : public WritableFile {
     return WriteUnbuffered(write_data, write_size);
   }
 
+  Status AppendV(const Slice* data, size_t n) override {
+    return GatherAppend(
+        data, n, buf_, &pos_, [this](const Slice& s) { return Append(s); },
+        [this](const struct ::iovec* iov, int count) {
+          return ::writev(fd_, iov, count);
+        },
+        [this](int error_number) {
+          return PosixError(filename_, error_number);
+        });
+  }
+
   Status Close() override {
     Status status = FlushBuffer();
     const int close_result = ::close(fd_);
@@ -302,6 +451,17 @@ class PosixWritableFile final : public WritableFile {
 
   Status Flush() override { return FlushBuffer(); }
 
+  Status Preallocate(uint64_t size) override {
+#if defined(__linux__)
+    // mode 0：同时增大文件大小，预分配的块标记为未写入，读出为 0
+    if (::fallocate(fd_, 0, 0, static_cast<off_t>(size)) != 0 &&
+        errno != EOPNOTSUPP) {
+      return PosixError(filename_, errno);
+    }
+#endif  // defined(__linux__)
+    return Status::OK();
+  }
+
   Status Sync() override {
     // Ensure new files referred to by the manifest are in the filesystem.
     //
@@ -321,6 +481,19 @@ class PosixWritableFile final : public WritableFile {
     return SyncFd(fd_, filename_);
   }
 
+  // 持久化目录 dirname 中的目录项，供 PosixEnv::SyncDir 使用
+  static Status SyncDir(const std::string& dirname) {
+    Status status;
+    int fd = ::open(dirname.c_str(), O_RDONLY | kOpenBaseFlags);
+    if (fd < 0) {
+      status = PosixError(dirname, errno);
+    } else {
+      status = SyncFd(fd, dirname);
+      ::close(fd);
+    }
+    return status;
+  }
+
  private:
   Status FlushBuffer() {
     Status status = WriteUnbuffered(buf_, pos_);
@@ -344,19 +517,10 @@ class PosixWritableFile final : public WritableFile {
   }
 
   Status SyncDirIfManifest() {
-    Status status;
     if (!is_manifest_) {
-      return status;
-    }
-
-    int fd = ::open(dirname_.c_str(), O_RDONLY | kOpenBaseFlags);
-    if (fd < 0) {
-      status = PosixError(dirname_, errno);
-    } else {
-      status = SyncFd(fd, dirname_);
-      ::close(fd);
+      return Status::OK();
     }
-    return status;
+    return SyncDir(dirname_);
   }
 
   // Ensures that all the caches associated with the given file descriptor's
@@ -435,6 +599,124 @@ class PosixWritableFile final : public WritableFile {
   const std::string dirname_;  // The directory of filename_.
 };
 
+#if defined(O_DIRECT)
+// 以 O_DIRECT 打开的文件顺序写入，见 Env::NewDirectWritableFile。
+// 每次写入的地址、文件偏移和长度都按 kDirectIOAlignment 对齐：缓冲区写满时
+// 整块写入；Sync 和 Close 时把不足一个对齐块的尾部补 0 写入，再截断文件，
+// 这个尾部留在缓冲区开头，之后的写入会连同新数据把它所在的块重写一遍。
+class PosixDirectWritableFile final : public WritableFile {
+ public:
+  PosixDirectWritableFile(std::string filename, int fd)
+      : buf_(kDirectIOAlignment, kDirectWritableFileBufferSize),
+        pos_(0),
+        offset_(0),
+        fd_(fd),
+        filename_(std::move(filename)) {}
+
+  ~PosixDirectWritableFile() override {
+    if (fd_ >= 0) {
+      // Ignoring any potential errors
+      Close();
+    }
+  }
+
+  Status Append(const Slice& data) override {
+    const char* write_data = data.data();
+    size_t write_size = data.size();
+    while (write_size > 0) {
+      const size_t copy_size = std::min(write_size, buf_.capacity() - pos_);
+      std::memcpy(buf_.data() + pos_, write_data, copy_size);
+      write_data += copy_size;
+      write_size -= copy_size;
+      pos_ += copy_size;
+      if (pos_ == buf_.capacity()) {
+        Status status = WriteAligned(buf_.data(), pos_);
+        if (!status.ok()) {
+          return status;
+        }
+        offset_ += pos_;
+        pos_ = 0;
+      }
+    }
+    return Status::OK();
+  }
+
+  Status Close() override {
+    Status status = WriteTail();
+    const int close_result = ::close(fd_);
+    if (close_result < 0 && status.ok()) {
+      status = PosixError(filename_, errno);
+    }
+    fd_ = -1;
+    return status;
+  }
+
+  // 不足一个对齐块的数据不能单独写入，留在缓冲区中
+  Status Flush() override { return Status::OK(); }
+
+  Status Sync() override {
+    Status status = WriteTail();
+    if (!status.ok()) {
+      return status;
+    }
+    if (::fdatasync(fd_) != 0) {
+      return PosixError(filename_, errno);
+    }
+    return Status::OK();
+  }
+
+ private:
+  // 在 offset_ 处写入 data[0, size)，size 是 kDirectIOAlignment 的整数倍
+  Status WriteAligned(const char* data, size_t size) {
+    uint64_t offset = offset_;
+    while (size > 0) {
+      ssize_t write_result =
+          ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+      if (write_result < 0) {
+        if (errno == EINTR) {
+          continue;  // Retry
+        }
+        return PosixError(filename_, errno);
+      }
+      data += write_result;
+      size -= write_result;
+      offset += write_result;
+    }
+    return Status::OK();
+  }
+
+  // 写入缓冲区中的全部数据(尾部补 0 到对齐)，把文件截断到实际大小，
+  // 然后只在缓冲区中保留最后一个不完整的块
+  Status WriteTail() {
+    if (pos_ == 0) {
+      return Status::OK();
+    }
+    const size_t write_size =
+        static_cast<size_t>(RoundUpToAlignment(pos_, kDirectIOAlignment));
+    std::memset(buf_.data() + pos_, 0, write_size - pos_);
+    Status status = WriteAligned(buf_.data(), write_size);
+    if (!status.ok()) {
+      return status;
+    }
+    if (::ftruncate(fd_, static_cast<off_t>(offset_ + pos_)) != 0) {
+      return PosixError(filename_, errno);
+    }
+    const size_t full =
+        static_cast<size_t>(TruncateToAlignment(pos_, kDirectIOAlignment));
+    std::memmove(buf_.data(), buf_.data() + full, pos_ - full);
+    offset_ += full;
+    pos_ -= full;
+    return Status::OK();
+  }
+
+  AlignedBuffer buf_;
+  size_t pos_;       // buf_[0, pos_ - 1] 是要写到文件 offset_ 处的数据
+  uint64_t offset_;  // buf_ 在文件中的偏移，总是对齐的
+  int fd_;
+  const std::string filename_;
+};
+#endif  // defined(O_DIRECT)
+
 int LockOrUnlock(int fd, bool lock) {
   errno = 0;
   struct ::flock file_lock_info;
@@ -503,6 +785,36 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  Status NewMmapSequentialFile(const std::string& filename,
+                               SequentialFile** result) override {
+    *result = nullptr;
+    int fd = ::open(filename.c_str(), O_RDONLY | kOpenBaseFlags);
+    if (fd < 0) {
+      return PosixError(filename, errno);
+    }
+
+    // 空文件不能映射，映射数达到上限时也退回到普通的顺序读
+    uint64_t file_size;
+    Status status = GetFileSize(filename, &file_size);
+    if (!status.ok() || file_size == 0 || !mmap_limiter_.Acquire()) {
+      ::close(fd);
+      return status.ok() ? NewSequentialFile(filename, result) : status;
+    }
+
+    void* mmap_base =
+        ::mmap(/*addr=*/nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mmap_base == MAP_FAILED) {
+      status = PosixError(filename, errno);
+      ::close(fd);
+      mmap_limiter_.Release();
+      return status;
+    }
+    *result = new PosixMmapSequentialFile(filename, fd,
+                                          reinterpret_cast<char*>(mmap_base),
+                                          file_size, &mmap_limiter_);
+    return Status::OK();
+  }
+
   Status NewRandomAccessFile(const std::string& filename,
                              RandomAccessFile** result) override {
     *result = nullptr;
@@ -549,6 +861,40 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+#if defined(O_DIRECT)
+  Status NewDirectRandomAccessFile(const std::string& filename,
+                                   RandomAccessFile** result) override {
+    *result = nullptr;
+    int fd = ::open(filename.c_str(), O_RDONLY | O_DIRECT | kOpenBaseFlags);
+    if (fd < 0) {
+      if (errno == EINVAL) {
+        // 文件系统不支持 O_DIRECT(例如 tmpfs)
+        return NewRandomAccessFile(filename, result);
+      }
+      return PosixError(filename, errno);
+    }
+    *result = new PosixRandomAccessFile(filename, fd, &fd_limiter_, O_DIRECT);
+    return Status::OK();
+  }
+
+  Status NewDirectWritableFile(const std::string& filename,
+                               WritableFile** result) override {
+    int fd = ::open(filename.c_str(),
+                    O_TRUNC | O_WRONLY | O_CREAT | O_DIRECT | kOpenBaseFlags,
+                    0644);
+    if (fd < 0) {
+      if (errno == EINVAL) {
+        return NewWritableFile(filename, result);
+      }
+      *result = nullptr;
+      return PosixError(filename, errno);
+    }
+
+    *result = new PosixDirectWritableFile(filename, fd);
+    return Status::OK();
+  }
+#endif  // defined(O_DIRECT)
+
   Status NewAppendableFile(const std::string& filename,
                            WritableFile** result) override {
     int fd = ::open(filename.c_str(),
@@ -562,6 +908,24 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  Status ReuseWritableFile(const std::string& filename,
+                           const std::string& old_filename,
+                           WritableFile** result) override {
+    *result = nullptr;
+    Status status = RenameFile(old_filename, filename);
+    if (!status.ok()) {
+      return status;
+    }
+    // 不截断也不追加，从文件开头覆盖写入
+    int fd = ::open(filename.c_str(), O_WRONLY | kOpenBaseFlags);
+    if (fd < 0) {
+      return PosixError(filename, errno);
+    }
+
+    *result = new PosixWritableFile(filename, fd);
+    return Status::OK();
+  }
+
   bool FileExists(const std::string& filename) override {
     return ::access(filename.c_str(), F_OK) == 0;
   }
@@ -619,6 +983,10 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  Status SyncDir(const std::string& dirname) override {
+    return PosixWritableFile::SyncDir(dirname);
+  }
+
   Status LockFile(const std::string& filename, FileLock** lock) override {
     *lock = nullptr;
 
@@ -654,9 +1022,35 @@ class PosixEnv : public Env {
     return Status::OK();
   }
 
+  // 放入 LOW 优先级的线程池
   void Schedule(void (*background_work_function)(void* background_work_arg),
                 void* background_work_arg) override;
 
+  void Schedule(void (*background_work_function)(void* background_work_arg),
+                void* background_work_arg, Priority pri) override;
+
+  void SetBackgroundThreads(int num, Priority pri) override {
+    assert(pri >= Priority::LOW && pri < Priority::TOTAL);
+    thread_pools_[pri].SetBackgroundThreads(num);
+  }
+
+  int GetBackgroundThreads(Priority pri) override {
+    assert(pri >= Priority::LOW && pri < Priority::TOTAL);
+    return thread_pools_[pri].GetBackgroundThreads();
+  }
+
+  unsigned int GetThreadPoolQueueLen(Priority pri) override {
+    assert(pri >= Priority::LOW && pri < Priority::TOTAL);
+    return thread_pools_[pri].GetQueueLen();
+  }
+
+  void GetThreadPoolStats(Priority pri, ThreadPoolStats* stats) override {
+    assert(pri >= Priority::LOW && pri < Priority::TOTAL);
+    thread_pools_[pri].GetStats(stats);
+  }
+
+  void WaitForJoin() override;
+
   void StartThread(void (*thread_main)(void* thread_main_arg),
                    void* thread_main_arg) override {
     std::thread new_thread(thread_main, thread_main_arg);
@@ -711,26 +1105,7 @@ class PosixEnv : public Env {
   }
 
  private:
-  void BackgroundThreadMain();
-
-  static void BackgroundThreadEntryPoint(PosixEnv* env) {
-    env->BackgroundThreadMain();
-  }
-
-  // 在 Schedule() 调用中存储工作项数据。
-  struct BackgroundWorkItem {
-    explicit BackgroundWorkItem(void (*function)(void* arg), void* arg)
-        : function(function), arg(arg) {}
-
-    void (*const function)(void*);
-    void* const arg;
-  };
-
-  Mutex background_work_mutex_;
-  CondVar background_work_cv_;
-  bool started_background_thread_;
-
-  std::queue<BackgroundWorkItem> background_work_queue_;
+  ThreadPool thread_pools_[Priority::TOTAL];  // 每个优先级一个线程池，Thread-safe.
 
   PosixLockTable locks_;  // Thread-safe.
   Limiter mmap_limiter_;  // Thread-safe.
@@ -766,48 +1141,25 @@ int MaxOpenFiles() {
 }  // namespace
 
 PosixEnv::PosixEnv()
-    : background_work_cv_(&background_work_mutex_),
-      started_background_thread_(false),
-      mmap_limiter_(MaxMmaps()),
+    : mmap_limiter_(MaxMmaps()),
       fd_limiter_(MaxOpenFiles()) {}
 
 void PosixEnv::Schedule(
     void (*background_work_function)(void* background_work_arg),
     void* background_work_arg) {
-  background_work_mutex_.Lock();
-
-  // Start the background thread, if we haven't done so already.
-  if (!started_background_thread_) {
-    started_background_thread_ = true;
-    std::thread background_thread(PosixEnv::BackgroundThreadEntryPoint, this);
-    background_thread.detach();
-  }
-
-  // If the queue is empty, the background thread may be waiting for work.
-  if (background_work_queue_.empty()) {
-    background_work_cv_.Signal();
-  }
-
-  background_work_queue_.emplace(background_work_function, background_work_arg);
-  background_work_mutex_.Unlock();
+  Schedule(background_work_function, background_work_arg, Priority::LOW);
 }
 
-void PosixEnv::BackgroundThreadMain() {
-  while (true) {
-    background_work_mutex_.Lock();
-
-    // Wait until there is work to be done.
-    while (background_work_queue_.empty()) {
-      background_work_cv_.Wait();
-    }
-
-    assert(!background_work_queue_.empty());
-    auto background_work_function = background_work_queue_.front().function;
-    void* background_work_arg = background_work_queue_.front().arg;
-    background_work_queue_.pop();
+void PosixEnv::Schedule(
+    void (*background_work_function)(void* background_work_arg),
+    void* background_work_arg, Priority pri) {
+  assert(pri >= Priority::LOW && pri < Priority::TOTAL);
+  thread_pools_[pri].Schedule(background_work_function, background_work_arg);
+}
 
-    background_work_mutex_.Unlock();
-    background_work_function(background_work_arg);
+void PosixEnv::WaitForJoin() {
+  for (ThreadPool& pool : thread_pools_) {
+    pool.JoinAllThreads(true);
   }
 }
 
@@ -0,0 +1,103 @@
+#ifndef STORAGE_LEVELDB_UTIL_GATHER_WRITE_H_
+#define STORAGE_LEVELDB_UTIL_GATHER_WRITE_H_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+
+#include "slice.h"
+#include "status.h"
+
+namespace leveldb {
+
+// 带缓冲的 WritableFile(PosixWritableFile、IoUringWritableFile)实现 AppendV 的
+// 公共部分，两者只在系统调用(writev / pwritev)和错误的表示上不同。
+
+// AppendV 中总长度不小于该值的写入不拷贝到缓冲区，和缓冲区中已有的数据一起
+// 通过一次 writev 写入
+constexpr const size_t kGatherWriteSize = 4096;
+
+// 一次 writev 最多提交的 iovec 数(系统的上限 IOV_MAX)。GatherAppend 中
+// 更多的 Slice 分成多次 writev 写入
+#if defined(IOV_MAX)
+constexpr const int kGatherWriteMaxIov = IOV_MAX;
+#else
+constexpr const int kGatherWriteMaxIov = 1024;
+#endif
+
+// 写入 iov[0, count)，写入不完整或被信号中断时从中断的位置继续。会修改 iov。
+// write_v(const iovec*, int) 包装 writev 或 pwritev，返回写入的字节数，出错时返回 -1 并设置 errno，
+// 需要时由它自己推进文件偏移。error(int errno) 把错误转换为 Status。
+template <typename WriteV, typename Error>
+Status WriteFullyV(struct ::iovec* iov, int count, WriteV write_v, Error error) {
+  while (count > 0) {
+    ssize_t write_result = write_v(iov, count);
+    if (write_result < 0) {
+      if (errno == EINTR) {
+        continue;  // Retry
+      }
+      return error(errno);
+    }
+    size_t written = static_cast<size_t>(write_result);
+    while (count > 0 && written >= iov->iov_len) {
+      written -= iov->iov_len;
+      iov++;
+      count--;
+    }
+    if (count > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+      iov->iov_len -= written;
+    }
+  }
+  return Status::OK();
+}
+
+// WritableFile::AppendV：小的写入对每个 Slice 调用 append(拷贝到缓冲区，之后
+// 合并写入)；大的写入不拷贝，缓冲区中的 buf[0, *pos) 和 data 一起通过
+// WriteFullyV 写入，并清空缓冲区。
+template <typename Append, typename WriteV, typename Error>
+Status GatherAppend(const Slice* data, size_t n, char* buf, size_t* pos,
+                    Append append, WriteV write_v, Error error) {
+  size_t total = 0;
+  for (size_t i = 0; i < n; i++) {
+    total += data[i].size();
+  }
+  if (total < kGatherWriteSize) {
+    for (size_t i = 0; i < n; i++) {
+      Status status = append(data[i]);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return Status::OK();
+  }
+
+  struct ::iovec iov[kGatherWriteMaxIov];
+  int count = 0;
+  if (*pos > 0) {
+    iov[count].iov_base = buf;
+    iov[count].iov_len = *pos;
+    count++;
+    *pos = 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    if (count == kGatherWriteMaxIov) {
+      Status status = WriteFullyV(iov, count, write_v, error);
+      if (!status.ok()) {
+        return status;
+      }
+      count = 0;
+    }
+    iov[count].iov_base = const_cast<char*>(data[i].data());
+    iov[count].iov_len = data[i].size();
+    count++;
+  }
+  return WriteFullyV(iov, count, write_v, error);
+}
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_GATHER_WRITE_H_
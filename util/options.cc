@@ -0,0 +1,10 @@
+#include "options.h"
+
+#include "comparator.h"
+#include "env.h"
+
+namespace leveldb {
+
+Options::Options() : comparator(BytewiseComparator()), env(Env::Default()) {}
+
+}  // namespace leveldb
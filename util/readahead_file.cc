@@ -0,0 +1,74 @@
+#include "readahead_file.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "aligned_buffer.h"
+#include "env.h"
+
+namespace leveldb {
+
+namespace {
+
+class ReadaheadRandomAccessFile final : public RandomAccessFile {
+ public:
+  ReadaheadRandomAccessFile(RandomAccessFile* file, size_t readahead_size)
+      : file_(file),
+        buf_(kDirectIOAlignment, readahead_size),
+        buf_offset_(0),
+        buf_len_(0) {}
+
+  ~ReadaheadRandomAccessFile() override = default;
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override {
+    if (!InBuffer(offset, n)) {
+      const uint64_t aligned_offset =
+          TruncateToAlignment(offset, kDirectIOAlignment);
+      if (offset + n - aligned_offset > buf_.capacity()) {
+        return file_->Read(offset, n, result, scratch);
+      }
+      Slice data;
+      buf_len_ = 0;
+      Status s = file_->Read(aligned_offset, buf_.capacity(), &data,
+                             buf_.data());
+      if (!s.ok()) {
+        *result = Slice(scratch, 0);
+        return s;
+      }
+      if (data.data() != buf_.data()) {
+        std::memcpy(buf_.data(), data.data(), data.size());
+      }
+      buf_offset_ = aligned_offset;
+      buf_len_ = data.size();
+    }
+
+    // 读到文件尾时缓冲区中可能少于 n 字节
+    const size_t skip = static_cast<size_t>(offset - buf_offset_);
+    const size_t copy_size = skip < buf_len_ ? std::min(n, buf_len_ - skip) : 0;
+    std::memcpy(scratch, buf_.data() + skip, copy_size);
+    *result = Slice(scratch, copy_size);
+    return Status::OK();
+  }
+
+ private:
+  // [offset, offset + n) 是否都在缓冲区中
+  bool InBuffer(uint64_t offset, size_t n) const {
+    return offset >= buf_offset_ && offset + n <= buf_offset_ + buf_len_;
+  }
+
+  RandomAccessFile* const file_;
+  const AlignedBuffer buf_;
+  mutable uint64_t buf_offset_;  // buf_ 中的数据在文件中的位置
+  mutable size_t buf_len_;       // buf_ 中有效数据的长度
+};
+
+}  // namespace
+
+RandomAccessFile* NewReadaheadRandomAccessFile(RandomAccessFile* file,
+                                               size_t readahead_size) {
+  return new ReadaheadRandomAccessFile(file, readahead_size);
+}
+
+}  // namespace leveldb
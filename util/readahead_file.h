@@ -0,0 +1,23 @@
+#ifndef STORAGE_LEVELDB_UTIL_READAHEAD_FILE_H_
+#define STORAGE_LEVELDB_UTIL_READAHEAD_FILE_H_
+
+#include <cstddef>
+
+namespace leveldb {
+
+class RandomAccessFile;
+
+// 返回一个包装 file 的 RandomAccessFile：缓冲区之外的 Read 从对齐的位置一次读入
+// readahead_size 字节(向上取整为 4KB 的整数倍)，之后落在缓冲区中的 Read 直接拷贝。
+// 用于顺序读取以 O_DIRECT 打开的 sstable(compaction 的输入)，把每个数据块一次
+// 的 pread 合并为每 readahead_size 字节一次；对齐的缓冲区也让底层的 O_DIRECT
+// 读取不需要中转。超过缓冲区大小的 Read 直接转发给 file。
+//
+// 不拥有 file，file 的生命期不能短于返回的对象。返回的对象不是线程安全的，
+// 只能由一个线程(一个迭代器)使用。
+RandomAccessFile* NewReadaheadRandomAccessFile(RandomAccessFile* file,
+                                               size_t readahead_size);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_READAHEAD_FILE_H_
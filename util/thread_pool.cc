@@ -0,0 +1,154 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+namespace leveldb {
+
+ThreadPool::ThreadPool(int num_threads)
+    : work_cv_(&mutex_),
+      drained_cv_(&mutex_),
+      num_live_threads_(0),
+      total_threads_(std::max(num_threads, 1)),
+      running_jobs_(0),
+      exit_all_threads_(false),
+      jobs_completed_(0),
+      total_queue_micros_(0),
+      max_queue_micros_(0),
+      total_run_micros_(0),
+      max_run_micros_(0) {}
+
+ThreadPool::~ThreadPool() { JoinAllThreads(true); }
+
+uint64_t ThreadPool::NowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void ThreadPool::Schedule(void (*function)(void* arg), void* arg) {
+  MutexLock l(&mutex_);
+  if (exit_all_threads_) {
+    // 正在关闭，不再接受新任务
+    return;
+  }
+  StartThreads();
+  queue_.emplace_back(function, arg, NowMicros());
+  work_cv_.Signal();
+}
+
+void ThreadPool::SetBackgroundThreads(int num_threads) {
+  MutexLock l(&mutex_);
+  total_threads_ = std::max(num_threads, 1);
+  if (!threads_.empty()) {
+    // 已经启动过，立即按新的线程数创建线程；多余的线程被唤醒后自行退出
+    StartThreads();
+  }
+  work_cv_.SignalAll();
+}
+
+int ThreadPool::GetBackgroundThreads() {
+  MutexLock l(&mutex_);
+  return total_threads_;
+}
+
+unsigned int ThreadPool::GetQueueLen() {
+  MutexLock l(&mutex_);
+  return static_cast<unsigned int>(queue_.size());
+}
+
+void ThreadPool::GetStats(Env::ThreadPoolStats* stats) {
+  MutexLock l(&mutex_);
+  stats->queue_len = static_cast<unsigned int>(queue_.size());
+  stats->running_jobs = running_jobs_;
+  stats->num_threads = total_threads_;
+  stats->jobs_completed = jobs_completed_;
+  stats->total_queue_micros = total_queue_micros_;
+  stats->max_queue_micros = max_queue_micros_;
+  stats->total_run_micros = total_run_micros_;
+  stats->max_run_micros = max_run_micros_;
+}
+
+void ThreadPool::JoinAllThreads(bool wait_for_jobs) {
+  std::vector<std::thread> threads;
+  {
+    MutexLock l(&mutex_);
+    if (wait_for_jobs) {
+      while (!queue_.empty() || running_jobs_ > 0) {
+        drained_cv_.Wait();
+      }
+    } else {
+      queue_.clear();
+    }
+    exit_all_threads_ = true;
+    work_cv_.SignalAll();
+    threads.swap(threads_);
+  }
+
+  // 不持有锁 join，退出中的线程还需要获取锁
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  MutexLock l(&mutex_);
+  num_live_threads_ = 0;
+  exit_all_threads_ = false;
+}
+
+void ThreadPool::StartThreads() {
+  // 先 join 之前因为线程数调小而退出的线程，它们在退出前已经更新了 num_live_threads_
+  while (threads_.size() > num_live_threads_) {
+    threads_.back().join();
+    threads_.pop_back();
+  }
+  while (num_live_threads_ < static_cast<size_t>(total_threads_)) {
+    threads_.emplace_back(&ThreadPool::BackgroundThreadMain, this,
+                          num_live_threads_);
+    num_live_threads_++;
+  }
+}
+
+void ThreadPool::BackgroundThreadMain(size_t thread_index) {
+  MutexLock l(&mutex_);
+  while (true) {
+    // Wait until there is work to be done.
+    while (queue_.empty() && !exit_all_threads_ &&
+           !IsExcessiveThread(thread_index)) {
+      work_cv_.Wait();
+    }
+
+    if (exit_all_threads_) {
+      break;
+    }
+    if (IsExcessiveThread(thread_index)) {
+      // 线程数被调小。编号更小的多余线程可能在等待本线程先退出
+      num_live_threads_--;
+      work_cv_.SignalAll();
+      break;
+    }
+
+    BackgroundWorkItem item = queue_.front();
+    queue_.pop_front();
+    running_jobs_++;
+    const uint64_t start_micros = NowMicros();
+    const uint64_t queue_micros = start_micros - item.enqueue_micros;
+
+    mutex_.Unlock();
+    (*item.function)(item.arg);
+    const uint64_t run_micros = NowMicros() - start_micros;
+    mutex_.Lock();
+
+    running_jobs_--;
+    jobs_completed_++;
+    total_queue_micros_ += queue_micros;
+    max_queue_micros_ = std::max(max_queue_micros_, queue_micros);
+    total_run_micros_ += run_micros;
+    max_run_micros_ = std::max(max_run_micros_, run_micros);
+    if (queue_.empty() && running_jobs_ == 0) {
+      drained_cv_.SignalAll();
+    }
+  }
+}
+
+}  // namespace leveldb
@@ -0,0 +1,92 @@
+#ifndef STORAGE_LEVELDB_UTIL_THREAD_POOL_H_
+#define STORAGE_LEVELDB_UTIL_THREAD_POOL_H_
+
+#include <cstdint>
+#include <deque>
+#include <thread>
+#include <vector>
+
+#include "env.h"
+#include "mutex.h"
+
+namespace leveldb {
+
+// 固定大小(可在运行时调整)的后台线程池，任务按 FIFO 顺序执行。
+// PosixEnv 为每个优先级持有一个线程池；也可以单独使用。
+// 线程在第一次 Schedule 时才创建。所有方法都是线程安全的。
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads = 1);
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // 等待已经入队的任务执行完，然后 join 所有线程
+  ~ThreadPool();
+
+  // 把 function(arg) 放入队列，由某个后台线程执行
+  void Schedule(void (*function)(void* arg), void* arg);
+
+  // 调整线程数(至少为 1)。增加时立即创建新线程；减少时多余的线程在完成
+  // 当前任务后退出，不会打断正在执行的任务，调用者也不会等待它们。
+  void SetBackgroundThreads(int num_threads);
+  int GetBackgroundThreads();
+
+  // 队列中等待执行的任务数(不包括正在执行的任务)
+  unsigned int GetQueueLen();
+
+  void GetStats(Env::ThreadPoolStats* stats);
+
+  // 有序关闭：wait_for_jobs 为 true 时先等待队列中的任务全部执行完，否则丢弃
+  // 尚未开始的任务；然后 join 所有线程。之后再次 Schedule 会重新创建线程。
+  void JoinAllThreads(bool wait_for_jobs);
+
+ private:
+  struct BackgroundWorkItem {
+    BackgroundWorkItem(void (*function)(void* arg), void* arg,
+                       uint64_t enqueue_micros)
+        : function(function), arg(arg), enqueue_micros(enqueue_micros) {}
+
+    void (*function)(void*);
+    void* arg;
+    uint64_t enqueue_micros;  // 入队时间，用于统计排队延迟
+  };
+
+  static uint64_t NowMicros();
+
+  void BackgroundThreadMain(size_t thread_index);
+
+  // 创建线程直到活跃线程数达到 total_threads_。
+  // REQUIRES: mutex_ 已加锁
+  void StartThreads();
+
+  // 当前线程是否应该退出：线程数被调小，且它是编号最大的活跃线程。
+  // 总是让编号最大的线程先退出，使活跃线程的编号保持连续。
+  // REQUIRES: mutex_ 已加锁
+  bool IsExcessiveThread(size_t thread_index) const {
+    return thread_index >= static_cast<size_t>(total_threads_) &&
+           thread_index + 1 == num_live_threads_;
+  }
+
+  Mutex mutex_;
+  CondVar work_cv_;     // 有新任务、线程数变化或者需要退出
+  CondVar drained_cv_;  // 队列为空且没有正在执行的任务
+  std::deque<BackgroundWorkItem> queue_;
+  // threads_[0, num_live_threads_) 为活跃线程，之后的是已经退出、尚未 join 的线程
+  std::vector<std::thread> threads_;
+  size_t num_live_threads_;
+  int total_threads_;
+  int running_jobs_;
+  bool exit_all_threads_;
+
+  // 统计信息
+  uint64_t jobs_completed_;
+  uint64_t total_queue_micros_;
+  uint64_t max_queue_micros_;
+  uint64_t total_run_micros_;
+  uint64_t max_run_micros_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_THREAD_POOL_H_